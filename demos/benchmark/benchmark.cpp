@@ -6,10 +6,12 @@
 #include "Math.hpp"
 #include "Model.hpp"
 #include "PerformanceOverlay.hpp"
+#include "ProgramBinaryCache.hpp"
 #include "Random.hpp"
 #include "Renderer.hpp"
 #include "RendererOverlay.hpp"
 #include "Scene.hpp"
+#include "Shader.hpp"
 #include "ShaderCollection.hpp"
 #include "Sprite.hpp"
 #include "Stopwatch.hpp"
@@ -21,8 +23,10 @@
 #include "Window.hpp"
 
 #include <algorithm>
+#include <filesystem>
 #include <string>
 #include <sys/resource.h>
+#include <vector>
 
 static const std::string gnu_linux = "I'd just like to interject for a moment. What you're refering to as Linux, is in fact,\n\
 GNU/Linux, or as I've recently taken to calling it, GNU plus Linux. Linux is not an\n\
@@ -63,9 +67,24 @@ int main(void)
 
 	window.init_imgui();
 
-	birb::stopwatch stopwatch_shader_precompiling;
+	// Use a cache directory of our own, so that the cold start doesn't wipe the real cache
+	const std::filesystem::path program_binary_directory = std::filesystem::temp_directory_path() / "birb3d_benchmark_program_binaries";
+	birb::program_binary_cache::directory = program_binary_directory.string();
+
+	// Cold start. Everything gets compiled from source and the program binaries are written to disk
+	birb::program_binary_cache::clear();
+
+	birb::stopwatch stopwatch_shader_precompiling_cold;
+	birb::shader_collection::precompile_basic_shaders();
+	f64 shader_precompiling_cold_time = stopwatch_shader_precompiling_cold.stop();
+
+	// Warm start. Throw away the compiled shaders and load the programs back from the disk
+	birb::shader_collection::wipe();
+	birb::shader::clear_shader_cache();
+
+	birb::stopwatch stopwatch_shader_precompiling_warm;
 	birb::shader_collection::precompile_basic_shaders();
-	f64 shader_precompiling_time = stopwatch_shader_precompiling.stop();
+	f64 shader_precompiling_warm_time = stopwatch_shader_precompiling_warm.stop();
 
 	birb::stopwatch stopwatch_renderer_construction("Renderer construction");
 	birb::renderer renderer;
@@ -272,11 +291,15 @@ int main(void)
 			for (auto entity : view)
 			{
 				birb::transformer& transformer = view.get<birb::transformer>(entity);
+
+				std::vector<size_t> rotated_transforms;
 				for (size_t i = 0; i < transformer.transforms.size() - 8; i += 8)
 				{
 					transformer.transforms[i].rotation.z += timestep.deltatime() * 32.0f;
-					transformer.update_transform(i);
+					rotated_transforms.push_back(i);
 				}
+
+				transformer.update_transforms(rotated_transforms);
 				transformer.update_vbo_data();
 			}
 		}
@@ -367,7 +390,9 @@ int main(void)
 			std::cerr << "\n";
 			std::cerr << "Window creation:       " << birb::stopwatch::format_time(window_creation_time) << "\n";
 			std::cerr << "Renderer construction: " << birb::stopwatch::format_time(renderer_construction_time) << "\n";
-			std::cerr << "Shader precompiling:   " << birb::stopwatch::format_time(shader_precompiling_time) << "\n";
+			std::cerr << "Shader precompiling:   " << birb::stopwatch::format_time(shader_precompiling_cold_time) << " (cold), "
+				<< birb::stopwatch::format_time(shader_precompiling_warm_time) << " (warm)\n";
+			std::cerr << "Program binary hits:   " << birb::program_binary_cache::hits() << "\n";
 			std::cerr << "Text init:             " << birb::stopwatch::format_time(text_init_time) << "\n";
 			std::cerr << "Sprite init:           " << birb::stopwatch::format_time(sprite_init_time) << "\n";
 			std::cerr << "3D init:               " << birb::stopwatch::format_time(three_d_init_time) << "\n";
@@ -392,4 +417,7 @@ int main(void)
 			window.quit();
 		}
 	}
+
+	std::error_code error;
+	std::filesystem::remove_all(program_binary_directory, error);
 }
@@ -1,3 +1,4 @@
+#include "AssetLoader.hpp"
 #include "BoxCollider.hpp"
 #include "Camera.hpp"
 #include "Components.hpp"
@@ -31,6 +32,7 @@ int main(void)
 
 	birb::renderer renderer;
 	renderer.opt_blend(true);
+	renderer.opt_hot_reload(true);
 	renderer.set_scene(scene);
 	renderer.debug.alloc_world(window);
 	renderer.debug.alloc_entity_editor(scene);
@@ -74,10 +76,14 @@ int main(void)
 
 	birb::entity world = scene.create_entity("World");
 
+	// The models get decoded in the background and pop into the world once they have been uploaded
+	birb::asset_loader asset_loader;
 	birb::stopwatch model_loading("Model loading");
-	birb::model world_model("world.obj");
-	birb::model tree_model("tree.obj");
-	model_loading.stop();
+	const birb::asset_handle<birb::model> world_model = asset_loader.load_model("world.obj");
+	const birb::asset_handle<birb::model> tree_model = asset_loader.load_model("tree.obj");
+	bool world_model_added = false;
+	bool tree_models_added = false;
+	bool models_loaded = false;
 
 	birb::random rng;
 
@@ -88,7 +94,6 @@ int main(void)
 		trees.at(i) = std::make_unique<birb::entity>(scene.create_entity());
 
 		birb::entity& tree = *trees.at(i);
-		tree.add_component(tree_model);
 
 		birb::transform transform;
 		transform.position.x = rng.range_float(-tree_area, tree_area);
@@ -105,7 +110,6 @@ int main(void)
 	birb::transform transform;
 	transform.position.y = -0.5f;
 
-	world.add_component(world_model);
 	world.add_component(transform);
 	world.add_component(default_color_shader);
 
@@ -132,6 +136,28 @@ int main(void)
 	{
 		time += timestep.deltatime();
 
+		asset_loader.process_uploads();
+
+		if (!world_model_added && world_model.is_ready())
+		{
+			world.add_component(*world_model.get());
+			world_model_added = true;
+		}
+
+		if (!tree_models_added && tree_model.is_ready())
+		{
+			for (const std::unique_ptr<birb::entity>& tree : trees)
+				tree->add_component(*tree_model.get());
+
+			tree_models_added = true;
+		}
+
+		if (!models_loaded && asset_loader.pending_count() == 0)
+		{
+			model_loading.stop();
+			models_loaded = true;
+		}
+
 		camera.process_input(window, timestep);
 
 		player.get_component<birb::rigidbody>().position = { camera.position.x, camera.position.y - 4, camera.position.z };
@@ -1,37 +1,54 @@
+#include "Camera.hpp"
 #include "CameraInfoOverlay.hpp"
+#include "Components.hpp"
+#include "Entity.hpp"
+#include "Model.hpp"
 #include "PerformanceOverlay.hpp"
-#include "ShaderUniforms.hpp"
+#include "Random.hpp"
+#include "Renderer.hpp"
+#include "RendererOverlay.hpp"
+#include "Scene.hpp"
+#include "Shader.hpp"
 #include "Timestep.hpp"
 #include "Window.hpp"
 
-#include <algorithm>
-#include <execution>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include <array>
+#include <cmath>
+#include <imgui.h>
+#include <vector>
 
-#include "Profiling.hpp"
-#include "Camera.hpp"
-#include "TextureMaterial.hpp"
-#include "Random.hpp"
-#include "Renderer.hpp"
-#include "Shader.hpp"
-#include "VAO.hpp"
-#include "VBO.hpp"
+// Many small point lights flying around a field of models. Shows how the
+// frame time scales with the light count with and without clustered lighting
+//
+// Controls:
+//   1-5	Change the point light count
+//   c		Toggle clustered lighting
 
 static birb::random rng;
 
-static void randomize_positions(std::vector<glm::vec3>& cube_pos_vec)
+static constexpr std::array<u16, 5> light_counts = { 4, 64, 256, 1024, 4096 };
+static constexpr f32 field_size = 40.0f;
+
+static void create_lights(const u16 count, std::vector<birb::vec3<f32>>& light_origins)
 {
-	constexpr float position_range = 20.0f;
+	birb::shader::point_lights.resize(count);
+	light_origins.resize(count);
 
-	for (size_t i = 0; i < cube_pos_vec.size(); ++i)
+	for (u16 i = 0; i < count; ++i)
 	{
-		float x = rng.range_float(-position_range, position_range);
-		float y = rng.range_float(-position_range, position_range);
-		float z = rng.range_float(-position_range, position_range);
+		birb::point_light& light = birb::shader::point_lights[i];
+		light.name = "Light " + std::to_string(static_cast<unsigned int>(i));
+
+		light.ambient = { 0.0f, 0.0f, 0.0f };
+		light.diffuse = rng.range_vec3_float(0.2f, 1.0f);
+		light.specular = light.diffuse;
 
-		cube_pos_vec[i] = {x, y, z};
+		// Keep the lights small so that each of them only touches a few clusters
+		light.attenuation_constant = 1.0f;
+		light.attenuation_linear = 0.7f;
+		light.attenuation_quadratic = 1.8f;
+
+		light_origins[i] = { rng.range_float(-field_size, field_size), rng.range_float(0.5f, 2.0f), rng.range_float(-field_size, field_size) };
 	}
 }
 
@@ -40,135 +57,67 @@ int main(void)
 	birb::window window("Lighting", birb::vec2<int>(1280, 720));
 	birb::renderer renderer;
 	window.init_imgui();
+	window.lock_cursor_to_window();
 
 	birb::timestep timestep;
 	birb::overlay::performance perf_widget(timestep);
+	birb::overlay::renderer_overlay render_widget(renderer);
 
-	birb::camera camera(birb::vec3<float>(0.0f, 0.0f, -3.0f), window.size());
-	window.lock_cursor_to_window();
+	birb::camera camera(birb::vec3<f32>(0.0f, 5.0f, 10.0f), window.size());
+	camera.far_clip = 200.0f;
+	camera.update_projection_matrices(window.size());
 	camera.process_input(window, timestep);
-	camera.yaw = 90;
-	camera.pitch = 0;
+	camera.yaw = -90;
+	camera.pitch = -20;
 
 	birb::overlay::camera_info camera_widget(camera);
 
-	const std::vector<float> cube_verts =
-	{
-		// positions          // normals           // texture coords
-		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-		 0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
-		 0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-		 0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-
-		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-		 0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
-		 0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-		 0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
-		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-
-		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-		 0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-		 0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-		 0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-		 0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-		 0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-		 0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-		 0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
-		 0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-		 0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-
-		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
-		 0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
-		 0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-		 0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
-		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
-	};
-
-	// Colored cube
-	birb::vbo cube_vbo(cube_verts);
-
-	birb::vao cube_vao;
-	cube_vao.bind();
-
-	cube_vao.link_vbo(cube_vbo, 0, 3, 8, 0);
-	cube_vao.link_vbo(cube_vbo, 1, 3, 8, 3);
-	cube_vao.link_vbo(cube_vbo, 2, 2, 8, 6);
-
-	cube_vao.unbind();
-	cube_vbo.unbind();
-
-
-	// Light cube
-	birb::vao light_vao;
-	light_vao.bind();
-
-	light_vao.link_vbo(cube_vbo, 0, 3, 8, 0);
-
-	light_vao.unbind();
-
-
-	std::array<birb::vec3<float>, 4> light_positions;
-	std::array<birb::vec3<float>, light_positions.size()> light_colors;
-	for (size_t i = 0; i < light_positions.size(); ++i)
-	{
-		float x = rng.range_float(-5.0f, 5.0f);
-		float y = rng.range_float(-5.0f, 5.0f);
-		float z = rng.range_float(-5.0f, 5.0f);
-		light_positions[i] = {x, y, z};
-
-		float r = rng.range_float(0.0f, 1.0f);
-		float g = rng.range_float(0.0f, 1.0f);
-		float b = rng.range_float(0.0f, 1.0f);
-		light_colors[i] = {r, g, b};
-	}
+	birb::scene scene;
+	renderer.set_scene(scene);
 
-	birb::shader default_shader("default");
+	// Dim the directional light so that the point lights stand out
+	birb::shader::directional_light.ambient = { 0.05f, 0.05f, 0.05f };
+	birb::shader::directional_light.diffuse = { 0.1f, 0.1f, 0.1f };
+	birb::shader::directional_light.specular = { 0.1f, 0.1f, 0.1f };
 
-	// Point light
-	for (size_t i = 0; i < light_positions.size(); ++i)
-	{
-		default_shader.point_lights[i].ambient = {0.2f, 0.2f, 0.2f};
-		default_shader.point_lights[i].diffuse = light_colors[i];
-		default_shader.point_lights[i].specular = {1.0f, 1.0f, 1.0f};
+	// Field of models for the lights to light up
+	constexpr i32 model_grid_size = 20;
+	constexpr f32 model_spacing = (field_size * 2.0f) / model_grid_size;
 
-		default_shader.point_lights[i].position = light_positions[i];
+	birb::model suzanne_model("suzanne.obj");
+	birb::material material({ 0.8f, 0.8f, 0.8f }, { 1.0f, 1.0f, 1.0f }, 32);
 
-		default_shader.point_lights[i].attenuation_constant = 1.0f;
-		default_shader.point_lights[i].attenuation_linear = 0.09f;
-		default_shader.point_lights[i].attenuation_quadratic = 0.032f;
+	for (i32 x = 0; x < model_grid_size; ++x)
+	{
+		for (i32 z = 0; z < model_grid_size; ++z)
+		{
+			birb::entity suzanne = scene.create_entity();
+			suzanne.add_component(suzanne_model);
+			suzanne.add_component(material);
+			suzanne.add_component(birb::shader_ref("default"));
+
+			birb::transform transform;
+			transform.position = { -field_size + x * model_spacing, 0.0f, -field_size + z * model_spacing };
+			transform.rotation.y = rng.range_float(0.0f, 360.0f);
+			suzanne.add_component(transform);
+		}
 	}
 
-	default_shader.update_point_lights();
-	default_shader.update_directional_light();
-
-	birb::texture_material material("texture_512.png", "specular_512.png", 32);
-	material.apply_to_shader(default_shader);
-
-	birb::shader light_shader("default", "light");
-
-	constexpr int cube_count = 1000;
-	std::vector<glm::vec3> cube_positions(cube_count);
-	randomize_positions(cube_positions);
+	u8 light_count_index = 2;
+	std::vector<birb::vec3<f32>> light_origins;
+	create_lights(light_counts[light_count_index], light_origins);
 
 	while (!window.should_close())
 	{
+		camera.process_input(window, timestep);
+
 		while (window.inputs_available())
 		{
 			birb::input input = window.next_input();
+
+			if (input.state != birb::input::action::key_down)
+				continue;
+
 			switch (input.key)
 			{
 				case birb::input::keycode::escape:
@@ -179,77 +128,51 @@ int main(void)
 					window.lock_cursor_to_window();
 					break;
 
-				default:
+				case birb::input::keycode::one:
+				case birb::input::keycode::two:
+				case birb::input::keycode::three:
+				case birb::input::keycode::four:
+				case birb::input::keycode::five:
+					light_count_index = static_cast<i32>(input.key) - static_cast<i32>(birb::input::keycode::one);
+					create_lights(light_counts[light_count_index], light_origins);
 					break;
-			}
 
-			if (input.state == birb::input::action::key_down)
-			{
-				switch (input.key)
-				{
-					case birb::input::keycode::r:
-						randomize_positions(cube_positions);
-						break;
-
-					default:
-						break;
-				}
+				case birb::input::keycode::c:
+					renderer.opt_clustered_lighting(!renderer.is_clustered_lighting_enabled());
+					break;
+
+				default:
+					break;
 			}
 		}
 
-		camera.process_input(window, timestep);
-
-		window.clear();
-
-		default_shader.activate();
-		glm::mat4 projection = glm::perspective(glm::radians(45.0f), static_cast<float>(window.size().x) / static_cast<float>(window.size().y), 0.1f, 100.0f);
-		default_shader.set(birb::shader_uniforms::view, camera.view_matrix());
-		default_shader.set(birb::shader_uniforms::projection, projection);
-		default_shader.set(birb::shader_uniforms::view_pos, camera.position);
-
-		// Do the matrix maths
-		std::vector<glm::mat4> cube_model_matrices(cube_positions.size());
-
-		std::transform(std::execution::par, cube_positions.begin(), cube_positions.end(), cube_model_matrices.begin(), [timestep](const glm::vec3& position) {
-			glm::mat4 model = glm::mat4(1.0f);
-
-			model = glm::translate(model, position);
-			model = glm::rotate(model, glm::radians(((position.x + position.y + position.z) * 20.0f) + static_cast<float>(timestep.time_since_startup()) * 50.0f), glm::vec3(1.0f, 0.3f, 0.5f));
-
-			return model;
-		});
-
-		for (size_t i = 0; i < cube_positions.size(); ++i)
+		// Move the lights around in small circles so that they need to be re-binned every frame
+		const f32 time = timestep.time_since_startup();
+		for (size_t i = 0; i < birb::shader::point_lights.size(); ++i)
 		{
-			default_shader.set(birb::shader_uniforms::model, cube_model_matrices[i]);
-			renderer.draw_arrays(cube_vao, cube_verts.size());
+			const f32 phase = time + i * 0.37f;
+			birb::shader::point_lights[i].position = light_origins[i] + birb::vec3<f32>(std::cos(phase), 0.0f, std::sin(phase));
 		}
 
-		light_shader.set(birb::shader_uniforms::view, camera.view_matrix());
-		light_shader.set(birb::shader_uniforms::projection, projection);
+		window.clear();
 
-		light_shader.activate();
+		renderer.draw_entities(camera, window.size());
 
-		// Draw the light source cubes
+		ImGui::Begin("Lighting");
 		{
-			PROFILER_SCOPE_RENDER("Render light sources")
-			for (size_t i = 0; i < light_positions.size(); ++i)
-			{
-				glm::mat4 model = glm::mat4(1.0f);
-				model = glm::translate(model, light_positions[i].to_glm_vec());
-				model = glm::scale(model, glm::vec3(0.2f));
-
-				light_shader.set(birb::shader_uniforms::model, model);
-				light_shader.set(birb::shader_uniforms::color, birb::color(light_colors[i].x, light_colors[i].y, light_colors[i].z));
-				renderer.draw_arrays(light_vao, cube_verts.size());
-			}
+			ImGui::Text("Point lights: %lu (keys 1-5)", birb::shader::point_lights.size());
+			ImGui::Text("Clustered lighting: %s (key c)", renderer.is_clustered_lighting_enabled() ? "on" : "off");
 		}
+		ImGui::End();
 
 		perf_widget.draw();
+		render_widget.draw();
 		camera_widget.draw();
-		window.flip();
 
+		window.flip();
 		window.poll();
 		timestep.step();
 	}
+
+	return 0;
 }
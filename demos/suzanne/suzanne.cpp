@@ -26,6 +26,7 @@ int main(void)
 	window.lock_cursor_to_window();
 	window.hot_reload_assets_on_focus_change = true;
 	birb::renderer renderer;
+	renderer.opt_hot_reload(true);
 	birb::timestep timestep;
 	birb::camera camera(window.size());
 	camera.movement_speed = 7;
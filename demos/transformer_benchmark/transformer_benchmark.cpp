@@ -0,0 +1,129 @@
+#include "Logger.hpp"
+#include "Random.hpp"
+#include "Stopwatch.hpp"
+#include "Transform.hpp"
+#include "Transformer.hpp"
+#include "Types.hpp"
+#include "Vector.hpp"
+#include "Window.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+static constexpr size_t transform_count = 1'000'000;
+static constexpr i32 iteration_count = 10;
+
+int main(void)
+{
+	// The window is only needed for the OpenGL context that the instance VBO needs
+	birb::window window("Transformer benchmark", birb::vec2<int>(320, 240));
+
+	birb::random rng;
+
+	birb::transformer transformer;
+	transformer.transforms.resize(transform_count);
+
+	for (birb::transform& t : transformer.transforms)
+	{
+		t.position = { rng.range_float(-100.0f, 100.0f), rng.range_float(-100.0f, 100.0f), rng.range_float(-100.0f, 100.0f) };
+		t.rotation = { rng.range_float(0.0f, 360.0f), rng.range_float(0.0f, 360.0f), rng.range_float(0.0f, 360.0f) };
+		t.local_scale = { rng.range_float(0.5f, 2.0f), rng.range_float(0.5f, 2.0f), rng.range_float(0.5f, 2.0f) };
+	}
+
+	birb::log("Locking ", transform_count, " transforms ", iteration_count, " times");
+
+	// Reference: lock the transforms one by one
+	f64 per_transform_duration = 0.0;
+	{
+		std::vector<glm::mat4> model_matrices;
+
+		for (i32 i = 0; i < iteration_count; ++i)
+		{
+			birb::stopwatch timer;
+
+			model_matrices.clear();
+			model_matrices.reserve(transform_count);
+
+			for (birb::transform& t : transformer.transforms)
+			{
+				t.unlock();
+				t.lock();
+				model_matrices.push_back(t.model_matrix());
+			}
+
+			per_transform_duration += timer.stop(true);
+		}
+	}
+
+	// Per-entity model_matrix() compared to the batched kernel on a single thread.
+	// The kernel reads the components from separate arrays like the hierarchy does
+	f64 model_matrix_duration = 0.0;
+	f64 compose_duration = 0.0;
+	{
+		std::vector<glm::vec3> positions, rotations, scales;
+		positions.reserve(transform_count);
+		rotations.reserve(transform_count);
+		scales.reserve(transform_count);
+
+		for (const birb::transform& t : transformer.transforms)
+		{
+			positions.push_back(t.position.to_glm_vec());
+			rotations.push_back(t.rotation.to_glm_vec());
+			scales.push_back(t.local_scale.to_glm_vec());
+		}
+
+		std::vector<glm::mat4> model_matrices(transform_count);
+
+		for (i32 i = 0; i < iteration_count; ++i)
+		{
+			birb::stopwatch timer;
+
+			for (size_t j = 0; j < transform_count; ++j)
+			{
+				transformer.transforms[j].unlock();
+				model_matrices[j] = transformer.transforms[j].model_matrix();
+			}
+
+			model_matrix_duration += timer.stop(true);
+		}
+
+		for (i32 i = 0; i < iteration_count; ++i)
+		{
+			birb::stopwatch timer;
+			birb::transform::compose_model_matrices(positions, rotations, scales, model_matrices);
+			compose_duration += timer.stop(true);
+		}
+	}
+
+	// The parallel lock path, including the VBO upload
+	f64 lock_duration = 0.0;
+	for (i32 i = 0; i < iteration_count; ++i)
+	{
+		birb::stopwatch timer;
+		transformer.lock();
+		lock_duration += timer.stop(true);
+
+		transformer.unlock();
+	}
+
+	// Relocking reuses the VBO and only streams the matrices in the renderer
+	f64 relock_duration = 0.0;
+	transformer.lock();
+	for (i32 i = 0; i < iteration_count; ++i)
+	{
+		birb::stopwatch timer;
+		transformer.relock();
+		relock_duration += timer.stop(true);
+
+		transformer.mark_vbo_data_uploaded();
+	}
+	transformer.unlock();
+
+	birb::log("Per transform lock: ", birb::stopwatch::format_time(per_transform_duration / iteration_count));
+	birb::log("Per transform model_matrix(): ", birb::stopwatch::format_time(model_matrix_duration / iteration_count));
+	birb::log("transform::compose_model_matrices(): ", birb::stopwatch::format_time(compose_duration / iteration_count));
+	birb::log("transformer::lock(): ", birb::stopwatch::format_time(lock_duration / iteration_count));
+	birb::log("transformer::relock(): ", birb::stopwatch::format_time(relock_duration / iteration_count));
+
+	return 0;
+}
@@ -1,5 +1,6 @@
 #include "Debugging.hpp"
 #include "Profiling.hpp"
+#include "ProgramBinaryCache.hpp"
 #include "Shader.hpp"
 
 #include <imgui.h>
@@ -25,6 +26,19 @@ namespace editor
 #endif
 			if (shader_cache_size > 0 && ImGui::Button("Clear cache"))
 				birb::shader::clear_shader_cache();
+
+			// Program binaries on disk
+#ifdef BIRB_PLATFORM_LINUX
+			ImGui::Text("Program binary hits: %lu", birb::program_binary_cache::hits());
+			ImGui::Text("Program binary misses: %lu", birb::program_binary_cache::misses());
+#else
+			ImGui::Text("Program binary hits: %llu", birb::program_binary_cache::hits());
+			ImGui::Text("Program binary misses: %llu", birb::program_binary_cache::misses());
+#endif
+			ImGui::Checkbox("Use program binaries", &birb::program_binary_cache::enabled);
+
+			if (ImGui::Button("Clear program binaries"))
+				birb::program_binary_cache::clear();
 		}
 		ImGui::End();
 	}
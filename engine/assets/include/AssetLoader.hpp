@@ -0,0 +1,233 @@
+#pragma once
+
+#include "Assert.hpp"
+#include "Logger.hpp"
+#include "Texture.hpp"
+#include "Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace birb
+{
+	class font;
+	class font_manager;
+	class model;
+	class sound_file;
+
+	enum class asset_status : u8
+	{
+		loading,
+		ready,
+		failed,
+	};
+
+	/**
+	 * @brief Handle to an asset that is being loaded by an asset_loader
+	 *
+	 * The status only changes in asset_loader::process_uploads(), so an asset
+	 * that was ready at the start of a frame stays ready for the whole frame
+	 */
+	template<typename T>
+	class asset_handle
+	{
+	public:
+		asset_handle() = default;
+
+		asset_status status() const
+		{
+			ensure(state != nullptr, "The handle doesn't refer to any asset");
+			return state->status;
+		}
+
+		bool is_ready() const
+		{
+			return state != nullptr && state->status == asset_status::ready;
+		}
+
+		bool has_failed() const
+		{
+			return state != nullptr && state->status == asset_status::failed;
+		}
+
+		/**
+		 * @brief Get the loaded asset
+		 *
+		 * Only call this after is_ready() has returned true
+		 */
+		std::shared_ptr<T> get() const
+		{
+			ensure(is_ready(), "Tried to access an asset that hasn't been loaded");
+			return state->asset;
+		}
+
+	private:
+		friend class asset_loader;
+
+		struct shared_state
+		{
+			std::atomic<asset_status> status = asset_status::loading;
+			std::shared_ptr<T> asset;
+		};
+
+		explicit asset_handle(const std::shared_ptr<shared_state>& state)
+		:state(state)
+		{}
+
+		std::shared_ptr<shared_state> state;
+	};
+
+	/**
+	 * @brief Loads assets in the background with a pool of worker threads
+	 *
+	 * Loading is split into two steps. The decoding step reads and decodes the
+	 * files on the worker threads. The upload step creates the OpenGL and OpenAL
+	 * objects from the decoded data on the main thread in process_uploads()
+	 *
+	 * The loader itself isn't thread safe. Only the worker threads it owns run in
+	 * the background, so all of the public functions must be called from the main thread
+	 */
+	class asset_loader
+	{
+	public:
+		/**
+		 * @param worker_count Amount of worker threads. Zero leaves one hardware thread for the main thread
+		 */
+		explicit asset_loader(const u8 worker_count = 0);
+		~asset_loader();
+		asset_loader(const asset_loader&) = delete;
+		asset_loader(asset_loader&) = delete;
+		asset_loader(asset_loader&&) = delete;
+
+		/**
+		 * @brief Queue a texture to be loaded
+		 *
+		 * Only call this from the main thread
+		 */
+		asset_handle<texture> load_texture(const std::string& path, const u32 slot = 0, const color_format format = color_format::RGBA, const texture_type type = texture_type::TEX_2D);
+
+		/**
+		 * @brief Queue a model to be loaded
+		 *
+		 * Only call this from the main thread
+		 */
+		asset_handle<model> load_model(const std::string& path);
+
+		/**
+		 * @brief Queue a sound file to be loaded
+		 *
+		 * Only call this from the main thread
+		 */
+		asset_handle<sound_file> load_sound(const std::string& path);
+
+		/**
+		 * @brief Queue a font to be loaded
+		 *
+		 * Only call this from the main thread
+		 *
+		 * @param fonts The font manager needs to outlive the load
+		 */
+		asset_handle<font> load_font(font_manager& fonts, const std::string& path, const u8 size);
+
+		/**
+		 * @brief Load any kind of asset
+		 *
+		 * Only call this from the main thread
+		 *
+		 * @param name Name of the asset for log messages
+		 * @param decode Runs on a worker thread. Returns nullptr if the asset can't be decoded
+		 * @param upload Runs on the main thread. Returns nullptr if the asset can't be created
+		 */
+		template<typename T, typename Decoded>
+		asset_handle<T> load(const std::string& name, std::function<std::shared_ptr<Decoded>()> decode, std::function<std::shared_ptr<T>(Decoded&)> upload)
+		{
+			ensure(decode != nullptr);
+			ensure(upload != nullptr);
+
+			const std::shared_ptr<typename asset_handle<T>::shared_state> state = std::make_shared<typename asset_handle<T>::shared_state>();
+			++pending_loads;
+
+			push_job([this, state, name, decode, upload]
+			{
+				const std::shared_ptr<Decoded> decoded = decode();
+
+				push_upload([state, name, decoded, upload]
+				{
+					if (decoded != nullptr)
+						state->asset = upload(*decoded);
+
+					if (state->asset == nullptr)
+					{
+						birb::log_error("Failed to load asset: ", name);
+						state->status = asset_status::failed;
+						return;
+					}
+
+					state->status = asset_status::ready;
+				});
+			});
+
+			return asset_handle<T>(state);
+		}
+
+		/**
+		 * @brief Upload the assets that have finished decoding
+		 *
+		 * Call this once per frame from the main thread. Uploading stops once the time
+		 * budget has been used up, but at least one asset gets uploaded per call
+		 */
+		void process_uploads(const std::chrono::microseconds budget = std::chrono::microseconds(2000));
+
+		/**
+		 * @brief Block until all of the queued assets have been loaded
+		 *
+		 * Only call this from the main thread
+		 */
+		void finish_all();
+
+		/**
+		 * @brief Block until all of the queued assets have been decoded
+		 *
+		 * Only call this from the main thread. The assets still
+		 * need to be uploaded with process_uploads() after this
+		 */
+		void wait_for_decoding();
+
+		/**
+		 * @brief Amount of assets that haven't been uploaded yet
+		 */
+		size_t pending_count() const;
+
+		u8 worker_count() const;
+
+	private:
+		void push_job(std::function<void()> job);
+		void push_upload(std::function<void()> upload);
+		void worker_loop();
+
+		// Runs the next upload in the queue. Returns false if the queue was empty
+		bool run_next_upload();
+
+		std::vector<std::thread> workers;
+
+		std::mutex job_mutex;
+		std::condition_variable job_available;
+		std::deque<std::function<void()>> jobs;
+		bool stopping = false;
+
+		std::mutex upload_mutex;
+		std::condition_variable upload_available;
+		std::deque<std::function<void()>> uploads;
+
+		// Not synchronized, since only the main thread touches this
+		size_t pending_loads = 0;
+	};
+}
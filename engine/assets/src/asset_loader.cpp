@@ -0,0 +1,215 @@
+#include "AssetLoader.hpp"
+#include "Font.hpp"
+#include "FontManager.hpp"
+#include "Image.hpp"
+#include "Model.hpp"
+#include "Profiling.hpp"
+#include "SoundFile.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace birb
+{
+	asset_loader::asset_loader(const u8 worker_count)
+	{
+		u32 thread_count = worker_count;
+
+		// Leave one thread for the main thread to keep rendering on
+		if (thread_count == 0)
+			thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		workers.reserve(thread_count);
+		for (u32 i = 0; i < thread_count; ++i)
+			workers.emplace_back(&asset_loader::worker_loop, this);
+	}
+
+	asset_loader::~asset_loader()
+	{
+		{
+			std::unique_lock lock(job_mutex);
+			stopping = true;
+		}
+
+		job_available.notify_all();
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	asset_handle<texture> asset_loader::load_texture(const std::string& path, const u32 slot, const color_format format, const texture_type type)
+	{
+		return load<texture, asset::image>(path,
+			[path]() -> std::shared_ptr<asset::image>
+			{
+				const std::shared_ptr<asset::image> image = std::make_shared<asset::image>(path.c_str(), true);
+				return image->data != nullptr ? image : nullptr;
+			},
+			[path, slot, format, type](asset::image& image)
+			{
+				const std::shared_ptr<texture> tex = std::make_shared<texture>();
+				tex->load(image, path, slot, format, type);
+				return tex;
+			});
+	}
+
+	asset_handle<model> asset_loader::load_model(const std::string& path)
+	{
+		return load<model, model::import_data>(path,
+			[path]() -> std::shared_ptr<model::import_data>
+			{
+				const std::shared_ptr<model::import_data> data = model::import_file(path);
+				return data->success ? data : nullptr;
+			},
+			[](model::import_data& data)
+			{
+				const std::shared_ptr<model> mdl = std::make_shared<model>();
+				mdl->load_model(data);
+				return mdl;
+			});
+	}
+
+	asset_handle<sound_file> asset_loader::load_sound(const std::string& path)
+	{
+		return load<sound_file, sound_file::sample_data>(path,
+			[path]() -> std::shared_ptr<sound_file::sample_data>
+			{
+				const std::shared_ptr<sound_file::sample_data> data = std::make_shared<sound_file::sample_data>();
+				return sound_file::decode(path, *data) ? data : nullptr;
+			},
+			[](sound_file::sample_data& data) -> std::shared_ptr<sound_file>
+			{
+				const std::shared_ptr<sound_file> sound = std::make_shared<sound_file>();
+				return sound->load(data) ? sound : nullptr;
+			});
+	}
+
+	asset_handle<font> asset_loader::load_font(font_manager& fonts, const std::string& path, const u8 size)
+	{
+		return load<font, font_manager::glyph_atlas>(path,
+			[&fonts, path, size]() -> std::shared_ptr<font_manager::glyph_atlas>
+			{
+				std::optional<font_manager::glyph_atlas> atlas = fonts.rasterize_font(path, size);
+				if (!atlas)
+					return nullptr;
+
+				return std::make_shared<font_manager::glyph_atlas>(std::move(*atlas));
+			},
+			[](font_manager::glyph_atlas& atlas)
+			{
+				return std::make_shared<font>(font_manager::upload_font(atlas));
+			});
+	}
+
+	void asset_loader::process_uploads(const std::chrono::microseconds budget)
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		// Always do at least one upload so that a single slow asset can't stall the queue
+		while (run_next_upload())
+		{
+			if (std::chrono::steady_clock::now() - start >= budget)
+				break;
+		}
+	}
+
+	void asset_loader::finish_all()
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		while (pending_loads > 0)
+		{
+			{
+				std::unique_lock lock(upload_mutex);
+				upload_available.wait(lock, [this] { return !uploads.empty(); });
+			}
+
+			while (run_next_upload()) {}
+		}
+	}
+
+	void asset_loader::wait_for_decoding()
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		// Every asset that hasn't been uploaded yet is waiting in the upload queue once it has been decoded
+		std::unique_lock lock(upload_mutex);
+		upload_available.wait(lock, [this] { return uploads.size() == pending_loads; });
+	}
+
+	size_t asset_loader::pending_count() const
+	{
+		return pending_loads;
+	}
+
+	u8 asset_loader::worker_count() const
+	{
+		return static_cast<u8>(workers.size());
+	}
+
+	void asset_loader::push_job(std::function<void()> job)
+	{
+		{
+			std::unique_lock lock(job_mutex);
+			jobs.push_back(std::move(job));
+		}
+
+		job_available.notify_one();
+	}
+
+	void asset_loader::push_upload(std::function<void()> upload)
+	{
+		{
+			std::unique_lock lock(upload_mutex);
+			uploads.push_back(std::move(upload));
+		}
+
+		upload_available.notify_one();
+	}
+
+	void asset_loader::worker_loop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+
+			{
+				std::unique_lock lock(job_mutex);
+				job_available.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+				// Jobs that haven't started yet are dropped, since
+				// nobody would be around to upload the results
+				if (stopping)
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			job();
+		}
+	}
+
+	bool asset_loader::run_next_upload()
+	{
+		std::function<void()> upload;
+
+		{
+			std::unique_lock lock(upload_mutex);
+			if (uploads.empty())
+				return false;
+
+			upload = std::move(uploads.front());
+			uploads.pop_front();
+		}
+
+		upload();
+
+		ensure(pending_loads > 0);
+		--pending_loads;
+
+		return true;
+	}
+}
@@ -14,7 +14,8 @@ namespace birb
 			PROFILER_SCOPE_IO_FN();
 			ensure(path != nullptr, "Invalid image path");
 
-			stbi_set_flip_vertically_on_load(flip_vertically);
+			// The flag is thread local, so images can be decoded on multiple threads at once
+			stbi_set_flip_vertically_on_load_thread(flip_vertically);
 
 			data = stbi_load(path, &dimensions.x, &dimensions.y, &color_channels, 0);
 			if (data == nullptr)
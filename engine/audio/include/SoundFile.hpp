@@ -5,6 +5,7 @@
 #include <AL/al.h>
 #include <sndfile.h>
 #include <string>
+#include <vector>
 
 namespace birb
 {
@@ -17,6 +18,17 @@ namespace birb
 		sound_file(const sound_file&) = default;
 		sound_file(sound_file&) = default;
 
+		/**
+		 * @brief Decoded samples that haven't been uploaded to OpenAL yet
+		 */
+		struct sample_data
+		{
+			std::vector<f32> samples;
+			i32 channels = 0;
+			i32 sample_rate = 0;
+			sf_count_t frame_count = 0;
+		};
+
 		/**
 		 * @brief Load a soundfile from a given file path
 		 *
@@ -25,6 +37,22 @@ namespace birb
 		 */
 		bool load(const std::string& file_path);
 
+		/**
+		 * @brief Upload samples that were decoded with decode()
+		 *
+		 * @return True if the samples were uploaded successfully
+		 */
+		bool load(const sample_data& data);
+
+		/**
+		 * @brief Read and decode a sound file without touching OpenAL
+		 *
+		 * Safe to call from any thread. Only mono and stereo files are supported
+		 *
+		 * @return True if the file was decoded successfully
+		 */
+		static bool decode(const std::string& file_path, sample_data& data);
+
 		/**
 		 * @brief Returns the OpenAL audio buffer
 		 */
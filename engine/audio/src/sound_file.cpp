@@ -13,14 +13,6 @@ static_assert(sizeof(int) == sizeof(ALint));
 
 namespace birb
 {
-	struct free_delete
-	{
-		void operator()(void* x)
-		{
-			free(x);
-		}
-	};
-
 	sound_file::sound_file() {}
 
 	sound_file::sound_file(const std::string& file_path)
@@ -65,7 +57,21 @@ namespace birb
 
 		log("Loading sound file: ", file_path);
 
-		SNDFILE* sndfile = sf_open(file_path.c_str(), SFM_READ, &sfinfo);
+		sample_data data;
+		if (!decode(file_path, data))
+			return false;
+
+		return load(data);
+	}
+
+	bool sound_file::decode(const std::string& file_path, sample_data& data)
+	{
+		PROFILER_SCOPE_AUDIO_FN();
+
+		ensure(!file_path.empty());
+
+		SF_INFO info{};
+		SNDFILE* sndfile = sf_open(file_path.c_str(), SFM_READ, &info);
 
 		if (!sndfile)
 		{
@@ -73,41 +79,72 @@ namespace birb
 			return false;
 		}
 
-		if (sfinfo.frames < 1)
+		// Close the file on all of the return paths
+		const std::unique_ptr<SNDFILE, decltype(&sf_close)> file(sndfile, sf_close);
+
+		if (info.frames < 1)
 		{
 			log_error("Bad sample count error");
 			return false;
 		}
 
 		// Values for float sampling
-		splblockalign = 1;
-        byteblockalign = sfinfo.channels * 4;
-		format = AL_FORMAT_STEREO_FLOAT32;
+		constexpr i32 splblockalign = 1;
+		const i32 byteblockalign = info.channels * 4;
 
-		log("Channel count: ", sfinfo.channels);
-		ensure(sfinfo.channels == 2, "Channel count of two required for now");
-		ensure(byteblockalign != 0, "Zero division");
+		log("Channel count: ", info.channels);
+		if (info.channels != 1 && info.channels != 2)
+		{
+			log_error("Unsupported channel count ", info.channels, " in sound file ", file_path, ". Only mono and stereo are supported");
+			return false;
+		}
 
-		if(sfinfo.frames / splblockalign > static_cast<sf_count_t>(INT_MAX / byteblockalign))
+		if(info.frames / splblockalign > static_cast<sf_count_t>(INT_MAX / byteblockalign))
 		{
 			log_error("Too many samples error");
 			return false;
 		}
-		// This assert should be here, but a LD game needs to get done OwO
-		// ensure(alGetError() != AL_NO_ERROR);
 
-		// Allocate a buffer for the sound file
-		std::unique_ptr<f32, free_delete> file_buffer(static_cast<f32*>(malloc(sfinfo.frames / splblockalign * byteblockalign)));
-        frame_count = sf_readf_float(sndfile, file_buffer.get(), sfinfo.frames);
-		check_al_errors();
-		log("Frame count: ", frame_count);
+		data.samples.resize(info.frames * info.channels);
+		data.frame_count = sf_readf_float(sndfile, data.samples.data(), info.frames);
+		log("Frame count: ", data.frame_count);
 
-		if (frame_count < 1)
+		if (data.frame_count < 1)
 		{
 			log_error("Failed to read samples in");
 			return false;
 		}
 
+		data.channels = info.channels;
+		data.sample_rate = info.samplerate;
+
+		return true;
+	}
+
+	bool sound_file::load(const sample_data& data)
+	{
+		PROFILER_SCOPE_AUDIO_FN();
+
+		ensure(data.frame_count > 0);
+		ensure(data.samples.size() >= static_cast<size_t>(data.frame_count * data.channels));
+		check_al_errors();
+
+		if (data.channels != 1 && data.channels != 2)
+		{
+			log_error("Unsupported channel count: ", data.channels);
+			return false;
+		}
+
+		sfinfo.frames = data.frame_count;
+		sfinfo.channels = data.channels;
+		sfinfo.samplerate = data.sample_rate;
+
+		// Values for float sampling
+		splblockalign = 1;
+		byteblockalign = sfinfo.channels * 4;
+		format = data.channels == 1 ? AL_FORMAT_MONO_FLOAT32 : AL_FORMAT_STEREO_FLOAT32;
+		frame_count = data.frame_count;
+
 		byte_count = static_cast<ALsizei>(frame_count / splblockalign * byteblockalign);
 
 		// Load the audio into a buffer
@@ -115,8 +152,7 @@ namespace birb
 		alGenBuffers(1, &audio_buffer);
 		log("Block align: ", splblockalign);
 		ensure(splblockalign == 1, "Only block alignment of one is supported at the moment");
-		alBufferData(audio_buffer, format, file_buffer.get(), byte_count, sfinfo.samplerate);
-		sf_close(sndfile);
+		alBufferData(audio_buffer, format, data.samples.data(), byte_count, data.sample_rate);
 
 		ALenum err = alGetError();
 		if(err != AL_NO_ERROR)
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace birb
+{
+	/**
+	 * @brief Watches files for changes on a background thread
+	 *
+	 * Uses inotify on Linux. Directories get watched instead of the files themselves,
+	 * since many editors save by writing a new file and renaming it over the old one.
+	 * A burst of events for the same file is reported only once, after the
+	 * file has been left alone for the debounce time.
+	 *
+	 * On other platforms nothing ever gets reported
+	 */
+	class file_watcher
+	{
+	public:
+		explicit file_watcher(const std::chrono::milliseconds debounce_time = std::chrono::milliseconds(100));
+		~file_watcher();
+		file_watcher(const file_watcher&) = delete;
+		file_watcher(file_watcher&) = delete;
+		file_watcher(file_watcher&&) = delete;
+
+		/**
+		 * @brief Start watching a file or all of the files in a directory
+		 *
+		 * Watching the same path multiple times is fine. Paths that
+		 * don't exist are ignored
+		 */
+		void watch(const std::string& path);
+
+		/**
+		 * @brief Take the files that have changed since the last call
+		 *
+		 * Meant to be called once per frame from the main thread
+		 *
+		 * @return Canonical paths to the changed files
+		 */
+		std::vector<std::string> poll_changes();
+
+		/**
+		 * @return True if the platform has a file watching backend
+		 */
+		static bool is_supported();
+
+	private:
+		void watch_loop();
+
+		// Queue a change for a file in a watched directory
+		void record_change(const i32 watch_descriptor, const std::string& file_name);
+
+		// Move changes that have been quiet for long enough to the ready list.
+		// Returns the time until the next pending change is ready
+		std::chrono::milliseconds flush_settled_changes();
+
+		const std::chrono::milliseconds debounce_time;
+
+		i32 inotify_fd = -1;
+		i32 wake_fd = -1;
+		std::atomic<bool> running = false;
+		std::thread thread;
+
+		std::mutex mutex;
+
+		// Watch descriptors of the watched directories
+		std::unordered_map<i32, std::string> watched_directories;
+
+		// Files that should be reported. Directories in this set report all of their files
+		std::unordered_set<std::string> watched_paths;
+
+		// Paths as they were passed to watch(). Lets repeated calls skip the filesystem
+		std::unordered_set<std::string> requested_paths;
+
+		// Changed files and the time of their latest event
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending_changes;
+
+		std::vector<std::string> ready_changes;
+	};
+}
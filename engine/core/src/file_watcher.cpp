@@ -0,0 +1,234 @@
+#include "Assert.hpp"
+#include "FileWatcher.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <filesystem>
+
+#ifdef BIRB_PLATFORM_LINUX
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace birb
+{
+	file_watcher::file_watcher(const std::chrono::milliseconds debounce_time)
+	:debounce_time(debounce_time)
+	{
+#ifdef BIRB_PLATFORM_LINUX
+		inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotify_fd == -1)
+		{
+			birb::log_error("Could not initialize inotify. Files won't be watched for changes");
+			return;
+		}
+
+		// Used for waking up the watcher thread when it needs to quit
+		wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		ensure(wake_fd != -1, "Could not create an eventfd for the file watcher");
+
+		running = true;
+		thread = std::thread(&file_watcher::watch_loop, this);
+#else
+		birb::log_warn("File watching is not supported on this platform");
+#endif
+	}
+
+	file_watcher::~file_watcher()
+	{
+#ifdef BIRB_PLATFORM_LINUX
+		if (running)
+		{
+			running = false;
+
+			const u64 wake_value = 1;
+			[[maybe_unused]] const ssize_t written = write(wake_fd, &wake_value, sizeof(wake_value));
+
+			thread.join();
+		}
+
+		if (wake_fd != -1)
+			close(wake_fd);
+
+		// Closing the inotify instance removes all of its watches
+		if (inotify_fd != -1)
+			close(inotify_fd);
+#endif
+	}
+
+	void file_watcher::watch(const std::string& path)
+	{
+#ifdef BIRB_PLATFORM_LINUX
+		if (inotify_fd == -1)
+			return;
+
+		{
+			std::unique_lock lock(mutex);
+			if (requested_paths.contains(path))
+				return;
+		}
+
+		std::error_code error;
+		if (!std::filesystem::exists(path, error))
+			return;
+
+		const std::filesystem::path canonical_path = std::filesystem::weakly_canonical(path, error);
+		if (error)
+			return;
+
+		const bool is_directory = std::filesystem::is_directory(canonical_path, error);
+		const std::string directory = is_directory ? canonical_path.string() : canonical_path.parent_path().string();
+
+		std::unique_lock lock(mutex);
+		requested_paths.insert(path);
+
+		if (!watched_paths.insert(canonical_path.string()).second)
+			return;
+
+		// Editors tend to save files by writing a temporary file and renaming it
+		// over the original, which would remove a watch placed on the file itself.
+		// Watching the directory instead catches both ways of saving a file
+		const i32 watch_descriptor = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watch_descriptor == -1)
+		{
+			birb::log_warn("Could not watch ", directory, " for changes");
+			watched_paths.erase(canonical_path.string());
+			requested_paths.erase(path);
+			return;
+		}
+
+		// Adding the same directory again returns the existing watch descriptor
+		watched_directories[watch_descriptor] = directory;
+#else
+		(void)path;
+#endif
+	}
+
+	std::vector<std::string> file_watcher::poll_changes()
+	{
+		std::unique_lock lock(mutex);
+
+		std::vector<std::string> changes;
+		changes.swap(ready_changes);
+		return changes;
+	}
+
+	bool file_watcher::is_supported()
+	{
+#ifdef BIRB_PLATFORM_LINUX
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void file_watcher::watch_loop()
+	{
+#ifdef BIRB_PLATFORM_LINUX
+		std::array<pollfd, 2> poll_fds = {
+			pollfd { .fd = inotify_fd, .events = POLLIN, .revents = 0 },
+			pollfd { .fd = wake_fd, .events = POLLIN, .revents = 0 },
+		};
+
+		// Aligned so that the inotify_event structs can be read in place
+		alignas(inotify_event) std::array<char, 4096> buffer;
+
+		// Block until something happens if there's nothing to debounce
+		i32 timeout = -1;
+
+		while (running)
+		{
+			const i32 ready = poll(poll_fds.data(), poll_fds.size(), timeout);
+
+			if (ready == -1)
+			{
+				if (errno == EINTR)
+					continue;
+
+				birb::log_error("Polling for file changes failed. Files won't be watched anymore");
+				return;
+			}
+
+			if (poll_fds[1].revents & POLLIN)
+				break;
+
+			if (ready > 0 && (poll_fds[0].revents & POLLIN))
+			{
+				ssize_t length = 0;
+				while ((length = read(inotify_fd, buffer.data(), buffer.size())) > 0)
+				{
+					for (ssize_t offset = 0; offset < length;)
+					{
+						const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+						offset += sizeof(inotify_event) + event->len;
+
+						if (event->len == 0 || (event->mask & IN_ISDIR))
+							continue;
+
+						record_change(event->wd, event->name);
+					}
+				}
+			}
+
+			const std::chrono::milliseconds time_left = flush_settled_changes();
+			timeout = time_left.count() > 0 ? static_cast<i32>(time_left.count()) : -1;
+		}
+#endif
+	}
+
+	void file_watcher::record_change(const i32 watch_descriptor, const std::string& file_name)
+	{
+		std::unique_lock lock(mutex);
+
+		if (!watched_directories.contains(watch_descriptor))
+			return;
+
+		const std::string directory = watched_directories.at(watch_descriptor);
+		const std::string path = directory + "/" + file_name;
+
+		// Skip files that are in a watched directory only because
+		// some other file in the same directory is being watched
+		if (!watched_paths.contains(directory) && !watched_paths.contains(path))
+			return;
+
+		pending_changes[path] = std::chrono::steady_clock::now();
+	}
+
+	std::chrono::milliseconds file_watcher::flush_settled_changes()
+	{
+		std::unique_lock lock(mutex);
+
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::milliseconds time_left(0);
+
+		for (auto it = pending_changes.begin(); it != pending_changes.end();)
+		{
+			const std::chrono::milliseconds quiet_time = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second);
+
+			if (quiet_time >= debounce_time)
+			{
+				if (std::find(ready_changes.begin(), ready_changes.end(), it->first) == ready_changes.end())
+					ready_changes.push_back(it->first);
+
+				it = pending_changes.erase(it);
+				continue;
+			}
+
+			const std::chrono::milliseconds remaining = debounce_time - quiet_time;
+			if (time_left.count() == 0 || remaining < time_left)
+				time_left = remaining;
+
+			++it;
+		}
+
+		// Don't go back to blocking indefinitely while there are changes waiting
+		if (!pending_changes.empty() && time_left.count() == 0)
+			time_left = std::chrono::milliseconds(1);
+
+		return time_left;
+	}
+}
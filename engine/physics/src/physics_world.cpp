@@ -8,6 +8,9 @@
 #include "Scene.hpp"
 #include "State.hpp"
 #include "Transform.hpp"
+#include "Vector.hpp"
+
+#include <glm/glm.hpp>
 
 namespace birb
 {
@@ -48,11 +51,20 @@ namespace birb
 			// Update the position and velocity stuff
 			rigidbody.update(deltatime);
 			transform.position = rigidbody.position;
+		}
+
+		// Move the colliders to the world space positions of the
+		// rigidbodies, which can be different if they have a parent
+		current_scene->update_world_matrices();
+
+		const auto collider_view = registry.view<rigidbody, collider::box>();
+		for (const auto& entity : collider_view)
+		{
+			if (!current_scene->has_world_matrix(entity))
+				continue;
 
-			// Update colliders
-			collider::box* box = registry.try_get<collider::box>(entity);
-			if (box)
-				box->set_position(transform.position);
+			const glm::vec4& world_position = current_scene->world_matrix(entity)[3];
+			collider_view.get<collider::box>(entity).set_position(vec3<f32>(world_position.x, world_position.y, world_position.z));
 		}
 	}
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace birb
+{
+	/**
+	 * @brief Axis aligned bounding box
+	 *
+	 * A default constructed bounding box is empty (min > max) and can be
+	 * grown to fit points or other boxes with expand()
+	 */
+	struct bounding_box
+	{
+		glm::vec3 min = glm::vec3(std::numeric_limits<f32>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<f32>::lowest());
+
+		/**
+		 * @return True if the box contains at least a single point
+		 */
+		bool is_valid() const;
+
+		void expand(const glm::vec3& point);
+		void expand(const bounding_box& box);
+
+		glm::vec3 center() const;
+
+		/**
+		 * @brief Half of the size of the box on each axis
+		 */
+		glm::vec3 extents() const;
+
+		/**
+		 * @brief Test if a sphere overlaps the box
+		 */
+		bool intersects_sphere(const glm::vec3& center, const f32 radius) const;
+
+		/**
+		 * @brief Transform the box and fit a new axis aligned box around the result
+		 *
+		 * @param matrix Affine transformation matrix (for example a model matrix)
+		 */
+		bounding_box transformed(const glm::mat4& matrix) const;
+	};
+}
@@ -2,6 +2,7 @@
 
 #include "EditorComponent.hpp"
 #include "EventBus.hpp"
+#include "Frustum.hpp"
 #include "UBO.hpp"
 #include "Vector.hpp"
 #include "Window.hpp"
@@ -44,6 +45,17 @@ namespace birb
 		glm::mat4 orthographic_no_near_clip_projection_matrix() const;
 
 		glm::mat4 view_matrix() const;
+
+		/**
+		 * @brief View frustum for the perspective projection
+		 */
+		birb::frustum perspective_frustum() const;
+
+		/**
+		 * @brief View frustum for the orthographic projection
+		 */
+		birb::frustum orthographic_frustum() const;
+
 		glm::vec3 front_vec() const;
 		glm::vec3 right_vec() const;
 		void process_input(window& window, const timestep& timestep);
@@ -7,9 +7,10 @@ namespace birb
 {
 	struct character
 	{
-		u32			texture_id; // Handle to the OpenGL texture
 		vec2<u32>	size;		// Dimensions of the glyph
 		vec2<i32>	bearing;	// Offset from baseline to top left corner of a glyph
 		i64			advance;	// Offset to the next glyph
+		vec2<f32>	uv_min;		// Top left corner of the glyph in the font atlas
+		vec2<f32>	uv_max;		// Bottom right corner of the glyph in the font atlas
 	};
 }
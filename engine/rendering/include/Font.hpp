@@ -13,17 +13,24 @@ namespace birb
 	class font
 	{
 	public:
-		explicit font(const std::shared_ptr<std::map<char, character>> character_map, const u8 size, const u64 uuid);
+		explicit font(const std::shared_ptr<std::map<char, character>> character_map, const u32 atlas_texture_id, const u8 size, const u64 uuid);
 		~font() = default;
 		font(const font&) = default;
 		font(font&) = default;
 
 		character& get_char(const char c) const;
 		vec2<u32> char_dimensions(const char c) const;
+
+		/**
+		 * @brief Get the texture that all of the glyphs of the font are packed into
+		 */
+		u32 atlas_texture_id() const;
+
 		const u8 size;
 		const u64 uuid;
 
 	private:
 		std::shared_ptr<std::map<char, character>> character_map;
+		u32 _atlas_texture_id;
 	};
 }
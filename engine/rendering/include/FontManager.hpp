@@ -6,11 +6,17 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace birb
 {
 	class font;
+	struct character;
 
 	class font_manager
 	{
@@ -28,7 +34,38 @@ namespace birb
 		 */
 		font load_font(const std::string& font_file, const u8 size);
 
+		/**
+		 * @brief Glyphs of a font packed into an atlas that hasn't been uploaded yet
+		 */
+		struct glyph_atlas
+		{
+			std::shared_ptr<std::map<char, character>> character_map;
+
+			// Single channel pixels of the square atlas
+			std::vector<u8> pixels;
+			u32 atlas_size = 0;
+
+			u8 font_size = 0;
+		};
+
+		/**
+		 * @brief Rasterize the glyphs of a font and pack them into an atlas
+		 *
+		 * Doesn't touch OpenGL, so it can be called from any thread
+		 *
+		 * @return Nothing if the font couldn't be loaded
+		 */
+		std::optional<glyph_atlas> rasterize_font(const std::string& font_file, const u8 size);
+
+		/**
+		 * @brief Upload a rasterized glyph atlas into a texture
+		 */
+		static font upload_font(const glyph_atlas& atlas);
+
 	private:
 		FT_Library ft;
+
+		// The FreeType library object can only be used by one thread at a time
+		std::mutex ft_mutex;
 	};
 }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "BoundingBox.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace birb
+{
+	/**
+	 * @brief View frustum for visibility tests
+	 *
+	 * The planes are extracted from a combined projection * view matrix,
+	 * so the same code works with both perspective and orthographic projections
+	 *
+	 * A default constructed frustum doesn't reject anything
+	 */
+	class frustum
+	{
+	public:
+		frustum();
+		explicit frustum(const glm::mat4& view_projection);
+
+		/**
+		 * @brief Re-extract the frustum planes from a new projection * view matrix
+		 */
+		void update(const glm::mat4& view_projection);
+
+		bool contains(const glm::vec3& point) const;
+
+		/**
+		 * @brief Test if a world space bounding box is at least partially inside of the frustum
+		 *
+		 * The test is conservative. Boxes near the corners of the frustum might
+		 * be reported as visible even if they are slightly outside of it
+		 */
+		bool intersects(const bounding_box& box) const;
+
+		bool intersects_sphere(const glm::vec3& center, const f32 radius) const;
+
+		enum plane
+		{
+			left = 0,
+			right,
+			bottom,
+			top,
+			near_clip,
+			far_clip,
+		};
+
+		static constexpr u8 plane_count = 6;
+
+		/**
+		 * @brief Get a frustum plane in the form of (normal.xyz, distance)
+		 */
+		glm::vec4 get_plane(const plane which) const;
+
+	private:
+		std::array<glm::vec4, plane_count> planes;
+	};
+}
@@ -11,6 +11,7 @@ namespace birb
 		array = 34962,
 		element_array = 34963,
 		uniform = 35345,
+		texture = 35882,
 	};
 
 	enum class gl_usage
@@ -65,6 +66,7 @@ namespace birb
 			{ gl_buffer_type::array, 0 },
 			{ gl_buffer_type::element_array, 0 },
 			{ gl_buffer_type::uniform, 0},
+			{ gl_buffer_type::texture, 0},
 		};
 	};
 }
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "BoundingBox.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace birb
+{
+	struct point_light;
+
+	/**
+	 * @brief Assigns point lights to view space clusters (froxels) for clustered forward shading
+	 *
+	 * The view frustum is split into a grid of tiles on the screen and into
+	 * exponentially growing slices along the view depth. Each light is added
+	 * to the light list of every cluster that its sphere of influence touches,
+	 * so the fragment shader only needs to loop over the lights in the cluster
+	 * that the fragment is in
+	 */
+	class light_clusters
+	{
+	public:
+		static constexpr u16 grid_size_x = 16;
+		static constexpr u16 grid_size_y = 9;
+		static constexpr u16 grid_size_z = 24;
+		static constexpr u32 cluster_count = grid_size_x * grid_size_y * grid_size_z;
+
+		// Lights beyond this limit get dropped from the cluster
+		static constexpr u16 max_lights_per_cluster = 256;
+
+		// Lights are considered to have no effect when their attenuation
+		// goes below this value
+		static constexpr f32 light_cutoff = 5.0f / 256.0f;
+
+		/**
+		 * @brief Assign lights to clusters
+		 *
+		 * @param view_matrix View matrix of the camera
+		 * @param fov Vertical field of view in degrees
+		 * @param aspect_ratio Width / height of the viewport
+		 */
+		void update(const glm::mat4& view_matrix, const f32 fov, const f32 aspect_ratio, const f32 near_clip, const f32 far_clip, const std::vector<point_light>& lights);
+
+		static constexpr u32 cluster_index(const u16 x, const u16 y, const u16 z)
+		{
+			return x + grid_size_x * (y + grid_size_y * z);
+		}
+
+		/**
+		 * @brief Find the depth slice for a positive view space depth
+		 */
+		u16 depth_slice(const f32 view_depth) const;
+
+		/**
+		 * @brief Get the indices of the lights that affect a cluster
+		 */
+		std::span<const u16> cluster_lights(const u32 cluster) const;
+
+		/**
+		 * @brief Light list (offset, count) of each cluster in the light index array
+		 */
+		const std::vector<glm::uvec2>& light_ranges() const;
+		const std::vector<u16>& light_indices() const;
+
+		/**
+		 * @brief View space bounding box of a cluster
+		 */
+		const bounding_box& cluster_bounds(const u32 cluster) const;
+
+		u32 max_cluster_light_count() const;
+
+		// The depth slice of a view depth is floor(log(depth) * slice_scale - slice_bias)
+		f32 slice_scale() const;
+		f32 slice_bias() const;
+
+		/**
+		 * @brief Distance after which the light attenuates below light_cutoff
+		 */
+		static f32 light_radius(const point_light& light);
+
+	private:
+		void update_cluster_bounds(const f32 fov, const f32 aspect_ratio, const f32 near_clip, const f32 far_clip);
+		f32 slice_depth(const u16 slice) const;
+
+		// Projection parameters that the cluster bounds were built for
+		f32 bounds_fov = 0.0f;
+		f32 bounds_aspect_ratio = 0.0f;
+		f32 bounds_near_clip = 0.0f;
+		f32 bounds_far_clip = 0.0f;
+
+		f32 _slice_scale = 0.0f;
+		f32 _slice_bias = 0.0f;
+
+		std::vector<bounding_box> cluster_aabbs = std::vector<bounding_box>(cluster_count);
+
+		// Indices of the clusters for parallel iteration
+		std::vector<u32> cluster_ids;
+
+		// View space center (xyz) and radius (w) of each light
+		std::vector<glm::vec4> view_space_lights;
+
+		// Lights that overlap each depth slice. Only these need to
+		// be tested against the clusters of the slice
+		std::array<std::vector<u16>, grid_size_z> slice_lights;
+
+		// Fixed size light lists that can be filled in parallel.
+		// These get compacted into the light index array
+		std::vector<u16> cluster_light_scratch = std::vector<u16>(cluster_count * max_lights_per_cluster);
+
+		std::vector<glm::uvec2> _light_ranges = std::vector<glm::uvec2>(cluster_count);
+		std::vector<u16> _light_indices;
+		u32 _max_cluster_light_count = 0;
+	};
+}
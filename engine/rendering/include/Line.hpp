@@ -1,17 +1,12 @@
 #pragma once
 
 #include "Color.hpp"
-#include "VAO.hpp"
-#include "VBO.hpp"
 #include "Vector.hpp"
 
 #include <array>
-#include <memory>
 
 namespace birb
 {
-	class vbo;
-
 	class line
 	{
 	public:
@@ -21,14 +16,18 @@ namespace birb
 		line(line&) = default;
 
 		birb::color color;
-		std::shared_ptr<birb::vao> vao;
+
+		/**
+		 * @brief Positions of the two end points
+		 *
+		 * The renderer streams these to the GPU when drawing the line
+		 */
+		const std::array<f32, 6>& vertices() const;
 
 	private:
 		void update_verts();
 
-		std::array<f32, 6> vertices;
+		std::array<f32, 6> _vertices;
 		vec3<f32> point_a, point_b;
-
-		std::shared_ptr<birb::vbo> vbo;
 	};
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BoundingBox.hpp"
 #include "GLBuffer.hpp"
 #include "Material.hpp"
 
@@ -18,6 +19,15 @@ namespace birb
 		glm::vec2 tex_coords;
 	};
 
+	/**
+	 * @brief Range of a single level of detail in the index buffer of a mesh
+	 */
+	struct mesh_lod
+	{
+		u32 first_index = 0;
+		u32 index_count = 0;
+	};
+
 	struct mesh_texture
 	{
 		u32 id;
@@ -28,27 +38,127 @@ namespace birb
 	class mesh
 	{
 	public:
-		mesh(const std::vector<vertex>& vertices, const std::vector<u32>& indices, const std::vector<mesh_texture>& textures, const material& material, const std::string& material_name, const std::string& name);
+		/**
+		 * @param lod_indices Index lists for the lower levels of detail. These get appended
+		 *                    after the full detail indices into the same index buffer
+		 * @param packed_vertices Upload the vertices in the 16 byte packed_vertex format
+		 *                        instead of full floats. The vertices member keeps the full floats
+		 */
+		mesh(const std::vector<vertex>& vertices, const std::vector<u32>& indices, const std::vector<mesh_texture>& textures, const material& material, const std::string& material_name, const std::string& name, const std::vector<std::vector<u32>>& lod_indices = {}, const bool packed_vertices = false);
 		void destroy();
 
 		void draw(shader& shader, renderer_stats& render_stats, const bool skip_materials = false);
 
+		/**
+		 * @brief Bind the textures of the mesh and point the shader material samplers to them
+		 */
+		void bind_textures(shader& shader) const;
+
+		/**
+		 * @brief Set the vertex decoding uniforms of the shader for the vertex format of the mesh
+		 *
+		 * Needs to be called before drawing the mesh with a shader that
+		 * was last used for a mesh with a different vertex format or bounds
+		 */
+		void apply_vertex_format(shader& shader) const;
+
+		/**
+		 * @brief Call glDrawElements() for the mesh
+		 *
+		 * The VAO of the mesh needs to be bound before calling this
+		 *
+		 * @param lod Level of detail to draw. Levels that the mesh doesn't have fall back to the lowest one
+		 */
+		void draw_elements(renderer_stats& render_stats, const u8 lod = 0) const;
+
+		/**
+		 * @brief Call glDrawElementsInstanced() for the mesh
+		 *
+		 * The VAO of the mesh needs to be bound and the instance
+		 * attributes set up before calling this
+		 *
+		 * @param lod Level of detail to draw. Levels that the mesh doesn't have fall back to the lowest one
+		 */
+		void draw_elements_instanced(const u32 instance_count, renderer_stats& render_stats, const u8 lod = 0) const;
+
+		/**
+		 * @brief Get the index range of a level of detail
+		 *
+		 * Levels past the lowest level of detail of the mesh return the lowest level
+		 */
+		mesh_lod lod(const u8 level) const;
+
+		/**
+		 * @return Amount of levels of detail including the full detail mesh
+		 */
+		u8 lod_count() const;
+
+		u32 vao_id() const;
+
+		/**
+		 * @return True if the index buffer uses 16-bit indices
+		 */
+		bool has_short_indices() const;
+
+		/**
+		 * @return True if the vertex buffer uses the packed_vertex format
+		 */
+		bool has_packed_vertices() const;
+
+		/**
+		 * @brief A hash generated from the ids of the textures used by the mesh
+		 *
+		 * Meshes that use the same set of textures will have the same hash
+		 */
+		u64 texture_set_hash() const;
+
+		/**
+		 * @return True if both meshes use the exact same textures in the same order
+		 */
+		bool shares_textures_with(const mesh& other) const;
+
 		std::vector<vertex> vertices;
 		std::vector<u32> indices;
 		std::vector<mesh_texture> textures;
 
+		// Highest amount of levels of detail that a mesh can have
+		static constexpr u8 max_lod_count = 4;
+
 		std::string material_name;
 		birb::material material;
 
+		/**
+		 * @brief Local space bounds of the mesh vertices
+		 */
+		bounding_box bounds;
+
+		/**
+		 * @brief Average cache miss ratio of the indices before and after optimizing them
+		 *
+		 * Both are zero if the mesh wasn't optimized
+		 */
+		f32 unoptimized_acmr = 0.0f;
+		f32 optimized_acmr = 0.0f;
+
 		/**
 		 * @brief Name of the mesh
 		 */
 		const std::string name;
 
 	private:
-		void setup_mesh();
+		void setup_mesh(const std::vector<std::vector<u32>>& lod_indices);
 
 		gl_buffer vbo, ebo;
 		u32 vao;
+
+		// Type of the indices in the index buffer (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+		u32 index_type = 0;
+		u8 index_size = 0;
+
+		bool packed_vertices = false;
+
+		// Index ranges of the levels of detail. The first one is the full detail mesh
+		std::vector<mesh_lod> lods;
+		u64 texture_hash = 0;
 	};
 }
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <span>
+#include <vector>
+
+namespace birb
+{
+	struct vertex;
+
+	/**
+	 * @brief Reordering of mesh data for faster drawing on the GPU
+	 *
+	 * The functions are meant to be run in the order they are declared in.
+	 * None of them change the triangles themselves, only their order
+	 * and the order of the vertices
+	 */
+	namespace mesh_optimizer
+	{
+		/**
+		 * @brief Merge vertices that have the exact same attributes
+		 *
+		 * Unused vertices are dropped too
+		 */
+		void weld_vertices(std::vector<vertex>& vertices, std::vector<u32>& indices);
+
+		/**
+		 * @brief Reorder triangles so that vertices get reused from the post-transform cache
+		 *
+		 * Uses the linear-speed vertex cache optimization by Tom Forsyth
+		 */
+		void optimize_vertex_cache(std::vector<u32>& indices, const size_t vertex_count);
+
+		/**
+		 * @brief Reorder clusters of triangles so that the outer surfaces of the mesh get drawn first
+		 *
+		 * Run this after optimize_vertex_cache(). The triangles are split into clusters
+		 * along the boundaries where the vertex cache gets flushed anyway, so the cache
+		 * efficiency only gets slightly worse (Sander, Nehab & Barczak 2007)
+		 *
+		 * @param threshold How much the average cache miss ratio is allowed to grow.
+		 *                  For example 1.05 allows 5% more cache misses
+		 */
+		void optimize_overdraw(std::vector<u32>& indices, std::span<const vertex> vertices, const f32 threshold);
+
+		/**
+		 * @brief Reorder vertices into the order they are first used in
+		 *
+		 * Makes the vertex fetches read memory linearly
+		 */
+		void optimize_vertex_fetch(std::vector<vertex>& vertices, std::vector<u32>& indices);
+
+		/**
+		 * @brief Average cache miss ratio
+		 *
+		 * Simulates a FIFO post-transform cache and counts how many vertices need
+		 * to be transformed per triangle. The result is between 0.5 (best case for
+		 * large regular meshes) and 3.0 (no vertex ever gets reused)
+		 *
+		 * @param cache_size Amount of vertices that fit into the simulated cache
+		 */
+		f32 acmr(std::span<const u32> indices, const size_t vertex_count, const u32 cache_size = 16);
+	}
+}
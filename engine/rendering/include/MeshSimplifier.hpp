@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <span>
+#include <vector>
+
+namespace birb
+{
+	struct vertex;
+
+	/**
+	 * @brief Triangle mesh simplification for generating levels of detail
+	 */
+	namespace mesh_simplifier
+	{
+		/**
+		 * @brief Reduce the triangle count of an indexed triangle mesh
+		 *
+		 * Uses quadric error metric edge collapses (Garland & Heckbert). Each collapse
+		 * moves one end of an edge onto the other one, so the result only references
+		 * the original vertices and can share the vertex buffer with the full mesh.
+		 * Vertices with the same position are treated as a single vertex, so texture
+		 * seams don't stop the simplification. Vertices on open borders are never moved
+		 *
+		 * @param vertices Vertices of the mesh
+		 * @param indices Triangle list indices into the vertices
+		 * @param target_index_count The simplification stops when the index count reaches this
+		 * @param max_error Largest allowed collapse error relative to the size of the mesh bounds.
+		 *                  The simplification stops before reaching the target if all of the
+		 *                  remaining collapses would be more expensive than this
+		 * @return Triangle list indices into the original vertices
+		 */
+		std::vector<u32> simplify(std::span<const vertex> vertices, std::span<const u32> indices, const size_t target_index_count, const f32 max_error);
+
+		/**
+		 * @brief Generate index buffers for the lower levels of detail of a mesh
+		 *
+		 * Each level has roughly half of the triangles of the previous one. Levels that
+		 * wouldn't remove enough triangles to be worth it are left out, so the result
+		 * might have less than lod_count - 1 levels. Small meshes don't get any levels
+		 *
+		 * @param lod_count Amount of levels including the full detail mesh
+		 * @return Index buffers for the levels 1 to lod_count - 1
+		 */
+		std::vector<std::vector<u32>> generate_lods(std::span<const vertex> vertices, std::span<const u32> indices, const u8 lod_count);
+	}
+}
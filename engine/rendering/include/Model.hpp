@@ -1,6 +1,10 @@
 #pragma once
 
+#include "BoundingBox.hpp"
 #include "EditorComponent.hpp"
+#include "Image.hpp"
+#include "Material.hpp"
+#include "Mesh.hpp"
 #include "PrimitiveMeshes.hpp"
 #include "Shader.hpp"
 
@@ -10,11 +14,10 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace birb
 {
-	class mesh;
-	struct mesh_texture;
 	struct renderer_stats;
 
 	class model : public editor_component
@@ -31,9 +34,62 @@ namespace birb
 		void draw_editor_ui() override;
 		std::string collapsing_header_name() const override;
 
+		/**
+		 * @brief CPU-side contents of a model file
+		 *
+		 * Importing reads the file, optimizes the meshes and decodes the textures
+		 * without touching OpenGL, so it can be done on any thread
+		 */
+		struct import_data
+		{
+			struct mesh_data
+			{
+				std::string name;
+				std::vector<vertex> vertices;
+				std::vector<u32> indices;
+				std::vector<std::vector<u32>> lod_indices;
+				birb::material material;
+				std::string material_name;
+
+				// Indices to the textures of the import
+				std::vector<size_t> texture_indices;
+
+				f32 unoptimized_acmr = 0.0f;
+			};
+
+			struct texture_data
+			{
+				// Path relative to the model directory
+				std::string path;
+				std::string type;
+				asset::image image;
+			};
+
+			std::string path;
+			std::string directory;
+			std::filesystem::file_time_type write_time;
+			std::vector<mesh_data> meshes;
+			std::vector<texture_data> textures;
+
+			// False if the file couldn't be read
+			bool success = false;
+		};
+
+		/**
+		 * @brief Read a model file into memory without uploading it
+		 *
+		 * Safe to call from any thread. Pass the result to load_model() on the main thread
+		 */
+		static std::shared_ptr<import_data> import_file(const std::string& path);
+
 		std::string model_file_path();
 		void load_model();
 		void load_model(const std::string& path);
+
+		/**
+		 * @brief Upload an imported model file
+		 */
+		void load_model(const import_data& data);
 		void load_model_from_memory(const primitive_mesh mesh, const std::string& name = "unknown");
 
 		/**
@@ -44,18 +100,89 @@ namespace birb
 		 */
 		mesh* get_mesh_by_name(const std::string& mesh_name);
 
+		/**
+		 * @brief Get all of the meshes in the model
+		 */
+		const std::vector<mesh>& get_meshes() const;
+
 		/**
 		 * @brief Reload the model file only if the file has been modified
 		 *
 		 * Note: Only the timestamp of the latest modification is checked.
 		 *       Do not use this method if you changed the file path
+		 *
+		 * The old meshes are kept if the file can't be imported
+		 *
+		 * @param force Reload even if the model file hasn't been modified. Needed when
+		 *              only the material or texture files of the model have changed
+		 * @return True if the model was reloaded
 		 */
-		void reload();
+		bool reload(const bool force = false);
+
+		/**
+		 * @brief Update a copy of a model after another copy has been reloaded
+		 *
+		 * Copies share their meshes, so reloading one of them replaces the meshes of
+		 * all of them. The vertex count, bounds and levels of detail are per copy though
+		 */
+		void refresh_shared_state(const model& reloaded);
+
+		/**
+		 * @brief Files that the model gets loaded from
+		 *
+		 * Includes the model file, a material library with the same name
+		 * if there is one and the material textures
+		 */
+		std::vector<std::string> dependencies() const;
 
 		void destroy();
 
+		/**
+		 * @brief Upload the meshes in the 16 byte packed vertex format instead of full floats
+		 *
+		 * Halves the vertex memory and bandwidth at the cost of a tiny loss in precision.
+		 * Meshes that have already been loaded get reloaded in the new format
+		 */
+		void opt_packed_vertices(const bool enabled);
+		bool is_packed_vertices_enabled() const;
+
 		u32 vertex_count() const;
 
+		/**
+		 * @brief Local space bounds that cover all of the meshes in the model
+		 */
+		const bounding_box& bounds() const;
+
+		/**
+		 * @brief Pick the level of detail that the meshes of the model should be drawn with
+		 *
+		 * @param screen_size Diameter of the model bounds relative to the viewport height
+		 * @return The picked level of detail
+		 */
+		u8 select_lod(const f32 screen_size);
+
+		/**
+		 * @brief Level of detail picked by the latest select_lod() call
+		 */
+		u8 lod() const;
+
+		/**
+		 * @brief Highest amount of levels of detail that any of the meshes in the model have
+		 */
+		u8 lod_count() const;
+
+		/**
+		 * @brief Pick the level of detail for a screen size
+		 *
+		 * The screen size needs to get a bit past a threshold before the level changes,
+		 * so that models close to a threshold don't flicker between two levels
+		 *
+		 * @param current The level of detail that is currently in use
+		 * @param lod_count Amount of levels of detail available
+		 * @param screen_size Diameter of the model bounds relative to the viewport height
+		 */
+		static u8 next_lod(const u8 current, const u8 lod_count, const f32 screen_size);
+
 		template<class Archive>
 		void serialize(Archive& ar)
 		{
@@ -65,13 +192,21 @@ namespace birb
 	private:
 		static inline const std::string editor_header_name = "Model";
 
-		void process_node(aiNode* node, const aiScene* scene);
-		mesh process_mesh(aiMesh* ai_mesh, const aiScene* scene);
-		std::vector<mesh_texture> load_material_textures(aiMaterial* mat, aiTextureType type, std::string type_name);
+		static void process_node(aiNode* node, const aiScene* scene, import_data& data);
+		static import_data::mesh_data process_mesh(aiMesh* ai_mesh, const aiScene* scene, import_data& data);
+
+		// Decodes the textures that haven't been decoded yet and returns their indices in the import data
+		static std::vector<size_t> load_material_textures(aiMaterial* mat, aiTextureType type, std::string type_name, import_data& data);
+
+		// Create the meshes and textures of imported model data
+		void upload_meshes(const import_data& data);
 
 		std::shared_ptr<std::vector<mesh_texture>> textures_loaded;
 		std::shared_ptr<std::vector<mesh>> meshes;
 
+		// Shared like the meshes, so that all copies agree on the vertex format
+		std::shared_ptr<bool> packed_vertices;
+
 		std::filesystem::file_time_type last_write_time;
 
 		std::string directory;
@@ -90,6 +225,10 @@ namespace birb
 		static inline const std::string null_path = "...";
 
 		u32 vert_count = 0;
+		bounding_box local_bounds;
+
+		u8 current_lod = 0;
+		u8 max_lod_count = 0;
 
 		// Editor stuff
 		std::string text_box_model_file_path = "";
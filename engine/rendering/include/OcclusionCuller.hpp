@@ -0,0 +1,145 @@
+#pragma once
+
+#include "BoundingBox.hpp"
+#include "Types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace birb
+{
+	struct vertex;
+
+	/**
+	 * @brief Marks a 3D model as an occluder for the occlusion culling
+	 *
+	 * Occluders should be large and simple meshes like walls and floors,
+	 * since every triangle of the model gets rasterized on the CPU
+	 */
+	struct occluder
+	{
+		// Disabled occluders are drawn and culled like any other model
+		bool enabled = true;
+	};
+
+	/**
+	 * @brief Software rasterized occlusion culling
+	 *
+	 * Occluder triangles are rasterized into a low resolution depth buffer on
+	 * the CPU, so it works without a GPU and doesn't need any read backs. The
+	 * triangles are binned into screen tiles and the tiles are rasterized in
+	 * parallel with SSE2 when it is available.
+	 *
+	 * The depth buffer is reduced into a hierarchy of min and max depths.
+	 * Bounding boxes are tested against the coarsest level where the box covers
+	 * at most 2x2 texels and the finer levels are only visited for the texels
+	 * that the coarse level can't decide
+	 *
+	 * Depth values are normalized device depths remapped to [0, 1], where 1 is the far plane
+	 */
+	class occlusion_culler
+	{
+	public:
+		static constexpr u16 width = 256;
+		static constexpr u16 height = 128;
+		static constexpr u16 tile_size = 32;
+		static constexpr u16 tile_count_x = width / tile_size;
+		static constexpr u16 tile_count_y = height / tile_size;
+
+		// Levels down to a single texel
+		static constexpr u8 level_count = 9;
+
+		static_assert(width % tile_size == 0 && height % tile_size == 0);
+		static_assert(tile_size % 4 == 0, "The rasterizer processes four pixels at a time");
+		static_assert((width >> (level_count - 1)) == 1);
+
+		occlusion_culler();
+
+		/**
+		 * @brief Clear the depth buffer and the occluders for a new frame
+		 *
+		 * @param view_projection Projection * view matrix of the camera
+		 */
+		void begin(const glm::mat4& view_projection);
+
+		/**
+		 * @brief Queue the triangles of an occluder mesh for rasterization
+		 *
+		 * @param vertices Vertices of the mesh
+		 * @param indices Triangle list indices into the vertices
+		 * @param model_matrix World matrix of the mesh
+		 */
+		void add_occluder(std::span<const vertex> vertices, std::span<const u32> indices, const glm::mat4& model_matrix);
+
+		/**
+		 * @brief Rasterize the queued occluders and build the depth hierarchy
+		 */
+		void rasterize();
+
+		/**
+		 * @brief Test if a world space bounding box might be visible
+		 *
+		 * The test is conservative. Boxes that cross the near plane or are completely
+		 * outside of the screen are reported as visible, since those are left
+		 * for the frustum culling to deal with
+		 */
+		bool is_visible(const bounding_box& box) const;
+
+		/**
+		 * @brief Depth of a pixel in the full resolution depth buffer
+		 */
+		f32 depth(const u16 x, const u16 y) const;
+
+		/**
+		 * @brief Amount of triangles that were queued since begin()
+		 */
+		u32 triangle_count() const;
+
+	private:
+		// Screen space triangle with the depth as a plane equation
+		struct screen_triangle
+		{
+			glm::vec2 vertices[3];
+			f32 depth_origin;
+			f32 depth_dx;
+			f32 depth_dy;
+		};
+
+		void add_triangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+		void add_screen_triangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+		void rasterize_tile(const u16 tile);
+		void build_hierarchy();
+		bool is_region_visible(const u8 level, const glm::ivec2 min, const glm::ivec2 max, const f32 box_depth) const;
+
+		static constexpr u16 level_width(const u8 level)
+		{
+			return std::max(width >> level, 1);
+		}
+
+		static constexpr u16 level_height(const u8 level)
+		{
+			return std::max(height >> level, 1);
+		}
+
+		glm::mat4 view_projection;
+
+		std::vector<screen_triangle> triangles;
+
+		// Indices of the triangles that overlap each tile
+		std::array<std::vector<u32>, tile_count_x * tile_count_y> tile_bins;
+
+		// Indices of the tiles for parallel iteration
+		std::array<u16, tile_count_x * tile_count_y> tile_ids;
+
+		// Clip space vertices of the occluder that is being added
+		std::vector<glm::vec4> clip_vertices;
+
+		// Level 0 of the max depths is the full resolution depth buffer. The
+		// min depths don't have a level 0, since it would be the same buffer
+		std::array<std::vector<f32>, level_count> min_depths;
+		std::array<std::vector<f32>, level_count> max_depths;
+	};
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "BoundingBox.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace birb
+{
+	struct vertex;
+
+	/**
+	 * @brief Compact 16 byte version of the 32 byte mesh vertex
+	 *
+	 * Positions are stored as normalized 16-bit integers relative to the mesh bounds,
+	 * normals are octahedral encoded into two normalized 16-bit integers and texture
+	 * coordinates are half floats. Shaders decode the positions and normals with the
+	 * functions in include/vertex.glsl
+	 */
+	struct packed_vertex
+	{
+		// The fourth component is padding
+		std::array<u16, 4> position;
+		std::array<i16, 2> normal;
+		std::array<u16, 2> tex_coords;
+	};
+
+	static_assert(sizeof(packed_vertex) == 16);
+
+	namespace vertex_packing
+	{
+		/**
+		 * @param bounds Bounds of the mesh that the vertex belongs to
+		 */
+		packed_vertex pack(const vertex& vertex, const bounding_box& bounds);
+
+		/**
+		 * @brief Decode a packed vertex the same way as the shaders do it
+		 */
+		vertex unpack(const packed_vertex& packed, const bounding_box& bounds);
+
+		/**
+		 * @brief Map a unit vector onto an octahedron that is unfolded into the [-1, 1] square
+		 */
+		glm::vec2 encode_octahedral(const glm::vec3& normal);
+		glm::vec3 decode_octahedral(const glm::vec2& encoded);
+
+		/**
+		 * @brief Convert a float into an IEEE 754 half float with round to nearest even
+		 */
+		u16 float_to_half(const f32 value);
+		f32 half_to_float(const u16 value);
+	}
+}
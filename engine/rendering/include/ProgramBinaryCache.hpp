@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace birb
+{
+	/**
+	 * @brief On-disk cache for linked shader programs
+	 *
+	 * Linked programs are saved with glGetProgramBinary() and loaded back with
+	 * glProgramBinary() on the next start, which skips compiling and linking.
+	 * Program binaries only work with the driver that created them, so the
+	 * driver vendor, renderer and version strings are a part of the cache key.
+	 *
+	 * Requires OpenGL 4.1 or GL_ARB_get_program_binary. Without either of them
+	 * all of the functions that touch OpenGL do nothing
+	 */
+	namespace program_binary_cache
+	{
+		/**
+		 * @brief Set to false to always compile shaders from source
+		 */
+		inline bool enabled = true;
+
+		/**
+		 * @brief Directory where the program binaries get stored
+		 *
+		 * If left empty, a directory in the user cache directory is used
+		 */
+		inline std::string directory;
+
+		/**
+		 * @brief Contents of a cached program binary file
+		 */
+		struct program_binary
+		{
+			u32 format = 0;
+			std::vector<u8> data;
+		};
+
+		/**
+		 * @brief Hash the final shader sources and the driver string into a cache key
+		 */
+		u64 key(const std::string_view vertex_src, const std::string_view fragment_src, const std::string_view driver);
+
+		/**
+		 * @brief Path to the cache file of a key
+		 */
+		std::string file_path(const u64 key);
+
+		/**
+		 * @return False if the file couldn't be opened for writing
+		 */
+		bool write_file(const std::string& path, const u64 key, const program_binary& binary);
+
+		/**
+		 * @brief Read a program binary that was written with write_file()
+		 *
+		 * @return False if the file doesn't exist, is truncated or belongs to a different key
+		 */
+		bool read_file(const std::string& path, const u64 key, program_binary& binary);
+
+		/**
+		 * @brief Check if the driver can save and load program binaries
+		 */
+		bool is_supported();
+
+		/**
+		 * @brief Vendor, renderer and version strings of the current OpenGL context
+		 */
+		std::string driver_string();
+
+		/**
+		 * @brief Create a program from a cached binary
+		 *
+		 * @return The new program or 0 if there was no binary or the driver rejected it
+		 */
+		u32 load_program(const u64 key);
+
+		/**
+		 * @brief Ask the driver to keep the binary of a program available
+		 *
+		 * Call this before the program gets linked
+		 */
+		void prepare_program(const u32 program);
+
+		/**
+		 * @brief Save the binary of a successfully linked program
+		 */
+		void store_program(const u64 key, const u32 program);
+
+		/**
+		 * @brief Delete all of the cached program binaries
+		 */
+		void clear();
+
+		size_t hits();
+		size_t misses();
+	}
+}
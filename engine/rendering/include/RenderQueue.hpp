@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace birb
+{
+	/**
+	 * @brief List of draw commands that can be sorted by render state
+	 *
+	 * Each command has a 64-bit sort key that encodes the state it needs
+	 * (shader, material, textures etc.) with the most expensive state change
+	 * in the highest bits. Sorting the queue places draws that share state
+	 * next to each other, so that redundant state changes can be skipped
+	 * when the commands are executed
+	 */
+	class render_queue
+	{
+	public:
+		struct command
+		{
+			u64 key;
+
+			// Indices that point to the data that should be drawn.
+			// The meaning of these is up to the user of the queue
+			u32 index;
+			u32 sub_index;
+		};
+
+		void push(const u64 key, const u32 index, const u32 sub_index = 0);
+
+		/**
+		 * @brief Sort the commands by their keys in ascending order
+		 *
+		 * Uses a stable LSD radix sort, so commands with identical keys keep
+		 * the order they were pushed in
+		 */
+		void sort();
+
+		void clear();
+		size_t size() const;
+		bool empty() const;
+
+		const std::vector<command>& commands() const;
+
+		/**
+		 * @brief Mask a value to the given bit count and shift it into place in a sort key
+		 */
+		static constexpr u64 key_field(const u64 value, const u8 bit_count, const u8 offset)
+		{
+			const u64 mask = bit_count >= 64 ? ~0ull : (1ull << bit_count) - 1;
+			return (value & mask) << offset;
+		}
+
+		/**
+		 * @brief Convert a float into an unsigned integer that sorts in the same order
+		 */
+		static u32 sortable_float(const f32 value);
+
+		/**
+		 * @brief Quantize a depth value to the given amount of bits
+		 *
+		 * The result keeps the ordering of the depth values, but values
+		 * close to each other might end up in the same bucket
+		 */
+		static u32 depth_bits(const f32 depth, const u8 bit_count);
+
+	private:
+		std::vector<command> queue;
+
+		// Temporary storage used by the radix sort. Kept around
+		// to avoid allocating memory every frame
+		std::vector<command> sort_buffer;
+	};
+}
@@ -4,10 +4,18 @@
 #include "DebugView.hpp"
 #include "EventBus.hpp"
 #include "FBO.hpp"
+#include "GLBuffer.hpp"
+#include "Frustum.hpp"
+#include "LightClusters.hpp"
 #include "MimicSprite.hpp"
+#include "OcclusionCuller.hpp"
+#include "RenderQueue.hpp"
 #include "RendererStats.hpp"
 #include "ShaderRef.hpp"
+#include "ShadowCascades.hpp"
 #include "Sprite.hpp"
+#include "StreamBuffer.hpp"
+#include "TBO.hpp"
 #include "Types.hpp"
 #include "UBO.hpp"
 #include "VAO.hpp"
@@ -21,6 +29,8 @@ namespace birb
 {
 	class camera;
 	class ebo;
+	class file_watcher;
+	class model;
 	class scene;
 	class window;
 
@@ -57,6 +67,19 @@ namespace birb
 
 		void draw_entities(const camera& camera, vec2<i32> window_size);
 
+		/**
+		 * @brief Upload the directional light and point lights to the GPU
+		 *
+		 * This gets called by draw_entities(), so it only needs to be called
+		 * manually when drawing things without it. The light buffers are
+		 * only updated if the lights have changed since the previous call,
+		 * but the light clusters get rebuilt every time
+		 *
+		 * @param camera The camera that the lights get clustered for
+		 * @param viewport_size Size of the viewport in pixels
+		 */
+		void update_lights(const camera& camera, const vec2<i32> viewport_size);
+
 		/**
 		 * @brief Call glDrawElements() while using the previously bound VAO
 		 */
@@ -110,8 +133,60 @@ namespace birb
 
 		/**
 		 * @brief Enable shadows for the 3D rendering pass
+		 *
+		 * The directional light casts shadows with cascaded shadow maps
 		 */
 		void opt_shadows(const bool enabled);
+		bool is_shadows_enabled() const;
+
+		/**
+		 * @brief Skip 3D models that are outside of the camera view frustum
+		 */
+		void opt_frustum_culling(const bool enabled);
+		bool is_frustum_culling_enabled() const;
+
+		/**
+		 * @brief Skip 3D models that are hidden behind occluders
+		 *
+		 * Models with an enabled occluder component get rasterized into a depth
+		 * buffer on the CPU and the bounds of the other visible models are tested
+		 * against it. Only pays off if the occluders hide a lot of models
+		 */
+		void opt_occlusion_culling(const bool enabled);
+		bool is_occlusion_culling_enabled() const;
+
+		/**
+		 * @brief Draw 3D models with simplified meshes when they cover a small part of the screen
+		 *
+		 * Only meshes that got levels of detail generated when loading them are affected
+		 */
+		void opt_lod(const bool enabled);
+		bool is_lod_enabled() const;
+
+		/**
+		 * @brief Draw 3D models that share the same meshes, shader and material with a single instanced draw call
+		 *
+		 * Only shaders that have an instanced variant can be instanced
+		 */
+		void opt_instancing(const bool enabled);
+		bool is_instancing_enabled() const;
+
+		/**
+		 * @brief Merge sprites that share a texture and projection into instanced draw calls
+		 *
+		 * Applies to normal and mimic sprites. Sprites are still drawn back to front,
+		 * so a batch only spans sprites that are next to each other in the draw order
+		 */
+		void opt_sprite_batching(const bool enabled);
+		bool is_sprite_batching_enabled() const;
+
+		/**
+		 * @brief Assign point lights to view space clusters so that each fragment only shades the lights near it
+		 *
+		 * Without clustering every fragment loops over every point light
+		 */
+		void opt_clustered_lighting(const bool enabled);
+		bool is_clustered_lighting_enabled() const;
 
 		/**
 		 * @brief OpenGL alpha blending
@@ -134,6 +209,16 @@ namespace birb
 		void opt_post_process(const bool enabled);
 		bool is_post_processing_enabled() const;
 
+		/**
+		 * @brief Reload external shaders, models and sprite textures when their files change
+		 *
+		 * The files are watched on a background thread and the changes get applied
+		 * at the start of draw_entities(). Only the assets whose files changed get
+		 * reloaded. File watching is only supported on Linux
+		 */
+		void opt_hot_reload(const bool enabled);
+		bool is_hot_reload_enabled() const;
+
 	private:
 		/////////////////////////////////////////////////////////////////////////
 		// The different draw functions are defined in their own source files:
@@ -148,24 +233,42 @@ namespace birb
 		// 2D drawing funcs
 		template<typename T>
 		void set_sprite_aspect_ratio_uniforms(const T& sprite, shader& texture_shader)
+		{
+			texture_shader.set(shader_uniforms::texture::aspect_ratio, sprite_aspect_ratio(sprite));
+		}
+
+		template<typename T>
+		static glm::vec2 sprite_aspect_ratio(const T& sprite)
 		{
 			static_assert(std::is_same<T, birb::sprite>::value || std::is_same<T, birb::mimic_sprite>::value);
 			if (sprite.ignore_aspect_ratio)
-				texture_shader.set(shader_uniforms::texture::aspect_ratio, { 1.0f, 1.0f });
-			else
-				// Modify the sprite shape based on if we want to respect the aspect ratio width or height wise
-				if (sprite.aspect_ratio_lock == aspect_ratio_lock::width)
-					texture_shader.set(shader_uniforms::texture::aspect_ratio, { sprite.texture->aspect_ratio(), 1.0f });
+				return { 1.0f, 1.0f };
+
+			// Sprites might only show a part of their texture
+			const f32 aspect_ratio = [&sprite]
+			{
+				if constexpr (std::is_same<T, birb::sprite>::value)
+					return sprite.aspect_ratio();
 				else
-					texture_shader.set(shader_uniforms::texture::aspect_ratio, { 1.0f, sprite.texture->aspect_ratio_reverse() });
+					return sprite.texture->aspect_ratio();
+			}();
+
+			// Modify the sprite shape based on if we want to respect the aspect ratio width or height wise
+			if (sprite.aspect_ratio_lock == aspect_ratio_lock::width)
+				return { aspect_ratio, 1.0f };
+			else
+				return { 1.0f, 1.0f / aspect_ratio };
 		}
+
 		void draw_sprites(std::shared_ptr<shader> texture_shader);
 		void draw_sprites_instanced(std::shared_ptr<shader> texture_shader);
 		void draw_mimic_sprites(std::shared_ptr<shader> texture_shader);
 		void draw_shader_sprites();
+		void draw_sprite_batches();
 
 		// 3D drawing funcs
 		void draw_models();
+		void draw_shadow_maps();
 		void draw_box_collider_view();
 
 		// screenspace drawing funcs
@@ -182,10 +285,92 @@ namespace birb
 		bool debug_widgets_enabled = false;
 		bool debug_overlays_enabled = false;
 		bool shadows_enabled = true;
+		bool frustum_culling_enabled = true;
+		bool occlusion_culling_enabled = false;
+		bool lod_enabled = true;
+		bool instancing_enabled = true;
+		bool sprite_batching_enabled = true;
+		bool clustered_lighting_enabled = true;
 		shader_ref line_shader;
 
+		// View frustum of the camera that is currently being used for drawing.
+		// Gets updated at the start of draw_entities()
+		frustum view_frustum;
+
+		// Software depth buffer for the occlusion culling. Gets cleared at the
+		// start of draw_entities() and filled in draw_models()
+		occlusion_culler occlusion;
+
+		// View matrix of the camera that is currently being used for drawing.
+		// Used for calculating depth values for the render queue sort keys
+		glm::mat4 current_view_matrix;
+
+		// Scales a view space radius divided by depth into a fraction of the viewport height.
+		// Used for picking the levels of detail for 3D models
+		f32 lod_projection_scale = 1.0f;
+
+		// Draw command queues. These get refilled every frame, but are kept
+		// around to avoid re-allocating memory
+		render_queue model_queue;
+		render_queue sprite_queue;
+		render_queue text_queue;
+
 		// Uniform buffer objects //
 		birb::ubo view_matrix_ubo;
+		birb::ubo light_info_ubo;
+
+		// Lighting buffers that are too large for uniform blocks
+		birb::tbo point_light_tbo;
+		birb::tbo cluster_range_tbo;
+		birb::tbo cluster_index_tbo;
+
+		light_clusters clusters;
+
+		// Light data that was last uploaded to the lighting buffers.
+		// The point light staging array is kept around to avoid re-allocating it
+		std140::light_info uploaded_light_info;
+		std::vector<std140::point_light> uploaded_point_lights;
+		std::vector<std140::point_light> point_light_staging;
+		bool lights_uploaded = false;
+
+		// Vertex and instance data that gets rebuilt every frame
+		stream_buffer vertex_stream;
+
+		// Per-frame model matrices for instanced 3D models
+		std::vector<glm::mat4> model_instance_matrices;
+
+		// Minimum amount of identical models that gets drawn with instancing
+		static constexpr u32 instancing_threshold = 2;
+
+		// First vertex attribute location of the per-instance model matrix.
+		// A mat4 takes up four consecutive locations
+		static constexpr u8 instance_matrix_layout = 5;
+
+
+		/////////////
+		// Shadows //
+		/////////////
+
+		struct shadow_caster
+		{
+			const birb::model* model = nullptr;
+			glm::mat4 model_matrix;
+			bounding_box bounds;
+			u8 lod = 0;
+		};
+
+		shadow_cascades cascades;
+
+		// Shadow maps of the cascades. These get created when shadows are drawn for the first time
+		std::array<std::unique_ptr<birb::fbo>, shadow_cascades::cascade_count> shadow_map_fbos;
+
+		shader_ref shadow_depth_shader_ref;
+
+		// Active models with bounds. Refilled every frame
+		std::vector<shadow_caster> shadow_casters;
+
+		// Per-frame model matrices for the instanced shadow caster draws of all cascades
+		std::vector<glm::mat4> shadow_instance_matrices;
 
 		renderer_stats render_stats;
 
@@ -255,6 +440,8 @@ namespace birb
 		////////////////////////////////////
 
 		shader_ref texture_shader_ref;
+		shader_ref instanced_texture_shader_ref;
+		shader_ref batched_texture_shader_ref;
 
 		// Vertices and texture coordinates for a square
 		static constexpr std::array<f32, 4 * 3 + 4 * 2> quad_vertices = {
@@ -271,6 +458,18 @@ namespace birb
 			3, 2, 0,
 		};
 
+		// Per-instance data of a batched sprite
+		struct sprite_instance
+		{
+			glm::mat4 model_matrix;
+			glm::vec3 color;
+			glm::vec2 aspect_ratio;
+			glm::vec4 uv_rect;
+		};
+
+		// Instances of the sprites in the order of the sprite queue commands
+		std::vector<sprite_instance> sprite_instances;
+
 		// The opengl buffers needed for sprites
 		//
 		// Some of these are declared as pointers because they
@@ -280,16 +479,33 @@ namespace birb
 		std::unique_ptr<vbo> sprite_vbo;
 
 
-		////////////////////
-		// Text rendering //
-		////////////////////
+		/////////////////////////////
+		// Text and line rendering //
+		/////////////////////////////
+
+		// Corners of the unit quad that the glyphs are drawn with as a triangle strip
+		static constexpr std::array<f32, 8> text_quad_corners = {
+			0.0f, 0.0f,
+			1.0f, 0.0f,
+			0.0f, 1.0f,
+			1.0f, 1.0f,
+		};
+
+		// Per-glyph instance data. The glyphs of all of the text entities
+		// that share a font get streamed into a single batch
+		struct text_glyph_instance
+		{
+			glm::vec4 rect;		// Screen position and size of the glyph
+			glm::vec4 uv_rect;	// Area of the glyph in the font atlas
+			glm::vec3 color;
+		};
 
 		vao text_vao;
+		std::unique_ptr<vbo> text_quad_vbo;
+		std::vector<text_glyph_instance> text_glyph_instances;
 
-		// The text vbo will be handled manually since it
-		// involves dynamically changing the vertex data
-		// and the current VBO class doesn't support that
-		vbo text_vbo;
+		// The line vertices are streamed through vertex_stream
+		vao line_vao;
 
 
 		/////////////////////
@@ -314,5 +530,23 @@ namespace birb
 		std::unique_ptr<birb::fbo> post_processing_fbo;
 		birb::window* window = nullptr;
 		vec2<i32> old_window_dimensions;
+
+
+		///////////////////
+		// Hot reloading //
+		///////////////////
+
+		// Apply the file changes that the asset watcher has noticed
+		void reload_changed_assets();
+
+		// Start watching the files of the assets in the current scene
+		void watch_scene_assets();
+
+		std::unique_ptr<file_watcher> asset_watcher;
+
+		// New entities might bring new files with them, so the
+		// watched files get refreshed every once in a while
+		static constexpr u32 asset_watch_refresh_interval = 60;
+		u32 next_asset_watch_refresh = 0;
 	};
 }
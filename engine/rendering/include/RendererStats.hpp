@@ -2,6 +2,8 @@
 
 #include "Types.hpp"
 
+#include <array>
+
 namespace birb
 {
 	struct renderer_stats
@@ -10,6 +12,42 @@ namespace birb
 		u32 entities_3d = 0;
 		u32 entities_screenspace = 0;
 
+		// Frustum culling results for 3D entities
+		u32 entities_3d_visible = 0;
+		u32 entities_3d_culled = 0;
+
+		// Occlusion culling results for 3D entities that passed the frustum culling
+		u32 occluders_rasterized = 0;
+		u32 entities_3d_occluded = 0;
+
+		// Triangles drawn from each mesh level of detail, including the shadow maps
+		std::array<u32, 4> lod_triangles{};
+
+		// 3D entities that were drawn with instancing
+		u32 entities_3d_instanced = 0;
+
+		// Sprites that were merged into batches and the draw calls that the batches took
+		u32 sprites_batched = 0;
+		u32 sprite_batches = 0;
+
+		// Transformer model matrices copied into instance VBOs
+		u32 instance_matrices_uploaded = 0;
+
+		// Transform hierarchy world matrices that had to be recalculated
+		u32 world_matrices_updated = 0;
+
+		// Clustered lighting
+		u32 point_lights = 0;
+		u32 light_cluster_indices = 0;
+		u32 light_cluster_max_lights = 0;
+		f64 light_clustering_duration = 0.0f;
+
+		// Shadow casters drawn into the shadow maps, counted once per cascade
+		u32 shadow_casters = 0;
+
+		// Culling and drawing of the shadow maps. This is a part of draw_3d_duration
+		f64 shadow_duration = 0.0f;
+
 		u32 vertices_2d = 0;
 		u32 vertices_3d = 0;
 		u32 vertices_screenspace = 0;
@@ -25,10 +63,17 @@ namespace birb
 		u32 draw_arrays_instanced = 0;
 		u32 draw_elements_instanced = 0;
 
+		// OpenGL state changes made while drawing
+		u32 shader_switches = 0;
+		u32 material_changes = 0;
+		u32 texture_binds = 0;
+		u32 vao_binds = 0;
+
 		u32 total_entities() const;
 		u32 total_vertices() const;
 		f64 total_duration() const;
 		u32 total_draw_calls() const;
+		u32 total_state_changes() const;
 		void reset_counters();
 	};
 }
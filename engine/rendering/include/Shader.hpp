@@ -1,17 +1,22 @@
 #pragma once
 
+#include "Assert.hpp"
 #include "EditorComponent.hpp"
+#include "ShaderUniforms.hpp"
 #include "Vector.hpp"
 
+#include <array>
+#include <cstddef>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace birb
 {
 	struct color;
-	struct uniform;
-	struct material;
+	class material;
 
 	struct point_light
 	{
@@ -41,6 +46,20 @@ namespace birb
 		shader();
 		explicit shader(const std::string& shader_name);
 		shader(const std::string& vertex, const std::string& fragment);
+
+		enum class compile_mode
+		{
+			blocking,
+
+			// Compiling and linking gets started, but the results are only
+			// checked when poll_compile() notices that the driver is done
+			deferred,
+		};
+
+		/**
+		 * @param variant Bitmask of shader_variant::feature values that get defined in the sources
+		 */
+		shader(const std::string& vertex, const std::string& fragment, const compile_mode mode, const u32 variant = 0);
 		shader(shader& other);
 		shader(const shader& other);
 		shader(shader&&) = default;
@@ -49,22 +68,71 @@ namespace birb
 		// Reference to the shader program
 		u32 id = 0;
 
-		// Lighting constants
-		const static u16 point_light_count = 4;
-
 		// Directional lighting
 		static inline struct directional_light directional_light;
 
-		// Point lights
-		static inline std::array<point_light, point_light_count> point_lights;
+		/**
+		 * @brief Point lights
+		 *
+		 * The lights get uploaded into the point light uniform block by the
+		 * renderer, so there can be at most max_point_lights of them
+		 */
+		static inline std::vector<point_light> point_lights = std::vector<point_light>(4);
+
+		/**
+		 * @brief Fallback programs stand in for shaders that are still compiling
+		 *
+		 * Setting uniforms that don't exist in a fallback program is allowed,
+		 * since the program it replaces might have had them
+		 */
+		bool is_fallback = false;
 
 		// Activate the shader program
 		void activate();
 
-		void update_directional_light();
-		void update_point_lights();
+		/**
+		 * @return True if the program was created with compile_mode::deferred and isn't usable yet
+		 */
+		bool is_compiling() const;
+
+		/**
+		 * @brief Check if a deferred compile has finished and set up the program if it has
+		 *
+		 * Without KHR_parallel_shader_compile the completion status can't be queried
+		 * without waiting, so this blocks until the driver is done
+		 *
+		 * @return True if the program is ready to be used
+		 */
+		bool poll_compile();
+
+		/**
+		 * @brief Check if the driver can compile shaders in background threads
+		 */
+		static bool is_parallel_compile_supported();
+
+		/**
+		 * @brief Recompile the program from its current source code
+		 *
+		 * The old program is kept if the new sources fail to compile, so
+		 * mistakes in hot reloaded shaders don't take the whole program down.
+		 * Call forget_cached_source() for the changed sources first, or the
+		 * old compiled shader stages will get reused
+		 *
+		 * @return True if the program was replaced
+		 */
+		bool reload();
+
+		/**
+		 * @return True if the shader is built from the given shader source (for example "default_frag")
+		 */
+		bool uses_source(const std::string& source_name) const;
 
 		bool has_uniform_var(const std::string& name) const;
+
+		/**
+		 * @return True if the built-in uniform is used by the shader program
+		 */
+		bool has_uniform(const uniform& uniform, i32 index = -1) const;
 		i32 uniform_location(const std::string& name) const;
 
 		// These functions are defined in shader_set_funcs.cpp instead of shader.cpp
@@ -109,6 +177,11 @@ namespace birb
 		static size_t shader_cache_size();
 		static size_t shader_cache_hits();
 
+		/**
+		 * @brief Drop the cached shader stages that were compiled from the given shader source
+		 */
+		static void forget_cached_source(const std::string& source_name);
+
 		template<class Archive>
 		void serialize(Archive& ar)
 		{
@@ -122,6 +195,9 @@ namespace birb
 		static inline const std::string editor_header_name = "Shader";
 		static inline u32 d_currently_active_shader = 0;
 
+		// The program that was last passed to glUseProgram()
+		static inline u32 active_program = 0;
+
 		// Material helper functions and variables
 		void set_diffuse_color(const color& color);
 		void set_specular_color(const color& color);
@@ -139,33 +215,73 @@ namespace birb
 		};
 
 		void compile_shader(const std::string& vertex, const std::string& fragment);
+
+		// Split halves of compile_shader(). begin_compile() only issues the
+		// compile and link commands and finish_compile() checks their results
+		void begin_compile(const std::string& vertex, const std::string& fragment);
+		void finish_compile();
+
+		// State of a compile that has been started but not finished yet. The
+		// shader objects are 0 if the program was loaded from a program binary
+		bool compiling = false;
+		u32 pending_vertex_shader = 0;
+		u32 pending_fragment_shader = 0;
+		u64 pending_binary_key = 0;
 		u32 compile_gl_shader_program(const std::string& shader_name, const char* shader_src, const shader_type type);
 		std::string shader_type_to_str(const shader_type type) const;
-		void compile_errors(u32 shader, const shader_type type);
+
+		/**
+		 * @param fatal Crash the program if there are errors instead of only logging them
+		 * @return True if there were no errors
+		 */
+		bool compile_errors(u32 shader, const shader_type type, const bool fatal = true);
+		void bind_uniform_block(const uniform_block& block, const bool required);
 
 		std::string vertex_shader_name = "NULL";
 		std::string fragment_shader_name = "NULL";
+		u32 variant_mask = 0;
+
+		/**
+		 * @brief Look up the locations of all built-in uniforms and reset the value cache
+		 *
+		 * Needs to be called every time the program gets re-linked
+		 */
+		void resolve_uniform_locations();
 
 		// Uniform variable cache
 		// Returns true if the variable was cached
 		template<typename T>
 		__attribute__((always_inline))
-		constexpr inline bool uniform_cache(const i32 key, const T value, std::unordered_map<i32, T>& cache)
+		inline bool uniform_cache(const u16 slot, const T& value)
 		{
-			ensure(key != -1, "The shader uniform doesn't exist");
-			if (cache[key] == value)
+			ensure(slot < uniform_table::slot_count);
+
+			if (is_fallback && uniform_locations[slot] == -1)
+				return true;
+
+			ensure(uniform_locations[slot] != -1, "The shader uniform doesn't exist");
+			ensure(sizeof(T) == uniform_table::value_offsets[slot + 1] - uniform_table::value_offsets[slot], "Uniform type mismatch");
+
+			std::byte* cached_value = uniform_value_cache.data() + uniform_table::value_offsets[slot];
+			if (uniform_value_cached[slot] && std::memcmp(cached_value, &value, sizeof(T)) == 0)
 				return true;
 
-			cache[key] = value;
+			std::memcpy(cached_value, &value, sizeof(T));
+			uniform_value_cached[slot] = true;
 			return false;
 		}
 
-		std::unordered_map<i32, i32> uniform_cache_int;
-		std::unordered_map<i32, f32> uniform_cache_float;
-		std::unordered_map<i32, glm::vec2> uniform_cache_vec2;
-		std::unordered_map<i32, glm::vec3> uniform_cache_vec3;
-		std::unordered_map<i32, vec3<f32>> uniform_cache_birb_vec3_float;
-		std::unordered_map<i32, glm::vec4> uniform_cache_vec4;
-		std::unordered_map<i32, glm::mat4> uniform_cache_mat4;
+		// Locations of the built-in uniforms indexed by their uniform slots.
+		// Uniforms that don't exist in the shader have the location -1
+		std::array<i32, uniform_table::slot_count> uniform_locations;
+
+		// The last values that were uploaded to the built-in uniforms. The values
+		// are stored at the offsets given by uniform_table::value_offsets
+		std::array<std::byte, uniform_table::value_cache_size> uniform_value_cache;
+		std::array<bool, uniform_table::slot_count> uniform_value_cached;
+
+		// Locations of uniforms that were set by their name instead of the built-in
+		// uniform objects. These are resolved the first time they are used
+		mutable std::unordered_map<std::string, i32> named_uniform_locations;
 	};
 }
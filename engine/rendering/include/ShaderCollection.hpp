@@ -3,6 +3,7 @@
 #include "Types.hpp"
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 namespace birb
@@ -53,9 +54,59 @@ namespace birb
 		 *
 		 * If the shader hasn't been compiled yet when its requested for,
 		 * it'll get compiled once and after that it can be re-used
+		 *
+		 * With async_compile enabled, the shader gets queued for compiling and
+		 * the fallback shader is returned until poll_async_compiles() finds it finished
 		 */
 		static std::shared_ptr<shader> get_shader(const shader_ref& ref);
 
+		/**
+		 * @brief Compile new shaders in the background instead of blocking in get_shader()
+		 */
+		static inline bool async_compile = false;
+
+		/**
+		 * @brief Move finished shaders out of the compile queue
+		 *
+		 * The renderer calls this once per frame. Without KHR_parallel_shader_compile
+		 * checking a shader blocks until it's done, so only one shader gets finished per call
+		 */
+		static void poll_async_compiles();
+
+		/**
+		 * @brief Amount of shaders in the compile queue
+		 */
+		static size_t pending_compile_count();
+
+		/**
+		 * @brief Shader that gets drawn with in place of shaders that are still compiling
+		 */
+		static std::shared_ptr<shader> fallback_shader();
+
+		/**
+		 * @brief Get the instanced variant of a shader
+		 *
+		 * Instanced variants use a vertex shader with an "_instanced" suffix
+		 * and the same fragment shader as the original shader. They read the
+		 * model matrix from the vertex attributes 5-8 instead of the model uniform
+		 *
+		 * @return The instanced shader or nullptr if the shader doesn't have an instanced variant
+		 */
+		static std::shared_ptr<shader> get_instanced_shader(const shader_ref& ref);
+
+		static constexpr char instanced_suffix[] = "_instanced";
+
+		/**
+		 * @brief Recompile the shaders that use a changed shader source
+		 *
+		 * Only external shaders from shader::shader_src_search_paths can change,
+		 * since the builtin shaders are embedded into the executable
+		 *
+		 * @param source_name Name of the shader source without the file extension (for example "default_frag")
+		 * @return Amount of shaders that were recompiled
+		 */
+		static size_t reload_shader_source(const std::string& source_name);
+
 		/**
 		 * @brief Clear the shader collection
 		 */
@@ -75,6 +126,14 @@ namespace birb
 		static inline bool builtin_shaders_hashed = false;
 
 		static inline std::unordered_map<u64, std::shared_ptr<shader>> shader_storage;
+
+		// Shaders that were started with compile_mode::deferred and aren't ready yet
+		static inline std::unordered_map<u64, std::shared_ptr<shader>> pending_shaders;
+		static inline std::shared_ptr<shader> fallback;
+
+		// Instanced variants of shaders. Shaders without an
+		// instanced variant are stored as nullptr
+		static inline std::unordered_map<u64, std::shared_ptr<shader>> instanced_shader_storage;
 		static inline std::unordered_map<u64, std::string> vertex_shader_hashes;
 		static inline std::unordered_map<u64, std::string> fragment_shader_hashes;
 	};
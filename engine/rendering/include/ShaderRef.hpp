@@ -13,6 +13,11 @@ namespace birb
 		shader_ref(const std::string& shader_name);
 		shader_ref(const std::string& vertex, const std::string& fragment);
 
+		/**
+		 * @param variant Bitmask of shader_variant::feature values
+		 */
+		shader_ref(const std::string& vertex, const std::string& fragment, const u32 variant);
+
 		void draw_editor_ui() override;
 		std::string collapsing_header_name() const override;
 
@@ -31,6 +36,16 @@ namespace birb
 		 */
 		u64 fragment() const;
 
+		/**
+		 * @brief Bitmask of the shader_variant features that get compiled into the shader
+		 */
+		u32 variant() const;
+
+		/**
+		 * @brief Get a reference to another variant of the same shader
+		 */
+		shader_ref with_variant(const u32 variant) const;
+
 		/**
 		 * @brief Recalculate hashes with new vertex and fragment shader names
 		 *
@@ -46,5 +61,6 @@ namespace birb
 		u64 combined_hash = 0;
 		u64 vertex_hash = 0;
 		u64 fragment_hash = 0;
+		u32 variant_mask = 0;
 	};
 }
@@ -3,6 +3,7 @@
 #include "GLBuffer.hpp"
 #include "Types.hpp"
 
+#include <array>
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
@@ -21,10 +22,184 @@ namespace birb
 		BIRB_COLOR,
 	};
 
+	/**
+	 * @brief Compile-time identifiers for the built-in uniforms
+	 *
+	 * The locations of all of these uniforms are resolved once after a shader
+	 * program has been linked and stored into a flat table indexed by the
+	 * uniform slots (see uniform_table)
+	 */
+	enum class uniform_id : u16
+	{
+		model,
+		view,
+		projection,
+		view_pos,
+
+		color,
+
+		vertex_position_offset,
+		vertex_position_scale,
+		vertex_packed_normals,
+
+		light_space_matrix,
+		shadow_map,
+
+		point_light_data,
+		light_cluster_ranges,
+		light_cluster_indices,
+
+		// Shared by color and texture materials
+		material_shininess,
+
+		material_color_diffuse,
+		material_color_specular,
+
+		material_texture_diffuse,
+		material_texture_specular,
+
+		tex0,
+
+		texture_aspect_ratio,
+		texture_orthographic,
+		texture_uv_rect,
+
+		count
+	};
+
+	/**
+	 * @brief Amount of cascades in the directional light shadow map
+	 */
+	constexpr u8 shadow_cascade_count = 4;
+
+	struct uniform_info
+	{
+		const char* name;
+		uniform_type type;
+		const char* struct_var = "";
+
+		// Zero if the uniform is not an array
+		u16 array_size = 0;
+	};
+
+	/**
+	 * @brief Get the name, type and array size of a built-in uniform
+	 */
+	constexpr uniform_info get_uniform_info(const uniform_id id)
+	{
+		switch (id)
+		{
+			case uniform_id::model:			return { "model", uniform_type::MAT4 };
+			case uniform_id::view:			return { "view", uniform_type::MAT4 };
+			case uniform_id::projection:	return { "projection", uniform_type::MAT4 };
+			case uniform_id::view_pos:		return { "view_pos", uniform_type::VEC3 };
+
+			case uniform_id::color:			return { "color", uniform_type::BIRB_COLOR };
+
+			case uniform_id::vertex_position_offset:	return { "vertex_position_offset", uniform_type::VEC3 };
+			case uniform_id::vertex_position_scale:		return { "vertex_position_scale", uniform_type::VEC3 };
+			case uniform_id::vertex_packed_normals:		return { "vertex_packed_normals", uniform_type::INT };
+
+			case uniform_id::light_space_matrix:	return { "light_space_matrix", uniform_type::MAT4 };
+			case uniform_id::shadow_map:			return { "shadow_map", uniform_type::INT, "", shadow_cascade_count };
+
+			case uniform_id::point_light_data:		return { "point_light_data", uniform_type::INT };
+			case uniform_id::light_cluster_ranges:	return { "light_cluster_ranges", uniform_type::INT };
+			case uniform_id::light_cluster_indices:	return { "light_cluster_indices", uniform_type::INT };
+
+			case uniform_id::material_shininess:	return { "material", uniform_type::FLOAT, "shininess" };
+
+			case uniform_id::material_color_diffuse:	return { "material", uniform_type::BIRB_COLOR, "diffuse" };
+			case uniform_id::material_color_specular:	return { "material", uniform_type::BIRB_COLOR, "specular" };
+
+			case uniform_id::material_texture_diffuse:		return { "material", uniform_type::INT, "diffuse_tex" };
+			case uniform_id::material_texture_specular:		return { "material", uniform_type::INT, "specular_tex" };
+
+			case uniform_id::tex0:	return { "tex0", uniform_type::INT };
+
+			case uniform_id::texture_aspect_ratio:	return { "aspect_ratio", uniform_type::VEC2 };
+			case uniform_id::texture_orthographic:	return { "orthographic", uniform_type::INT };
+			case uniform_id::texture_uv_rect:		return { "uv_rect", uniform_type::VEC4 };
+
+			case uniform_id::count:
+				break;
+		}
+
+		return { "", uniform_type::INT };
+	}
+
+	/**
+	 * @brief Layout of the per-shader uniform location and value cache tables
+	 *
+	 * Each element of a uniform gets its own slot, so array uniforms take up
+	 * as many slots as they have elements. The value cache is a single block of
+	 * bytes where each slot has room for one value of the type of the uniform
+	 */
+	namespace uniform_table
+	{
+		constexpr u16 uniform_count = static_cast<u16>(uniform_id::count);
+
+		constexpr u16 element_count(const uniform_id id)
+		{
+			const uniform_info info = get_uniform_info(id);
+			return info.array_size == 0 ? 1 : info.array_size;
+		}
+
+		constexpr u32 value_size(const uniform_type type)
+		{
+			switch (type)
+			{
+				case uniform_type::INT:				return sizeof(i32);
+				case uniform_type::FLOAT:			return sizeof(f32);
+				case uniform_type::VEC2:			return sizeof(f32) * 2;
+				case uniform_type::VEC3:			return sizeof(f32) * 3;
+				case uniform_type::VEC4:			return sizeof(f32) * 4;
+				case uniform_type::MAT4:			return sizeof(f32) * 16;
+				case uniform_type::BIRB_VEC3_FLOAT:	return sizeof(f32) * 3;
+				case uniform_type::BIRB_COLOR:		return sizeof(f32) * 3;
+			}
+
+			return 0;
+		}
+
+		constexpr std::array<u16, uniform_count + 1> first_slots = []
+		{
+			std::array<u16, uniform_count + 1> slots{};
+			for (u16 i = 0; i < uniform_count; ++i)
+				slots[i + 1] = slots[i] + element_count(static_cast<uniform_id>(i));
+
+			return slots;
+		}();
+
+		constexpr u16 slot_count = first_slots[uniform_count];
+
+		constexpr std::array<u32, slot_count + 1> value_offsets = []
+		{
+			std::array<u32, slot_count + 1> offsets{};
+			u16 slot = 0;
+			for (u16 i = 0; i < uniform_count; ++i)
+			{
+				const uniform_id id = static_cast<uniform_id>(i);
+				for (u16 j = 0; j < element_count(id); ++j, ++slot)
+					offsets[slot + 1] = offsets[slot] + value_size(get_uniform_info(id).type);
+			}
+
+			return offsets;
+		}();
+
+		constexpr u32 value_cache_size = value_offsets[slot_count];
+
+		constexpr u16 first_slot(const uniform_id id)
+		{
+			return first_slots[static_cast<u16>(id)];
+		}
+	}
+
 	struct uniform
 	{
-		uniform(const std::string& name, uniform_type type, const std::string& struct_var = "", bool is_array = false, i32 array_max_size = 0);
+		explicit uniform(const uniform_id id);
 
+		const uniform_id id;
 		std::string name;
 		const uniform_type type;
 		const bool is_array = false;
@@ -33,6 +208,13 @@ namespace birb
 		std::vector<std::string> array_str_cache;
 
 		std::string str(i32 index = -1) const;
+
+		/**
+		 * @brief Get the slot of the uniform in the per-shader uniform tables
+		 *
+		 * @param index Array index for array uniforms. -1 for other uniforms
+		 */
+		u16 slot(i32 index = -1) const;
 	};
 
 	struct uniform_block
@@ -44,78 +226,153 @@ namespace birb
 		const gl_usage usage;
 	};
 
-	namespace shader_uniforms
+	/**
+	 * @brief Maximum amount of point lights
+	 *
+	 * The point lights are stored in a texture buffer where each light takes up
+	 * four RGBA32F texels. OpenGL 3.3 guarantees room for at least 65536 texels
+	 */
+	constexpr u16 max_point_lights = 4096;
+
+	/**
+	 * @brief Texture units reserved for the lighting buffers
+	 *
+	 * The last units of the 16 that are guaranteed to exist are used,
+	 * so that they don't collide with the material textures
+	 */
+	namespace light_texture_unit
 	{
-		const static inline uniform model("model", uniform_type::MAT4);
-		const static inline uniform view("view", uniform_type::MAT4);
-		const static inline uniform projection("projection", uniform_type::MAT4);
-		const static inline uniform view_pos("view_pos", uniform_type::VEC3);
+		// Each shadow cascade takes up its own unit starting from this one
+		constexpr u8 shadow_maps = 9;
 
-		const static inline uniform color("color", uniform_type::BIRB_COLOR);
-		const static inline uniform text_color("text_color", uniform_type::BIRB_COLOR);
-		const static inline uniform text_position("text_position", uniform_type::BIRB_VEC3_FLOAT);
+		constexpr u8 point_light_data = 13;
+		constexpr u8 cluster_ranges = 14;
+		constexpr u8 cluster_indices = 15;
 
-		namespace block
+		static_assert(shadow_maps + shadow_cascade_count <= point_light_data);
+	}
+
+	/**
+	 * @brief CPU side mirrors of the lighting data in std140 layout
+	 *
+	 * The scalar members fill the padding after the vec3 members, so the
+	 * structs can be copied into the buffers as-is
+	 */
+	namespace std140
+	{
+		struct directional_light
 		{
-			const static inline uniform_block view_matrices(0, "view_matrices", sizeof(glm::mat4), gl_usage::static_draw);
-			const static inline uniform_block projection_matrices(1, "projection_matrices", sizeof(glm::mat4) * 3, gl_usage::static_draw);
-		}
+			glm::vec3 direction;
+			f32 padding_0 = 0.0f;
+			glm::vec3 ambient;
+			f32 padding_1 = 0.0f;
+			glm::vec3 diffuse;
+			f32 padding_2 = 0.0f;
+			glm::vec3 specular;
+			f32 padding_3 = 0.0f;
+		};
 
-		namespace lights
+		struct light_info
 		{
-			const static inline uniform light_space_matrix("light_space_matrix", uniform_type::MAT4);
-			const static inline uniform shadow_map("shadow_map", uniform_type::INT);
-		}
+			directional_light directional;
+			i32 point_light_count = 0;
+			i32 clustered = 0;
+			i32 shadows = 0;
+			i32 padding = 0;
+
+			// Cluster grid size (xyz)
+			glm::uvec4 cluster_grid = glm::uvec4(0);
+
+			// Depth slice scale and bias (xy) and the amount of
+			// clusters per pixel on the x and y axis (zw)
+			glm::vec4 cluster_slicing = glm::vec4(0.0f);
 
-		namespace point_lights
+			// World space -> light clip space of each shadow cascade
+			glm::mat4 shadow_matrices[shadow_cascade_count];
+
+			// Far view depth and world space texel size of each cascade.
+			// The values of all cascades are packed into a single vec4
+			glm::vec4 cascade_splits = glm::vec4(0.0f);
+			glm::vec4 cascade_texel_sizes = glm::vec4(0.0f);
+		};
+
+		// Four RGBA32F texels in the point light texture buffer
+		struct point_light
 		{
-			const static inline uniform position ("point_lights", uniform_type::BIRB_VEC3_FLOAT, "position", true, 64);
-			const static inline uniform constant ("point_lights", uniform_type::FLOAT, "constant", true, 64);
-			const static inline uniform linear ("point_lights", uniform_type::FLOAT, "linear", true, 64);
-			const static inline uniform quadratic ("point_lights", uniform_type::FLOAT, "quadratic", true, 64);
-			const static inline uniform ambient ("point_lights", uniform_type::BIRB_VEC3_FLOAT, "ambient", true, 64);
-			const static inline uniform diffuse ("point_lights", uniform_type::BIRB_VEC3_FLOAT, "diffuse", true, 64);
-			const static inline uniform specular ("point_lights", uniform_type::BIRB_VEC3_FLOAT, "specular", true, 64);
-			const static inline uniform count ("point_light_count", uniform_type::INT);
+			glm::vec3 position;
+			f32 constant;
+			glm::vec3 ambient;
+			f32 linear;
+			glm::vec3 diffuse;
+			f32 quadratic;
+			glm::vec3 specular;
+			f32 padding = 0.0f;
+		};
+
+		static_assert(sizeof(directional_light) == 64);
+		static_assert(sizeof(light_info) == 400);
+		static_assert(shadow_cascade_count <= 4);
+		static_assert(sizeof(point_light) == 64);
+	}
+
+	namespace shader_uniforms
+	{
+		const static inline uniform model(uniform_id::model);
+		const static inline uniform view(uniform_id::view);
+		const static inline uniform projection(uniform_id::projection);
+		const static inline uniform view_pos(uniform_id::view_pos);
+
+		const static inline uniform color(uniform_id::color);
+
+		// Decoding of packed mesh vertices
+		namespace vertex
+		{
+			const static inline uniform position_offset(uniform_id::vertex_position_offset);
+			const static inline uniform position_scale(uniform_id::vertex_position_scale);
+			const static inline uniform packed_normals(uniform_id::vertex_packed_normals);
 		}
 
-		namespace directional_light
+		namespace block
 		{
-			const static inline uniform direction("directional_light", uniform_type::BIRB_VEC3_FLOAT, "direction", false);
-			const static inline uniform ambient("directional_light", uniform_type::BIRB_VEC3_FLOAT, "ambient", false);
-			const static inline uniform diffuse("directional_light", uniform_type::BIRB_VEC3_FLOAT, "diffuse", false);
-			const static inline uniform specular("directional_light", uniform_type::BIRB_VEC3_FLOAT, "specular", false);
+			const static inline uniform_block view_matrices(0, "view_matrices", sizeof(glm::mat4), gl_usage::static_draw);
+			const static inline uniform_block projection_matrices(1, "projection_matrices", sizeof(glm::mat4) * 3, gl_usage::static_draw);
+			const static inline uniform_block light_info(2, "light_info", sizeof(std140::light_info), gl_usage::dynamic_draw);
 		}
 
-		namespace material
+		namespace lights
 		{
-			const static inline uniform type("material_type", uniform_type::INT);
+			const static inline uniform light_space_matrix(uniform_id::light_space_matrix);
+			const static inline uniform shadow_map(uniform_id::shadow_map);
+
+			const static inline uniform point_light_data(uniform_id::point_light_data);
+			const static inline uniform cluster_ranges(uniform_id::light_cluster_ranges);
+			const static inline uniform cluster_indices(uniform_id::light_cluster_indices);
 		}
 
 		namespace material_color
 		{
-			const static inline uniform diffuse("material", uniform_type::BIRB_COLOR, "diffuse", false);
-			const static inline uniform specular("material", uniform_type::BIRB_COLOR, "specular", false);
-			const static inline uniform shininess("material", uniform_type::FLOAT, "shininess", false);
+			const static inline uniform diffuse(uniform_id::material_color_diffuse);
+			const static inline uniform specular(uniform_id::material_color_specular);
+			const static inline uniform shininess(uniform_id::material_shininess);
 		}
 
 		namespace material_texture
 		{
-			const static inline uniform diffuse("material", uniform_type::INT, "diffuse_tex", false);
-			const static inline uniform specular("material", uniform_type::INT, "specular_tex", false);
-			const static inline uniform shininess("material", uniform_type::FLOAT, "shininess", false);
+			const static inline uniform diffuse(uniform_id::material_texture_diffuse);
+			const static inline uniform specular(uniform_id::material_texture_specular);
+			const static inline uniform shininess(uniform_id::material_shininess);
 		}
 
 		namespace texture_units
 		{
-			const static inline uniform tex0("tex0", uniform_type::INT);
+			const static inline uniform tex0(uniform_id::tex0);
 		}
 
 		namespace texture
 		{
-			const static inline uniform instanced("instanced", uniform_type::INT);
-			const static inline uniform aspect_ratio("aspect_ratio", uniform_type::VEC2);
-			const static inline uniform orthographic("orthographic", uniform_type::INT);
+			const static inline uniform aspect_ratio(uniform_id::texture_aspect_ratio);
+			const static inline uniform orthographic(uniform_id::texture_orthographic);
+			const static inline uniform uv_rect(uniform_id::texture_uv_rect);
 			// const static inline uniform aspect_ratio_reverse("aspect_ratio_reverse", uniform_type::FLOAT);
 		}
 	}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <string>
+
+namespace birb
+{
+	/**
+	 * @brief Compile-time features of shader programs
+	 *
+	 * A shader_ref carries a bitmask of these features. Each set bit becomes a
+	 * #define line in the shader source, so every combination of features is
+	 * compiled into its own specialized program instead of branching on uniforms
+	 */
+	namespace shader_variant
+	{
+		enum feature : u32
+		{
+			none		= 0,
+
+			// Model matrix from the instance attributes
+			instanced	= 1 << 0,
+
+			// Model matrix, color, aspect ratio and UV rect from the instance attributes (sprite batches)
+			batched		= 1 << 1,
+
+			// Material colors are sampled from the diffuse and specular textures
+			textured	= 1 << 2,
+		};
+
+		constexpr u8 feature_count = 3;
+
+		/**
+		 * @brief Name of the preprocessor define of a feature, for example BIRB_INSTANCED
+		 */
+		const char* define_name(const feature feature);
+
+		/**
+		 * @brief #define lines for all of the features in the mask
+		 */
+		std::string define_lines(const u32 mask);
+
+		/**
+		 * @brief Insert the defines of the mask into GLSL source code
+		 *
+		 * The defines go right after the #version directive, since
+		 * nothing else is allowed to come before it
+		 */
+		std::string inject_defines(const std::string& src, const u32 mask);
+
+		/**
+		 * @brief Human readable list of the features in the mask
+		 */
+		std::string to_str(const u32 mask);
+	}
+}
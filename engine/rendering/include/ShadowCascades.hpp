@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Frustum.hpp"
+#include "ShaderUniforms.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace birb
+{
+	/**
+	 * @brief Splits the camera view frustum into cascades for directional light shadow mapping
+	 *
+	 * Each cascade covers a range of view depths and gets its own orthographic
+	 * light projection that is fit around a bounding sphere of that part of the
+	 * camera frustum. Using a sphere keeps the projection size constant when the
+	 * camera rotates and the projection gets snapped to the shadow map texels,
+	 * so the shadow edges don't shimmer when the camera moves
+	 */
+	class shadow_cascades
+	{
+	public:
+		static constexpr u8 cascade_count = shadow_cascade_count;
+
+		// Width and height of the shadow map of each cascade
+		static constexpr i32 map_resolution = 2048;
+
+		// Blend between logarithmic (1.0) and uniform (0.0) cascade splits
+		static constexpr f32 split_lambda = 0.75f;
+
+		struct cascade
+		{
+			// Range of view depths that the cascade covers
+			f32 near_depth = 0.0f;
+			f32 far_depth = 0.0f;
+
+			// World space -> light clip space
+			glm::mat4 light_matrix = glm::mat4(1.0f);
+
+			// World space size of a shadow map texel
+			f32 texel_size = 0.0f;
+
+			// Shadow casters that are outside of this frustum can be skipped
+			frustum caster_frustum;
+		};
+
+		/**
+		 * @brief Maximum view depth that gets shadows
+		 *
+		 * The camera far clip is used instead if it is closer than this
+		 */
+		f32 shadow_distance = 100.0f;
+
+		/**
+		 * @brief How far towards the light from a cascade casters are searched for
+		 *
+		 * Objects further away than this won't cast shadows into the cascade
+		 */
+		f32 caster_distance = 100.0f;
+
+		/**
+		 * @brief Fit the cascades to a camera
+		 *
+		 * @param view_matrix View matrix of the camera
+		 * @param fov Vertical field of view in degrees
+		 * @param aspect_ratio Width / height of the viewport
+		 * @param light_direction Direction that the directional light travels to
+		 */
+		void update(const glm::mat4& view_matrix, const f32 fov, const f32 aspect_ratio, const f32 near_clip, const f32 far_clip, const glm::vec3& light_direction);
+
+		const cascade& get_cascade(const u8 index) const;
+
+		/**
+		 * @brief Far view depth of a cascade with the practical split scheme
+		 */
+		static f32 split_depth(const u8 index, const f32 near_clip, const f32 far_clip);
+
+	private:
+		std::array<cascade, cascade_count> cascades;
+	};
+}
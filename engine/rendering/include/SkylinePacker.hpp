@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Types.hpp"
+#include "Vector.hpp"
+
+#include <optional>
+#include <vector>
+
+namespace birb
+{
+	/**
+	 * @brief Packs rectangles into a fixed size area with the skyline bottom-left heuristic
+	 *
+	 * The packer keeps track of the top edges (the skyline) of the rectangles
+	 * that have been placed so far and puts each new rectangle to the spot where
+	 * its top edge ends up the lowest. There's no randomness involved, so the same
+	 * rectangles inserted in the same order always end up in the same places
+	 */
+	class skyline_packer
+	{
+	public:
+		explicit skyline_packer(const vec2<i32> size);
+
+		/**
+		 * @brief Find a place for a rectangle
+		 *
+		 * Empty rectangles don't take up any space and get placed to the origin
+		 *
+		 * @return Position of the bottom left corner of the rectangle or
+		 * nothing if the rectangle doesn't fit anywhere
+		 */
+		std::optional<vec2<i32>> insert(const vec2<i32> rect_size);
+
+		vec2<i32> size() const;
+
+		/**
+		 * @brief Fraction of the area that is covered by rectangles
+		 */
+		f32 occupancy() const;
+
+	private:
+		// Horizontal piece of the skyline
+		struct segment
+		{
+			i32 x;
+			i32 y;
+			i32 width;
+		};
+
+		const vec2<i32> _size;
+		std::vector<segment> skyline;
+		i64 used_area = 0;
+
+		/**
+		 * @brief Find the lowest height that a rectangle starting at the given segment can be placed at
+		 *
+		 * @return The height or -1 if the rectangle doesn't fit there
+		 */
+		i32 fit(const size_t index, const vec2<i32> rect_size) const;
+	};
+}
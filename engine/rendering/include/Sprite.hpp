@@ -5,17 +5,26 @@
 #include "EditorComponent.hpp"
 #include "SpriteBase.hpp"
 
+#include <glm/glm.hpp>
 #include <memory>
 #include <string>
 
 namespace birb
 {
 	class texture;
+	class texture_atlas;
 
 	class sprite : public sprite_base, editor_component
 	{
 	public:
 		explicit sprite(const std::string& file_path, color_format format = color_format::RGBA);
+
+		/**
+		 * @brief Create a sprite from an image in a texture atlas
+		 *
+		 * Sprites that use the same atlas page can be batched together
+		 */
+		sprite(const texture_atlas& atlas, const std::string& image_path);
 		~sprite() = default;
 		sprite(const sprite& other) = default;
 		sprite(sprite& other) = default;
@@ -26,6 +35,16 @@ namespace birb
 		std::shared_ptr<birb::texture> texture;
 		birb::color color;
 
+		// Area of the texture that the sprite shows. The bottom left
+		// corner is in xy and the top right corner in zw
+		glm::vec4 uv_rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+		/**
+		 * @brief Aspect ratio of the area of the texture that the sprite shows
+		 */
+		f32 aspect_ratio() const;
+		f32 aspect_ratio_reverse() const;
+
 	private:
 		static inline const std::string editor_header_name = "Sprite";
 	};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "GLBuffer.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+namespace birb
+{
+	/**
+	 * @brief Ring buffer for vertex and instance data that changes every frame
+	 *
+	 * The buffer is split into a region per frame in flight. Data gets appended
+	 * into the region of the current frame, so the CPU never writes into memory
+	 * that the GPU might still be reading from.
+	 *
+	 * With GL_ARB_buffer_storage the buffer is mapped persistently and the
+	 * regions are guarded with fences. Without it the buffer gets orphaned
+	 * every time the ring wraps around and the regions are written with
+	 * unsynchronized mappings
+	 */
+	class stream_buffer
+	{
+	public:
+		// Amount of frames that the CPU can be ahead of the GPU
+		static constexpr u8 frame_count = 3;
+
+		static constexpr u32 default_frame_capacity = 1024 * 1024;
+		static constexpr u32 default_alignment = 16;
+
+		explicit stream_buffer(const gl_buffer_type type, const u32 frame_capacity = default_frame_capacity);
+		~stream_buffer();
+		stream_buffer(const stream_buffer&) = delete;
+		stream_buffer(stream_buffer&) = delete;
+		stream_buffer(stream_buffer&&) = delete;
+
+		/**
+		 * @brief Append data into the region of the current frame
+		 *
+		 * The buffer grows if the frame runs out of space. Growing replaces
+		 * the underlying buffer object, so bind the buffer after pushing and
+		 * don't mix offsets from before and after a push in the same draw call
+		 *
+		 * @param size Size of the data in bytes
+		 * @param alignment Alignment of the returned offset in bytes
+		 * @return Offset of the data from the beginning of the buffer in bytes
+		 */
+		u32 push(const void* data, const u32 size, const u32 alignment = default_alignment);
+
+		/**
+		 * @brief Stream data into a region of another buffer
+		 *
+		 * The data is pushed into the ring and copied on the GPU, so the
+		 * destination buffer doesn't need to be re-specified or synchronized with
+		 *
+		 * @param destination_buffer ID of the buffer to copy the data into
+		 * @param size Size of the data in bytes
+		 * @param destination_offset Offset of the region in the destination buffer in bytes
+		 */
+		void copy_to(const u32 destination_buffer, const void* data, const u32 size, const u32 destination_offset);
+
+		/**
+		 * @brief Finish the current frame and move to the next region
+		 *
+		 * Blocks if the GPU hasn't finished reading the next region yet
+		 */
+		void next_frame();
+
+		u32 id() const;
+		void bind() const;
+		void unbind() const;
+
+		/**
+		 * @brief Check if the buffer is mapped persistently instead of being orphaned
+		 */
+		bool is_persistent() const;
+
+		u32 frame_capacity() const;
+
+		/**
+		 * @brief Amount of bytes pushed during the current frame
+		 */
+		u32 frame_size() const;
+
+	private:
+		void allocate(const u32 frame_capacity);
+		void release();
+		void orphan();
+		void wait_for_fence(const u8 region);
+
+		static bool buffer_storage_supported();
+
+		const gl_buffer_type type;
+		std::unique_ptr<gl_buffer> buffer;
+
+		u32 _frame_capacity = 0;
+		u8 frame = 0;
+
+		// Write head in the region of the current frame
+		u32 frame_offset = 0;
+
+		// Persistently mapped memory of the whole buffer
+		std::byte* mapped_memory = nullptr;
+		bool persistent = false;
+
+		// GLsync objects of the frames that are in flight. Stored
+		// as void pointers to keep OpenGL out of the header
+		std::array<void*, frame_count> fences{};
+	};
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "GLBuffer.hpp"
+#include "Types.hpp"
+
+#include <cstddef>
+
+namespace birb
+{
+	enum class tbo_format
+	{
+		r16ui = 33332,
+		rg32ui = 33340,
+		rgba32f = 34836,
+	};
+
+	/**
+	 * @brief Texture buffer object
+	 *
+	 * A buffer that shaders can read with texelFetch() through a samplerBuffer.
+	 * Useful for arrays that are too large for uniform blocks
+	 */
+	class tbo
+	{
+	public:
+		explicit tbo(const tbo_format format);
+		~tbo();
+		tbo(const tbo&) = delete;
+		tbo(tbo&) = delete;
+		tbo(tbo&&) = delete;
+
+		/**
+		 * @brief Replace the contents of the buffer
+		 *
+		 * The buffer only gets re-allocated if the new data doesn't fit into it
+		 *
+		 * @param size Size of the data in bytes
+		 */
+		void set_data(const void* data, const size_t size);
+
+		/**
+		 * @brief Bind the buffer texture to a texture unit
+		 */
+		void bind(const u32 texture_unit) const;
+
+		size_t capacity() const;
+
+	private:
+		void allocate(const void* data, const size_t size);
+
+		gl_buffer buffer;
+		u32 texture_id = 0;
+		size_t _capacity = 0;
+		const tbo_format format;
+
+		// Texture buffers with no data store can't be sampled, so always allocate at least this much
+		static constexpr size_t min_capacity = 64;
+	};
+}
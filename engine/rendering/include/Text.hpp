@@ -7,8 +7,8 @@
 #include "Types.hpp"
 #include "Vector.hpp"
 
-#include <set>
-#include <unordered_map>
+#include <glm/glm.hpp>
+#include <span>
 #include <vector>
 
 namespace birb
@@ -17,11 +17,25 @@ namespace birb
 	{
 	public:
 		text(const std::string& text, const birb::font& font, const vec3<f32> position, const birb::color = 0xFFFFFF, const shader_ref& = {"text", "text"});
-		~text();
-		text(const text& other);
+		~text() = default;
+		text(const text& other) = default;
 		text(text&) = delete;
 		text(text&&) = default;
 
+		/**
+		 * @brief Placement of a single character in the font atlas and on the screen
+		 */
+		struct glyph_quad
+		{
+			// Bottom left corner of the glyph relative to the text position
+			glm::vec2 position;
+			glm::vec2 size;
+
+			// Area of the glyph in the font atlas
+			glm::vec2 uv_min;
+			glm::vec2 uv_max;
+		};
+
 		void draw_editor_ui() override;
 		std::string collapsing_header_name() const override;
 
@@ -30,27 +44,40 @@ namespace birb
 		birb::color color;
 		shader_ref shader;
 
+		/**
+		 * @brief Change the text
+		 *
+		 * Only the characters after the first changed character are laid out again
+		 */
 		void set_text(const std::string& text);
 		std::string get_text() const;
 		void clear();
 		bool empty() const;
 
-		std::set<char> chars() const;
-		std::vector<glm::vec2> char_positions(const char c) const;
-		u32 char_texture_id(const char c) const;
-		u32 instance_vbo(const char c) const;
+		/**
+		 * @brief Get the quads of the visible characters
+		 *
+		 * Whitespace doesn't get a quad, so there might be fewer quads than characters
+		 */
+		std::span<const glyph_quad> glyphs() const;
 
 	private:
 		static inline const std::string editor_header_name = "Text";
 		std::string txt;
-		std::set<char> _chars;
-		std::unordered_map<char, std::vector<glm::vec2>> _char_positions;
-		std::unordered_map<char, u32> _char_texture_ids;
+		std::vector<glyph_quad> _glyphs;
 
-		std::vector<u32> instance_vbo_ids;
-		std::unordered_map<char, u32> instance_vbos;
+		// Layout state before each character of the text. There's one
+		// extra element for the state after the last character
+		struct char_layout
+		{
+			glm::vec2 cursor;
+			u32 first_glyph;
+		};
+		std::vector<char_layout> char_layouts = { char_layout{ glm::vec2(0.0f, 0.0f), 0 } };
 
-		void allocate_instance_vbos();
-		void update_instance_vbos();
+		/**
+		 * @brief Lay out the characters of the text starting from the given index
+		 */
+		void layout(const size_t first_char);
 	};
 }
@@ -4,8 +4,15 @@
 #include "Shader.hpp"
 #include "Vector.hpp"
 
+#include <string>
+
 namespace birb
 {
+	namespace asset
+	{
+		struct image;
+	}
+
 	enum class texture_type
 	{
 		TEX_1D = 3552,
@@ -36,6 +43,29 @@ namespace birb
 
 		void load(const char* image_path, const u32 slot, const color_format format, const texture_type type = texture_type::TEX_2D);
 
+		/**
+		 * @brief Upload an image that has already been decoded
+		 *
+		 * @param image_path Path to the file that the image was decoded from. Used for reloading
+		 */
+		void load(const asset::image& image, const std::string& image_path, const u32 slot, const color_format format, const texture_type type = texture_type::TEX_2D);
+
+		/**
+		 * @brief Load the image file of the texture again into the same OpenGL texture
+		 *
+		 * Anything that refers to the texture by its id picks up the new image
+		 * without any extra work. Only works for textures loaded from an image file
+		 */
+		void reload();
+
+		/**
+		 * @brief Create a mipmapped 2D texture from 8-bit pixel data in memory
+		 *
+		 * @param pixels Rows of pixels starting from the bottom of the image
+		 * @param max_mipmap_level Highest mipmap level that gets sampled
+		 */
+		void load(const u8* pixels, const vec2<i32> dimensions, const color_format format, const i32 max_mipmap_level);
+
 		void tex_unit(birb::shader& shader, const char* uniform = "tex0", const u32 unit = 0);
 
 		/**
@@ -61,11 +91,28 @@ namespace birb
 		f32 aspect_ratio() const;
 		f32 aspect_ratio_reverse() const;
 
+		/**
+		 * @brief Path to the image file that the texture was loaded from
+		 *
+		 * Empty if the texture wasn't loaded from a file
+		 */
+		const std::string& path() const;
+
 		static u32 texture_from_file(const std::string& path);
 
+		/**
+		 * @brief Upload a decoded image the same way as texture_from_file() does
+		 */
+		static u32 texture_from_image(const asset::image& image);
+
 	private:
 		texture_type type = texture_type::TEX_2D;
 		u32 slot = 0;
+		color_format format = color_format::RGBA;
+		std::string image_path;
+
+		// Upload the image into the currently bound texture
+		void upload_image(const asset::image& image);
 
 		vec2<i32> dimensions; // Width and height of the texture
 
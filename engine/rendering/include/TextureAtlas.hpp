@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Types.hpp"
+#include "Vector.hpp"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace birb
+{
+	class texture;
+
+	/**
+	 * @brief Sub-rectangle of a texture atlas page
+	 */
+	struct atlas_region
+	{
+		u16 page = 0;
+
+		// Bottom left corner and size of the image in pixels without the gutter
+		vec2<i32> position;
+		vec2<i32> size;
+
+		// Texture coordinates of the bottom left (xy) and top right (zw) corners
+		glm::vec4 uv_rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	};
+
+	/**
+	 * @brief Packs images into a few large textures so that sprites using them can be batched together
+	 *
+	 * Each image is surrounded by a gutter that repeats its edge pixels, so
+	 * neither filtering nor the lower mipmap levels bleed the neighbouring
+	 * images into it. The packing only depends on the image sizes and their
+	 * order, so the same set of images always produces the same atlas.
+	 *
+	 * The packed pages can be cached to disk. The cache gets invalidated if
+	 * any of the image files change
+	 */
+	class texture_atlas
+	{
+	public:
+		static constexpr i32 default_page_size = 2048;
+		static constexpr i32 default_gutter = 4;
+
+		/**
+		 * @brief Pack images into an atlas
+		 *
+		 * @param image_paths Paths to the image files
+		 * @param cache_path Path to the cache file. The images are only packed if the
+		 *                   cache is missing or out of date. An empty path disables the cache
+		 * @param page_size Width and height of each atlas texture
+		 * @param gutter Width of the border around each image in pixels
+		 */
+		explicit texture_atlas(const std::vector<std::string>& image_paths, const std::string& cache_path = "", const i32 page_size = default_page_size, const i32 gutter = default_gutter);
+		~texture_atlas() = default;
+		texture_atlas(const texture_atlas&) = delete;
+		texture_atlas(texture_atlas&) = delete;
+		texture_atlas(texture_atlas&&) = default;
+
+		bool contains(const std::string& image_path) const;
+
+		/**
+		 * @brief Get the area of an image in the atlas
+		 */
+		const atlas_region& region(const std::string& image_path) const;
+
+		/**
+		 * @brief Get the texture of an atlas page
+		 */
+		std::shared_ptr<birb::texture> page(const u16 index) const;
+		u16 page_count() const;
+
+		/**
+		 * @brief Check if the atlas was loaded from the cache instead of packing the images
+		 */
+		bool is_cached() const;
+
+		/**
+		 * @brief Place rectangles of the given sizes on atlas pages
+		 *
+		 * Rectangles are placed from the tallest to the shortest and rectangles of equal
+		 * size keep their order, so the same sizes always produce the same layout
+		 */
+		static std::vector<atlas_region> pack(const std::vector<vec2<i32>>& sizes, const i32 page_size, const i32 gutter);
+
+	private:
+		static constexpr u8 channel_count = 4;
+
+		const i32 page_size;
+		const i32 gutter;
+
+		std::unordered_map<std::string, atlas_region> regions;
+		std::vector<std::shared_ptr<birb::texture>> pages;
+		bool _is_cached = false;
+
+		/**
+		 * @brief Hash of the atlas settings and the sizes and modification times of the images
+		 */
+		u64 cache_key(const std::vector<std::string>& image_paths) const;
+
+		bool read_cache(const std::string& path, const u64 key, const std::vector<std::string>& image_paths, std::vector<atlas_region>& packed_regions, std::vector<std::vector<u8>>& page_pixels) const;
+		void write_cache(const std::string& path, const u64 key, const std::vector<std::string>& image_paths, const std::vector<atlas_region>& packed_regions, const std::vector<std::vector<u8>>& page_pixels) const;
+
+		void upload_pages(const std::vector<std::vector<u8>>& page_pixels);
+	};
+}
@@ -4,9 +4,12 @@ layout (location = 0) in vec3 aPos;
 out vec3 FragPos;
 
 #include "include/matrices.glsl"
+#include "include/vertex.glsl"
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
-	FragPos = vec3(model * vec4(aPos, 1.0));
+	vec3 position = decode_position(aPos);
+
+	gl_Position = projection * view * model * vec4(position, 1.0);
+	FragPos = vec3(model * vec4(position, 1.0));
 }
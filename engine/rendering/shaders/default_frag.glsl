@@ -5,9 +5,9 @@ out vec4 FragColor;
 in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
+in float ViewDepth;
 
-#define POINT_LIGHT_COUNT 64 // The light total light count must be less than this variable
-uniform int point_light_count;
+#include "include/lights.glsl"
 
 uniform vec3 view_pos;
 
@@ -24,36 +24,7 @@ struct Material
 
 uniform Material material;
 
-#define MATERIAL_TYPE_COLOR 0
-#define MATERIAL_TYPE_TEXTURE 1
-uniform int material_type;
-
-struct PointLight
-{
-	vec3 position;
-
-	float constant;
-	float linear;
-	float quadratic;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-struct DirLight
-{
-	vec3 direction;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-uniform PointLight point_lights[POINT_LIGHT_COUNT];
-uniform DirLight directional_light;
-
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir, float shadow);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir);
 
 void main()
@@ -62,16 +33,30 @@ void main()
 	vec3 view_dir = normalize(view_pos - FragPos);
 
 	// Directional lighting
-	vec3 result = CalcDirLight(directional_light, norm, view_dir);
+	float shadow = directional_shadow(FragPos, norm, ViewDepth);
+	vec3 result = CalcDirLight(directional_light, norm, view_dir, shadow);
 
-	// Loop over point lights
-	for (int i = 0; i < point_light_count; i++)
-		result += CalcPointLight(point_lights[i], norm, FragPos, view_dir);
+	if (clustered_lighting != 0)
+	{
+		// Only loop over the point lights that affect the cluster of this fragment
+		uvec2 light_range = texelFetch(light_cluster_ranges, fragment_cluster(ViewDepth)).xy;
+		for (uint i = 0u; i < light_range.y; i++)
+		{
+			int light_index = int(texelFetch(light_cluster_indices, int(light_range.x + i)).x);
+			result += CalcPointLight(fetch_point_light(light_index), norm, FragPos, view_dir);
+		}
+	}
+	else
+	{
+		// Loop over all of the point lights
+		for (int i = 0; i < point_light_count; i++)
+			result += CalcPointLight(fetch_point_light(i), norm, FragPos, view_dir);
+	}
 
 	FragColor = vec4(result, 1.0f);
 }
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir)
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir, float shadow)
 {
 	vec3 light_dir = normalize(-light.direction);
 
@@ -87,22 +72,18 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir)
 	vec3 diffuse;
 	vec3 specular;
 
-	switch (material_type)
-	{
-		case MATERIAL_TYPE_COLOR:
-			ambient = light.ambient * material.diffuse;
-			diffuse = light.diffuse * diff * material.diffuse;
-			specular = light.specular * spec * material.specular;
-			break;
-
-		case MATERIAL_TYPE_TEXTURE:
-			ambient = light.ambient * vec3(texture(material.diffuse_tex, TexCoords));
-			diffuse = light.diffuse * diff * vec3(texture(material.diffuse_tex, TexCoords));
-			specular = light.specular * spec * vec3(texture(material.specular_tex, TexCoords));
-			break;
-	}
-
-	return (ambient + diffuse + specular);
+#ifdef BIRB_TEXTURED
+	ambient = light.ambient * vec3(texture(material.diffuse_tex, TexCoords));
+	diffuse = light.diffuse * diff * vec3(texture(material.diffuse_tex, TexCoords));
+	specular = light.specular * spec * vec3(texture(material.specular_tex, TexCoords));
+#else
+	ambient = light.ambient * material.diffuse;
+	diffuse = light.diffuse * diff * material.diffuse;
+	specular = light.specular * spec * material.specular;
+#endif
+
+	// Shadows only block the direct light
+	return (ambient + (1.0 - shadow) * (diffuse + specular));
 }
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir)
@@ -125,20 +106,15 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir)
 	vec3 diffuse;
 	vec3 specular;
 
-	switch (material_type)
-	{
-		case MATERIAL_TYPE_COLOR:
-			ambient = light.ambient * material.diffuse;
-			diffuse = light.diffuse * diff * material.diffuse;
-			specular = light.specular * spec * material.specular;
-			break;
-
-		case MATERIAL_TYPE_TEXTURE:
-			ambient = light.ambient * vec3(texture(material.diffuse_tex, TexCoords));
-			diffuse = light.diffuse * diff * vec3(texture(material.diffuse_tex, TexCoords));
-			specular = light.specular * spec * vec3(texture(material.specular_tex, TexCoords));
-			break;
-	}
+#ifdef BIRB_TEXTURED
+	ambient = light.ambient * vec3(texture(material.diffuse_tex, TexCoords));
+	diffuse = light.diffuse * diff * vec3(texture(material.diffuse_tex, TexCoords));
+	specular = light.specular * spec * vec3(texture(material.specular_tex, TexCoords));
+#else
+	ambient = light.ambient * material.diffuse;
+	diffuse = light.diffuse * diff * material.diffuse;
+	specular = light.specular * spec * material.specular;
+#endif
 
 	ambient		*= attenuation;
 	diffuse		*= attenuation;
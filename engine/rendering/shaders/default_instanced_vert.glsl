@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in mat4 instanceMatrix;
+
+out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
+out float ViewDepth;
+
+#include "include/matrices.glsl"
+#include "include/vertex.glsl"
+
+void main()
+{
+	vec3 position = decode_position(aPos);
+
+	FragPos = vec3(instanceMatrix * vec4(position, 1.0));
+
+	vec4 view_space_pos = view * vec4(FragPos, 1.0);
+	ViewDepth = -view_space_pos.z;
+	gl_Position = projection * view_space_pos;
+	Normal = mat3(transpose(inverse(instanceMatrix))) * decode_normal(aNormal); // TODO: Calculate this on the CPU
+	TexCoords = aTexCoords;
+}
@@ -6,13 +6,20 @@ layout (location = 2) in vec2 aTexCoords;
 out vec2 TexCoords;
 out vec3 FragPos;
 out vec3 Normal;
+out float ViewDepth;
 
 #include "include/matrices.glsl"
+#include "include/vertex.glsl"
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
-	FragPos = vec3(model * vec4(aPos, 1.0));
-	Normal = mat3(transpose(inverse(model))) * aNormal; // TODO: Calculate this on the CPU
+	vec3 position = decode_position(aPos);
+
+	FragPos = vec3(model * vec4(position, 1.0));
+
+	vec4 view_space_pos = view * vec4(FragPos, 1.0);
+	ViewDepth = -view_space_pos.z;
+	gl_Position = projection * view_space_pos;
+	Normal = mat3(transpose(inverse(model))) * decode_normal(aNormal); // TODO: Calculate this on the CPU
 	TexCoords = aTexCoords;
 }
@@ -0,0 +1,10 @@
+#version 330 core
+
+// Stand-in for shaders that are still being compiled in the background.
+// Nothing gets drawn, since the vertex layout of the real shader is unknown
+out vec4 FragColor;
+
+void main()
+{
+	discard;
+}
@@ -0,0 +1,132 @@
+// Has to match shadow_cascade_count on the CPU side
+#define SHADOW_CASCADE_COUNT 4
+
+struct PointLight
+{
+	vec3 position;
+	float constant;
+
+	vec3 ambient;
+	float linear;
+
+	vec3 diffuse;
+	float quadratic;
+
+	vec3 specular;
+};
+
+struct DirLight
+{
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+layout (std140) uniform light_info
+{
+	DirLight directional_light;
+	int point_light_count;
+	int clustered_lighting;
+	int shadows_enabled;
+
+	uvec4 cluster_grid;
+
+	// xy: depth slice scale and bias, zw: clusters per pixel
+	vec4 cluster_slicing;
+
+	mat4 shadow_matrices[SHADOW_CASCADE_COUNT];
+
+	// Far view depth and world space texel size of each cascade
+	vec4 cascade_splits;
+	vec4 cascade_texel_sizes;
+};
+
+// Each point light takes up four texels
+uniform samplerBuffer point_light_data;
+
+// Depth maps of the directional light shadow cascades
+uniform sampler2D shadow_map[SHADOW_CASCADE_COUNT];
+
+// Offset and count of the light index list of each cluster
+uniform usamplerBuffer light_cluster_ranges;
+uniform usamplerBuffer light_cluster_indices;
+
+PointLight fetch_point_light(int index)
+{
+	vec4 texel_0 = texelFetch(point_light_data, index * 4);
+	vec4 texel_1 = texelFetch(point_light_data, index * 4 + 1);
+	vec4 texel_2 = texelFetch(point_light_data, index * 4 + 2);
+	vec4 texel_3 = texelFetch(point_light_data, index * 4 + 3);
+
+	PointLight light;
+	light.position = texel_0.xyz;
+	light.constant = texel_0.w;
+	light.ambient = texel_1.xyz;
+	light.linear = texel_1.w;
+	light.diffuse = texel_2.xyz;
+	light.quadratic = texel_2.w;
+	light.specular = texel_3.xyz;
+
+	return light;
+}
+
+// Find the cluster of the current fragment. Has to match light_clusters on the CPU side
+int fragment_cluster(float view_depth)
+{
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * cluster_slicing.zw), cluster_grid.xy - 1u);
+	uint slice = uint(clamp(floor(log(view_depth) * cluster_slicing.x - cluster_slicing.y), 0.0, float(cluster_grid.z - 1u)));
+
+	return int(tile.x + cluster_grid.x * (tile.y + cluster_grid.y * slice));
+}
+
+// Samplers in arrays can only be indexed with constant expressions in GLSL 3.30.
+// The cascade can change within a quad, so the mip level is given explicitly
+float sample_shadow_map(int cascade, vec2 coords)
+{
+	switch (cascade)
+	{
+		case 0: return textureLod(shadow_map[0], coords, 0.0).r;
+		case 1: return textureLod(shadow_map[1], coords, 0.0).r;
+		case 2: return textureLod(shadow_map[2], coords, 0.0).r;
+		default: return textureLod(shadow_map[3], coords, 0.0).r;
+	}
+}
+
+// Amount of shadow from the directional light. 0.0 is fully lit and 1.0 is fully in shadow
+float directional_shadow(vec3 frag_pos, vec3 normal, float view_depth)
+{
+	if (shadows_enabled == 0)
+		return 0.0;
+
+	int cascade = 0;
+	while (cascade < SHADOW_CASCADE_COUNT && view_depth > cascade_splits[cascade])
+		cascade++;
+
+	// Beyond the shadow distance
+	if (cascade == SHADOW_CASCADE_COUNT)
+		return 0.0;
+
+	// Push the sample position out of the surface by a texel to avoid shadow acne
+	vec3 offset_pos = frag_pos + normal * cascade_texel_sizes[cascade] * 1.5;
+	vec4 light_space_pos = shadow_matrices[cascade] * vec4(offset_pos, 1.0);
+	vec3 coords = light_space_pos.xyz / light_space_pos.w * 0.5 + 0.5;
+
+	if (coords.z > 1.0)
+		return 0.0;
+
+	// 3x3 percentage closer filtering
+	vec2 texel = 1.0 / vec2(textureSize(shadow_map[0], 0));
+	float shadow = 0.0;
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			float closest_depth = sample_shadow_map(cascade, coords.xy + vec2(x, y) * texel);
+			shadow += coords.z - 0.0005 > closest_depth ? 1.0 : 0.0;
+		}
+	}
+
+	return shadow / 9.0;
+}
@@ -0,0 +1,23 @@
+// Packed mesh vertices store their positions relative to the mesh
+// bounds and their normals octahedral encoded. Full float meshes
+// use the default values, which leave the attributes as they are
+uniform vec3 vertex_position_offset = vec3(0.0);
+uniform vec3 vertex_position_scale = vec3(1.0);
+uniform int vertex_packed_normals = 0;
+
+vec3 decode_position(vec3 position)
+{
+	return vertex_position_offset + position * vertex_position_scale;
+}
+
+vec3 decode_normal(vec3 normal)
+{
+	if (vertex_packed_normals == 0)
+		return normal;
+
+	vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
@@ -4,8 +4,9 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 light_space_matrix;
 
 #include "include/matrices.glsl"
+#include "include/vertex.glsl"
 
 void main()
 {
-	gl_Position = light_space_matrix * model * vec4(aPos, 1.0);
+	gl_Position = light_space_matrix * model * vec4(decode_position(aPos), 1.0);
 }
@@ -0,0 +1,6 @@
+#version 330 core
+
+// Only the depth gets written into the shadow map
+void main()
+{
+}
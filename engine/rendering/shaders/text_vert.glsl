@@ -1,15 +1,18 @@
 #version 330 core
-layout (location = 0) in vec4 vertex; // vec2 position | vec2 texture_coord
-layout (location = 1) in vec2 vertex_offset;
+layout (location = 0) in vec2 corner; // Corner of the unit quad
+layout (location = 1) in vec4 glyph_rect; // vec2 position | vec2 size
+layout (location = 2) in vec4 glyph_uv; // vec2 uv_min | vec2 uv_max
+layout (location = 3) in vec3 glyph_color;
 out vec2 TexCoords;
-
-uniform vec3 text_position;
-//uniform mat4 projection;
+out vec3 TextColor;
 
 #include "include/matrices.glsl"
 
 void main()
 {
-	gl_Position = projection_ortho_no_near_clip * vec4(vertex.xy + vertex_offset + text_position.xy, 0.0, 1.0);
-	TexCoords = vertex.zw;
+	gl_Position = projection_ortho_no_near_clip * vec4(glyph_rect.xy + corner * glyph_rect.zw, 0.0, 1.0);
+
+	// The glyph bitmaps are stored top row first
+	TexCoords = vec2(mix(glyph_uv.x, glyph_uv.z, corner.x), mix(glyph_uv.w, glyph_uv.y, corner.y));
+	TextColor = glyph_color;
 }
@@ -2,11 +2,11 @@
 out vec4 FragColor;
 
 in vec2 texCoord;
+in vec3 spriteColor;
 
 uniform sampler2D tex0;
-uniform vec3 color;
 
 void main()
 {
-	FragColor = texture(tex0, texCoord) * vec4(color, 1.0);
+	FragColor = texture(tex0, texCoord) * vec4(spriteColor, 1.0);
 }
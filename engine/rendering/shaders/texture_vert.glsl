@@ -2,15 +2,24 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTex;
 layout (location = 5) in mat4 instanceMatrix;
+layout (location = 9) in vec3 instanceColor;
+layout (location = 10) in vec2 instanceAspectRatio;
+layout (location = 11) in vec4 instanceUvRect;
 
 out vec2 texCoord;
 out vec3 FragPos;
+out vec3 spriteColor;
 
 
 #include "include/matrices.glsl"
 
-uniform int instanced;
+// BIRB_INSTANCED = model matrix from the instance attributes
+// BIRB_BATCHED = model matrix, color, aspect ratio and UV rect from the instance attributes (sprite batches)
 uniform int orthographic;
+uniform vec3 color;
+
+// Area of the texture to show. xy = bottom left, zw = top right
+uniform vec4 uv_rect;
 
 uniform vec2 aspect_ratio;
 // aspect_ratio.x = aspect_ratio
@@ -24,11 +33,26 @@ void main()
 	else
 		projection_matrix = projection;
 
-	if (instanced == 1)
-		gl_Position = projection_matrix * view * instanceMatrix * vec4(aPos.x / aspect_ratio.y, aPos.y / aspect_ratio.x, aPos.z, 1.0f);
-	else
-		gl_Position = projection_matrix * view * model * vec4(aPos.x / aspect_ratio.y, aPos.y / aspect_ratio.x, aPos.z, 1.0f);
-
-	texCoord = aTex;
-	FragPos = vec3(model * vec4(aPos, 1.0));
+#if defined(BIRB_BATCHED)
+	mat4 model_matrix = instanceMatrix;
+	vec2 sprite_aspect_ratio = instanceAspectRatio;
+	vec4 sprite_uv_rect = instanceUvRect;
+	vec3 sprite_color = instanceColor;
+#elif defined(BIRB_INSTANCED)
+	mat4 model_matrix = instanceMatrix;
+	vec2 sprite_aspect_ratio = aspect_ratio;
+	vec4 sprite_uv_rect = uv_rect;
+	vec3 sprite_color = color;
+#else
+	mat4 model_matrix = model;
+	vec2 sprite_aspect_ratio = aspect_ratio;
+	vec4 sprite_uv_rect = uv_rect;
+	vec3 sprite_color = color;
+#endif
+
+	gl_Position = projection_matrix * view * model_matrix * vec4(aPos.x / sprite_aspect_ratio.y, aPos.y / sprite_aspect_ratio.x, aPos.z, 1.0f);
+
+	texCoord = mix(sprite_uv_rect.xy, sprite_uv_rect.zw, aTex);
+	FragPos = vec3(model_matrix * vec4(aPos, 1.0));
+	spriteColor = sprite_color;
 }
@@ -0,0 +1,74 @@
+#include "Assert.hpp"
+#include "BoundingBox.hpp"
+
+#include <glm/glm.hpp>
+
+namespace birb
+{
+	bool bounding_box::is_valid() const
+	{
+		return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+	}
+
+	void bounding_box::expand(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void bounding_box::expand(const bounding_box& box)
+	{
+		if (!box.is_valid())
+			return;
+
+		min = glm::min(min, box.min);
+		max = glm::max(max, box.max);
+	}
+
+	glm::vec3 bounding_box::center() const
+	{
+		ensure(is_valid(), "Tried to get the center of an empty bounding box");
+		return (min + max) * 0.5f;
+	}
+
+	glm::vec3 bounding_box::extents() const
+	{
+		ensure(is_valid(), "Tried to get the extents of an empty bounding box");
+		return (max - min) * 0.5f;
+	}
+
+	bool bounding_box::intersects_sphere(const glm::vec3& center, const f32 radius) const
+	{
+		// Find the point in the box that is closest to the center of the sphere
+		const glm::vec3 closest_point = glm::clamp(center, min, max);
+		const glm::vec3 delta = closest_point - center;
+
+		return glm::dot(delta, delta) <= radius * radius;
+	}
+
+	bounding_box bounding_box::transformed(const glm::mat4& matrix) const
+	{
+		ensure(is_valid(), "Tried to transform an empty bounding box");
+
+		// Transform the center point and project the extents onto the
+		// world axes with the absolute values of the rotation/scale part
+		// of the matrix. This avoids transforming all eight corners
+		const glm::vec3 old_center = center();
+		const glm::vec3 old_extents = extents();
+
+		const glm::vec3 new_center = glm::vec3(matrix * glm::vec4(old_center, 1.0f));
+
+		const glm::mat3 abs_matrix(
+			glm::abs(glm::vec3(matrix[0])),
+			glm::abs(glm::vec3(matrix[1])),
+			glm::abs(glm::vec3(matrix[2]))
+		);
+
+		const glm::vec3 new_extents = abs_matrix * old_extents;
+
+		bounding_box result;
+		result.min = new_center - new_extents;
+		result.max = new_center + new_extents;
+		return result;
+	}
+}
@@ -149,6 +149,16 @@ namespace birb
 		return glm::lookAt(position, position + front, up);
 	}
 
+	birb::frustum camera::perspective_frustum() const
+	{
+		return birb::frustum(cached_projection_matrix_perspective * view_matrix());
+	}
+
+	birb::frustum camera::orthographic_frustum() const
+	{
+		return birb::frustum(cached_projection_matrix_ortho * view_matrix());
+	}
+
 	glm::vec3 camera::front_vec() const
 	{
 		return front;
@@ -54,7 +54,7 @@ namespace birb
 		GL_SUPERVISOR_SCOPE();
 		ensure(id != 0);
 		ensure(birb::g_opengl_initialized);
-		glDeleteBuffers(1, &id);
+		glDeleteFramebuffers(1, &id);
 
 		render_buffer_object.reset();
 	}
@@ -150,7 +150,10 @@ namespace birb
 		// Render buffer object
 		render_buffer_object.reset();
 
-		setup_rbo(dimensions);
+		// Depth maps are the depth attachment themselves, so the depth-stencil
+		// render buffer would replace them
+		if (format != color_format::DEPTH)
+			setup_rbo(dimensions);
 	}
 
 	void fbo::attach_texture(const texture& texture, const color_format format)
@@ -7,11 +7,12 @@
 
 namespace birb
 {
-	font::font(const std::shared_ptr<std::map<char, character>> character_map, const u8 size, const u64 uuid)
-	:size(size), uuid(uuid), character_map(character_map)
+	font::font(const std::shared_ptr<std::map<char, character>> character_map, const u32 atlas_texture_id, const u8 size, const u64 uuid)
+	:size(size), uuid(uuid), character_map(character_map), _atlas_texture_id(atlas_texture_id)
 	{
 		ensure(character_map.get(), "Unallocated character map");
 		ensure(!character_map->empty(), "Empty character map");
+		ensure(atlas_texture_id != 0, "Invalid font atlas");
 	}
 
 	character& font::get_char(const char c) const
@@ -23,4 +24,9 @@ namespace birb
 	{
 		return character_map->at(c).size;
 	}
+
+	u32 font::atlas_texture_id() const
+	{
+		return _atlas_texture_id;
+	}
 }
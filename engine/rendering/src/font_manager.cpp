@@ -4,18 +4,61 @@
 #include "FontManager.hpp"
 #include "Logger.hpp"
 #include "Profiling.hpp"
+#include "SkylinePacker.hpp"
 #include "UUID.hpp"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <algorithm>
 #include <glad/gl.h>
 #include <map>
+#include <optional>
+#include <vector>
 
 static u8 counter = 0;
 
 namespace birb
 {
+	// Empty space around each glyph in the atlas, so that linear
+	// filtering doesn't bleed the neighbouring glyphs into each other
+	static constexpr u32 glyph_padding = 1;
+
+	static constexpr u32 min_atlas_size = 64;
+	static constexpr u32 max_atlas_size = 8192;
+
+	/**
+	 * @brief Pack the glyphs into a square atlas
+	 *
+	 * @return False if the glyphs don't fit into an atlas of the given size
+	 */
+	static bool pack_glyphs(const std::vector<character>& glyphs, const u32 atlas_size, std::vector<vec2<u32>>& positions)
+	{
+		skyline_packer packer(vec2<i32>(atlas_size, atlas_size));
+
+		for (size_t i = 0; i < glyphs.size(); ++i)
+		{
+			const vec2<u32> size = glyphs[i].size;
+
+			// Glyphs without a bitmap don't need any space
+			if (size.x == 0 || size.y == 0)
+			{
+				positions[i] = vec2<u32>(0, 0);
+				continue;
+			}
+
+			// Leave the padding to the bottom left of the glyph. The padding
+			// of the neighbouring glyphs covers the other sides
+			const std::optional<vec2<i32>> position = packer.insert(vec2<i32>(size.x + glyph_padding, size.y + glyph_padding));
+			if (!position)
+				return false;
+
+			positions[i] = vec2<u32>(position->x + glyph_padding, position->y + glyph_padding);
+		}
+
+		return true;
+	}
+
 	font_manager::font_manager()
 	{
 		ensure(counter == 0, "There should be only a singular font_manager at any time");
@@ -35,64 +78,135 @@ namespace birb
 	font font_manager::load_font(const std::string& font_file, const u8 size)
 	{
 		PROFILER_SCOPE_MISC_FN();
-		log("Loading font: ", font_file, " (size: ", static_cast<unsigned int>(size), ")");
 
-		FT_Face font_face;
-		if (FT_New_Face(ft, font_file.c_str(), 0, &font_face))
+		const std::optional<glyph_atlas> atlas = rasterize_font(font_file, size);
+		if (!atlas)
 			log_fatal(2, "Failed to load font: ", font_file);
 
-		FT_Set_Pixel_Sizes(font_face, 0, size);
-
-		std::shared_ptr<std::map<char, character>> character_map = std::make_shared<std::map<char, character>>();
+		return upload_font(*atlas);
+	}
 
-		// Disable byte-alignment restriction
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	std::optional<font_manager::glyph_atlas> font_manager::rasterize_font(const std::string& font_file, const u8 size)
+	{
+		PROFILER_SCOPE_MISC_FN();
+		log("Loading font: ", font_file, " (size: ", static_cast<unsigned int>(size), ")");
 
-		// Allocate memory for all of the OpenGL textures at once
 		constexpr u8 glyph_count = 128;
-		std::array<u32, glyph_count> glyph_texture_ids;
-		glGenTextures(glyph_count, glyph_texture_ids.data());
+
+		// Render all of the glyphs first, so that their sizes are known when packing the atlas
+		std::vector<character> glyphs(glyph_count);
+		std::vector<std::vector<u8>> glyph_bitmaps(glyph_count);
+
+		std::unique_lock lock(ft_mutex);
+
+		FT_Face font_face;
+		if (FT_New_Face(ft, font_file.c_str(), 0, &font_face))
+		{
+			log_error("Failed to open font: ", font_file);
+			return std::nullopt;
+		}
+
+		FT_Set_Pixel_Sizes(font_face, 0, size);
 
 		for (u8 i = 0; i < glyph_count; ++i)
 		{
 			// Load the glyph
 			if (FT_Load_Char(font_face, i, FT_LOAD_RENDER))
-				log_fatal(1, "Failed to load glyph: ", static_cast<char>(i));
-
-			// Generate the texture
-			ensure(glyph_texture_ids.at(i) != 0, "Missing OpenGL texture");
-			glBindTexture(GL_TEXTURE_2D, glyph_texture_ids[i]);
-			glTexImage2D(
-				GL_TEXTURE_2D,
-				0,
-				GL_RED,
-				font_face->glyph->bitmap.width,
-				font_face->glyph->bitmap.rows,
-				0,
-				GL_RED,
-				GL_UNSIGNED_BYTE,
-				font_face->glyph->bitmap.buffer
-			);
-
-			// Texture options
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-			character character = {
-				glyph_texture_ids[i],
-				vec2<u32>(font_face->glyph->bitmap.width, font_face->glyph->bitmap.rows),
-				vec2<i32>(font_face->glyph->bitmap_left, font_face->glyph->bitmap_top),
-				font_face->glyph->advance.x
-			};
-
-			character_map->insert(std::pair<char, birb::character>(i, character));
+			{
+				log_error("Failed to load glyph ", static_cast<u32>(i), " from font: ", font_file);
+				FT_Done_Face(font_face);
+				return std::nullopt;
+			}
+
+			const FT_Bitmap& bitmap = font_face->glyph->bitmap;
+
+			glyphs[i].size = vec2<u32>(bitmap.width, bitmap.rows);
+			glyphs[i].bearing = vec2<i32>(font_face->glyph->bitmap_left, font_face->glyph->bitmap_top);
+			glyphs[i].advance = font_face->glyph->advance.x;
+
+			// The rows of the bitmap might be padded, so copy them one by one
+			glyph_bitmaps[i].resize(bitmap.width * bitmap.rows);
+			for (u32 row = 0; row < bitmap.rows; ++row)
+				std::copy_n(bitmap.buffer + row * bitmap.pitch, bitmap.width, glyph_bitmaps[i].begin() + row * bitmap.width);
 		}
 
 		// Free the font face
 		FT_Done_Face(font_face);
+		lock.unlock();
+
+		// Find the smallest square atlas that all of the glyphs fit into
+		std::vector<vec2<u32>> glyph_positions(glyph_count);
+		u32 atlas_size = min_atlas_size;
+		while (!pack_glyphs(glyphs, atlas_size, glyph_positions))
+		{
+			atlas_size *= 2;
+			if (atlas_size > max_atlas_size)
+			{
+				log_error("The glyphs of the font don't fit into an atlas texture: ", font_file);
+				return std::nullopt;
+			}
+		}
+
+		// Copy the glyphs into the atlas
+		glyph_atlas atlas;
+		atlas.pixels.resize(atlas_size * atlas_size, 0);
+		atlas.atlas_size = atlas_size;
+		atlas.font_size = size;
+		atlas.character_map = std::make_shared<std::map<char, character>>();
+
+		const f32 atlas_size_reverse = 1.0f / atlas_size;
+
+		for (u8 i = 0; i < glyph_count; ++i)
+		{
+			character& glyph = glyphs[i];
+			const vec2<u32> position = glyph_positions[i];
+
+			for (u32 row = 0; row < glyph.size.y; ++row)
+				std::copy_n(glyph_bitmaps[i].begin() + row * glyph.size.x, glyph.size.x, atlas.pixels.begin() + (position.y + row) * atlas_size + position.x);
+
+			glyph.uv_min = vec2<f32>(position.x * atlas_size_reverse, position.y * atlas_size_reverse);
+			glyph.uv_max = vec2<f32>((position.x + glyph.size.x) * atlas_size_reverse, (position.y + glyph.size.y) * atlas_size_reverse);
+
+			atlas.character_map->insert(std::pair<char, birb::character>(i, glyph));
+		}
+
+		return atlas;
+	}
+
+	font font_manager::upload_font(const glyph_atlas& atlas)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(atlas.character_map != nullptr);
+		ensure(atlas.pixels.size() == atlas.atlas_size * atlas.atlas_size);
+
+		// Disable byte-alignment restriction
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		return font(character_map, size, uuid::generate());
+		u32 atlas_texture_id = 0;
+		glGenTextures(1, &atlas_texture_id);
+		ensure(atlas_texture_id != 0, "Missing OpenGL texture");
+
+		glBindTexture(GL_TEXTURE_2D, atlas_texture_id);
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			GL_RED,
+			atlas.atlas_size,
+			atlas.atlas_size,
+			0,
+			GL_RED,
+			GL_UNSIGNED_BYTE,
+			atlas.pixels.data()
+		);
+
+		// Texture options
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		return font(atlas.character_map, atlas_texture_id, atlas.font_size, uuid::generate());
 	}
 }
@@ -0,0 +1,90 @@
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+namespace birb
+{
+	frustum::frustum()
+	{
+		// Zeroed planes make every point land exactly on every plane,
+		// so nothing will get rejected
+		planes.fill(glm::vec4(0.0f));
+	}
+
+	frustum::frustum(const glm::mat4& view_projection)
+	{
+		update(view_projection);
+	}
+
+	void frustum::update(const glm::mat4& view_projection)
+	{
+		// Gribb-Hartmann plane extraction. glm matrices are column-major,
+		// so the rows need to be gathered manually
+		const auto row = [&view_projection](const u8 i)
+		{
+			return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+		};
+
+		const glm::vec4 row_x = row(0);
+		const glm::vec4 row_y = row(1);
+		const glm::vec4 row_z = row(2);
+		const glm::vec4 row_w = row(3);
+
+		planes[plane::left]		= row_w + row_x;
+		planes[plane::right]	= row_w - row_x;
+		planes[plane::bottom]	= row_w + row_y;
+		planes[plane::top]		= row_w - row_y;
+		planes[plane::near_clip]	= row_w + row_z;
+		planes[plane::far_clip]	= row_w - row_z;
+
+		// Normalize the planes so that the sphere test gets correct distances
+		for (glm::vec4& p : planes)
+		{
+			const f32 length = glm::length(glm::vec3(p));
+			if (length > 0.0f)
+				p /= length;
+		}
+	}
+
+	bool frustum::contains(const glm::vec3& point) const
+	{
+		for (const glm::vec4& p : planes)
+			if (glm::dot(glm::vec3(p), point) + p.w < 0.0f)
+				return false;
+
+		return true;
+	}
+
+	bool frustum::intersects(const bounding_box& box) const
+	{
+		for (const glm::vec4& p : planes)
+		{
+			// Pick the corner of the box that is furthest along the plane normal.
+			// If even that is behind the plane, the whole box is outside
+			const glm::vec3 positive_vertex(
+				p.x >= 0.0f ? box.max.x : box.min.x,
+				p.y >= 0.0f ? box.max.y : box.min.y,
+				p.z >= 0.0f ? box.max.z : box.min.z
+			);
+
+			if (glm::dot(glm::vec3(p), positive_vertex) + p.w < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool frustum::intersects_sphere(const glm::vec3& center, const f32 radius) const
+	{
+		for (const glm::vec4& p : planes)
+			if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+				return false;
+
+		return true;
+	}
+
+	glm::vec4 frustum::get_plane(const plane which) const
+	{
+		return planes[which];
+	}
+}
@@ -11,6 +11,7 @@ namespace birb
 	static_assert(static_cast<int>(gl_buffer_type::array) == GL_ARRAY_BUFFER);
 	static_assert(static_cast<int>(gl_buffer_type::element_array) == GL_ELEMENT_ARRAY_BUFFER);
 	static_assert(static_cast<int>(gl_buffer_type::uniform) == GL_UNIFORM_BUFFER);
+	static_assert(static_cast<int>(gl_buffer_type::texture) == GL_TEXTURE_BUFFER);
 
 	static_assert(static_cast<int>(gl_usage::static_draw) == GL_STATIC_DRAW);
 	static_assert(static_cast<int>(gl_usage::dynamic_draw) == GL_DYNAMIC_DRAW);
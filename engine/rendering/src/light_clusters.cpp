@@ -0,0 +1,218 @@
+#include "Assert.hpp"
+#include "LightClusters.hpp"
+#include "Profiling.hpp"
+#include "Shader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <glm/glm.hpp>
+#include <limits>
+#include <numeric>
+
+namespace birb
+{
+	void light_clusters::update(const glm::mat4& view_matrix, const f32 fov, const f32 aspect_ratio, const f32 near_clip, const f32 far_clip, const std::vector<point_light>& lights)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(near_clip > 0.0f, "Clustered lighting needs a positive near clip distance");
+		ensure(far_clip > near_clip);
+		ensure(aspect_ratio > 0.0f);
+		ensure(lights.size() <= std::numeric_limits<u16>::max(), "Too many lights for 16-bit light indices");
+
+		// The cluster bounds only depend on the projection
+		if (fov != bounds_fov || aspect_ratio != bounds_aspect_ratio || near_clip != bounds_near_clip || far_clip != bounds_far_clip)
+			update_cluster_bounds(fov, aspect_ratio, near_clip, far_clip);
+
+		// Move the lights into view space
+		view_space_lights.resize(lights.size());
+		std::transform(std::execution::par_unseq, lights.begin(), lights.end(), view_space_lights.begin(),
+			[&view_matrix](const point_light& light)
+			{
+				const glm::vec4 center = view_matrix * glm::vec4(light.position.to_glm_vec(), 1.0f);
+				return glm::vec4(glm::vec3(center), light_radius(light));
+			});
+
+		// Find the depth slices that each light touches
+		for (std::vector<u16>& slice : slice_lights)
+			slice.clear();
+
+		for (u16 i = 0; i < view_space_lights.size(); ++i)
+		{
+			const f32 depth = -view_space_lights[i].z;
+			const f32 radius = view_space_lights[i].w;
+
+			if (radius <= 0.0f || depth + radius < near_clip || depth - radius > far_clip)
+				continue;
+
+			const u16 first_slice = depth_slice(std::max(depth - radius, near_clip));
+			const u16 last_slice = depth_slice(std::min(depth + radius, far_clip));
+
+			for (u16 slice = first_slice; slice <= last_slice; ++slice)
+				slice_lights[slice].push_back(i);
+		}
+
+		// Test the lights of each slice against the clusters in that slice
+		std::for_each(std::execution::par_unseq, cluster_ids.begin(), cluster_ids.end(),
+			[this](const u32 cluster)
+			{
+				const bounding_box& bounds = cluster_aabbs[cluster];
+				const std::vector<u16>& candidates = slice_lights[cluster / (grid_size_x * grid_size_y)];
+				u16* cluster_lights = cluster_light_scratch.data() + cluster * max_lights_per_cluster;
+
+				u32 count = 0;
+				for (const u16 light : candidates)
+				{
+					if (count == max_lights_per_cluster)
+						break;
+
+					if (bounds.intersects_sphere(glm::vec3(view_space_lights[light]), view_space_lights[light].w))
+						cluster_lights[count++] = light;
+				}
+
+				_light_ranges[cluster].y = count;
+			});
+
+		// Pack the light lists next to each other
+		u32 light_index_count = 0;
+		_max_cluster_light_count = 0;
+		for (glm::uvec2& range : _light_ranges)
+		{
+			range.x = light_index_count;
+			light_index_count += range.y;
+			_max_cluster_light_count = std::max(_max_cluster_light_count, range.y);
+		}
+
+		_light_indices.resize(light_index_count);
+		std::for_each(std::execution::par_unseq, cluster_ids.begin(), cluster_ids.end(),
+			[this](const u32 cluster)
+			{
+				const u16* cluster_lights = cluster_light_scratch.data() + cluster * max_lights_per_cluster;
+				std::copy(cluster_lights, cluster_lights + _light_ranges[cluster].y, _light_indices.begin() + _light_ranges[cluster].x);
+			});
+	}
+
+	u16 light_clusters::depth_slice(const f32 view_depth) const
+	{
+		ensure(view_depth > 0.0f);
+
+		const f32 slice = std::floor(std::log(view_depth) * _slice_scale - _slice_bias);
+		return std::clamp(static_cast<i32>(slice), 0, grid_size_z - 1);
+	}
+
+	std::span<const u16> light_clusters::cluster_lights(const u32 cluster) const
+	{
+		ensure(cluster < cluster_count);
+		return std::span<const u16>(_light_indices.data() + _light_ranges[cluster].x, _light_ranges[cluster].y);
+	}
+
+	const std::vector<glm::uvec2>& light_clusters::light_ranges() const
+	{
+		return _light_ranges;
+	}
+
+	const std::vector<u16>& light_clusters::light_indices() const
+	{
+		return _light_indices;
+	}
+
+	const bounding_box& light_clusters::cluster_bounds(const u32 cluster) const
+	{
+		ensure(cluster < cluster_count);
+		return cluster_aabbs[cluster];
+	}
+
+	u32 light_clusters::max_cluster_light_count() const
+	{
+		return _max_cluster_light_count;
+	}
+
+	f32 light_clusters::slice_scale() const
+	{
+		return _slice_scale;
+	}
+
+	f32 light_clusters::slice_bias() const
+	{
+		return _slice_bias;
+	}
+
+	f32 light_clusters::light_radius(const point_light& light)
+	{
+		const f32 brightness = std::max({
+			light.ambient.x, light.ambient.y, light.ambient.z,
+			light.diffuse.x, light.diffuse.y, light.diffuse.z,
+			light.specular.x, light.specular.y, light.specular.z,
+		});
+
+		// Solve constant + linear * d + quadratic * d^2 = brightness / cutoff for d
+		const f32 c = light.attenuation_constant - brightness / light_cutoff;
+		const f32 l = light.attenuation_linear;
+		const f32 q = light.attenuation_quadratic;
+
+		// The light is too dim to have any effect
+		if (brightness <= 0.0f || c >= 0.0f)
+			return 0.0f;
+
+		if (q > 0.0f)
+			return (-l + std::sqrt(l * l - 4.0f * q * c)) / (2.0f * q);
+
+		if (l > 0.0f)
+			return -c / l;
+
+		// The light doesn't attenuate at all
+		return std::numeric_limits<f32>::max();
+	}
+
+	void light_clusters::update_cluster_bounds(const f32 fov, const f32 aspect_ratio, const f32 near_clip, const f32 far_clip)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		bounds_fov = fov;
+		bounds_aspect_ratio = aspect_ratio;
+		bounds_near_clip = near_clip;
+		bounds_far_clip = far_clip;
+
+		const f32 depth_ratio_log = std::log(far_clip / near_clip);
+		_slice_scale = grid_size_z / depth_ratio_log;
+		_slice_bias = grid_size_z * std::log(near_clip) / depth_ratio_log;
+
+		if (cluster_ids.empty())
+		{
+			cluster_ids.resize(cluster_count);
+			std::iota(cluster_ids.begin(), cluster_ids.end(), 0);
+		}
+
+		const f32 tan_half_fov = std::tan(glm::radians(fov) * 0.5f);
+
+		for (u16 z = 0; z < grid_size_z; ++z)
+		{
+			const std::array<f32, 2> depths = { slice_depth(z), slice_depth(z + 1) };
+
+			for (u16 y = 0; y < grid_size_y; ++y)
+			{
+				const std::array<f32, 2> ndc_y = { -1.0f + 2.0f * y / grid_size_y, -1.0f + 2.0f * (y + 1) / grid_size_y };
+
+				for (u16 x = 0; x < grid_size_x; ++x)
+				{
+					const std::array<f32, 2> ndc_x = { -1.0f + 2.0f * x / grid_size_x, -1.0f + 2.0f * (x + 1) / grid_size_x };
+
+					// Fit the box around the corners of the cluster. The camera looks towards -z
+					bounding_box box;
+					for (const f32 depth : depths)
+						for (const f32 tile_y : ndc_y)
+							for (const f32 tile_x : ndc_x)
+								box.expand(glm::vec3(tile_x * depth * tan_half_fov * aspect_ratio, tile_y * depth * tan_half_fov, -depth));
+
+					cluster_aabbs[cluster_index(x, y, z)] = box;
+				}
+			}
+		}
+	}
+
+	f32 light_clusters::slice_depth(const u16 slice) const
+	{
+		return bounds_near_clip * std::pow(bounds_far_clip / bounds_near_clip, static_cast<f32>(slice) / grid_size_z);
+	}
+}
@@ -5,30 +5,24 @@ namespace birb
 	line::line(vec3<f32> a, vec3<f32> b)
 	:point_a(a), point_b(b)
 	{
-		vao = std::make_shared<birb::vao>();
-
-		vao->bind();
-		vbo = std::make_shared<birb::vbo>(vertices);
 		update_verts();
-		vao->link_vbo(*vbo, 0, 3, 3, 0);
-		vao->unbind();
+	}
+
+	const std::array<f32, 6>& line::vertices() const
+	{
+		return _vertices;
 	}
 
 	void line::update_verts()
 	{
 		// Point A
-		vertices[0] = point_a.x;
-		vertices[1] = point_a.y;
-		vertices[2] = point_a.z;
+		_vertices[0] = point_a.x;
+		_vertices[1] = point_a.y;
+		_vertices[2] = point_a.z;
 
 		// Point B
-		vertices[3] = point_b.x;
-		vertices[4] = point_b.y;
-		vertices[5] = point_b.z;
-
-		vbo->bind();
-		vbo->set_data(vertices.data(), vertices.size(), gl_usage::dynamic_draw);
-		vao->unbind();
-		vbo->unbind();
+		_vertices[3] = point_b.x;
+		_vertices[4] = point_b.y;
+		_vertices[5] = point_b.z;
 	}
 }
@@ -1,22 +1,37 @@
 #include "Assert.hpp"
 #include "Globals.hpp"
 #include "Logger.hpp"
+#include "Math.hpp"
 #include "Mesh.hpp"
+#include "PackedVertex.hpp"
 #include "Profiling.hpp"
 #include "RendererStats.hpp"
 #include "Shader.hpp"
+#include "ShaderUniforms.hpp"
 
+#include <algorithm>
 #include <climits>
 #include <cstddef>
 #include <glad/gl.h>
+#include <limits>
 #include <string>
 
 namespace birb
 {
-	mesh::mesh(const std::vector<vertex>& vertices, const std::vector<u32>& indices, const std::vector<mesh_texture>& textures, const birb::material& material, const std::string& material_name, const std::string& name)
-	:vertices(vertices), indices(indices), textures(textures), material_name(material_name), material(material), name(name), vbo(gl_buffer_type::array), ebo(gl_buffer_type::element_array)
+	static_assert(std::tuple_size_v<decltype(renderer_stats::lod_triangles)> == mesh::max_lod_count, "Each level of detail needs a triangle counter");
+
+	mesh::mesh(const std::vector<vertex>& vertices, const std::vector<u32>& indices, const std::vector<mesh_texture>& textures, const birb::material& material, const std::string& material_name, const std::string& name, const std::vector<std::vector<u32>>& lod_indices, const bool packed_vertices)
+	:vertices(vertices), indices(indices), textures(textures), material_name(material_name), material(material), name(name), vbo(gl_buffer_type::array), ebo(gl_buffer_type::element_array), packed_vertices(packed_vertices)
 	{
-		setup_mesh();
+		for (const vertex& v : vertices)
+			bounds.expand(v.position);
+
+		for (const mesh_texture& texture : textures)
+			texture_hash = combine_hashes(texture_hash, static_cast<u64>(std::hash<u32>{}(texture.id)));
+
+		ensure(lod_indices.size() < max_lod_count, "Too many levels of detail");
+
+		setup_mesh(lod_indices);
 		birb::log("Mesh constructed: ", name, " (mat: ", material_name, ", addr: ", birb::ptr_to_str(this), ")");
 	}
 
@@ -36,13 +51,27 @@ namespace birb
 
 		ensure(shader.id != 0);
 
-		u32 diffuse_nr = 1;
-		u32 specular_nr = 1;
-
 		// Apply the material on the mesh if it has any
 		if (!skip_materials && !material_name.empty())
 			shader.apply_color_material(material);
 
+		bind_textures(shader);
+		apply_vertex_format(shader);
+
+		// Draw the mesh
+		glBindVertexArray(vao);
+		glDrawElements(GL_TRIANGLES, indices.size(), index_type, 0);
+		glBindVertexArray(0);
+		++render_stats.draw_elements_vao_calls;
+	}
+
+	void mesh::bind_textures(shader& shader) const
+	{
+		ensure(shader.id != 0);
+
+		u32 diffuse_nr = 1;
+		u32 specular_nr = 1;
+
 		for (size_t i = 0; i < textures.size(); ++i)
 		{
 			glActiveTexture(GL_TEXTURE0 + i);
@@ -61,15 +90,89 @@ namespace birb
 			glBindTexture(GL_TEXTURE_2D, textures[i].id);
 		}
 		glActiveTexture(GL_TEXTURE0);
+	}
 
-		// Draw the mesh
-		glBindVertexArray(vao);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+	void mesh::apply_vertex_format(shader& shader) const
+	{
+		// Shaders that don't decode packed vertices can still draw full float vertices
+		if (!shader.has_uniform(shader_uniforms::vertex::position_offset))
+		{
+			ensure(!packed_vertices, "The shader can't decode packed vertices");
+			return;
+		}
+
+		shader.set(shader_uniforms::vertex::position_offset, packed_vertices ? bounds.min : glm::vec3(0.0f));
+		shader.set(shader_uniforms::vertex::position_scale, packed_vertices ? bounds.max - bounds.min : glm::vec3(1.0f));
+
+		// Depth only shaders don't have any use for the normals
+		if (shader.has_uniform(shader_uniforms::vertex::packed_normals))
+			shader.set(shader_uniforms::vertex::packed_normals, packed_vertices ? 1 : 0);
+	}
+
+	void mesh::draw_elements(renderer_stats& render_stats, const u8 lod) const
+	{
+		const mesh_lod range = this->lod(lod);
+
+		glDrawElements(GL_TRIANGLES, range.index_count, index_type, reinterpret_cast<void*>(range.first_index * index_size));
 		++render_stats.draw_elements_vao_calls;
+		render_stats.lod_triangles[std::min(lod, static_cast<u8>(lod_count() - 1))] += range.index_count / 3;
+	}
+
+	void mesh::draw_elements_instanced(const u32 instance_count, renderer_stats& render_stats, const u8 lod) const
+	{
+		ensure(instance_count > 0);
+
+		const mesh_lod range = this->lod(lod);
+
+		glDrawElementsInstanced(GL_TRIANGLES, range.index_count, index_type, reinterpret_cast<void*>(range.first_index * index_size), instance_count);
+		++render_stats.draw_elements_instanced;
+		render_stats.lod_triangles[std::min(lod, static_cast<u8>(lod_count() - 1))] += range.index_count / 3 * instance_count;
+	}
+
+	mesh_lod mesh::lod(const u8 level) const
+	{
+		ensure(!lods.empty());
+		return lods[std::min<size_t>(level, lods.size() - 1)];
+	}
+
+	u8 mesh::lod_count() const
+	{
+		return lods.size();
+	}
+
+	u32 mesh::vao_id() const
+	{
+		return vao;
+	}
+
+	bool mesh::has_short_indices() const
+	{
+		return index_size == sizeof(u16);
+	}
+
+	bool mesh::has_packed_vertices() const
+	{
+		return packed_vertices;
+	}
+
+	u64 mesh::texture_set_hash() const
+	{
+		return texture_hash;
 	}
 
-	void mesh::setup_mesh()
+	bool mesh::shares_textures_with(const mesh& other) const
+	{
+		if (texture_hash != other.texture_hash || textures.size() != other.textures.size())
+			return false;
+
+		for (size_t i = 0; i < textures.size(); ++i)
+			if (textures[i].id != other.textures[i].id || textures[i].type != other.textures[i].type)
+				return false;
+
+		return true;
+	}
+
+	void mesh::setup_mesh(const std::vector<std::vector<u32>>& lod_indices)
 	{
 		PROFILER_SCOPE_MISC_FN();
 
@@ -83,25 +186,88 @@ namespace birb
 		// Bind the VAO and setup the VBO with the vertex data
 		glBindVertexArray(vao);
 		vbo.bind();
-		vbo.set_data(vertices.size() * sizeof(vertex), &vertices[0], gl_usage::static_draw);
 
-		// Bind the EBO and setup the indices
+		if (packed_vertices)
+		{
+			std::vector<packed_vertex> packed(vertices.size());
+			for (size_t i = 0; i < vertices.size(); ++i)
+				packed[i] = vertex_packing::pack(vertices[i], bounds);
+
+			vbo.set_data(packed.size() * sizeof(packed_vertex), &packed[0], gl_usage::static_draw);
+		}
+		else
+		{
+			vbo.set_data(vertices.size() * sizeof(vertex), &vertices[0], gl_usage::static_draw);
+		}
+
+		// The levels of detail share the vertices, so their indices
+		// are placed one after another into a single index buffer
+		lods.push_back({ 0, static_cast<u32>(indices.size()) });
+
+		std::vector<u32> lod_buffer;
+		if (!lod_indices.empty())
+		{
+			lod_buffer = indices;
+			for (const std::vector<u32>& level : lod_indices)
+			{
+				ensure(!level.empty());
+
+				lods.push_back({ static_cast<u32>(lod_buffer.size()), static_cast<u32>(level.size()) });
+				lod_buffer.insert(lod_buffer.end(), level.begin(), level.end());
+			}
+		}
+
+		const std::vector<u32>& index_buffer = lod_buffer.empty() ? indices : lod_buffer;
+
+		// Bind the EBO and setup the indices. Meshes with few enough
+		// vertices get 16-bit indices to halve the index buffer size
 		ebo.bind();
-		ebo.set_data(indices.size() * sizeof(u32), &indices[0], gl_usage::static_draw);
+		if (vertices.size() <= std::numeric_limits<u16>::max())
+		{
+			const std::vector<u16> short_indices(index_buffer.begin(), index_buffer.end());
+			ebo.set_data(short_indices.size() * sizeof(u16), &short_indices[0], gl_usage::static_draw);
+
+			index_type = GL_UNSIGNED_SHORT;
+			index_size = sizeof(u16);
+		}
+		else
+		{
+			ebo.set_data(index_buffer.size() * sizeof(u32), &index_buffer[0], gl_usage::static_draw);
+
+			index_type = GL_UNSIGNED_INT;
+			index_size = sizeof(u32);
+		}
 
 		// -- Load data into the currently bound VBO, I think ... --
 
-		// Vertex positions
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), nullptr);
+		if (packed_vertices)
+		{
+			// Positions relative to the mesh bounds
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(packed_vertex), reinterpret_cast<void*>(offsetof(packed_vertex, position)));
+
+			// Octahedral encoded normals
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(packed_vertex), reinterpret_cast<void*>(offsetof(packed_vertex, normal)));
 
-		// Vertex normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(offsetof(vertex, normal)));
+			// Half float texture coordinates
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(packed_vertex), reinterpret_cast<void*>(offsetof(packed_vertex, tex_coords)));
+		}
+		else
+		{
+			// Vertex positions
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), nullptr);
 
-		// Vertex texture coordinates
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(offsetof(vertex, tex_coords)));
+			// Vertex normals
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(offsetof(vertex, normal)));
+
+			// Vertex texture coordinates
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(offsetof(vertex, tex_coords)));
+		}
 
 		// Unbind the VAO
 		glBindVertexArray(0);
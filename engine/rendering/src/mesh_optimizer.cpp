@@ -0,0 +1,401 @@
+#include "Assert.hpp"
+#include "Math.hpp"
+#include "Mesh.hpp"
+#include "MeshOptimizer.hpp"
+#include "Profiling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace birb
+{
+	namespace mesh_optimizer
+	{
+		static constexpr u32 invalid_index = std::numeric_limits<u32>::max();
+
+		// Tuning values for the vertex cache optimization from the original article by Tom Forsyth
+		static constexpr u32 forsyth_cache_size = 32;
+		static constexpr f32 cache_decay_power = 1.5f;
+		static constexpr f32 last_triangle_score = 0.75f;
+		static constexpr f32 valence_boost_scale = 2.0f;
+		static constexpr f32 valence_boost_power = 0.5f;
+
+		// Size of the simulated FIFO cache that the overdraw optimization uses for finding the cluster boundaries
+		static constexpr u32 overdraw_cache_size = 16;
+
+		/**
+		 * @brief Push the vertices of a triangle into a simulated FIFO cache
+		 *
+		 * A vertex is in the cache if it was pushed less than cache_size pushes ago.
+		 * Increasing the timestamp by cache_size + 1 empties the cache
+		 *
+		 * @return Amount of vertices that were not in the cache
+		 */
+		static u32 push_to_fifo_cache(const u32* triangle, const u32 cache_size, std::vector<u32>& timestamps, u32& timestamp)
+		{
+			u32 misses = 0;
+
+			for (u8 i = 0; i < 3; ++i)
+			{
+				if (timestamp - timestamps[triangle[i]] > cache_size)
+				{
+					timestamps[triangle[i]] = timestamp++;
+					++misses;
+				}
+			}
+
+			return misses;
+		}
+
+		static f32 vertex_score(const i32 cache_position, const u32 live_triangles)
+		{
+			// The vertex isn't needed by any of the remaining triangles
+			if (live_triangles == 0)
+				return -1.0f;
+
+			f32 score = 0.0f;
+
+			if (cache_position >= 0)
+			{
+				// The vertices of the latest triangle get a fixed score, so that
+				// the next triangle doesn't prefer any of the three edges
+				if (cache_position < 3)
+				{
+					score = last_triangle_score;
+				}
+				else
+				{
+					const f32 scale = 1.0f / (forsyth_cache_size - 3);
+					score = std::pow(1.0f - (cache_position - 3) * scale, cache_decay_power);
+				}
+			}
+
+			// Prefer vertices with only a few triangles left, so that they
+			// get finished off instead of leaving lonely triangles behind
+			score += valence_boost_scale * std::pow(static_cast<f32>(live_triangles), -valence_boost_power);
+
+			return score;
+		}
+
+		void weld_vertices(std::vector<vertex>& vertices, std::vector<u32>& indices)
+		{
+			PROFILER_SCOPE_MISC_FN();
+
+			const auto hash = [](const vertex& v) -> size_t
+			{
+				u64 result = 0;
+				for (const f32 value : { v.position.x, v.position.y, v.position.z, v.normal.x, v.normal.y, v.normal.z, v.tex_coords.x, v.tex_coords.y })
+					result = combine_hashes(result, static_cast<u64>(std::hash<f32>{}(value)));
+
+				return result;
+			};
+
+			const auto equal = [](const vertex& a, const vertex& b)
+			{
+				return a.position == b.position && a.normal == b.normal && a.tex_coords == b.tex_coords;
+			};
+
+			std::unordered_map<vertex, u32, decltype(hash), decltype(equal)> unique_vertices(vertices.size(), hash, equal);
+
+			std::vector<u32> remap(vertices.size(), invalid_index);
+			std::vector<vertex> welded;
+			welded.reserve(vertices.size());
+
+			for (u32& index : indices)
+			{
+				ensure(index < vertices.size(), "Vertex index out of range");
+
+				if (remap[index] == invalid_index)
+				{
+					const auto [it, inserted] = unique_vertices.try_emplace(vertices[index], welded.size());
+					if (inserted)
+						welded.push_back(vertices[index]);
+
+					remap[index] = it->second;
+				}
+
+				index = remap[index];
+			}
+
+			vertices = std::move(welded);
+		}
+
+		void optimize_vertex_cache(std::vector<u32>& indices, const size_t vertex_count)
+		{
+			PROFILER_SCOPE_MISC_FN();
+
+			ensure(indices.size() % 3 == 0, "Only triangle lists can be optimized");
+
+			const size_t triangle_count = indices.size() / 3;
+			if (triangle_count == 0)
+				return;
+
+			// Triangles that use each vertex. The live triangles of a vertex
+			// are kept at the start of its range
+			std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+			for (const u32 index : indices)
+				++adjacency_offsets[index + 1];
+
+			std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+
+			std::vector<u32> live_triangles(vertex_count);
+			std::vector<u32> adjacency(indices.size());
+			for (size_t i = 0; i < indices.size(); ++i)
+				adjacency[adjacency_offsets[indices[i]] + live_triangles[indices[i]]++] = i / 3;
+
+			std::vector<i32> cache_positions(vertex_count, -1);
+			std::vector<f32> vertex_scores(vertex_count);
+			for (size_t i = 0; i < vertex_count; ++i)
+				vertex_scores[i] = vertex_score(-1, live_triangles[i]);
+
+			std::vector<u8> emitted(triangle_count, 0);
+			std::vector<u32> result;
+			result.reserve(indices.size());
+
+			// The extra space is for the vertices that get pushed out by the latest triangle
+			std::array<u32, forsyth_cache_size + 3> cache;
+			std::array<u32, forsyth_cache_size + 3> new_cache;
+			u32 cache_count = 0;
+
+			u32 best_triangle = invalid_index;
+			u32 next_unemitted = 0;
+
+			for (size_t i = 0; i < triangle_count; ++i)
+			{
+				// None of the cached vertices have any triangles left, so continue
+				// from the next triangle in the original order
+				if (best_triangle == invalid_index)
+				{
+					while (emitted[next_unemitted])
+						++next_unemitted;
+
+					best_triangle = next_unemitted;
+				}
+
+				const u32* triangle = &indices[best_triangle * 3];
+				emitted[best_triangle] = 1;
+				result.insert(result.end(), triangle, triangle + 3);
+
+				// Move the vertices of the triangle to the front of the cache
+				u32 new_cache_count = 0;
+				for (u8 j = 0; j < 3; ++j)
+					new_cache[new_cache_count++] = triangle[j];
+
+				for (u32 j = 0; j < cache_count; ++j)
+					if (cache[j] != triangle[0] && cache[j] != triangle[1] && cache[j] != triangle[2])
+						new_cache[new_cache_count++] = cache[j];
+
+				// Remove the triangle from the live triangles of its vertices
+				for (u8 j = 0; j < 3; ++j)
+				{
+					const u32 v = triangle[j];
+					u32* live = &adjacency[adjacency_offsets[v]];
+					u32* live_end = live + live_triangles[v];
+
+					u32* it = std::find(live, live_end, best_triangle);
+					ensure(it != live_end);
+
+					*it = *(live_end - 1);
+					--live_triangles[v];
+				}
+
+				// Vertices that fell out of the cache get their position reset too
+				for (u32 j = 0; j < new_cache_count; ++j)
+				{
+					const u32 v = new_cache[j];
+					cache_positions[v] = j < forsyth_cache_size ? static_cast<i32>(j) : -1;
+					vertex_scores[v] = vertex_score(cache_positions[v], live_triangles[v]);
+				}
+
+				// Only the triangles around the cached vertices had their scores changed,
+				// so the next triangle is picked from those
+				best_triangle = invalid_index;
+				f32 best_score = -1.0f;
+
+				for (u32 j = 0; j < new_cache_count; ++j)
+				{
+					const u32 v = new_cache[j];
+					for (u32 k = adjacency_offsets[v]; k < adjacency_offsets[v] + live_triangles[v]; ++k)
+					{
+						const u32 t = adjacency[k];
+						const f32 score = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+
+						if (score > best_score)
+						{
+							best_triangle = t;
+							best_score = score;
+						}
+					}
+				}
+
+				cache_count = std::min(new_cache_count, forsyth_cache_size);
+				std::copy(new_cache.begin(), new_cache.begin() + cache_count, cache.begin());
+			}
+
+			indices = std::move(result);
+		}
+
+		void optimize_overdraw(std::vector<u32>& indices, std::span<const vertex> vertices, const f32 threshold)
+		{
+			PROFILER_SCOPE_MISC_FN();
+
+			ensure(indices.size() % 3 == 0, "Only triangle lists can be optimized");
+			ensure(threshold >= 1.0f);
+
+			const u32 triangle_count = indices.size() / 3;
+			if (triangle_count == 0)
+				return;
+
+			std::vector<u32> timestamps(vertices.size(), 0);
+			u32 timestamp = overdraw_cache_size + 1;
+
+			// Triangles where all of the vertices miss the cache start from a cold cache anyway
+			std::vector<u32> hard_boundaries;
+			for (u32 i = 0; i < triangle_count; ++i)
+				if (push_to_fifo_cache(&indices[i * 3], overdraw_cache_size, timestamps, timestamp) == 3 || i == 0)
+					hard_boundaries.push_back(i);
+
+			hard_boundaries.push_back(triangle_count);
+
+			// Split the clusters further at the points where the cache miss ratio of the cluster
+			// so far is low enough that starting over with a cold cache doesn't hurt much
+			std::vector<u32> cluster_starts;
+			for (size_t i = 0; i + 1 < hard_boundaries.size(); ++i)
+			{
+				const u32 start = hard_boundaries[i];
+				const u32 end = hard_boundaries[i + 1];
+
+				timestamp += overdraw_cache_size + 1;
+				u32 cluster_misses = 0;
+				for (u32 j = start; j < end; ++j)
+					cluster_misses += push_to_fifo_cache(&indices[j * 3], overdraw_cache_size, timestamps, timestamp);
+
+				const f32 cluster_threshold = threshold * cluster_misses / (end - start);
+
+				timestamp += overdraw_cache_size + 1;
+				u32 misses = 0;
+				u32 cluster_start = start;
+
+				for (u32 j = start; j < end; ++j)
+				{
+					misses += push_to_fifo_cache(&indices[j * 3], overdraw_cache_size, timestamps, timestamp);
+
+					if (j == end - 1 || static_cast<f32>(misses) / (j - cluster_start + 1) <= cluster_threshold)
+					{
+						cluster_starts.push_back(cluster_start);
+						cluster_start = j + 1;
+						misses = 0;
+						timestamp += overdraw_cache_size + 1;
+					}
+				}
+			}
+
+			cluster_starts.push_back(triangle_count);
+
+			const auto triangle_centroid = [&indices, &vertices](const u32 triangle)
+			{
+				return (vertices[indices[triangle * 3]].position
+					+ vertices[indices[triangle * 3 + 1]].position
+					+ vertices[indices[triangle * 3 + 2]].position) / 3.0f;
+			};
+
+			glm::vec3 mesh_centroid(0.0f);
+			for (u32 i = 0; i < triangle_count; ++i)
+				mesh_centroid += triangle_centroid(i);
+
+			mesh_centroid /= static_cast<f32>(triangle_count);
+
+			// Clusters that face away from the center of the mesh are on its outer
+			// surface and likely to cover the rest of the mesh, so they get drawn first
+			struct cluster
+			{
+				u32 first_triangle;
+				u32 triangle_count;
+				f32 sort_key;
+			};
+
+			std::vector<cluster> clusters(cluster_starts.size() - 1);
+			for (size_t i = 0; i < clusters.size(); ++i)
+			{
+				cluster& c = clusters[i];
+				c.first_triangle = cluster_starts[i];
+				c.triangle_count = cluster_starts[i + 1] - cluster_starts[i];
+
+				glm::vec3 centroid(0.0f);
+				glm::vec3 normal(0.0f);
+
+				for (u32 j = c.first_triangle; j < c.first_triangle + c.triangle_count; ++j)
+				{
+					const glm::vec3& p0 = vertices[indices[j * 3]].position;
+					const glm::vec3& p1 = vertices[indices[j * 3 + 1]].position;
+					const glm::vec3& p2 = vertices[indices[j * 3 + 2]].position;
+
+					centroid += triangle_centroid(j);
+
+					// Area weighted
+					normal += glm::cross(p1 - p0, p2 - p0);
+				}
+
+				centroid /= static_cast<f32>(c.triangle_count);
+
+				const f32 normal_length = glm::length(normal);
+				c.sort_key = normal_length > 0.0f ? glm::dot(centroid - mesh_centroid, normal / normal_length) : 0.0f;
+			}
+
+			std::stable_sort(clusters.begin(), clusters.end(), [](const cluster& a, const cluster& b) { return a.sort_key > b.sort_key; });
+
+			std::vector<u32> result;
+			result.reserve(indices.size());
+
+			for (const cluster& c : clusters)
+				result.insert(result.end(), indices.begin() + c.first_triangle * 3, indices.begin() + (c.first_triangle + c.triangle_count) * 3);
+
+			indices = std::move(result);
+		}
+
+		void optimize_vertex_fetch(std::vector<vertex>& vertices, std::vector<u32>& indices)
+		{
+			PROFILER_SCOPE_MISC_FN();
+
+			std::vector<u32> remap(vertices.size(), invalid_index);
+			std::vector<vertex> reordered;
+			reordered.reserve(vertices.size());
+
+			for (u32& index : indices)
+			{
+				ensure(index < vertices.size(), "Vertex index out of range");
+
+				if (remap[index] == invalid_index)
+				{
+					remap[index] = reordered.size();
+					reordered.push_back(vertices[index]);
+				}
+
+				index = remap[index];
+			}
+
+			vertices = std::move(reordered);
+		}
+
+		f32 acmr(std::span<const u32> indices, const size_t vertex_count, const u32 cache_size)
+		{
+			const size_t triangle_count = indices.size() / 3;
+			if (triangle_count == 0)
+				return 0.0f;
+
+			std::vector<u32> timestamps(vertex_count, 0);
+			u32 timestamp = cache_size + 1;
+			u32 misses = 0;
+
+			for (size_t i = 0; i < triangle_count; ++i)
+				misses += push_to_fifo_cache(&indices[i * 3], cache_size, timestamps, timestamp);
+
+			return static_cast<f32>(misses) / triangle_count;
+		}
+	}
+}
@@ -0,0 +1,420 @@
+#include "Assert.hpp"
+#include "BoundingBox.hpp"
+#include "Mesh.hpp"
+#include "MeshSimplifier.hpp"
+#include "Profiling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <limits>
+#include <numeric>
+
+namespace birb
+{
+	namespace mesh_simplifier
+	{
+		// Meshes with less triangles than this don't get any levels of detail
+		static constexpr size_t lod_min_triangle_count = 64;
+
+		// Each level of detail aims for this fraction of the triangles of the previous level
+		static constexpr f32 lod_triangle_ratio = 0.5f;
+
+		// Levels that keep more than this fraction of the triangles of the previous level are left out
+		static constexpr f32 lod_min_reduction = 0.85f;
+
+		// Largest allowed collapse error for each level relative to the size of the mesh
+		static constexpr std::array<f32, 3> lod_max_errors = { 0.01f, 0.025f, 0.06f };
+
+		/**
+		 * @brief Symmetric 4x4 matrix that sums up squared distances to a set of planes
+		 */
+		struct quadric
+		{
+			f64 xx = 0.0, xy = 0.0, xz = 0.0, xw = 0.0;
+			f64 yy = 0.0, yz = 0.0, yw = 0.0;
+			f64 zz = 0.0, zw = 0.0;
+			f64 ww = 0.0;
+
+			// Total weight of the planes. Used for averaging the error
+			f64 weight = 0.0;
+
+			void add_plane(const glm::vec3& normal, const f32 distance, const f64 plane_weight)
+			{
+				const f64 a = normal.x;
+				const f64 b = normal.y;
+				const f64 c = normal.z;
+				const f64 d = distance;
+
+				xx += plane_weight * a * a;
+				xy += plane_weight * a * b;
+				xz += plane_weight * a * c;
+				xw += plane_weight * a * d;
+				yy += plane_weight * b * b;
+				yz += plane_weight * b * c;
+				yw += plane_weight * b * d;
+				zz += plane_weight * c * c;
+				zw += plane_weight * c * d;
+				ww += plane_weight * d * d;
+				weight += plane_weight;
+			}
+
+			void add(const quadric& other)
+			{
+				xx += other.xx;
+				xy += other.xy;
+				xz += other.xz;
+				xw += other.xw;
+				yy += other.yy;
+				yz += other.yz;
+				yw += other.yw;
+				zz += other.zz;
+				zw += other.zw;
+				ww += other.ww;
+				weight += other.weight;
+			}
+
+			/**
+			 * @brief Weighted average of the squared distances from a point to the planes
+			 */
+			f64 error(const glm::vec3& point) const
+			{
+				if (weight <= 0.0)
+					return 0.0;
+
+				const f64 x = point.x;
+				const f64 y = point.y;
+				const f64 z = point.z;
+
+				const f64 sum = xx * x * x + 2.0 * xy * x * y + 2.0 * xz * x * z + 2.0 * xw * x
+					+ yy * y * y + 2.0 * yz * y * z + 2.0 * yw * y
+					+ zz * z * z + 2.0 * zw * z
+					+ ww;
+
+				// Rounding errors can make the sum slightly negative
+				return std::max(sum / weight, 0.0);
+			}
+		};
+
+		struct collapse
+		{
+			u32 from;
+			u32 to;
+			f64 cost;
+		};
+
+		static u64 edge_key(const u32 a, const u32 b)
+		{
+			return (static_cast<u64>(std::min(a, b)) << 32) | std::max(a, b);
+		}
+
+		std::vector<u32> simplify(std::span<const vertex> vertices, std::span<const u32> indices, const size_t target_index_count, const f32 max_error)
+		{
+			PROFILER_SCOPE_MISC_FN();
+
+			ensure(indices.size() % 3 == 0, "Only triangle lists can be simplified");
+
+			std::vector<u32> corners(indices.begin(), indices.end());
+			if (corners.size() <= target_index_count)
+				return corners;
+
+			// Vertices that share a position get merged, so that seams in the
+			// normals and texture coordinates don't stop the collapses. The vertices
+			// of each position are a contiguous range in the sorted order
+			std::vector<u32> order(vertices.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [&vertices](const u32 a, const u32 b)
+			{
+				const glm::vec3& pa = vertices[a].position;
+				const glm::vec3& pb = vertices[b].position;
+
+				if (pa.x != pb.x)
+					return pa.x < pb.x;
+
+				if (pa.y != pb.y)
+					return pa.y < pb.y;
+
+				return pa.z < pb.z;
+			});
+
+			std::vector<u32> position_ids(vertices.size());
+			std::vector<glm::vec3> positions;
+			std::vector<u32> position_vertex_offsets;
+			bounding_box bounds;
+
+			for (u32 i = 0; i < order.size(); ++i)
+			{
+				if (i == 0 || vertices[order[i]].position != vertices[order[i - 1]].position)
+				{
+					positions.push_back(vertices[order[i]].position);
+					position_vertex_offsets.push_back(i);
+					bounds.expand(positions.back());
+				}
+
+				position_ids[order[i]] = positions.size() - 1;
+			}
+			position_vertex_offsets.push_back(order.size());
+
+			const f64 max_cost = std::pow(static_cast<f64>(max_error) * glm::length(bounds.max - bounds.min), 2.0);
+
+			const auto corner_position = [&position_ids, &corners](const size_t corner)
+			{
+				return position_ids[corners[corner]];
+			};
+
+			// Area weighted triangle planes around each position
+			std::vector<quadric> quadrics(positions.size());
+			for (size_t i = 0; i < corners.size(); i += 3)
+			{
+				const glm::vec3& p0 = positions[corner_position(i)];
+				const glm::vec3& p1 = positions[corner_position(i + 1)];
+				const glm::vec3& p2 = positions[corner_position(i + 2)];
+
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const f32 length = glm::length(normal);
+				if (length == 0.0f)
+					continue;
+
+				const glm::vec3 unit_normal = normal / length;
+				const f32 distance = -glm::dot(unit_normal, p0);
+
+				for (u8 j = 0; j < 3; ++j)
+					quadrics[corner_position(i + j)].add_plane(unit_normal, distance, length * 0.5f);
+			}
+
+			std::vector<u64> edges;
+			const auto collect_edges = [&edges, &corners, &corner_position]()
+			{
+				edges.clear();
+				for (size_t i = 0; i < corners.size(); i += 3)
+				{
+					for (u8 j = 0; j < 3; ++j)
+					{
+						const u32 a = corner_position(i + j);
+						const u32 b = corner_position(i + (j + 1) % 3);
+
+						if (a != b)
+							edges.push_back(edge_key(a, b));
+					}
+				}
+				std::sort(edges.begin(), edges.end());
+			};
+
+			// Edges that only have a single triangle are on an open border and edges with more
+			// than two triangles are non-manifold. Moving their vertices would tear the mesh
+			std::vector<u8> locked(positions.size(), 0);
+			collect_edges();
+			for (size_t i = 0; i < edges.size();)
+			{
+				size_t run_end = i + 1;
+				while (run_end < edges.size() && edges[run_end] == edges[i])
+					++run_end;
+
+				if (run_end - i != 2)
+				{
+					locked[edges[i] >> 32] = 1;
+					locked[edges[i] & 0xFFFFFFFF] = 1;
+				}
+
+				i = run_end;
+			}
+
+			// Pick the vertex at a position that has the closest normal and texture
+			// coordinates to a vertex that is being moved there
+			const auto closest_vertex = [&vertices, &order, &position_vertex_offsets](const u32 position, const u32 original)
+			{
+				u32 closest = order[position_vertex_offsets[position]];
+				f32 closest_distance = std::numeric_limits<f32>::max();
+
+				for (u32 i = position_vertex_offsets[position]; i < position_vertex_offsets[position + 1]; ++i)
+				{
+					const glm::vec3 normal_difference = vertices[order[i]].normal - vertices[original].normal;
+					const glm::vec2 uv_difference = vertices[order[i]].tex_coords - vertices[original].tex_coords;
+					const f32 distance = glm::dot(normal_difference, normal_difference) + glm::dot(uv_difference, uv_difference);
+
+					if (distance < closest_distance)
+					{
+						closest = order[i];
+						closest_distance = distance;
+					}
+				}
+
+				return closest;
+			};
+
+			std::vector<u32> adjacency_offsets;
+			std::vector<u32> adjacency;
+			std::vector<u32> adjacency_fill;
+			std::vector<u8> removed_triangles;
+			std::vector<u8> touched(positions.size());
+			std::vector<collapse> collapses;
+
+			// Collapsing the edge shouldn't flip any of the triangles around the moved position
+			const auto flips_triangles = [&](const collapse& collapse)
+			{
+				for (u32 i = adjacency_offsets[collapse.from]; i < adjacency_offsets[collapse.from + 1]; ++i)
+				{
+					const u32 triangle = adjacency[i];
+					if (removed_triangles[triangle])
+						continue;
+
+					std::array<u32, 3> ids = { corner_position(triangle * 3), corner_position(triangle * 3 + 1), corner_position(triangle * 3 + 2) };
+
+					// Triangles on the collapsed edge get removed
+					if (std::find(ids.begin(), ids.end(), collapse.to) != ids.end())
+						continue;
+
+					const glm::vec3 before = glm::cross(positions[ids[1]] - positions[ids[0]], positions[ids[2]] - positions[ids[0]]);
+
+					std::replace(ids.begin(), ids.end(), collapse.from, collapse.to);
+					const glm::vec3 after = glm::cross(positions[ids[1]] - positions[ids[0]], positions[ids[2]] - positions[ids[0]]);
+
+					if (glm::dot(before, after) <= 0.0f)
+						return true;
+				}
+
+				return false;
+			};
+
+			// Each pass collapses the cheapest edges that don't share any positions with each other
+			while (corners.size() > target_index_count)
+			{
+				const size_t triangle_count = corners.size() / 3;
+
+				// Triangles around each position
+				adjacency_offsets.assign(positions.size() + 1, 0);
+				for (size_t i = 0; i < corners.size(); ++i)
+					++adjacency_offsets[corner_position(i) + 1];
+
+				std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+
+				adjacency.resize(corners.size());
+				adjacency_fill.assign(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+				for (size_t i = 0; i < corners.size(); ++i)
+					adjacency[adjacency_fill[corner_position(i)]++] = i / 3;
+
+				// Move the unlocked end of each edge onto the other end. If both
+				// ends can be moved, the cheaper direction is used
+				collect_edges();
+				edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+				collapses.clear();
+				for (const u64 edge : edges)
+				{
+					const u32 a = edge >> 32;
+					const u32 b = edge & 0xFFFFFFFF;
+
+					if (locked[a] && locked[b])
+						continue;
+
+					quadric combined = quadrics[a];
+					combined.add(quadrics[b]);
+
+					const f64 cost_a_to_b = locked[a] ? std::numeric_limits<f64>::max() : combined.error(positions[b]);
+					const f64 cost_b_to_a = locked[b] ? std::numeric_limits<f64>::max() : combined.error(positions[a]);
+
+					if (cost_a_to_b <= cost_b_to_a)
+						collapses.push_back({ a, b, cost_a_to_b });
+					else
+						collapses.push_back({ b, a, cost_b_to_a });
+				}
+
+				std::sort(collapses.begin(), collapses.end(), [](const collapse& a, const collapse& b) { return a.cost < b.cost; });
+
+				removed_triangles.assign(triangle_count, 0);
+				std::fill(touched.begin(), touched.end(), 0);
+
+				const size_t triangles_to_remove = (corners.size() - target_index_count + 2) / 3;
+				size_t removed_count = 0;
+				size_t collapse_count = 0;
+
+				for (const collapse& collapse : collapses)
+				{
+					if (collapse.cost > max_cost || removed_count >= triangles_to_remove)
+						break;
+
+					if (touched[collapse.from] || touched[collapse.to] || flips_triangles(collapse))
+						continue;
+
+					for (u32 i = adjacency_offsets[collapse.from]; i < adjacency_offsets[collapse.from + 1]; ++i)
+					{
+						const u32 triangle = adjacency[i];
+						if (removed_triangles[triangle])
+							continue;
+
+						for (u8 j = 0; j < 3; ++j)
+							if (corner_position(triangle * 3 + j) == collapse.from)
+								corners[triangle * 3 + j] = closest_vertex(collapse.to, corners[triangle * 3 + j]);
+
+						const u32 p0 = corner_position(triangle * 3);
+						const u32 p1 = corner_position(triangle * 3 + 1);
+						const u32 p2 = corner_position(triangle * 3 + 2);
+
+						if (p0 == p1 || p1 == p2 || p2 == p0)
+						{
+							removed_triangles[triangle] = 1;
+							++removed_count;
+						}
+					}
+
+					quadrics[collapse.to].add(quadrics[collapse.from]);
+					touched[collapse.from] = 1;
+					touched[collapse.to] = 1;
+					++collapse_count;
+				}
+
+				if (collapse_count == 0)
+					break;
+
+				// Drop the triangles that collapsed into lines
+				size_t write = 0;
+				for (size_t i = 0; i < triangle_count; ++i)
+				{
+					if (removed_triangles[i])
+						continue;
+
+					for (u8 j = 0; j < 3; ++j)
+						corners[write * 3 + j] = corners[i * 3 + j];
+
+					++write;
+				}
+				corners.resize(write * 3);
+			}
+
+			return corners;
+		}
+
+		std::vector<std::vector<u32>> generate_lods(std::span<const vertex> vertices, std::span<const u32> indices, const u8 lod_count)
+		{
+			PROFILER_SCOPE_MISC_FN();
+
+			std::vector<std::vector<u32>> lods;
+			if (lod_count <= 1 || indices.size() / 3 < lod_min_triangle_count)
+				return lods;
+
+			// The levels reference each other, so they can't be moved around
+			lods.reserve(lod_count - 1);
+
+			// Each level is simplified from the previous one, which is cheaper than
+			// starting from the full mesh every time
+			std::span<const u32> previous = indices;
+
+			for (u8 level = 1; level < lod_count; ++level)
+			{
+				const size_t target_index_count = static_cast<size_t>(previous.size() / 3 * lod_triangle_ratio) * 3;
+				const f32 max_error = lod_max_errors[std::min<size_t>(level - 1, lod_max_errors.size() - 1)];
+
+				std::vector<u32> simplified = simplify(vertices, previous, target_index_count, max_error);
+
+				if (simplified.size() > previous.size() * lod_min_reduction)
+					break;
+
+				lods.push_back(std::move(simplified));
+				previous = lods.back();
+			}
+
+			return lods;
+		}
+	}
+}
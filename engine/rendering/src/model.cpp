@@ -1,6 +1,9 @@
 #include "Assert.hpp"
+#include "Image.hpp"
 #include "Logger.hpp"
 #include "Mesh.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
 #include "Model.hpp"
 #include "Profiling.hpp"
 #include "RendererStats.hpp"
@@ -8,10 +11,13 @@
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
+#include <algorithm>
+#include <array>
 #include <assimp/scene.h>
 #include <filesystem>
 #include <imgui.h>
 #include <imgui_stdlib.h>
+#include <stb_sprintf.h>
 
 #ifndef NDEBUG
 #include <filesystem> // Needed for asserts
@@ -19,16 +25,34 @@
 
 namespace birb
 {
+	// Screen sizes below which the model switches to the next level of detail
+	static constexpr std::array<f32, mesh::max_lod_count - 1> lod_screen_sizes = { 0.4f, 0.2f, 0.08f };
+
+	// How far past a threshold the screen size needs to get before the level of detail changes
+	static constexpr f32 lod_hysteresis = 0.15f;
+
+	// How much the overdraw optimization is allowed to worsen the vertex cache efficiency
+	static constexpr f32 overdraw_threshold = 1.05f;
+
+	static std::string acmr_text(const f32 unoptimized, const f32 optimized)
+	{
+		std::array<char, 32> buffer;
+		stbsp_snprintf(buffer.data(), buffer.size(), "%.3f -> %.3f", unoptimized, optimized);
+		return buffer.data();
+	}
+
 	model::model()
 	{
 		textures_loaded = std::make_shared<std::vector<mesh_texture>>();
 		meshes = std::make_shared<std::vector<mesh>>();
+		packed_vertices = std::make_shared<bool>(false);
 	}
 
 	model::model(const std::string& path)
 	{
 		textures_loaded = std::make_shared<std::vector<mesh_texture>>();
 		meshes = std::make_shared<std::vector<mesh>>();
+		packed_vertices = std::make_shared<bool>(false);
 		load_model(path);
 	}
 
@@ -52,6 +76,21 @@ namespace birb
 		{
 			draw_info_table_row("Meshes", meshes->size());
 			draw_info_table_row("Textures loaded", textures_loaded->size());
+			draw_info_table_row("Levels of detail", static_cast<u32>(max_lod_count));
+
+			// Average over all of the meshes weighted by their triangle counts
+			f32 unoptimized_misses = 0.0f;
+			f32 optimized_misses = 0.0f;
+			size_t triangle_count = 0;
+			for (const birb::mesh& mesh : *meshes)
+			{
+				unoptimized_misses += mesh.unoptimized_acmr * (mesh.indices.size() / 3);
+				optimized_misses += mesh.optimized_acmr * (mesh.indices.size() / 3);
+				triangle_count += mesh.indices.size() / 3;
+			}
+
+			if (triangle_count > 0)
+				draw_info_table_row("ACMR", acmr_text(unoptimized_misses / triangle_count, optimized_misses / triangle_count));
 			draw_info_table_row("File path", file_path);
 			draw_info_table_row("Directory", directory);
 		}
@@ -68,6 +107,9 @@ namespace birb
 					ImGui::BeginTable(table_name.c_str(), 2);
 					draw_info_table_row("Vertices", meshes->at(i).vertices.size());
 					draw_info_table_row("Indices", meshes->at(i).indices.size());
+					draw_info_table_row("Levels of detail", static_cast<u32>(meshes->at(i).lod_count()));
+					draw_info_table_row("ACMR", acmr_text(meshes->at(i).unoptimized_acmr, meshes->at(i).optimized_acmr));
+					draw_info_table_row("Index size", std::string(meshes->at(i).has_short_indices() ? "16-bit" : "32-bit"));
 					draw_info_table_row("Textures", meshes->at(i).textures.size());
 					ImGui::EndTable();
 					ImGui::TreePop();
@@ -82,6 +124,10 @@ namespace birb
 		ImGui::Separator();
 		ImGui::Spacing();
 
+		bool packed_vertices_enabled = *packed_vertices;
+		if (ImGui::Checkbox("Packed vertices", &packed_vertices_enabled))
+			opt_packed_vertices(packed_vertices_enabled);
+
 		ImGui::InputText("File path", &text_box_model_file_path);
 
 		if (ImGui::Button("Reload"))
@@ -137,9 +183,46 @@ namespace birb
 
 		birb::log("Loading model: " + path);
 
+		load_model(*import_file(path));
+	}
+
+	void model::load_model(const import_data& data)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(!data.path.empty());
+
 		file_exists = true;
-		file_path = path;
-		text_box_model_file_path = path;
+		file_path = data.path;
+		text_box_model_file_path = data.path;
+
+		if (!data.success)
+			return;
+
+		directory = data.directory;
+		upload_meshes(data);
+
+		birb::log("Model loaded: " + data.path);
+		last_write_time = data.write_time;
+	}
+
+	std::shared_ptr<model::import_data> model::import_file(const std::string& path)
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		ensure(!path.empty());
+		ensure(path != null_path, "Tried to import a model from disk that was probably meant to be loaded from memory");
+
+		std::shared_ptr<import_data> data = std::make_shared<import_data>();
+		data->path = path;
+
+		std::error_code error;
+		data->write_time = std::filesystem::last_write_time(path, error);
+		if (error)
+		{
+			birb::log_error("Model file doesn't exist: ", path);
+			return data;
+		}
 
 		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -147,23 +230,20 @@ namespace birb
 		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 		{
 			birb::log_error("assimp error: ", importer.GetErrorString());
-			return;
+			return data;
 		}
 
 		size_t last_slash = path.find_last_of('/');
 
 		if (last_slash != std::string::npos)
-			directory = path.substr(0, last_slash);
+			data->directory = path.substr(0, last_slash);
 		else
-			directory = "./";
+			data->directory = "./";
 
-		// Reset the vert counter. The process_node function will recalculate it
-		vert_count = 0;
+		process_node(scene->mRootNode, scene, *data);
+		data->success = true;
 
-		process_node(scene->mRootNode, scene);
-
-		birb::log("Model loaded: " + path);
-		last_write_time = std::filesystem::last_write_time(path);
+		return data;
 	}
 
 	void model::load_model_from_memory(const primitive_mesh mesh, const std::string& name)
@@ -190,14 +270,57 @@ namespace birb
 		file_path = null_path;
 		directory = "./";
 
-		// Reset the vert counter. The process_node function will recalculate it
-		vert_count = 0;
+		import_data data;
+		data.path = null_path;
+		data.directory = directory;
+		process_node(scene->mRootNode, scene, data);
 
-		process_node(scene->mRootNode, scene);
+		upload_meshes(data);
 
 		birb::log("Model loaded from memory: " + name);
 	}
 
+	void model::upload_meshes(const import_data& data)
+	{
+		// Reset the vert counter and bounds. They get recalculated from the new meshes
+		vert_count = 0;
+		local_bounds = bounding_box();
+		current_lod = 0;
+		max_lod_count = 0;
+
+		std::vector<mesh_texture> uploaded_textures;
+		uploaded_textures.reserve(data.textures.size());
+
+		for (const import_data::texture_data& imported_texture : data.textures)
+		{
+			mesh_texture uploaded_texture;
+			uploaded_texture.id = texture::texture_from_image(imported_texture.image);
+			uploaded_texture.type = imported_texture.type;
+			uploaded_texture.path = imported_texture.path;
+
+			uploaded_textures.push_back(uploaded_texture);
+			textures_loaded->push_back(uploaded_texture);
+		}
+
+		for (const import_data::mesh_data& imported_mesh : data.meshes)
+		{
+			std::vector<mesh_texture> textures;
+			for (const size_t texture_index : imported_mesh.texture_indices)
+				textures.push_back(uploaded_textures.at(texture_index));
+
+			meshes->emplace_back(imported_mesh.vertices, imported_mesh.indices, textures, imported_mesh.material,
+					imported_mesh.material_name, imported_mesh.name, imported_mesh.lod_indices, *packed_vertices);
+
+			birb::mesh& mesh = meshes->back();
+			mesh.unoptimized_acmr = imported_mesh.unoptimized_acmr;
+			mesh.optimized_acmr = mesh_optimizer::acmr(mesh.indices, mesh.vertices.size());
+
+			vert_count += mesh.vertices.size();
+			local_bounds.expand(mesh.bounds);
+			max_lod_count = std::max(max_lod_count, mesh.lod_count());
+		}
+	}
+
 	mesh* model::get_mesh_by_name(const std::string& mesh_name)
 	{
 		// check for a nullptr
@@ -218,18 +341,70 @@ namespace birb
 		return mesh_it.base();
 	}
 
-	void model::reload()
+	const std::vector<mesh>& model::get_meshes() const
 	{
+		ensure(meshes.get());
+		return *meshes;
+	}
+
+	bool model::reload(const bool force)
+	{
+		// Primitive meshes don't have a file that could change
+		if (is_primitive_mesh || !std::filesystem::exists(file_path))
+			return false;
+
 		// Don't reload the model if the file has not
 		// been modified
 		std::filesystem::file_time_type new_last_write_time = std::filesystem::last_write_time(file_path);
 
 		// Reload the model
-		if (new_last_write_time == last_write_time)
-			return;
+		if (new_last_write_time == last_write_time && !force)
+			return false;
+
+		// Import before destroying anything, so that a file that
+		// fails to parse doesn't leave the model empty
+		const std::shared_ptr<import_data> data = import_file(file_path);
+		if (!data->success)
+		{
+			birb::log_error("Could not reload model ", file_path, ". Keeping the old version");
+			return false;
+		}
 
 		destroy();
-		load_model();
+		load_model(*data);
+		return true;
+	}
+
+	void model::refresh_shared_state(const model& reloaded)
+	{
+		ensure(meshes == reloaded.meshes, "The models don't share their meshes");
+
+		directory = reloaded.directory;
+		last_write_time = reloaded.last_write_time;
+		vert_count = reloaded.vert_count;
+		local_bounds = reloaded.local_bounds;
+		max_lod_count = reloaded.max_lod_count;
+		current_lod = 0;
+	}
+
+	std::vector<std::string> model::dependencies() const
+	{
+		if (is_primitive_mesh || file_path.empty())
+			return {};
+
+		std::vector<std::string> files = { file_path };
+
+		// The material library of .obj files usually has the same name as the model
+		std::filesystem::path material_library_path = file_path;
+		material_library_path.replace_extension(".mtl");
+
+		if (material_library_path != file_path && std::filesystem::exists(material_library_path))
+			files.push_back(material_library_path.string());
+
+		for (const mesh_texture& texture : *textures_loaded)
+			files.push_back(directory + '/' + texture.path);
+
+		return files;
 	}
 
 	void model::destroy()
@@ -243,10 +418,35 @@ namespace birb
 		meshes->clear();
 		directory = "";
 		vert_count = 0;
+		local_bounds = bounding_box();
+		current_lod = 0;
+		max_lod_count = 0;
 		birb::log("Model destroyed: " + file_path);
 	}
 
-	void model::process_node(aiNode* node, const aiScene* scene)
+	void model::opt_packed_vertices(const bool enabled)
+	{
+		if (enabled == *packed_vertices)
+			return;
+
+		// The flag is shared with the copies of the model, since
+		// they all draw the meshes that get uploaded here
+		*packed_vertices = enabled;
+
+		// Upload the meshes again in the new format
+		if (!meshes->empty())
+		{
+			destroy();
+			load_model();
+		}
+	}
+
+	bool model::is_packed_vertices_enabled() const
+	{
+		return *packed_vertices;
+	}
+
+	void model::process_node(aiNode* node, const aiScene* scene, import_data& data)
 	{
 		ensure(node != nullptr);
 		ensure(scene != nullptr);
@@ -255,18 +455,17 @@ namespace birb
 		for (u32 i = 0; i < node->mNumMeshes; ++i)
 		{
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			meshes->push_back(process_mesh(mesh, scene));
-			vert_count += mesh->mNumVertices;
+			data.meshes.push_back(process_mesh(mesh, scene, data));
 		}
 
 		// Process the child nodes of the node
 		for (u32 i = 0; i < node->mNumChildren; ++i)
 		{
-			process_node(node->mChildren[i], scene);
+			process_node(node->mChildren[i], scene, data);
 		}
 	}
 
-	mesh model::process_mesh(aiMesh* ai_mesh, const aiScene* scene)
+	model::import_data::mesh_data model::process_mesh(aiMesh* ai_mesh, const aiScene* scene, import_data& data)
 	{
 		PROFILER_SCOPE_IO_FN();
 
@@ -275,7 +474,7 @@ namespace birb
 
 		std::vector<vertex> vertices;
 		std::vector<u32> indices;
-		std::vector<mesh_texture> textures;
+		std::vector<size_t> texture_indices;
 
 		// Process vertices
 		for (u32 i = 0; i < ai_mesh->mNumVertices; ++i)
@@ -339,25 +538,49 @@ namespace birb
 			material_name = material->GetName().C_Str();
 
 			// Diffuse maps
-			std::vector<mesh_texture> diffuse_maps = load_material_textures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-			textures.insert(textures.end(), diffuse_maps.begin(), diffuse_maps.end());
+			std::vector<size_t> diffuse_maps = load_material_textures(material, aiTextureType_DIFFUSE, "texture_diffuse", data);
+			texture_indices.insert(texture_indices.end(), diffuse_maps.begin(), diffuse_maps.end());
 
 			// Specular maps
-			std::vector<mesh_texture> specular_maps = load_material_textures(material, aiTextureType_SPECULAR, "texture_specular");
-			textures.insert(textures.end(), specular_maps.begin(), specular_maps.end());
+			std::vector<size_t> specular_maps = load_material_textures(material, aiTextureType_SPECULAR, "texture_specular", data);
+			texture_indices.insert(texture_indices.end(), specular_maps.begin(), specular_maps.end());
 		}
 
-		return birb::mesh(vertices, indices, textures, birb_material, material_name, ai_mesh->mName.C_Str());
+		// Assimp leaves the vertices unwelded and the triangles in the order they were
+		// in the file. The levels of detail get generated after the optimization so
+		// that they share the final vertex order
+		const f32 unoptimized_acmr = mesh_optimizer::acmr(indices, vertices.size());
+
+		mesh_optimizer::weld_vertices(vertices, indices);
+		mesh_optimizer::optimize_vertex_cache(indices, vertices.size());
+		mesh_optimizer::optimize_overdraw(indices, vertices, overdraw_threshold);
+		mesh_optimizer::optimize_vertex_fetch(vertices, indices);
+
+		std::vector<std::vector<u32>> lod_indices = mesh_simplifier::generate_lods(vertices, indices, mesh::max_lod_count);
+		for (std::vector<u32>& level : lod_indices)
+			mesh_optimizer::optimize_vertex_cache(level, vertices.size());
+
+		import_data::mesh_data mesh;
+		mesh.name = ai_mesh->mName.C_Str();
+		mesh.vertices = std::move(vertices);
+		mesh.indices = std::move(indices);
+		mesh.lod_indices = std::move(lod_indices);
+		mesh.material = birb_material;
+		mesh.material_name = material_name;
+		mesh.texture_indices = std::move(texture_indices);
+		mesh.unoptimized_acmr = unoptimized_acmr;
+
+		return mesh;
 	}
 
-	std::vector<mesh_texture> model::load_material_textures(aiMaterial* mat, aiTextureType type, std::string type_name)
+	std::vector<size_t> model::load_material_textures(aiMaterial* mat, aiTextureType type, std::string type_name, import_data& data)
 	{
 		PROFILER_SCOPE_IO_FN();
 
 		ensure(mat != nullptr);
 		ensure(!type_name.empty());
 
-		std::vector<mesh_texture> textures;
+		std::vector<size_t> textures;
 
 		for (u32 i = 0; i < mat->GetTextureCount(type); ++i)
 		{
@@ -365,11 +588,11 @@ namespace birb
 			mat->GetTexture(type, i, &str);
 
 			bool skip = false;
-			for (size_t j = 0; j < textures_loaded->size(); ++j)
+			for (size_t j = 0; j < data.textures.size(); ++j)
 			{
-				if (!std::strcmp(textures_loaded->at(j).path.data(), str.C_Str()))
+				if (data.textures[j].path == str.C_Str())
 				{
-					textures.push_back(textures_loaded->at(j));
+					textures.push_back(j);
 					skip = true;
 					break;
 				}
@@ -377,13 +600,14 @@ namespace birb
 
 			if (!skip)
 			{
-				mesh_texture texture;
-				texture.id = texture::texture_from_file(directory + '/' + str.C_Str());
-				texture.type = type_name;
-				texture.path = str.C_Str();
+				asset::image image((data.directory + '/' + str.C_Str()).c_str(), true);
+
+				// The image logs an error if it couldn't be decoded
+				if (image.data == nullptr)
+					continue;
 
-				textures.push_back(texture);
-				textures_loaded->push_back(texture);
+				textures.push_back(data.textures.size());
+				data.textures.push_back({ str.C_Str(), type_name, std::move(image) });
 			}
 		}
 
@@ -394,4 +618,43 @@ namespace birb
 	{
 		return vert_count;
 	}
+
+	const bounding_box& model::bounds() const
+	{
+		return local_bounds;
+	}
+
+	u8 model::select_lod(const f32 screen_size)
+	{
+		current_lod = next_lod(current_lod, max_lod_count, screen_size);
+		return current_lod;
+	}
+
+	u8 model::lod() const
+	{
+		return current_lod;
+	}
+
+	u8 model::lod_count() const
+	{
+		return max_lod_count;
+	}
+
+	u8 model::next_lod(const u8 current, const u8 lod_count, const f32 screen_size)
+	{
+		if (lod_count <= 1)
+			return 0;
+
+		u8 level = std::min<u8>(current, lod_count - 1);
+
+		// Switch to less detailed levels when the model gets smaller
+		while (level + 1 < lod_count && screen_size < lod_screen_sizes[level] * (1.0f - lod_hysteresis))
+			++level;
+
+		// Switch back to more detailed levels when the model gets larger
+		while (level > 0 && screen_size > lod_screen_sizes[level - 1] * (1.0f + lod_hysteresis))
+			--level;
+
+		return level;
+	}
 }
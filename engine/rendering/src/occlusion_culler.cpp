@@ -0,0 +1,367 @@
+#include "Assert.hpp"
+#include "Mesh.hpp"
+#include "OcclusionCuller.hpp"
+#include "Profiling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+
+#if defined(__SSE2__)
+#define BIRB_OCCLUSION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace birb
+{
+	// Triangles with a smaller screen space area than this don't cover any pixel centers
+	static constexpr f32 min_triangle_area = 1.0e-6f;
+
+	occlusion_culler::occlusion_culler()
+	{
+		std::iota(tile_ids.begin(), tile_ids.end(), 0);
+
+		max_depths[0].resize(static_cast<size_t>(width) * height, 1.0f);
+		for (u8 level = 1; level < level_count; ++level)
+		{
+			min_depths[level].resize(static_cast<size_t>(level_width(level)) * level_height(level), 1.0f);
+			max_depths[level].resize(static_cast<size_t>(level_width(level)) * level_height(level), 1.0f);
+		}
+	}
+
+	void occlusion_culler::begin(const glm::mat4& view_projection)
+	{
+		this->view_projection = view_projection;
+
+		triangles.clear();
+		for (std::vector<u32>& bin : tile_bins)
+			bin.clear();
+
+		std::fill(max_depths[0].begin(), max_depths[0].end(), 1.0f);
+	}
+
+	void occlusion_culler::add_occluder(std::span<const vertex> vertices, std::span<const u32> indices, const glm::mat4& model_matrix)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(indices.size() % 3 == 0, "Occluders need to be triangle lists");
+
+		const glm::mat4 model_view_projection = view_projection * model_matrix;
+
+		clip_vertices.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+			clip_vertices[i] = model_view_projection * glm::vec4(vertices[i].position, 1.0f);
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			ensure(indices[i] < vertices.size() && indices[i + 1] < vertices.size() && indices[i + 2] < vertices.size());
+			add_triangle(clip_vertices[indices[i]], clip_vertices[indices[i + 1]], clip_vertices[indices[i + 2]]);
+		}
+	}
+
+	void occlusion_culler::rasterize()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		// The tiles don't share any pixels, so they can be rasterized in parallel
+		std::for_each(std::execution::par, tile_ids.begin(), tile_ids.end(), [this](const u16 tile)
+		{
+			rasterize_tile(tile);
+		});
+
+		build_hierarchy();
+	}
+
+	bool occlusion_culler::is_visible(const bounding_box& box) const
+	{
+		ensure(box.is_valid());
+
+		glm::vec2 screen_min(std::numeric_limits<f32>::max());
+		glm::vec2 screen_max(std::numeric_limits<f32>::lowest());
+		f32 box_depth = std::numeric_limits<f32>::max();
+
+		for (u8 i = 0; i < 8; ++i)
+		{
+			const glm::vec3 corner(
+				i & 1 ? box.max.x : box.min.x,
+				i & 2 ? box.max.y : box.min.y,
+				i & 4 ? box.max.z : box.min.z);
+
+			const glm::vec4 clip = view_projection * glm::vec4(corner, 1.0f);
+
+			// The projected box can't be trusted if a corner is behind the near plane
+			if (clip.w <= 0.0f || clip.z < -clip.w)
+				return true;
+
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			screen_min = glm::min(screen_min, glm::vec2(ndc));
+			screen_max = glm::max(screen_max, glm::vec2(ndc));
+			box_depth = std::min(box_depth, ndc.z * 0.5f + 0.5f);
+		}
+
+		if (screen_max.x < -1.0f || screen_min.x > 1.0f || screen_max.y < -1.0f || screen_min.y > 1.0f)
+			return true;
+
+		// Every pixel that the box touches, including the partially covered ones
+		const glm::ivec2 pixel_min = glm::clamp(glm::ivec2(glm::floor((screen_min * 0.5f + 0.5f) * glm::vec2(width, height))), glm::ivec2(0), glm::ivec2(width - 1, height - 1));
+		const glm::ivec2 pixel_max = glm::clamp(glm::ivec2(glm::floor((screen_max * 0.5f + 0.5f) * glm::vec2(width, height))), glm::ivec2(0), glm::ivec2(width - 1, height - 1));
+
+		// Start from the coarsest level where the box is at most two texels wide and tall
+		u8 level = 0;
+		while (level + 1 < level_count
+				&& ((pixel_max.x >> level) - (pixel_min.x >> level) > 1 || (pixel_max.y >> level) - (pixel_min.y >> level) > 1))
+			++level;
+
+		return is_region_visible(level, pixel_min, pixel_max, box_depth);
+	}
+
+	f32 occlusion_culler::depth(const u16 x, const u16 y) const
+	{
+		ensure(x < width && y < height);
+		return max_depths[0][static_cast<size_t>(y) * width + x];
+	}
+
+	u32 occlusion_culler::triangle_count() const
+	{
+		return triangles.size();
+	}
+
+	void occlusion_culler::add_triangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+	{
+		// Skip triangles that are completely outside of one of the side planes
+		for (u8 axis = 0; axis < 2; ++axis)
+		{
+			if (a[axis] > a.w && b[axis] > b.w && c[axis] > c.w)
+				return;
+
+			if (a[axis] < -a.w && b[axis] < -b.w && c[axis] < -c.w)
+				return;
+		}
+
+		// Clip the triangle against the near plane (z >= -w). This
+		// results in a polygon with at most four vertices
+		const std::array<glm::vec4, 3> input = { a, b, c };
+		std::array<glm::vec4, 4> polygon;
+		u8 polygon_size = 0;
+
+		for (u8 i = 0; i < 3; ++i)
+		{
+			const glm::vec4& current = input[i];
+			const glm::vec4& next = input[(i + 1) % 3];
+
+			const f32 current_distance = current.z + current.w;
+			const f32 next_distance = next.z + next.w;
+
+			if (current_distance >= 0.0f)
+				polygon[polygon_size++] = current;
+
+			if ((current_distance >= 0.0f) != (next_distance >= 0.0f))
+				polygon[polygon_size++] = glm::mix(current, next, current_distance / (current_distance - next_distance));
+		}
+
+		if (polygon_size < 3)
+			return;
+
+		std::array<glm::vec3, 4> screen;
+		for (u8 i = 0; i < polygon_size; ++i)
+		{
+			const glm::vec3 ndc = glm::vec3(polygon[i]) / polygon[i].w;
+			screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+		}
+
+		for (u8 i = 2; i < polygon_size; ++i)
+			add_screen_triangle(screen[0], screen[i - 1], screen[i]);
+	}
+
+	void occlusion_culler::add_screen_triangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		f32 area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (std::abs(area) < min_triangle_area)
+			return;
+
+		// Both windings are rasterized, since the occluders might be single sided walls
+		const glm::vec3& second = area > 0.0f ? b : c;
+		const glm::vec3& third = area > 0.0f ? c : b;
+		area = std::abs(area);
+
+		const glm::vec2 min = glm::max(glm::floor(glm::min(glm::vec2(a), glm::min(glm::vec2(second), glm::vec2(third)))), glm::vec2(0.0f));
+		const glm::vec2 max = glm::min(glm::ceil(glm::max(glm::vec2(a), glm::max(glm::vec2(second), glm::vec2(third)))), glm::vec2(width, height));
+
+		if (min.x >= max.x || min.y >= max.y)
+			return;
+
+		screen_triangle triangle;
+		triangle.vertices[0] = glm::vec2(a);
+		triangle.vertices[1] = glm::vec2(second);
+		triangle.vertices[2] = glm::vec2(third);
+
+		// Depth as a plane equation of the screen coordinates
+		triangle.depth_dx = ((second.z - a.z) * (third.y - a.y) - (third.z - a.z) * (second.y - a.y)) / area;
+		triangle.depth_dy = ((third.z - a.z) * (second.x - a.x) - (second.z - a.z) * (third.x - a.x)) / area;
+		triangle.depth_origin = a.z - triangle.depth_dx * a.x - triangle.depth_dy * a.y;
+
+		const u32 index = triangles.size();
+		triangles.push_back(triangle);
+
+		const u16 first_tile_x = static_cast<u16>(min.x) / tile_size;
+		const u16 first_tile_y = static_cast<u16>(min.y) / tile_size;
+		const u16 last_tile_x = (static_cast<u16>(max.x) - 1) / tile_size;
+		const u16 last_tile_y = (static_cast<u16>(max.y) - 1) / tile_size;
+
+		for (u16 y = first_tile_y; y <= last_tile_y; ++y)
+			for (u16 x = first_tile_x; x <= last_tile_x; ++x)
+				tile_bins[y * tile_count_x + x].push_back(index);
+	}
+
+	void occlusion_culler::rasterize_tile(const u16 tile)
+	{
+		const i32 tile_x = (tile % tile_count_x) * tile_size;
+		const i32 tile_y = (tile / tile_count_x) * tile_size;
+
+		f32* const depth_buffer = max_depths[0].data();
+
+		for (const u32 index : tile_bins[tile])
+		{
+			const screen_triangle& triangle = triangles[index];
+			const glm::vec2& a = triangle.vertices[0];
+			const glm::vec2& b = triangle.vertices[1];
+			const glm::vec2& c = triangle.vertices[2];
+
+			// Edge functions in the form of x * step_x + y * step_y + offset.
+			// Pixel centers where all of them are positive are inside of the triangle
+			const glm::vec3 step_x(a.y - b.y, b.y - c.y, c.y - a.y);
+			const glm::vec3 step_y(b.x - a.x, c.x - b.x, a.x - c.x);
+			const glm::vec3 offset(
+				-(step_x[0] * a.x + step_y[0] * a.y),
+				-(step_x[1] * b.x + step_y[1] * b.y),
+				-(step_x[2] * c.x + step_y[2] * c.y));
+
+			// Rows are processed in groups of four pixels, so the start is aligned down to four
+			const i32 min_x = std::max(static_cast<i32>(std::min({ a.x, b.x, c.x })), tile_x) & ~3;
+			const i32 min_y = std::max(static_cast<i32>(std::min({ a.y, b.y, c.y })), tile_y);
+			const i32 max_x = std::min(static_cast<i32>(std::ceil(std::max({ a.x, b.x, c.x }))), tile_x + tile_size);
+			const i32 max_y = std::min(static_cast<i32>(std::ceil(std::max({ a.y, b.y, c.y }))), tile_y + tile_size);
+
+#ifdef BIRB_OCCLUSION_SSE
+			const __m128 pixel_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+
+			for (i32 y = min_y; y < max_y; ++y)
+			{
+				const f32 center_y = y + 0.5f;
+
+				const __m128 row_edge_0 = _mm_set1_ps(step_y[0] * center_y + offset[0]);
+				const __m128 row_edge_1 = _mm_set1_ps(step_y[1] * center_y + offset[1]);
+				const __m128 row_edge_2 = _mm_set1_ps(step_y[2] * center_y + offset[2]);
+				const __m128 row_depth = _mm_set1_ps(triangle.depth_dy * center_y + triangle.depth_origin);
+
+				f32* const row = depth_buffer + static_cast<size_t>(y) * width;
+
+				for (i32 x = min_x; x < max_x; x += 4)
+				{
+					const __m128 center_x = _mm_add_ps(_mm_set1_ps(static_cast<f32>(x)), pixel_offsets);
+
+					const __m128 edge_0 = _mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(step_x[0])), row_edge_0);
+					const __m128 edge_1 = _mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(step_x[1])), row_edge_1);
+					const __m128 edge_2 = _mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(step_x[2])), row_edge_2);
+
+					const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge_0, zero), _mm_cmpge_ps(edge_1, zero)), _mm_cmpge_ps(edge_2, zero));
+					if (_mm_movemask_ps(inside) == 0)
+						continue;
+
+					const __m128 depth = _mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(triangle.depth_dx)), row_depth);
+					const __m128 old_depth = _mm_loadu_ps(row + x);
+					const __m128 new_depth = _mm_min_ps(old_depth, depth);
+
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, new_depth), _mm_andnot_ps(inside, old_depth)));
+				}
+			}
+#else
+			for (i32 y = min_y; y < max_y; ++y)
+			{
+				const f32 center_y = y + 0.5f;
+				f32* const row = depth_buffer + static_cast<size_t>(y) * width;
+
+				for (i32 x = min_x; x < max_x; ++x)
+				{
+					const glm::vec3 edges = step_x * (x + 0.5f) + step_y * center_y + offset;
+					if (edges[0] < 0.0f || edges[1] < 0.0f || edges[2] < 0.0f)
+						continue;
+
+					const f32 depth = triangle.depth_dx * (x + 0.5f) + triangle.depth_dy * center_y + triangle.depth_origin;
+					row[x] = std::min(row[x], depth);
+				}
+			}
+#endif
+		}
+	}
+
+	void occlusion_culler::build_hierarchy()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		for (u8 level = 1; level < level_count; ++level)
+		{
+			const u16 source_width = level_width(level - 1);
+			const u16 source_height = level_height(level - 1);
+
+			// The full resolution level has the same values in both
+			const std::vector<f32>& source_min = level == 1 ? max_depths[0] : min_depths[level - 1];
+			const std::vector<f32>& source_max = max_depths[level - 1];
+
+			for (u16 y = 0; y < level_height(level); ++y)
+			{
+				// Levels that are one texel tall don't get halved vertically
+				const u16 y0 = std::min<u16>(y * 2, source_height - 1);
+				const u16 y1 = std::min<u16>(y * 2 + 1, source_height - 1);
+
+				for (u16 x = 0; x < level_width(level); ++x)
+				{
+					const u16 x0 = std::min<u16>(x * 2, source_width - 1);
+					const u16 x1 = std::min<u16>(x * 2 + 1, source_width - 1);
+
+					const size_t i00 = static_cast<size_t>(y0) * source_width + x0;
+					const size_t i01 = static_cast<size_t>(y0) * source_width + x1;
+					const size_t i10 = static_cast<size_t>(y1) * source_width + x0;
+					const size_t i11 = static_cast<size_t>(y1) * source_width + x1;
+
+					const size_t target = static_cast<size_t>(y) * level_width(level) + x;
+					min_depths[level][target] = std::min({ source_min[i00], source_min[i01], source_min[i10], source_min[i11] });
+					max_depths[level][target] = std::max({ source_max[i00], source_max[i01], source_max[i10], source_max[i11] });
+				}
+			}
+		}
+	}
+
+	bool occlusion_culler::is_region_visible(const u8 level, const glm::ivec2 min, const glm::ivec2 max, const f32 box_depth) const
+	{
+		const u16 texels_per_row = level_width(level);
+
+		for (i32 y = min.y >> level; y <= max.y >> level; ++y)
+		{
+			for (i32 x = min.x >> level; x <= max.x >> level; ++x)
+			{
+				const size_t index = static_cast<size_t>(y) * texels_per_row + x;
+
+				// Everything in the texel is in front of the box
+				if (box_depth > max_depths[level][index])
+					continue;
+
+				// The box is in front of everything in the texel or there are no finer levels left
+				if (level == 0 || box_depth < min_depths[level][index])
+					return true;
+
+				// Refine the part of the region that overlaps this texel
+				const glm::ivec2 texel_min(x << level, y << level);
+				const glm::ivec2 texel_max(((x + 1) << level) - 1, ((y + 1) << level) - 1);
+
+				if (is_region_visible(level - 1, glm::max(min, texel_min), glm::min(max, texel_max), box_depth))
+					return true;
+			}
+		}
+
+		return false;
+	}
+}
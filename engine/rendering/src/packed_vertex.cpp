@@ -0,0 +1,146 @@
+#include "Mesh.hpp"
+#include "PackedVertex.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace birb
+{
+	namespace vertex_packing
+	{
+		static constexpr f32 unorm16_max = 65535.0f;
+		static constexpr f32 snorm16_max = 32767.0f;
+
+		static u16 to_unorm16(const f32 value)
+		{
+			return static_cast<u16>(std::round(std::clamp(value, 0.0f, 1.0f) * unorm16_max));
+		}
+
+		static i16 to_snorm16(const f32 value)
+		{
+			return static_cast<i16>(std::round(std::clamp(value, -1.0f, 1.0f) * snorm16_max));
+		}
+
+		static f32 from_snorm16(const i16 value)
+		{
+			return std::max(value / snorm16_max, -1.0f);
+		}
+
+		packed_vertex pack(const vertex& vertex, const bounding_box& bounds)
+		{
+			packed_vertex packed;
+
+			const glm::vec3 extent = bounds.max - bounds.min;
+			for (u8 i = 0; i < 3; ++i)
+				packed.position[i] = extent[i] > 0.0f ? to_unorm16((vertex.position[i] - bounds.min[i]) / extent[i]) : 0;
+
+			packed.position[3] = 0;
+
+			const glm::vec2 normal = encode_octahedral(vertex.normal);
+			packed.normal = { to_snorm16(normal.x), to_snorm16(normal.y) };
+
+			packed.tex_coords = { float_to_half(vertex.tex_coords.x), float_to_half(vertex.tex_coords.y) };
+
+			return packed;
+		}
+
+		vertex unpack(const packed_vertex& packed, const bounding_box& bounds)
+		{
+			vertex result;
+
+			const glm::vec3 extent = bounds.max - bounds.min;
+			for (u8 i = 0; i < 3; ++i)
+				result.position[i] = bounds.min[i] + (packed.position[i] / unorm16_max) * extent[i];
+
+			result.normal = decode_octahedral(glm::vec2(from_snorm16(packed.normal[0]), from_snorm16(packed.normal[1])));
+			result.tex_coords = glm::vec2(half_to_float(packed.tex_coords[0]), half_to_float(packed.tex_coords[1]));
+
+			return result;
+		}
+
+		glm::vec2 encode_octahedral(const glm::vec3& normal)
+		{
+			const f32 length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			if (length == 0.0f)
+				return glm::vec2(0.0f);
+
+			const glm::vec3 n = normal / length;
+			if (n.z >= 0.0f)
+				return glm::vec2(n.x, n.y);
+
+			// Fold the lower half of the octahedron over the upper half
+			return glm::vec2(
+				(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+				(1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+		}
+
+		glm::vec3 decode_octahedral(const glm::vec2& encoded)
+		{
+			glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+
+			const f32 t = std::max(-n.z, 0.0f);
+			n.x += n.x >= 0.0f ? -t : t;
+			n.y += n.y >= 0.0f ? -t : t;
+
+			return glm::normalize(n);
+		}
+
+		u16 float_to_half(const f32 value)
+		{
+			// Based on float_to_half_fast3_rtne() by Fabian Giesen
+			constexpr u32 f32_infinity = 255u << 23;
+			constexpr u32 f16_max = (127u + 16u) << 23;
+			constexpr u32 denormal_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+			u32 bits = std::bit_cast<u32>(value);
+			const u32 sign = bits & 0x80000000u;
+			bits ^= sign;
+
+			u16 result;
+
+			if (bits >= f16_max)
+			{
+				// Too large values become infinity and NaNs stay NaNs
+				result = bits > f32_infinity ? 0x7E00 : 0x7C00;
+			}
+			else if (bits < (113u << 23))
+			{
+				// Denormals get rounded by the float addition
+				const f32 denormal = std::bit_cast<f32>(bits) + std::bit_cast<f32>(denormal_magic);
+				result = std::bit_cast<u32>(denormal) - denormal_magic;
+			}
+			else
+			{
+				const u32 odd_mantissa = (bits >> 13) & 1;
+
+				// Rebias the exponent and round the mantissa
+				bits += ((15u - 127u) << 23) + 0xFFF;
+				bits += odd_mantissa;
+				result = bits >> 13;
+			}
+
+			return result | (sign >> 16);
+		}
+
+		f32 half_to_float(const u16 value)
+		{
+			const u32 sign = static_cast<u32>(value & 0x8000) << 16;
+			const u32 exponent = (value >> 10) & 0x1F;
+			const u32 mantissa = value & 0x3FF;
+
+			// Denormals
+			if (exponent == 0)
+			{
+				const f32 magnitude = std::ldexp(static_cast<f32>(mantissa), -24);
+				return sign ? -magnitude : magnitude;
+			}
+
+			// Infinity and NaN
+			if (exponent == 31)
+				return std::bit_cast<f32>(sign | 0x7F800000u | (mantissa << 13));
+
+			return std::bit_cast<f32>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		}
+	}
+}
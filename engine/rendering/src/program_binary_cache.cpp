@@ -0,0 +1,363 @@
+#include "Assert.hpp"
+#include "Globals.hpp"
+#include "Logger.hpp"
+#include "Profiling.hpp"
+#include "ProgramBinaryCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+namespace birb
+{
+	namespace program_binary_cache
+	{
+		// GL_ARB_get_program_binary isn't a part of OpenGL 3.3, so the
+		// functions and enums need to be fetched manually
+		using get_program_binary_fn = void (GLAD_API_PTR*)(GLuint program, GLsizei buffer_size, GLsizei* length, GLenum* binary_format, void* binary);
+		using program_binary_fn = void (GLAD_API_PTR*)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+		using program_parameter_fn = void (GLAD_API_PTR*)(GLuint program, GLenum pname, GLint value);
+
+		static get_program_binary_fn gl_get_program_binary = nullptr;
+		static program_binary_fn gl_program_binary = nullptr;
+		static program_parameter_fn gl_program_parameter = nullptr;
+
+		static constexpr GLenum program_binary_retrievable_hint = 0x8257;
+		static constexpr GLenum program_binary_length = 0x8741;
+		static constexpr GLenum num_program_binary_formats = 0x87FE;
+		static constexpr GLenum program_binary_formats = 0x87FF;
+
+		// Binary formats that the driver accepts
+		static std::vector<i32> supported_formats;
+
+		static size_t hit_count = 0;
+		static size_t miss_count = 0;
+
+		static constexpr std::array<char, 4> file_magic = { 'B', 'P', 'B', 'C' };
+
+		// Bump this if the file layout changes
+		static constexpr u32 file_version = 1;
+
+		struct file_header
+		{
+			std::array<char, 4> magic;
+			u32 version;
+			u64 key;
+			u32 format;
+			u32 padding;
+			u64 size;
+		};
+
+		static_assert(sizeof(file_header) == 32);
+
+		// 64-bit FNV-1a. std::hash isn't guaranteed to give the
+		// same results between runs, so it can't be used for the keys
+		static u64 fnv1a(const std::string_view data, u64 hash)
+		{
+			constexpr u64 prime = 0x100000001B3;
+
+			for (const char c : data)
+			{
+				hash ^= static_cast<u8>(c);
+				hash *= prime;
+			}
+
+			return hash;
+		}
+
+		static u64 hash_part(const std::string_view part, const u64 hash)
+		{
+			// Mixing in the length keeps the boundaries between the parts unambiguous
+			const u64 length = part.size();
+			const std::string_view length_bytes(reinterpret_cast<const char*>(&length), sizeof(length));
+
+			return fnv1a(part, fnv1a(length_bytes, hash));
+		}
+
+		u64 key(const std::string_view vertex_src, const std::string_view fragment_src, const std::string_view driver)
+		{
+			constexpr u64 offset_basis = 0xCBF29CE484222325;
+
+			u64 hash = hash_part(vertex_src, offset_basis);
+			hash = hash_part(fragment_src, hash);
+			hash = hash_part(driver, hash);
+
+			return hash;
+		}
+
+		static std::string cache_directory()
+		{
+			if (!directory.empty())
+				return directory;
+
+#ifdef BIRB_PLATFORM_WINDOWS
+			const char* app_data = getenv("LOCALAPPDATA");
+			ensure(app_data != nullptr);
+			return std::string(app_data) + "/birb3d/program_binaries";
+#else
+			const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+			if (xdg_cache_home != nullptr && xdg_cache_home[0] != '\0')
+				return std::string(xdg_cache_home) + "/birb3d/program_binaries";
+
+			const char* home = getenv("HOME");
+			ensure(home != nullptr);
+			return std::string(home) + "/.cache/birb3d/program_binaries";
+#endif
+		}
+
+		std::string file_path(const u64 key)
+		{
+			constexpr char hex_digits[] = "0123456789abcdef";
+
+			std::string name(16, '0');
+			for (u8 i = 0; i < 16; ++i)
+				name[15 - i] = hex_digits[(key >> (i * 4)) & 0xF];
+
+			return cache_directory() + "/" + name + ".bin";
+		}
+
+		bool write_file(const std::string& path, const u64 key, const program_binary& binary)
+		{
+			PROFILER_SCOPE_IO_FN();
+
+			const std::filesystem::path parent_path = std::filesystem::path(path).parent_path();
+
+			std::error_code error;
+			if (!parent_path.empty())
+				std::filesystem::create_directories(parent_path, error);
+
+			// Write into a temporary file first so that a crash
+			// can't leave a truncated binary behind
+			const std::string temp_path = path + ".tmp";
+
+			{
+				std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+					return false;
+
+				const file_header header = {
+					.magic = file_magic,
+					.version = file_version,
+					.key = key,
+					.format = binary.format,
+					.padding = 0,
+					.size = binary.data.size(),
+				};
+
+				file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				file.write(reinterpret_cast<const char*>(binary.data.data()), static_cast<std::streamsize>(binary.data.size()));
+
+				if (!file.good())
+					return false;
+			}
+
+			std::filesystem::rename(temp_path, path, error);
+			if (error)
+			{
+				std::filesystem::remove(temp_path, error);
+				return false;
+			}
+
+			return true;
+		}
+
+		bool read_file(const std::string& path, const u64 key, program_binary& binary)
+		{
+			PROFILER_SCOPE_IO_FN();
+
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open())
+				return false;
+
+			file_header header;
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+				return false;
+
+			if (header.magic != file_magic || header.version != file_version || header.key != key)
+				return false;
+
+			// Check the size before allocating anything, since a corrupted
+			// header could otherwise ask for an absurd amount of memory
+			std::error_code error;
+			const u64 file_size = std::filesystem::file_size(path, error);
+			if (error || file_size != sizeof(header) + header.size)
+				return false;
+
+			binary.format = header.format;
+			binary.data.resize(header.size);
+
+			return static_cast<bool>(file.read(reinterpret_cast<char*>(binary.data.data()), static_cast<std::streamsize>(header.size)));
+		}
+
+		bool is_supported()
+		{
+			ensure(birb::g_opengl_initialized);
+
+			static const bool supported = []() -> bool
+			{
+				i32 major_version = 0;
+				i32 minor_version = 0;
+				glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+				glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+
+				bool available = major_version > 4 || (major_version == 4 && minor_version >= 1);
+
+				i32 extension_count = 0;
+				glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+				for (i32 i = 0; i < extension_count && !available; ++i)
+					available = std::string_view(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) == "GL_ARB_get_program_binary";
+
+				if (available)
+				{
+					gl_get_program_binary = reinterpret_cast<get_program_binary_fn>(glfwGetProcAddress("glGetProgramBinary"));
+					gl_program_binary = reinterpret_cast<program_binary_fn>(glfwGetProcAddress("glProgramBinary"));
+					gl_program_parameter = reinterpret_cast<program_parameter_fn>(glfwGetProcAddress("glProgramParameteri"));
+				}
+
+				if (gl_get_program_binary == nullptr || gl_program_binary == nullptr || gl_program_parameter == nullptr)
+				{
+					birb::log("GL_ARB_get_program_binary is not available. Shader programs won't be cached to disk");
+					return false;
+				}
+
+				// Some drivers expose the extension without supporting any binary formats
+				i32 format_count = 0;
+				glGetIntegerv(num_program_binary_formats, &format_count);
+				if (format_count <= 0)
+				{
+					birb::log("The driver doesn't support any program binary formats. Shader programs won't be cached to disk");
+					return false;
+				}
+
+				supported_formats.resize(format_count);
+				glGetIntegerv(program_binary_formats, supported_formats.data());
+
+				birb::log("Caching linked shader programs to ", cache_directory());
+				return true;
+			}();
+
+			return supported;
+		}
+
+		std::string driver_string()
+		{
+			const auto gl_string = [](const GLenum name) -> std::string
+			{
+				const GLubyte* str = glGetString(name);
+				return str != nullptr ? reinterpret_cast<const char*>(str) : "";
+			};
+
+			return gl_string(GL_VENDOR) + "\n" + gl_string(GL_RENDERER) + "\n" + gl_string(GL_VERSION);
+		}
+
+		u32 load_program(const u64 key)
+		{
+			PROFILER_SCOPE_RENDER_FN();
+
+			if (!enabled || !is_supported())
+				return 0;
+
+			const std::string path = file_path(key);
+
+			program_binary binary;
+			if (!read_file(path, key, binary)
+				|| std::find(supported_formats.begin(), supported_formats.end(), static_cast<i32>(binary.format)) == supported_formats.end())
+			{
+				++miss_count;
+				return 0;
+			}
+
+			const u32 program = glCreateProgram();
+			gl_program_binary(program, binary.format, binary.data.data(), static_cast<GLsizei>(binary.data.size()));
+
+			i32 link_status = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+
+			// Drivers are allowed to reject binaries at any point, for example after an update
+			if (link_status == GL_FALSE)
+			{
+				birb::log_warn("The driver rejected a cached program binary (", path, "). Compiling the shader from source instead");
+				glDeleteProgram(program);
+
+				std::error_code error;
+				std::filesystem::remove(path, error);
+
+				++miss_count;
+				return 0;
+			}
+
+			++hit_count;
+			return program;
+		}
+
+		void prepare_program(const u32 program)
+		{
+			ensure(program != 0);
+
+			if (!enabled || !is_supported())
+				return;
+
+			gl_program_parameter(program, program_binary_retrievable_hint, GL_TRUE);
+		}
+
+		void store_program(const u64 key, const u32 program)
+		{
+			PROFILER_SCOPE_RENDER_FN();
+			ensure(program != 0);
+
+			if (!enabled || !is_supported())
+				return;
+
+			i32 length = 0;
+			glGetProgramiv(program, program_binary_length, &length);
+			if (length <= 0)
+				return;
+
+			program_binary binary;
+			binary.data.resize(length);
+
+			GLsizei written = 0;
+			GLenum format = 0;
+			gl_get_program_binary(program, length, &written, &format, binary.data.data());
+
+			if (written <= 0)
+				return;
+
+			binary.format = format;
+			binary.data.resize(written);
+
+			if (!write_file(file_path(key), key, binary))
+				birb::log_warn("Could not write a program binary to ", cache_directory());
+		}
+
+		void clear()
+		{
+			birb::log("Clearing the program binary cache");
+
+			// Only remove the binaries in case the directory is shared with other files
+			std::error_code error;
+			for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(cache_directory(), error))
+			{
+				if (entry.path().extension() == ".bin")
+					std::filesystem::remove(entry.path(), error);
+			}
+
+			hit_count = 0;
+			miss_count = 0;
+		}
+
+		size_t hits()
+		{
+			return hit_count;
+		}
+
+		size_t misses()
+		{
+			return miss_count;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#include "Assert.hpp"
+#include "Profiling.hpp"
+#include "RenderQueue.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace birb
+{
+	void render_queue::push(const u64 key, const u32 index, const u32 sub_index)
+	{
+		queue.push_back({ key, index, sub_index });
+	}
+
+	void render_queue::sort()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		if (queue.size() < 2)
+			return;
+
+		constexpr u8 radix_bits = 8;
+		constexpr u16 bucket_count = 1 << radix_bits;
+		constexpr u8 pass_count = sizeof(u64) * 8 / radix_bits;
+
+		// Count the digits for all of the passes at once
+		std::array<std::array<size_t, bucket_count>, pass_count> histograms{};
+		for (const command& cmd : queue)
+			for (u8 pass = 0; pass < pass_count; ++pass)
+				++histograms[pass][(cmd.key >> (pass * radix_bits)) & (bucket_count - 1)];
+
+		sort_buffer.resize(queue.size());
+
+		for (u8 pass = 0; pass < pass_count; ++pass)
+		{
+			std::array<size_t, bucket_count>& histogram = histograms[pass];
+
+			// If all of the keys have the same digit, this pass wouldn't change anything.
+			// Sort keys usually have lots of unused bits, so this skips most of the passes
+			const u8 first_digit = (queue.front().key >> (pass * radix_bits)) & (bucket_count - 1);
+			if (histogram[first_digit] == queue.size())
+				continue;
+
+			// Turn the counts into starting offsets
+			size_t offset = 0;
+			for (size_t& count : histogram)
+			{
+				const size_t bucket_size = count;
+				count = offset;
+				offset += bucket_size;
+			}
+
+			for (const command& cmd : queue)
+				sort_buffer[histogram[(cmd.key >> (pass * radix_bits)) & (bucket_count - 1)]++] = cmd;
+
+			queue.swap(sort_buffer);
+		}
+	}
+
+	void render_queue::clear()
+	{
+		queue.clear();
+	}
+
+	size_t render_queue::size() const
+	{
+		return queue.size();
+	}
+
+	bool render_queue::empty() const
+	{
+		return queue.empty();
+	}
+
+	const std::vector<render_queue::command>& render_queue::commands() const
+	{
+		return queue;
+	}
+
+	u32 render_queue::sortable_float(const f32 value)
+	{
+		static_assert(sizeof(f32) == sizeof(u32));
+
+		u32 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		// Flip all of the bits of negative numbers so that they sort in reverse
+		// and flip only the sign bit of positive numbers to place them after
+		// the negative ones
+		return (bits & 0x80000000) ? ~bits : bits | 0x80000000;
+	}
+
+	u32 render_queue::depth_bits(const f32 depth, const u8 bit_count)
+	{
+		ensure(bit_count > 0 && bit_count <= 32);
+		return sortable_float(depth) >> (32 - bit_count);
+	}
+}
@@ -3,16 +3,20 @@
 #include "Assert.hpp"
 #include "Camera.hpp"
 #include "EBO.hpp"
+#include "FileWatcher.hpp"
 #include "GLSupervisor.hpp"
 #include "Globals.hpp"
 #include "Logger.hpp"
+#include "Model.hpp"
 #include "Profiling.hpp"
 #include "Renderer.hpp"
 #include "Scene.hpp"
 #include "Shader.hpp"
 #include "ShaderCollection.hpp"
 #include "ShaderUniforms.hpp"
+#include "ShaderVariant.hpp"
 #include "Stopwatch.hpp"
+#include "Texture.hpp"
 #include "VBO.hpp"
 #include "Window.hpp"
 
@@ -20,11 +24,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <entt.hpp>
+#include <filesystem>
 #include <glad/gl.h>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 // Make sure that all of the datatypes are of correct size
 // so that they work correctly with OpenGL
@@ -66,8 +75,16 @@ namespace birb
 	renderer::renderer()
 	 :line_shader("line"),
 	 view_matrix_ubo(shader_uniforms::block::view_matrices),
+	 light_info_ubo(shader_uniforms::block::light_info),
+	 point_light_tbo(tbo_format::rgba32f),
+	 cluster_range_tbo(tbo_format::rg32ui),
+	 cluster_index_tbo(tbo_format::r16ui),
+	 vertex_stream(gl_buffer_type::array),
+	 shadow_depth_shader_ref("shadow_depth"),
 	 debug_shader_ref("color"),
 	 texture_shader_ref("texture"),
+	 instanced_texture_shader_ref("texture", "texture", shader_variant::instanced),
+	 batched_texture_shader_ref("texture", "texture", shader_variant::batched),
 	 post_processing_shader_ref("post_process")
 	{
 		GL_SUPERVISOR_SCOPE();
@@ -120,16 +137,27 @@ namespace birb
 		sprite_ebo->unbind();
 
 
-		// Initialize things for text rendering
+		// Initialize things for text and line rendering. The glyph instances and
+		// line vertices come from the stream buffer, so their attribute pointers
+		// are set when drawing
 		text_vao.bind();
 
-		text_vbo.bind();
-		text_vbo.set_data(NULL, sizeof(f32) * 6 * 4, gl_usage::dynamic_draw); // 6 verts, 4 floats per vert
-		text_vbo.enable_vertex_attrib_array(0);
-		text_vbo.set_vertex_attrib_ptr(0, 0, sizeof(f32), 4);
+		text_quad_vbo = std::make_unique<vbo>(text_quad_corners);
+		text_vao.link_vbo(*text_quad_vbo, 0, 2, 2, 0);
+
+		constexpr u8 glyph_instance_attrib_count = 3;
+		for (u8 i = 1; i <= glyph_instance_attrib_count; ++i)
+		{
+			glEnableVertexAttribArray(i);
+			glVertexAttribDivisor(i, 1);
+		}
 
 		text_vao.unbind();
-		text_vbo.unbind();
+		text_quad_vbo->unbind();
+
+		line_vao.bind();
+		glEnableVertexAttribArray(0);
+		line_vao.unbind();
 
 
 		// Initialize things for the collider debug cube
@@ -197,6 +225,9 @@ namespace birb
 	{
 		ensure(scene::scene_count() > 0);
 		current_scene = &scene;
+
+		// Start watching the files of the new scene on the next frame
+		next_asset_watch_refresh = frame_id_counter;
 	}
 
 	void renderer::set_window(birb::window& window)
@@ -212,6 +243,12 @@ namespace birb
 		ensure(scene::scene_count() > 0);
 		ensure(!g_buffers_flipped, "Tried to draw entities after the buffers were already flipped");
 
+		if (asset_watcher)
+			reload_changed_assets();
+
+		// Swap in the shaders that finished compiling since the last frame
+		shader_collection::poll_async_compiles();
+
 		// Bind the post-processing frame buffer and update its dimensions if needed
 		if (post_processing_enabled)
 		{
@@ -228,13 +265,31 @@ namespace birb
 		entt::registry& entity_registry = current_scene->registry;
 
 		glm::mat4 view_matrix = camera.view_matrix();
+		current_view_matrix = view_matrix;
 
 		// Update the view matrix
-		view_matrix_ubo.update_data(glm::value_ptr(camera.view_matrix()), sizeof(glm::mat4), 0);
+		view_matrix_ubo.update_data(glm::value_ptr(view_matrix), sizeof(glm::mat4), 0);
+
+		// 3D models are drawn with the perspective projection, so cull them against that
+		const glm::mat4 view_projection = camera.perspective_projection_matrix() * view_matrix;
+		view_frustum.update(view_projection);
+
+		if (occlusion_culling_enabled)
+			occlusion.begin(view_projection);
+
+		// The diameter of a sphere with the radius r at the depth d covers
+		// r * P[1][1] / d of the viewport height
+		lod_projection_scale = camera.perspective_projection_matrix()[1][1];
 
 		// Reset statistics
 		render_stats.reset_counters();
 
+		// Everything below reads the cached world matrices
+		current_scene->update_world_matrices();
+		render_stats.world_matrices_updated = current_scene->updated_world_matrix_count();
+
+		update_lights(camera, window_size);
+
 		birb::stopwatch render_stopwatch;
 
 		render_stopwatch.reset();
@@ -272,6 +327,10 @@ namespace birb
 			post_processing_fbo->unbind_frame_buffer();
 		}
 
+		// The GPU might still be reading the streamed data of this
+		// frame, so the next frame gets written into another region
+		vertex_stream.next_frame();
+
 		frame_id_counter++;
 
 		/*****************************************************************************/
@@ -294,6 +353,107 @@ namespace birb
 #endif
 	}
 
+	void renderer::update_lights(const camera& camera, const vec2<i32> viewport_size)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(viewport_size.x > 0 && viewport_size.y > 0, "Invalid viewport size");
+
+		ensure(shader::point_lights.size() <= max_point_lights, "Too many point lights");
+		const u16 point_light_count = static_cast<u16>(std::min<size_t>(shader::point_lights.size(), max_point_lights));
+
+		std140::light_info light_info;
+		light_info.directional.direction	= shader::directional_light.direction.to_glm_vec();
+		light_info.directional.ambient		= shader::directional_light.ambient.to_glm_vec();
+		light_info.directional.diffuse		= shader::directional_light.diffuse.to_glm_vec();
+		light_info.directional.specular		= shader::directional_light.specular.to_glm_vec();
+		light_info.point_light_count		= point_light_count;
+		light_info.clustered				= clustered_lighting_enabled;
+		light_info.shadows					= shadows_enabled;
+
+		point_light_staging.resize(point_light_count);
+		for (u16 i = 0; i < point_light_count; ++i)
+		{
+			const point_light& light = shader::point_lights[i];
+			std140::point_light& gpu_light = point_light_staging[i];
+
+			gpu_light.position	= light.position.to_glm_vec();
+			gpu_light.constant	= light.attenuation_constant;
+			gpu_light.ambient	= light.ambient.to_glm_vec();
+			gpu_light.linear	= light.attenuation_linear;
+			gpu_light.diffuse	= light.diffuse.to_glm_vec();
+			gpu_light.quadratic	= light.attenuation_quadratic;
+			gpu_light.specular	= light.specular.to_glm_vec();
+		}
+
+		const f32 aspect_ratio = static_cast<f32>(viewport_size.x) / static_cast<f32>(viewport_size.y);
+
+		// The shadow cascades follow the camera
+		for (u8 i = 0; i < shadow_cascade_count; ++i)
+			light_info.shadow_matrices[i] = glm::mat4(1.0f);
+
+		if (shadows_enabled)
+		{
+			cascades.update(camera.view_matrix(), camera.fov, aspect_ratio, camera.near_clip, camera.far_clip, light_info.directional.direction);
+
+			for (u8 i = 0; i < shadow_cascade_count; ++i)
+			{
+				const shadow_cascades::cascade& cascade = cascades.get_cascade(i);
+				light_info.shadow_matrices[i] = cascade.light_matrix;
+				light_info.cascade_splits[i] = cascade.far_depth;
+				light_info.cascade_texel_sizes[i] = cascade.texel_size;
+			}
+		}
+
+		if (clustered_lighting_enabled)
+		{
+			birb::stopwatch clustering_stopwatch;
+
+			// The lights need to be re-binned every frame since the camera might have moved
+			clusters.update(camera.view_matrix(), camera.fov, aspect_ratio, camera.near_clip, camera.far_clip, shader::point_lights);
+
+			light_info.cluster_grid = glm::uvec4(light_clusters::grid_size_x, light_clusters::grid_size_y, light_clusters::grid_size_z, 0);
+			light_info.cluster_slicing = glm::vec4(
+				clusters.slice_scale(),
+				clusters.slice_bias(),
+				static_cast<f32>(light_clusters::grid_size_x) / viewport_size.x,
+				static_cast<f32>(light_clusters::grid_size_y) / viewport_size.y);
+
+			cluster_range_tbo.set_data(clusters.light_ranges().data(), clusters.light_ranges().size() * sizeof(glm::uvec2));
+			cluster_index_tbo.set_data(clusters.light_indices().data(), clusters.light_indices().size() * sizeof(u16));
+
+			render_stats.light_cluster_indices = clusters.light_indices().size();
+			render_stats.light_cluster_max_lights = clusters.max_cluster_light_count();
+			render_stats.light_clustering_duration = clustering_stopwatch.stop(true);
+		}
+
+		render_stats.point_lights = point_light_count;
+
+		// Only touch the buffers if something has changed since the previous upload
+		if (!lights_uploaded || std::memcmp(&light_info, &uploaded_light_info, sizeof(std140::light_info)) != 0)
+		{
+			light_info_ubo.update_data(&light_info, sizeof(std140::light_info), 0);
+			uploaded_light_info = light_info;
+		}
+
+		const bool point_lights_changed = !lights_uploaded
+			|| point_light_staging.size() != uploaded_point_lights.size()
+			|| (point_light_count > 0 && std::memcmp(point_light_staging.data(), uploaded_point_lights.data(), point_light_count * sizeof(std140::point_light)) != 0);
+
+		if (point_lights_changed)
+		{
+			point_light_tbo.set_data(point_light_staging.data(), point_light_count * sizeof(std140::point_light));
+			std::swap(point_light_staging, uploaded_point_lights);
+		}
+
+		point_light_tbo.bind(light_texture_unit::point_light_data);
+		cluster_range_tbo.bind(light_texture_unit::cluster_ranges);
+		cluster_index_tbo.bind(light_texture_unit::cluster_indices);
+		glActiveTexture(GL_TEXTURE0);
+
+		lights_uploaded = true;
+	}
+
 	void renderer::draw_elements(size_t index_count, gl_primitive primitive)
 	{
 		ensure(index_count > 0, "Unncessary call to draw_elements()");
@@ -434,6 +594,71 @@ namespace birb
 		shadows_enabled = enabled;
 	}
 
+	bool renderer::is_shadows_enabled() const
+	{
+		return shadows_enabled;
+	}
+
+	void renderer::opt_frustum_culling(const bool enabled)
+	{
+		frustum_culling_enabled = enabled;
+	}
+
+	bool renderer::is_frustum_culling_enabled() const
+	{
+		return frustum_culling_enabled;
+	}
+
+	void renderer::opt_occlusion_culling(const bool enabled)
+	{
+		occlusion_culling_enabled = enabled;
+	}
+
+	bool renderer::is_occlusion_culling_enabled() const
+	{
+		return occlusion_culling_enabled;
+	}
+
+	void renderer::opt_lod(const bool enabled)
+	{
+		lod_enabled = enabled;
+	}
+
+	bool renderer::is_lod_enabled() const
+	{
+		return lod_enabled;
+	}
+
+	void renderer::opt_instancing(const bool enabled)
+	{
+		instancing_enabled = enabled;
+	}
+
+	bool renderer::is_instancing_enabled() const
+	{
+		return instancing_enabled;
+	}
+
+	void renderer::opt_sprite_batching(const bool enabled)
+	{
+		sprite_batching_enabled = enabled;
+	}
+
+	bool renderer::is_sprite_batching_enabled() const
+	{
+		return sprite_batching_enabled;
+	}
+
+	void renderer::opt_clustered_lighting(const bool enabled)
+	{
+		clustered_lighting_enabled = enabled;
+	}
+
+	bool renderer::is_clustered_lighting_enabled() const
+	{
+		return clustered_lighting_enabled;
+	}
+
 	void renderer::opt_blend(const bool enabled) const
 	{
 		ensure(g_opengl_initialized);
@@ -474,4 +699,140 @@ namespace birb
 	{
 		return post_processing_enabled;
 	}
+
+	void renderer::opt_hot_reload(const bool enabled)
+	{
+		if (enabled == is_hot_reload_enabled())
+			return;
+
+		if (!enabled)
+		{
+			asset_watcher.reset();
+			return;
+		}
+
+		asset_watcher = std::make_unique<file_watcher>();
+		next_asset_watch_refresh = frame_id_counter;
+	}
+
+	bool renderer::is_hot_reload_enabled() const
+	{
+		return asset_watcher != nullptr;
+	}
+
+	void renderer::reload_changed_assets()
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		ensure(asset_watcher != nullptr);
+
+		if (frame_id_counter >= next_asset_watch_refresh)
+		{
+			watch_scene_assets();
+			next_asset_watch_refresh = frame_id_counter + asset_watch_refresh_interval;
+		}
+
+		const std::vector<std::string> changes = asset_watcher->poll_changes();
+		if (changes.empty())
+			return;
+
+		const std::unordered_set<std::string> changed_files(changes.begin(), changes.end());
+
+		// The watcher reports canonical paths, but the assets might use relative ones
+		const auto is_changed = [&changed_files](const std::string& path) -> bool
+		{
+			std::error_code error;
+			const std::filesystem::path canonical_path = std::filesystem::weakly_canonical(path, error);
+			return !error && changed_files.contains(canonical_path.string());
+		};
+
+		for (const std::string& path : changes)
+		{
+			birb::log("File changed: ", path);
+
+			const std::filesystem::path file_path = path;
+			if (file_path.extension() == ".glsl")
+				shader_collection::reload_shader_source(file_path.stem().string());
+		}
+
+		// Models get reloaded if their model, material or texture files changed.
+		// Copies of a model share their meshes, so only one copy gets reloaded
+		// and the rest pick up the new meshes from it. Nullptr means that
+		// the meshes were left as they were
+		std::unordered_map<const std::vector<birb::mesh>*, const birb::model*> reloaded_models;
+
+		const auto model_view = current_scene->registry.view<birb::model>();
+		for (const entt::entity entity : model_view)
+		{
+			birb::model& model = model_view.get<birb::model>(entity);
+			const std::vector<birb::mesh>* shared_meshes = &model.get_meshes();
+
+			if (reloaded_models.contains(shared_meshes))
+			{
+				if (reloaded_models.at(shared_meshes) != nullptr)
+					model.refresh_shared_state(*reloaded_models.at(shared_meshes));
+
+				continue;
+			}
+
+			const std::vector<std::string> dependencies = model.dependencies();
+			const bool reloaded = std::any_of(dependencies.begin(), dependencies.end(), is_changed) && model.reload(true);
+			reloaded_models[shared_meshes] = reloaded ? &model : nullptr;
+		}
+
+		// Sprites that are copies of each other share their texture
+		std::unordered_set<birb::texture*> reloaded_textures;
+
+		const auto sprite_view = current_scene->registry.view<birb::sprite>();
+		for (const entt::entity entity : sprite_view)
+		{
+			const std::shared_ptr<birb::texture>& texture = sprite_view.get<birb::sprite>(entity).texture;
+
+			// Textures in texture atlases don't have a file of their own
+			if (texture == nullptr || texture->path().empty() || reloaded_textures.contains(texture.get()))
+				continue;
+
+			if (is_changed(texture->path()))
+			{
+				texture->reload();
+				reloaded_textures.insert(texture.get());
+			}
+		}
+	}
+
+	void renderer::watch_scene_assets()
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		ensure(asset_watcher != nullptr);
+		ensure(current_scene != nullptr);
+
+		// Only the external shaders can change. The builtin ones are embedded into the executable
+		for (const std::string& path : shader::shader_src_search_paths)
+			asset_watcher->watch(path);
+
+		// Many entities tend to share the same model files
+		std::unordered_set<std::string> watched_models;
+
+		const auto model_view = current_scene->registry.view<birb::model>();
+		for (const entt::entity entity : model_view)
+		{
+			birb::model& model = model_view.get<birb::model>(entity);
+
+			if (!watched_models.insert(model.model_file_path()).second)
+				continue;
+
+			for (const std::string& path : model.dependencies())
+				asset_watcher->watch(path);
+		}
+
+		const auto sprite_view = current_scene->registry.view<birb::sprite>();
+		for (const entt::entity entity : sprite_view)
+		{
+			const std::shared_ptr<birb::texture>& texture = sprite_view.get<birb::sprite>(entity).texture;
+
+			if (texture != nullptr && !texture->path().empty())
+				asset_watcher->watch(texture->path());
+		}
+	}
 }
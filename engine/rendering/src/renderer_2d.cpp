@@ -1,6 +1,7 @@
 #include "Box2DCollider.hpp"
 #include "MimicSprite.hpp"
 #include "Profiling.hpp"
+#include "RenderQueue.hpp"
 #include "Renderer.hpp"
 #include "ShaderCollection.hpp"
 #include "ShaderSprite.hpp"
@@ -11,11 +12,28 @@
 #include "Transformer.hpp"
 
 #include <algorithm>
+#include <cstddef>
 #include <execution>
 #include <glad/gl.h>
 
 namespace birb
 {
+	static const glm::vec4 full_uv_rect(0.0f, 0.0f, 1.0f, 1.0f);
+
+	/**
+	 * @brief Build a render queue sort key for a sprite
+	 *
+	 * Sprites are drawn back to front (lowest z first) so that transparency
+	 * keeps working. Sprites on the same depth get grouped by their projection
+	 * and texture
+	 */
+	static u64 sprite_sort_key(const f32 depth, const bool orthographic, const u32 texture_id)
+	{
+		return render_queue::key_field(render_queue::sortable_float(depth), 32, 32)
+			| render_queue::key_field(orthographic, 1, 31)
+			| render_queue::key_field(texture_id, 31, 0);
+	}
+
 	void renderer::draw_2d_entities()
 	{
 		PROFILER_SCOPE_RENDER_FN();
@@ -25,20 +43,18 @@ namespace birb
 
 		// Sprites should only have a singular texture, so we'll use the default
 		// tex0 texture unit
+		//
+		// Each way of drawing sprites has its own variant of the texture shader, so the
+		// draw functions need to activate the shader they use before drawing anything
 		const std::shared_ptr<shader> texture_shader = shader_collection::get_shader(texture_shader_ref);
 		texture_shader->activate();
 		texture_shader->set(shader_uniforms::texture_units::tex0, 0);
 
-		texture_shader->set(shader_uniforms::texture::instanced, 0);
 		draw_sprites(texture_shader);
 		draw_mimic_sprites(texture_shader);
-
-		texture_shader->set(shader_uniforms::texture::instanced, 1);
-		draw_sprites_instanced(texture_shader);
+		draw_sprites_instanced(shader_collection::get_shader(instanced_texture_shader_ref));
 
 		// Shader sprites use custom fragment shaders
-		texture_shader->set(shader_uniforms::texture::instanced, 0);
-
 		draw_shader_sprites();
 
 		sprite_vao.unbind();
@@ -72,8 +88,10 @@ namespace birb
 		{
 			PROFILER_SCOPE_RENDER("Calculate transform model matrices");
 
+			const scene& scene = *current_scene;
+
 			std::transform(std::execution::par, view.begin(), view.end(), sprite_model_array.begin(),
-				[view, &entity_registry](auto& entity)
+				[view, &entity_registry, &scene](auto& entity)
 				{
 					sprite_data data;
 
@@ -88,7 +106,7 @@ namespace birb
 						return data;
 
 					data.sprite = &view.get<birb::sprite>(entity);
-					data.model_matrix = view.get<birb::transform>(entity).model_matrix();
+					data.model_matrix = scene.world_matrix(entity);
 
 					return data;
 				}
@@ -96,18 +114,62 @@ namespace birb
 		}
 
 
-		for (const sprite_data& data : sprite_model_array)
+		sprite_queue.clear();
+		for (u32 i = 0; i < sprite_model_array.size(); ++i)
 		{
 			// Don't render entities that are inactive
-			if (!data.is_active)
+			if (!sprite_model_array[i].is_active)
 				continue;
 
+			const sprite_data& data = sprite_model_array[i];
+			sprite_queue.push(sprite_sort_key(data.model_matrix[3].z, data.sprite->orthographic_projection, data.sprite->texture->id), i);
+		}
+		sprite_queue.sort();
+
+		if (sprite_batching_enabled)
+		{
+			const std::vector<render_queue::command>& commands = sprite_queue.commands();
+			sprite_instances.resize(commands.size());
+
+			std::transform(std::execution::par_unseq, commands.begin(), commands.end(), sprite_instances.begin(),
+				[&sprite_model_array](const render_queue::command& command)
+				{
+					const sprite_data& data = sprite_model_array[command.index];
+					const birb::color& color = data.sprite->color;
+
+					return sprite_instance {
+						data.model_matrix,
+						glm::vec3(color.r, color.g, color.b),
+						sprite_aspect_ratio(*data.sprite),
+						data.sprite->uv_rect
+					};
+				}
+			);
+
+			draw_sprite_batches();
+			return;
+		}
+
+		texture_shader->activate();
+
+		u32 bound_texture = 0;
+
+		for (const render_queue::command& command : sprite_queue.commands())
+		{
+			const sprite_data& data = sprite_model_array[command.index];
+
 			texture_shader->set(shader_uniforms::model, data.model_matrix);
 			texture_shader->set(shader_uniforms::texture::orthographic, data.sprite->orthographic_projection);
 			texture_shader->set(shader_uniforms::color, data.sprite->color);
+			texture_shader->set(shader_uniforms::texture::uv_rect, data.sprite->uv_rect);
 			set_sprite_aspect_ratio_uniforms(*data.sprite, *texture_shader);
 
-			data.sprite->texture->bind();
+			if (data.sprite->texture->id != bound_texture)
+			{
+				data.sprite->texture->bind();
+				bound_texture = data.sprite->texture->id;
+				++render_stats.texture_binds;
+			}
 
 			draw_elements(quad_indices.size());
 
@@ -132,7 +194,10 @@ namespace birb
 		if (sprite_count == 0)
 			return;
 
-		constexpr u8 first_layout_index = 5;
+		texture_shader->activate();
+		texture_shader->set(shader_uniforms::texture_units::tex0, 0);
+
+		constexpr u8 first_layout_index = instance_matrix_layout;
 		constexpr u8 vec4_component_count = 4;
 		constexpr size_t vec4_size = sizeof(glm::vec4);
 
@@ -143,6 +208,12 @@ namespace birb
 			glVertexAttribDivisor(first_layout_index + i, 1);
 		}
 
+		// Group the instanced sprites by their textures. The instances can't be
+		// depth sorted as a whole, so they are kept in storage order otherwise
+		std::vector<entt::entity> entities;
+		entities.reserve(sprite_count);
+
+		sprite_queue.clear();
 		for (const auto& entity : view)
 		{
 			// Don't render entities that are inactive or invisible
@@ -150,13 +221,47 @@ namespace birb
 				continue;
 
 			const sprite& sprite = view.get<birb::sprite>(entity);
-			const transformer& transformer = view.get<birb::transformer>(entity);
+			sprite_queue.push(sprite_sort_key(0.0f, sprite.orthographic_projection, sprite.texture->id), entities.size());
+			entities.push_back(entity);
+		}
+		sprite_queue.sort();
+
+		u32 bound_texture = 0;
+
+		for (const render_queue::command& command : sprite_queue.commands())
+		{
+			const sprite& sprite = view.get<birb::sprite>(entities[command.index]);
+			transformer& transformer = view.get<birb::transformer>(entities[command.index]);
 			ensure(transformer.is_locked(), "Using an unlocked transformer is very inefficient");
 
+			// Copy the updated model matrices into the instance VBO through the stream
+			// buffer, so that the VBO doesn't have to be re-specified
+			if (transformer.has_pending_vbo_data())
+			{
+				const std::vector<glm::mat4>& matrices = transformer.locked_model_matrices();
+				const u32 vbo = transformer.model_matrix_instance_vbo();
+
+				for (const transformer::index_range& range : transformer.pending_vbo_ranges())
+				{
+					vertex_stream.copy_to(vbo, matrices.data() + range.first, range.count * sizeof(glm::mat4), range.first * sizeof(glm::mat4));
+					render_stats.instance_matrices_uploaded += range.count;
+				}
+
+				transformer.mark_vbo_data_uploaded();
+			}
+
 			texture_shader->set(shader_uniforms::texture::orthographic, sprite.orthographic_projection);
+			texture_shader->set(shader_uniforms::texture::uv_rect, sprite.uv_rect);
 
 			set_sprite_aspect_ratio_uniforms(sprite, *texture_shader);
-			sprite.texture->bind();
+
+			if (sprite.texture->id != bound_texture)
+			{
+				sprite.texture->bind();
+				bound_texture = sprite.texture->id;
+				++render_stats.texture_binds;
+			}
+
 			transformer.bind_vbo();
 
 			for (u8 i = 0; i < vec4_component_count; ++i)
@@ -183,6 +288,9 @@ namespace birb
 
 		const auto view = entity_registry.view<mimic_sprite, transform>();
 
+		std::vector<entt::entity> entities;
+
+		sprite_queue.clear();
 		for (const auto& entity : view)
 		{
 			// Don't render entities that are inactive or invisible
@@ -190,13 +298,55 @@ namespace birb
 				continue;
 
 			const mimic_sprite& entity_sprite = view.get<birb::mimic_sprite>(entity);
-			const birb::transform& transform = view.get<birb::transform>(entity);
+			const f32 depth = current_scene->world_matrix(entity)[3].z;
+
+			sprite_queue.push(sprite_sort_key(depth, entity_sprite.orthographic_projection, entity_sprite.texture->id), entities.size());
+			entities.push_back(entity);
+		}
+		sprite_queue.sort();
+
+		if (sprite_batching_enabled)
+		{
+			const std::vector<render_queue::command>& commands = sprite_queue.commands();
+			sprite_instances.resize(commands.size());
+
+			const scene& scene = *current_scene;
+
+			std::transform(std::execution::par_unseq, commands.begin(), commands.end(), sprite_instances.begin(),
+				[&view, &entities, &scene](const render_queue::command& command)
+				{
+					return sprite_instance {
+						scene.world_matrix(entities[command.index]),
+						glm::vec3(1.0f, 1.0f, 1.0f),
+						sprite_aspect_ratio(view.get<birb::mimic_sprite>(entities[command.index])),
+						full_uv_rect
+					};
+				}
+			);
+
+			draw_sprite_batches();
+			return;
+		}
+
+		texture_shader->activate();
+		texture_shader->set(shader_uniforms::texture::uv_rect, full_uv_rect);
+
+		u32 bound_texture = 0;
+
+		for (const render_queue::command& command : sprite_queue.commands())
+		{
+			const mimic_sprite& entity_sprite = view.get<birb::mimic_sprite>(entities[command.index]);
 
-			texture_shader->set(shader_uniforms::model, transform.model_matrix());
+			texture_shader->set(shader_uniforms::model, current_scene->world_matrix(entities[command.index]));
 			texture_shader->set(shader_uniforms::texture::orthographic, entity_sprite.orthographic_projection);
 			set_sprite_aspect_ratio_uniforms(entity_sprite, *texture_shader);
 
-			entity_sprite.texture->bind();
+			if (entity_sprite.texture->id != bound_texture)
+			{
+				entity_sprite.texture->bind();
+				bound_texture = entity_sprite.texture->id;
+				++render_stats.texture_binds;
+			}
 
 			draw_elements(quad_indices.size());
 
@@ -215,6 +365,13 @@ namespace birb
 
 		const auto view = entity_registry.view<shader_sprite, transform>();
 
+		std::vector<entt::entity> entities;
+		std::vector<std::shared_ptr<birb::shader>> shaders;
+
+		// Shader sprites are drawn back to front and grouped by their shader programs
+		// if they are on the same depth. The shader takes the place of the texture
+		// in the sort key, since these sprites don't have textures
+		sprite_queue.clear();
 		for (const auto& entity : view)
 		{
 			// Don't render entities that are inactive or invisible
@@ -222,14 +379,35 @@ namespace birb
 				continue;
 
 			shader_sprite& entity_sprite = view.get<shader_sprite>(entity);
-			const birb::transform& transform = view.get<birb::transform>(entity);
+			const f32 depth = current_scene->world_matrix(entity)[3].z;
 
 			std::shared_ptr<birb::shader> shader = shader_collection::get_shader(entity_sprite.shader_reference());
 
-			shader->activate();
-			shader->set(shader_uniforms::model, transform.model_matrix());
+			sprite_queue.push(sprite_sort_key(depth, entity_sprite.orthographic_projection, shader->id), entities.size());
+			entities.push_back(entity);
+			shaders.push_back(shader);
+		}
+		sprite_queue.sort();
+
+		u32 active_shader = 0;
+
+		for (const render_queue::command& command : sprite_queue.commands())
+		{
+			shader_sprite& entity_sprite = view.get<shader_sprite>(entities[command.index]);
+
+			const std::shared_ptr<birb::shader>& shader = shaders[command.index];
+
+			if (shader->id != active_shader)
+			{
+				shader->activate();
+				active_shader = shader->id;
+				++render_stats.shader_switches;
+			}
+
+			shader->set(shader_uniforms::model, current_scene->world_matrix(entities[command.index]));
 			shader->set(shader_uniforms::texture::orthographic, entity_sprite.orthographic_projection);
 			shader->set(shader_uniforms::texture::aspect_ratio, { 1.0f, 1.0f });
+			shader->set(shader_uniforms::texture::uv_rect, full_uv_rect);
 			draw_elements(quad_indices.size());
 
 			// We can probably assume that each rectangle shaped sprite is
@@ -238,4 +416,92 @@ namespace birb
 			++render_stats.entities_2d;
 		}
 	}
+
+	void renderer::draw_sprite_batches()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		const std::vector<render_queue::command>& commands = sprite_queue.commands();
+		ensure(sprite_instances.size() == commands.size());
+
+		if (commands.empty())
+			return;
+
+		const u32 instance_data_offset = vertex_stream.push(sprite_instances.data(), sprite_instances.size() * sizeof(sprite_instance));
+
+		// The projection and texture are stored in the lowest bits of the sprite sort key
+		constexpr u64 batch_state_mask = render_queue::key_field(~0ull, 32, 0);
+
+		constexpr u8 first_matrix_layout = instance_matrix_layout;
+		constexpr u8 color_layout = instance_matrix_layout + 4;
+		constexpr u8 aspect_ratio_layout = instance_matrix_layout + 5;
+		constexpr u8 uv_rect_layout = instance_matrix_layout + 6;
+		constexpr u8 attrib_count = 7;
+		constexpr size_t vec4_size = sizeof(glm::vec4);
+		constexpr size_t stride = sizeof(sprite_instance);
+
+		shader& texture_shader = *shader_collection::get_shader(batched_texture_shader_ref);
+		texture_shader.activate();
+		texture_shader.set(shader_uniforms::texture_units::tex0, 0);
+
+		for (u8 i = 0; i < attrib_count; ++i)
+		{
+			glEnableVertexAttribArray(first_matrix_layout + i);
+			glVertexAttribDivisor(first_matrix_layout + i, 1);
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+		vertex_stream.bind();
+
+		u32 bound_texture = 0;
+
+		for (size_t first = 0; first < commands.size();)
+		{
+			// Sprites that are next to each other in the sorted queue and share the same
+			// projection and texture can be merged without breaking the back to front order
+			const u64 batch_state = commands[first].key & batch_state_mask;
+
+			size_t last = first + 1;
+			while (last < commands.size() && (commands[last].key & batch_state_mask) == batch_state)
+				++last;
+
+			const bool orthographic = (batch_state >> 31) & 1;
+			const u32 texture_id = batch_state & render_queue::key_field(~0ull, 31, 0);
+
+			texture_shader.set(shader_uniforms::texture::orthographic, orthographic);
+
+			if (texture_id != bound_texture)
+			{
+				texture::bind(texture_id);
+				bound_texture = texture_id;
+				++render_stats.texture_binds;
+			}
+
+			// Point the instance attributes to the first sprite of the batch
+			const size_t batch_offset = instance_data_offset + first * stride;
+			for (u8 i = 0; i < 4; ++i)
+				glVertexAttribPointer(first_matrix_layout + i, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(batch_offset + offsetof(sprite_instance, model_matrix) + i * vec4_size));
+			glVertexAttribPointer(color_layout, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(batch_offset + offsetof(sprite_instance, color)));
+			glVertexAttribPointer(aspect_ratio_layout, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(batch_offset + offsetof(sprite_instance, aspect_ratio)));
+			glVertexAttribPointer(uv_rect_layout, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(batch_offset + offsetof(sprite_instance, uv_rect)));
+
+			const u32 sprite_count = last - first;
+			draw_elements_instanced(quad_indices.size(), sprite_count);
+
+			++render_stats.sprite_batches;
+			render_stats.sprites_batched += sprite_count;
+
+			// We can probably assume that each rectangle shaped sprite is
+			// equal to 4 vertices
+			render_stats.vertices_2d += 4 * sprite_count;
+			render_stats.entities_2d += sprite_count;
+
+			first = last;
+		}
+
+		vertex_stream.unbind();
+
+		for (u8 i = 0; i < attrib_count; ++i)
+			glDisableVertexAttribArray(first_matrix_layout + i);
+	}
 }
@@ -1,17 +1,27 @@
 #include "BoxCollider.hpp"
+#include "Frustum.hpp"
 #include "Material.hpp"
+#include "Math.hpp"
+#include "Mesh.hpp"
 #include "Model.hpp"
+#include "OcclusionCuller.hpp"
 #include "Profiling.hpp"
+#include "RenderQueue.hpp"
 #include "Renderer.hpp"
 #include "ShaderCollection.hpp"
 #include "ShaderRef.hpp"
 #include "ShaderUniforms.hpp"
+#include "ShaderVariant.hpp"
+#include "ShadowCascades.hpp"
 #include "State.hpp"
+#include "Stopwatch.hpp"
 #include "Transform.hpp"
 
 #include <algorithm>
 #include <execution>
+#include <functional>
 #include <glad/gl.h>
+#include <limits>
 #include <vector>
 
 namespace birb
@@ -35,10 +45,6 @@ namespace birb
 
 		entt::registry& entity_registry = current_scene->registry;
 
-		// Store shaders that have some specific uniforms updated already
-		// to avoid duplicate uniform updates
-		std::unordered_set<u32> uniforms_updated;
-
 		const auto view = entity_registry.view<birb::model, birb::shader_ref, birb::transform>();
 
 		// Process some data for each entity in parallel with std::transform
@@ -46,10 +52,23 @@ namespace birb
 		struct model_data
 		{
 			bool is_active = true;
+			bool is_visible = true;
+			bool is_occluder = false;
+			bool is_occluded = false;
 			birb::model* model = nullptr;
 			glm::mat4 model_matrix;
+
+			// World space bounds. Only valid if the model has any vertices
+			bool has_bounds = false;
+			bounding_box bounds;
+			f32 depth = 0.0f;
+			u8 lod = 0;
 			shader_ref* shader = nullptr;
+			birb::shader* program = nullptr;
 			birb::material* material = nullptr;
+
+			// Features added on top of the variant of the shader reference
+			u32 variant = shader_variant::none;
 		};
 
 		std::vector<model_data> model_data_array(std::distance(view.begin(), view.end()));
@@ -57,8 +76,15 @@ namespace birb
 		{
 			PROFILER_SCOPE_RENDER("Process transform model matrices for 3D models");
 
+			const frustum& culling_frustum = view_frustum;
+			const bool frustum_culling = frustum_culling_enabled;
+			const glm::mat4 view_matrix = current_view_matrix;
+			const bool lod = lod_enabled;
+			const f32 projection_scale = lod_projection_scale;
+			const scene& scene = *current_scene;
+
 			std::transform(std::execution::par_unseq, view.begin(), view.end(), model_data_array.begin(),
-				[view, &entity_registry](auto& entity)
+				[view, &entity_registry, &scene, &culling_frustum, frustum_culling, view_matrix, lod, projection_scale](auto& entity)
 				{
 					model_data data;
 					data.is_active = true;
@@ -74,59 +100,583 @@ namespace birb
 						return data;
 
 					data.model = &view.get<birb::model>(entity);
-					data.model_matrix = view.get<birb::transform>(entity).model_matrix();
+					data.model_matrix = scene.world_matrix(entity);
 					data.shader = &view.get<birb::shader_ref>(entity);
 					data.material = entity_registry.try_get<birb::material>(entity);
 
+					// Texture materials (type 1) sample their colors in a separate shader variant
+					if (data.material != nullptr && data.material->type == 1)
+						data.variant |= shader_variant::textured;
+
+					// Distance from the camera along the view direction
+					data.depth = -(view_matrix * data.model_matrix[3]).z;
+
+					// Test the world space bounds of the model against the view frustum.
+					// Models without any bounds (no vertices) are left for the draw loop to deal with
+					data.has_bounds = data.model->bounds().is_valid();
+					if (data.has_bounds)
+						data.bounds = data.model->bounds().transformed(data.model_matrix);
+
+					if (frustum_culling && data.has_bounds)
+						data.is_visible = culling_frustum.intersects(data.bounds);
+
+					// Pick the level of detail from the size of the bounds on the screen.
+					// Shadow casters outside of the view need a level too, so this is done before culling
+					if (lod && data.has_bounds)
+					{
+						const f32 radius = glm::length(data.bounds.extents());
+						const f32 center_depth = -(view_matrix * glm::vec4(data.bounds.center(), 1.0f)).z;
+
+						// The camera is inside of the bounds
+						const f32 screen_size = center_depth > radius ? radius * projection_scale / center_depth : std::numeric_limits<f32>::max();
+
+						data.lod = data.model->select_lod(screen_size);
+					}
+
+					const birb::occluder* occluder = entity_registry.try_get<birb::occluder>(entity);
+					data.is_occluder = occluder != nullptr && occluder->enabled;
+
 					return data;
 				}
 			);
 		}
 
-		if (gamma_correction_enabled)
-			glEnable(GL_FRAMEBUFFER_SRGB);
+		// Models outside of the camera view can still cast shadows into it,
+		// so the shadow casters are picked before the visibility culling
+		if (shadows_enabled)
+		{
+			shadow_casters.clear();
+			for (const model_data& data : model_data_array)
+				if (data.is_active && data.has_bounds)
+					shadow_casters.push_back({ data.model, data.model_matrix, data.bounds, data.lod });
+
+			draw_shadow_maps();
+		}
+
+		// Hidden models can cast shadows too, so the occlusion culling is done after the shadows.
+		// Occluders outside of the view can't hide anything, so only the visible ones get rasterized
+		if (occlusion_culling_enabled)
+		{
+			PROFILER_SCOPE_RENDER("Occlusion culling for 3D models");
+
+			for (const model_data& data : model_data_array)
+			{
+				if (!data.is_active || !data.is_visible || !data.is_occluder)
+					continue;
+
+				for (const birb::mesh& mesh : data.model->get_meshes())
+					occlusion.add_occluder(mesh.vertices, mesh.indices, data.model_matrix);
+
+				++render_stats.occluders_rasterized;
+			}
+
+			occlusion.rasterize();
+
+			const occlusion_culler& culler = occlusion;
+			std::for_each(std::execution::par_unseq, model_data_array.begin(), model_data_array.end(),
+				[&culler](model_data& data)
+				{
+					if (data.is_active && data.is_visible && data.has_bounds && !data.is_occluder)
+						data.is_occluded = !culler.is_visible(data.bounds);
+				}
+			);
+		}
+
+		// Sort key layout from the most expensive state change to the least expensive one
+		//   [ shader program | material | texture set | mesh VAO | level of detail | depth ]
+		constexpr u8 depth_bit_count	= 12;
+		constexpr u8 lod_bit_count		= 2;
+		constexpr u8 vao_bit_count		= 12;
+		constexpr u8 texture_bit_count	= 12;
+		constexpr u8 material_bit_count	= 12;
+		constexpr u8 shader_bit_count	= 14;
+
+		constexpr u8 depth_offset		= 0;
+		constexpr u8 lod_offset			= depth_offset + depth_bit_count;
+		constexpr u8 vao_offset			= lod_offset + lod_bit_count;
+		constexpr u8 texture_offset		= vao_offset + vao_bit_count;
+		constexpr u8 material_offset	= texture_offset + texture_bit_count;
+		constexpr u8 shader_offset		= material_offset + material_bit_count;
+		static_assert(shader_offset + shader_bit_count == 64);
+		static_assert(mesh::max_lod_count <= (1 << lod_bit_count));
+
+		// Materials are components that are copied to each entity, so they
+		// need to be identified by their values instead of their addresses
+		const auto material_hash = [](const birb::material& material) -> u64
+		{
+			u64 hash = std::hash<f32>{}(material.shininess);
+			for (const f32 value : { material.diffuse.r, material.diffuse.g, material.diffuse.b, material.specular.r, material.specular.g, material.specular.b })
+				hash = combine_hashes(hash, static_cast<u64>(std::hash<f32>{}(value)));
+
+			return combine_hashes(hash, static_cast<u64>(material.type));
+		};
+
+		const auto same_material = [](const birb::material& a, const birb::material& b) -> bool
+		{
+			return a.diffuse == b.diffuse
+				&& a.specular == b.specular
+				&& a.shininess == b.shininess
+				&& a.type == b.type;
+		};
+
+		// Meshes that don't have a material of their own keep using whatever was set before them
+		const auto effective_material = [](const model_data& data, const birb::mesh& mesh) -> const birb::material*
+		{
+			if (data.material != nullptr)
+				return data.material;
+
+			return mesh.material_name.empty() ? nullptr : &mesh.material;
+		};
+
+		{
+			PROFILER_SCOPE_RENDER("Build the 3D render queue");
+
+			model_queue.clear();
+
+			for (u32 i = 0; i < model_data_array.size(); ++i)
+			{
+				model_data& data = model_data_array[i];
+
+				// Check if the entity should be skipped because its not active
+				if (!data.is_active)
+					continue;
+
+				// Skip entities that are outside of the camera view
+				if (!data.is_visible)
+				{
+					++render_stats.entities_3d_culled;
+					continue;
+				}
+
+				// Skip entities that are hidden behind occluders
+				if (data.is_occluded)
+				{
+					++render_stats.entities_3d_occluded;
+					continue;
+				}
+
+				++render_stats.entities_3d_visible;
+
+				// Get the shader we'll be using for drawing the meshes of the model
+				data.program = shader_collection::get_shader(data.shader->with_variant(data.shader->variant() | data.variant)).get();
+				ensure(data.program->id != 0, "Tried to use an invalid shader for rendering");
+
+				ensure(data.model->vertex_count() != 0, "Tried to render a model with no vertices");
+
+				// Each mesh gets its own command, so that meshes with matching
+				// state can be grouped together even if they belong to different models
+				const std::vector<mesh>& meshes = data.model->get_meshes();
+				for (u32 j = 0; j < meshes.size(); ++j)
+				{
+					const birb::material* material = effective_material(data, meshes[j]);
+
+					const u64 key = render_queue::key_field(data.program->id, shader_bit_count, shader_offset)
+						| render_queue::key_field(material ? material_hash(*material) : 0, material_bit_count, material_offset)
+						| render_queue::key_field(meshes[j].texture_set_hash(), texture_bit_count, texture_offset)
+						| render_queue::key_field(meshes[j].vao_id(), vao_bit_count, vao_offset)
+						| render_queue::key_field(data.lod, lod_bit_count, lod_offset)
+						| render_queue::key_field(render_queue::depth_bits(data.depth, depth_bit_count), depth_bit_count, depth_offset);
+
+					model_queue.push(key, i, j);
+				}
+
+				++render_stats.entities_3d;
+				render_stats.vertices_3d += data.model->vertex_count();
+			}
+
+			model_queue.sort();
+		}
+
+		// Split the sorted commands into batches. Consecutive commands that draw the same mesh at the same
+		// level of detail with the same shader and material can be drawn with a single instanced draw call
+		struct draw_batch
+		{
+			u32 first_command = 0;
+			u32 command_count = 0;
+
+			// The shader that the batch gets drawn with. This will be
+			// the instanced variant of the shader for instanced batches
+			birb::shader* program = nullptr;
+
+			bool instanced = false;
+			u32 first_instance = 0;
+		};
+
+		std::vector<draw_batch> batches;
+		const std::vector<render_queue::command>& commands = model_queue.commands();
 
-		for (const model_data& data : model_data_array)
 		{
-			// Check if the entity should be skipped because its not active
-			if (!data.is_active)
-				continue;
+			PROFILER_SCOPE_RENDER("Batch 3D models for instancing");
 
-			// Get the shader we'll be using for drawing the meshes of the model
-			std::shared_ptr<shader> shader = shader_collection::get_shader(*data.shader);
-			shader->activate();
+			batches.reserve(commands.size());
+			model_instance_matrices.clear();
 
-			ensure(shader->id != 0, "Tried to use an invalid shader for rendering");
+			// Models with multiple meshes end up in multiple batches,
+			// so track which entities have already been counted as instanced
+			std::vector<bool> instanced_entities(model_data_array.size(), false);
 
-			// Make sure the lighting is up-to-date
-			if (!uniforms_updated.contains(shader->id))
+			const auto command_mesh = [&model_data_array](const render_queue::command& command) -> const birb::mesh&
 			{
-				shader->update_directional_light();
-				shader->update_point_lights();
-				uniforms_updated.insert(shader->id);
+				return model_data_array[command.index].model->get_meshes()[command.sub_index];
+			};
+
+			for (u32 i = 0; i < commands.size();)
+			{
+				const model_data& first = model_data_array[commands[i].index];
+				const birb::mesh& first_mesh = command_mesh(commands[i]);
+				const birb::material* first_material = effective_material(first, first_mesh);
+
+				u32 run_end = i + 1;
+
+				// Models that share their mesh data also share the mesh objects, so comparing
+				// mesh addresses is enough to find identical models
+				if (instancing_enabled)
+				{
+					while (run_end < commands.size())
+					{
+						const model_data& data = model_data_array[commands[run_end].index];
+						const birb::mesh& mesh = command_mesh(commands[run_end]);
+
+						if (&mesh != &first_mesh || data.lod != first.lod || data.program != first.program)
+							break;
+
+						const birb::material* material = effective_material(data, mesh);
+						if ((material == nullptr) != (first_material == nullptr)
+								|| (material != nullptr && !same_material(*material, *first_material)))
+							break;
+
+						++run_end;
+					}
+				}
+
+				draw_batch batch;
+				batch.first_command = i;
+				batch.command_count = run_end - i;
+				batch.program = first.program;
+
+				if (batch.command_count >= instancing_threshold)
+				{
+					birb::shader* instanced_shader = shader_collection::get_instanced_shader(first.shader->with_variant(first.shader->variant() | first.variant)).get();
+					if (instanced_shader != nullptr)
+					{
+						batch.program = instanced_shader;
+						batch.instanced = true;
+						batch.first_instance = model_instance_matrices.size();
+
+						for (u32 j = i; j < run_end; ++j)
+						{
+							model_instance_matrices.push_back(model_data_array[commands[j].index].model_matrix);
+
+							if (!instanced_entities[commands[j].index])
+							{
+								instanced_entities[commands[j].index] = true;
+								++render_stats.entities_3d_instanced;
+							}
+						}
+					}
+				}
+
+				// Batches that can't be instanced get drawn one command at a time
+				if (batch.instanced)
+				{
+					batches.push_back(batch);
+				}
+				else
+				{
+					for (u32 j = i; j < run_end; ++j)
+						batches.push_back({ j, 1, first.program, false, 0 });
+				}
+
+				i = run_end;
 			}
+		}
+
+		// Stream the model matrices for all of the instanced batches at once
+		u32 instance_data_offset = 0;
+		if (!model_instance_matrices.empty())
+			instance_data_offset = vertex_stream.push(model_instance_matrices.data(), model_instance_matrices.size() * sizeof(glm::mat4));
+
+		if (gamma_correction_enabled)
+			glEnable(GL_FRAMEBUFFER_SRGB);
 
-			shader->set(shader_uniforms::model, data.model_matrix);
+		// Currently applied state. Anything that matches these can be skipped
+		birb::shader* active_shader = nullptr;
+		const birb::material* active_material = nullptr;
+		const birb::mesh* textured_mesh = nullptr;
+		u32 bound_vao = 0;
+
+		constexpr u8 vec4_component_count = 4;
+		constexpr size_t vec4_size = sizeof(glm::vec4);
+
+		for (const draw_batch& batch : batches)
+		{
+			const render_queue::command& command = commands[batch.first_command];
+			const model_data& data = model_data_array[command.index];
+			const birb::mesh& mesh = data.model->get_meshes()[command.sub_index];
+
+			if (batch.program != active_shader)
+			{
+				active_shader = batch.program;
+				active_shader->activate();
+				++render_stats.shader_switches;
+
+				// Material uniforms and texture samplers are stored per program
+				active_material = nullptr;
+				textured_mesh = nullptr;
+			}
 
 			// Apply the material component on the shader if it has any
 			// TODO: Make this work with textures too
-			bool skip_mesh_materials = false;
-			if (data.material != nullptr)
+			const birb::material* material = effective_material(data, mesh);
+			if (material != nullptr && material != active_material
+					&& (active_material == nullptr || !same_material(*material, *active_material)))
+			{
+				active_shader->apply_color_material(*material);
+				active_material = material;
+				++render_stats.material_changes;
+			}
+
+			if (!mesh.textures.empty() && (textured_mesh == nullptr || !mesh.shares_textures_with(*textured_mesh)))
+			{
+				mesh.bind_textures(*active_shader);
+				textured_mesh = &mesh;
+				render_stats.texture_binds += mesh.textures.size();
+			}
+
+			if (mesh.vao_id() != bound_vao)
 			{
-				shader->apply_color_material(*data.material);
-				skip_mesh_materials = true;
+				glBindVertexArray(mesh.vao_id());
+				bound_vao = mesh.vao_id();
+				++render_stats.vao_binds;
 			}
 
-			// Draw the model
-			ensure(data.model->vertex_count() != 0, "Tried to render a model with no vertices");
-			data.model->draw(*shader, render_stats, skip_mesh_materials);
-			++render_stats.entities_3d;
-			render_stats.vertices_3d += data.model->vertex_count();
+			// The uniform cache skips this for meshes that share the vertex format and bounds
+			mesh.apply_vertex_format(*active_shader);
+
+			if (batch.instanced)
+			{
+				// Point the instance attributes to the model matrices of this batch
+				vertex_stream.bind();
+				for (u8 i = 0; i < vec4_component_count; ++i)
+				{
+					glEnableVertexAttribArray(instance_matrix_layout + i);
+					glVertexAttribDivisor(instance_matrix_layout + i, 1);
+					glVertexAttribPointer(instance_matrix_layout + i, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+							reinterpret_cast<void*>(instance_data_offset + batch.first_instance * sizeof(glm::mat4) + i * vec4_size));
+				}
+
+				mesh.draw_elements_instanced(batch.command_count, render_stats, data.lod);
+
+				// The VAO might get used by non-instanced draws later on
+				for (u8 i = 0; i < vec4_component_count; ++i)
+					glDisableVertexAttribArray(instance_matrix_layout + i);
+
+				vertex_stream.unbind();
+			}
+			else
+			{
+				// Meshes of the same model share the model matrix, so the
+				// uniform cache will skip the update for all but the first one
+				active_shader->set(shader_uniforms::model, data.model_matrix);
+				mesh.draw_elements(render_stats, data.lod);
+			}
 		}
 
+		glBindVertexArray(0);
 		glDisable(GL_FRAMEBUFFER_SRGB);
 	}
 
+	void renderer::draw_shadow_maps()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		birb::stopwatch shadow_stopwatch;
+
+		struct shadow_draw
+		{
+			u8 cascade = 0;
+			const birb::mesh* mesh = nullptr;
+			u8 lod = 0;
+
+			// Model matrix of non-instanced draws
+			glm::mat4 model_matrix;
+
+			bool instanced = false;
+			u32 first_instance = 0;
+			u32 instance_count = 0;
+		};
+
+		std::vector<shadow_draw> draws;
+		shadow_instance_matrices.clear();
+
+		std::shared_ptr<shader> depth_shader = shader_collection::get_shader(shadow_depth_shader_ref);
+		std::shared_ptr<shader> instanced_depth_shader = shader_collection::get_instanced_shader(shadow_depth_shader_ref);
+
+		{
+			PROFILER_SCOPE_RENDER("Cull shadow casters");
+
+			// Meshes of the casters in a cascade. Sorting them by the mesh and the level
+			// of detail puts the meshes that can be instanced together next to each other
+			struct cascade_mesh
+			{
+				const birb::mesh* mesh = nullptr;
+				u8 lod = 0;
+				u32 caster = 0;
+			};
+
+			std::vector<cascade_mesh> cascade_meshes;
+
+			for (u8 i = 0; i < shadow_cascades::cascade_count; ++i)
+			{
+				const frustum& caster_frustum = cascades.get_cascade(i).caster_frustum;
+
+				cascade_meshes.clear();
+				for (u32 j = 0; j < shadow_casters.size(); ++j)
+				{
+					if (!caster_frustum.intersects(shadow_casters[j].bounds))
+						continue;
+
+					for (const birb::mesh& mesh : shadow_casters[j].model->get_meshes())
+						cascade_meshes.push_back({ &mesh, shadow_casters[j].lod, j });
+
+					++render_stats.shadow_casters;
+				}
+
+				std::sort(cascade_meshes.begin(), cascade_meshes.end(), [](const cascade_mesh& a, const cascade_mesh& b)
+				{
+					if (a.mesh != b.mesh)
+						return std::less<const birb::mesh*>{}(a.mesh, b.mesh);
+
+					return a.lod < b.lod;
+				});
+
+				for (u32 j = 0; j < cascade_meshes.size();)
+				{
+					u32 run_end = j + 1;
+					while (run_end < cascade_meshes.size() && cascade_meshes[run_end].mesh == cascade_meshes[j].mesh && cascade_meshes[run_end].lod == cascade_meshes[j].lod)
+						++run_end;
+
+					if (instancing_enabled && instanced_depth_shader != nullptr && run_end - j >= instancing_threshold)
+					{
+						draws.push_back({ i, cascade_meshes[j].mesh, cascade_meshes[j].lod, glm::mat4(1.0f), true, static_cast<u32>(shadow_instance_matrices.size()), run_end - j });
+
+						for (u32 k = j; k < run_end; ++k)
+							shadow_instance_matrices.push_back(shadow_casters[cascade_meshes[k].caster].model_matrix);
+					}
+					else
+					{
+						for (u32 k = j; k < run_end; ++k)
+							draws.push_back({ i, cascade_meshes[k].mesh, cascade_meshes[k].lod, shadow_casters[cascade_meshes[k].caster].model_matrix, false, 0, 0 });
+					}
+
+					j = run_end;
+				}
+			}
+		}
+
+		u32 instance_data_offset = 0;
+		if (!shadow_instance_matrices.empty())
+			instance_data_offset = vertex_stream.push(shadow_instance_matrices.data(), shadow_instance_matrices.size() * sizeof(glm::mat4));
+
+		// Only one FBO can be bound at a time
+		if (post_processing_enabled)
+			post_processing_fbo->unbind();
+
+		if (shadow_map_fbos[0] == nullptr)
+		{
+			for (u8 i = 0; i < shadow_cascades::cascade_count; ++i)
+				shadow_map_fbos[i] = std::make_unique<fbo>(vec2<i32>(shadow_cascades::map_resolution, shadow_cascades::map_resolution), color_format::DEPTH, light_texture_unit::shadow_maps + i);
+		}
+
+		i32 viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glViewport(0, 0, shadow_cascades::map_resolution, shadow_cascades::map_resolution);
+
+		// Slope scaled depth bias against shadow acne
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(2.0f, 4.0f);
+
+		constexpr u8 vec4_component_count = 4;
+		constexpr size_t vec4_size = sizeof(glm::vec4);
+
+		birb::shader* active_shader = nullptr;
+		u32 bound_vao = 0;
+		size_t draw_index = 0;
+
+		for (u8 i = 0; i < shadow_cascades::cascade_count; ++i)
+		{
+			const glm::mat4& light_matrix = cascades.get_cascade(i).light_matrix;
+
+			shadow_map_fbos[i]->bind();
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+			for (; draw_index < draws.size() && draws[draw_index].cascade == i; ++draw_index)
+			{
+				const shadow_draw& draw = draws[draw_index];
+
+				birb::shader* program = draw.instanced ? instanced_depth_shader.get() : depth_shader.get();
+				if (program != active_shader)
+				{
+					active_shader = program;
+					active_shader->activate();
+					++render_stats.shader_switches;
+				}
+
+				active_shader->set(shader_uniforms::lights::light_space_matrix, light_matrix);
+
+				if (draw.mesh->vao_id() != bound_vao)
+				{
+					glBindVertexArray(draw.mesh->vao_id());
+					bound_vao = draw.mesh->vao_id();
+					++render_stats.vao_binds;
+				}
+
+				draw.mesh->apply_vertex_format(*active_shader);
+
+				if (draw.instanced)
+				{
+					vertex_stream.bind();
+					for (u8 j = 0; j < vec4_component_count; ++j)
+					{
+						glEnableVertexAttribArray(instance_matrix_layout + j);
+						glVertexAttribDivisor(instance_matrix_layout + j, 1);
+						glVertexAttribPointer(instance_matrix_layout + j, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+								reinterpret_cast<void*>(instance_data_offset + draw.first_instance * sizeof(glm::mat4) + j * vec4_size));
+					}
+
+					draw.mesh->draw_elements_instanced(draw.instance_count, render_stats, draw.lod);
+
+					for (u8 j = 0; j < vec4_component_count; ++j)
+						glDisableVertexAttribArray(instance_matrix_layout + j);
+
+					vertex_stream.unbind();
+				}
+				else
+				{
+					active_shader->set(shader_uniforms::model, draw.model_matrix);
+					draw.mesh->draw_elements(render_stats, draw.lod);
+				}
+			}
+
+			shadow_map_fbos[i]->unbind();
+		}
+
+		glBindVertexArray(0);
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+		if (post_processing_enabled)
+			post_processing_fbo->bind();
+
+		// Leave the shadow maps bound to their reserved texture units for the lighting shaders
+		for (u8 i = 0; i < shadow_cascades::cascade_count; ++i)
+			shadow_map_fbos[i]->bind_frame_buffer();
+
+		glActiveTexture(GL_TEXTURE0);
+
+		render_stats.shadow_duration = shadow_stopwatch.stop(true);
+	}
+
 	void renderer::draw_box_collider_view()
 	{
 		PROFILER_SCOPE_RENDER_FN();
@@ -1,16 +1,31 @@
 #include "Line.hpp"
 #include "Logger.hpp"
 #include "Profiling.hpp"
+#include "RenderQueue.hpp"
 #include "Renderer.hpp"
 #include "ShaderCollection.hpp"
 #include "ShaderUniforms.hpp"
 #include "State.hpp"
 #include "Text.hpp"
 
+#include <cstddef>
 #include <glad/gl.h>
+#include <vector>
 
 namespace birb
 {
+	/**
+	 * @brief Build a render queue sort key for a text entity
+	 *
+	 * Screenspace text doesn't have a depth, so the entities only
+	 * get grouped by their shaders and font atlases
+	 */
+	static u64 text_sort_key(const u32 shader_id, const u32 atlas_texture_id)
+	{
+		return render_queue::key_field(shader_id, 32, 32)
+			| render_queue::key_field(atlas_texture_id, 32, 0);
+	}
+
 	void renderer::draw_screenspace_entities()
 	{
 		PROFILER_SCOPE_RENDER_FN();
@@ -30,6 +45,10 @@ namespace birb
 
 		const auto view = entity_registry.view<birb::line>();
 
+		// Gather the vertices of all of the lines so that they can be streamed at once
+		std::vector<const birb::line*> lines;
+		std::vector<f32> vertices;
+
 		for (const auto& ent : view)
 		{
 			// Skip inactive entities
@@ -38,14 +57,33 @@ namespace birb
 				continue;
 
 			const birb::line& line = view.get<birb::line>(ent);
-			line.vao->bind();
+			lines.push_back(&line);
+			vertices.insert(vertices.end(), line.vertices().begin(), line.vertices().end());
+		}
+
+		if (lines.empty())
+			return;
+
+		constexpr u8 vertex_component_count = 3;
+		constexpr u8 line_vert_count = 2;
 
-			shader->set(shader_uniforms::color, line.color);
+		const u32 offset = vertex_stream.push(vertices.data(), vertices.size() * sizeof(f32));
+
+		line_vao.bind();
+		vertex_stream.bind();
+		glVertexAttribPointer(0, vertex_component_count, GL_FLOAT, GL_FALSE, vertex_component_count * sizeof(f32), reinterpret_cast<void*>(offset));
+		vertex_stream.unbind();
+
+		for (u32 i = 0; i < lines.size(); ++i)
+		{
+			shader->set(shader_uniforms::color, lines[i]->color);
 
 			// Draw the line
-			draw_arrays(2, gl_primitive::lines);
-			line.vao->unbind();
+			glDrawArrays(GL_LINES, i * line_vert_count, line_vert_count);
+			++render_stats.draw_arrays_calls;
 		}
+
+		line_vao.unbind();
 	}
 
 	void renderer::draw_text()
@@ -56,9 +94,12 @@ namespace birb
 
 		const auto view = entity_registry.view<birb::text>();
 
-		// We'll be drawing to TEXTURE0
-		glActiveTexture(GL_TEXTURE0);
+		// Group the text entities by their shaders and fonts, so that all of the
+		// text that shares a font atlas can be drawn with a single draw call
+		std::vector<entt::entity> entities;
+		std::vector<std::shared_ptr<shader>> shaders;
 
+		text_queue.clear();
 		for (const auto& entity : view)
 		{
 			// Check if the entity should be skipped because its not active or visible
@@ -67,71 +108,78 @@ namespace birb
 
 			const birb::text& text = view.get<birb::text>(entity);
 
-			// Skip the entity if the text component doens't have any text to render
-			if (text.empty())
+			// Skip the entity if the text component doesn't have any visible characters
+			if (text.glyphs().empty())
 				continue;
 
 			// Fetch the shader
 			const std::shared_ptr<shader> shader = shader_collection::get_shader(text.shader);
 			ensure(shader->id != 0, "Tried to use an invalid shader for rendering");
 
-			shader->activate();
-			shader->set(shader_uniforms::text_color, text.color);
-			shader->set(shader_uniforms::text_position, text.position);
-
-			// The same VAO can be used for all characters
-			text_vao.bind();
-
-			const std::set<char>& chars = text.chars();
-
-			// Set the text vertex attrib pointer
-			text_vbo.bind();
-			text_vbo.set_vertex_attrib_ptr(0, 0, sizeof(f32), 4);
-
-			// Iterate through the text
-			for (const char c : chars)
-			{
-				// Update the VBO
-				constexpr u8 vert_count = 6;
-
-				const vec2<f32>& dim = text.font.char_dimensions(c).to_float();
+			text_queue.push(text_sort_key(shader->id, text.font.atlas_texture_id()), entities.size());
+			entities.push_back(entity);
+			shaders.push_back(shader);
+		}
+		text_queue.sort();
 
-				const f32 verts[vert_count][4] = {
-					{ 0,		dim.y,	0.0f, 0.0f },
-					{ 0,		0,		0.0f, 1.0f },
-					{ dim.x, 	0,		1.0f, 1.0f },
+		if (text_queue.empty())
+			return;
 
-					{ 0,		dim.y,	0.0f, 0.0f },
-					{ dim.x,	0, 		1.0f, 1.0f },
-					{ dim.x,	dim.y,	1.0f, 0.0f }
-				};
+		// We'll be drawing to TEXTURE0
+		glActiveTexture(GL_TEXTURE0);
 
-				texture::bind(text.char_texture_id(c));
+		text_vao.bind();
 
-				text_vbo.bind();
-				text_vbo.update_data(*verts, sizeof(verts));
+		const std::vector<render_queue::command>& commands = text_queue.commands();
 
-				glBindBuffer(GL_ARRAY_BUFFER, text.instance_vbo(c));
-				glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(f32), nullptr);
-				glEnableVertexAttribArray(1);
-				glVertexAttribDivisor(1, 1);
+		for (size_t i = 0; i < commands.size();)
+		{
+			const u64 batch_key = commands[i].key;
+			const std::shared_ptr<shader>& shader = shaders[commands[i].index];
+			const u32 atlas_texture_id = view.get<birb::text>(entities[commands[i].index]).font.atlas_texture_id();
 
-				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			// Collect the glyphs of all of the text entities in the batch
+			text_glyph_instances.clear();
+			for (; i < commands.size() && commands[i].key == batch_key; ++i)
+			{
+				const birb::text& text = view.get<birb::text>(entities[commands[i].index]);
+				const glm::vec3 color(text.color.r, text.color.g, text.color.b);
+
+				for (const text::glyph_quad& glyph : text.glyphs())
+				{
+					text_glyph_instances.push_back({
+						glm::vec4(glyph.position.x + text.position.x, glyph.position.y + text.position.y, glyph.size.x, glyph.size.y),
+						glm::vec4(glyph.uv_min.x, glyph.uv_min.y, glyph.uv_max.x, glyph.uv_max.y),
+						color
+					});
+				}
+
+				++render_stats.entities_screenspace;
+			}
 
+			shader->activate();
 
-				// draw_arrays(vert_count);
-				glDrawArraysInstanced(GL_TRIANGLES, 0, 6, text.char_positions(c).size());
-				++render_stats.draw_arrays_instanced;
+			texture::bind(atlas_texture_id);
+			++render_stats.texture_binds;
 
+			const u32 offset = vertex_stream.push(text_glyph_instances.data(), text_glyph_instances.size() * sizeof(text_glyph_instance));
 
-				render_stats.vertices_screenspace += vert_count * text.char_positions(c).size();
-			}
+			// Point the instance attributes to the glyphs of this batch
+			constexpr size_t stride = sizeof(text_glyph_instance);
+			vertex_stream.bind();
+			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset + offsetof(text_glyph_instance, rect)));
+			glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset + offsetof(text_glyph_instance, uv_rect)));
+			glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset + offsetof(text_glyph_instance, color)));
+			vertex_stream.unbind();
 
-			text_vao.unbind();
-			texture::unbind();
+			constexpr u8 vert_count = text_quad_corners.size() / 2;
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, vert_count, text_glyph_instances.size());
+			++render_stats.draw_arrays_instanced;
 
-			++render_stats.entities_screenspace;
+			render_stats.vertices_screenspace += vert_count * text_glyph_instances.size();
 		}
 
+		text_vao.unbind();
+		texture::unbind();
 	}
 }
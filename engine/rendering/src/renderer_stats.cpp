@@ -27,12 +27,41 @@ namespace birb
 			+ draw_elements_instanced;
 	}
 
+	u32 renderer_stats::total_state_changes() const
+	{
+		return shader_switches
+			+ material_changes
+			+ texture_binds
+			+ vao_binds;
+	}
+
 	void renderer_stats::reset_counters()
 	{
 		entities_2d = 0;
 		entities_3d = 0;
 		entities_screenspace = 0;
 
+		entities_3d_visible = 0;
+		entities_3d_culled = 0;
+		occluders_rasterized = 0;
+		entities_3d_occluded = 0;
+		lod_triangles.fill(0);
+		entities_3d_instanced = 0;
+
+		sprites_batched = 0;
+		sprite_batches = 0;
+
+		instance_matrices_uploaded = 0;
+		world_matrices_updated = 0;
+
+		point_lights = 0;
+		light_cluster_indices = 0;
+		light_cluster_max_lights = 0;
+		light_clustering_duration = 0.0f;
+
+		shadow_casters = 0;
+		shadow_duration = 0.0f;
+
 		vertices_2d = 0;
 		vertices_3d = 0;
 		vertices_screenspace = 0;
@@ -43,5 +72,10 @@ namespace birb
 		draw_elements_vao_calls = 0;
 		draw_arrays_instanced = 0;
 		draw_elements_instanced = 0;
+
+		shader_switches = 0;
+		material_changes = 0;
+		texture_binds = 0;
+		vao_binds = 0;
 	}
 }
@@ -5,15 +5,19 @@
 #include "Logger.hpp"
 #include "Material.hpp"
 #include "Profiling.hpp"
+#include "ProgramBinaryCache.hpp"
 #include "Shader.hpp"
 #include "ShaderSource.hpp"
 #include "ShaderUniforms.hpp"
+#include "ShaderVariant.hpp"
 
 #include <array>
 #include <filesystem>
 #include <glad/gl.h>
+#include <GLFW/glfw3.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
+#include <string_view>
 
 namespace birb
 {
@@ -24,6 +28,11 @@ namespace birb
 	static const std::string missing_shader_vert = "default_vert";
 	static const std::string missing_shader_frag = "missing_shader_frag";
 
+	// KHR_parallel_shader_compile isn't a part of OpenGL 3.3, so the
+	// function and the completion status enum need to be fetched manually
+	using max_shader_compiler_threads_fn = void (GLAD_API_PTR*)(GLuint count);
+	static constexpr GLenum completion_status = 0x91B1;
+
 	shader::shader()
 	{}
 
@@ -33,9 +42,6 @@ namespace birb
 		static_assert(shader_type::vertex == GL_VERTEX_SHADER);
 		static_assert(shader_type::fragment == GL_FRAGMENT_SHADER);
 
-		static_assert(point_light_count > 0);
-		static_assert(point_light_count < 8192, "Arbitrary limitation, but you are probably doing something wrong");
-
 		compile_shader(shader_name, shader_name);
 		ensure(id != 0);
 	}
@@ -47,6 +53,17 @@ namespace birb
 		ensure(id != 0);
 	}
 
+	shader::shader(const std::string& vertex, const std::string& fragment, const compile_mode mode, const u32 variant)
+	:vertex_shader_name(vertex), fragment_shader_name(fragment), variant_mask(variant)
+	{
+		begin_compile(vertex, fragment);
+
+		if (mode == compile_mode::blocking)
+			finish_compile();
+
+		ensure(id != 0);
+	}
+
 	shader::shader(shader& other)
 	{
 		// TODO: Get rid of the duplicated copy constructor code
@@ -57,6 +74,7 @@ namespace birb
 		id = 0;
 		vertex_shader_name		= other.vertex_shader_name;
 		fragment_shader_name	= other.fragment_shader_name;
+		variant_mask			= other.variant_mask;
 
 		compile_shader(other.vertex_shader_name, other.fragment_shader_name);
 
@@ -72,6 +90,7 @@ namespace birb
 		id = 0;
 		vertex_shader_name		= other.vertex_shader_name;
 		fragment_shader_name	= other.fragment_shader_name;
+		variant_mask			= other.variant_mask;
 
 		compile_shader(other.vertex_shader_name, other.fragment_shader_name);
 
@@ -85,46 +104,143 @@ namespace birb
 
 		birb::log("Shader destroyed [" + vertex_shader_name + ", " + fragment_shader_name + "] (" + birb::ptr_to_str(this) + ")");
 		glDeleteProgram(this->id);
+
+		if (active_program == id)
+			active_program = 0;
 	}
 
 	void shader::activate()
 	{
+		// Avoid redundant state changes if the program is already in use
+		if (active_program == id)
+			return;
+
 		glUseProgram(this->id);
+		active_program = id;
 
 #ifndef NDEBUG
 		d_currently_active_shader = id;
 #endif
 	}
 
-	void shader::update_directional_light()
+	bool shader::is_compiling() const
 	{
-		PROFILER_SCOPE_RENDER_FN();
+		return compiling;
+	}
+
+	bool shader::poll_compile()
+	{
+		if (!compiling)
+			return true;
+
+		if (is_parallel_compile_supported())
+		{
+			i32 completed = GL_FALSE;
+			glGetProgramiv(id, completion_status, &completed);
+
+			if (completed == GL_FALSE)
+				return false;
+		}
 
-		set(shader_uniforms::directional_light::direction, directional_light.direction);
-		set(shader_uniforms::directional_light::ambient, directional_light.ambient);
-		set(shader_uniforms::directional_light::diffuse, directional_light.diffuse);
-		set(shader_uniforms::directional_light::specular, directional_light.specular);
+		finish_compile();
+		return true;
 	}
 
-	void shader::update_point_lights()
+	bool shader::is_parallel_compile_supported()
+	{
+		static const bool supported = []() -> bool
+		{
+			max_shader_compiler_threads_fn max_shader_compiler_threads = nullptr;
+
+			i32 extension_count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+			for (i32 i = 0; i < extension_count && max_shader_compiler_threads == nullptr; ++i)
+			{
+				const std::string_view extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+
+				if (extension == "GL_KHR_parallel_shader_compile")
+					max_shader_compiler_threads = reinterpret_cast<max_shader_compiler_threads_fn>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+				else if (extension == "GL_ARB_parallel_shader_compile")
+					max_shader_compiler_threads = reinterpret_cast<max_shader_compiler_threads_fn>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+			}
+
+			if (max_shader_compiler_threads == nullptr)
+			{
+				birb::log("KHR_parallel_shader_compile is not available. Deferred shaders will be finished one at a time");
+				return false;
+			}
+
+			// Let the driver pick the amount of compiler threads
+			max_shader_compiler_threads(0xFFFFFFFF);
+
+			birb::log("Compiling shaders in parallel");
+			return true;
+		}();
+
+		return supported;
+	}
+
+	bool shader::reload()
 	{
 		PROFILER_SCOPE_RENDER_FN();
+		ensure(id != 0);
 
-		set(shader_uniforms::point_lights::count, point_light_count);
+		// The names of missing shaders have been replaced, so there's nothing to reload
+		if (_is_missing)
+			return false;
 
-		// Point lights
-		for (u16 i = 0; i < point_light_count; ++i)
+		if (compiling)
+			finish_compile();
+
+		// begin_compile() would switch to the missing shader if the sources
+		// can't be found, which isn't wanted for a running program
+		if (load_shader_src(vertex_shader_name + "_vert").empty() || load_shader_src(fragment_shader_name + "_frag").empty())
 		{
-			set(shader_uniforms::point_lights::ambient,  point_lights.at(i).ambient, i);
-			set(shader_uniforms::point_lights::diffuse,  point_lights.at(i).diffuse, i);
-			set(shader_uniforms::point_lights::specular, point_lights.at(i).specular, i);
+			birb::log_error("Could not reload shader [", vertex_shader_name, ", ", fragment_shader_name, "]. Keeping the old version");
+			return false;
+		}
 
-			set(shader_uniforms::point_lights::position, point_lights.at(i).position, i);
+		const u32 old_id = id;
+		begin_compile(vertex_shader_name, fragment_shader_name);
 
-			set(shader_uniforms::point_lights::constant, 	point_lights.at(i).attenuation_constant, i);
-			set(shader_uniforms::point_lights::linear,		point_lights.at(i).attenuation_linear, i);
-			set(shader_uniforms::point_lights::quadratic,	point_lights.at(i).attenuation_quadratic, i);
+		// Programs loaded from a program binary have already been checked
+		if (pending_vertex_shader != 0)
+		{
+			const bool success = compile_errors(pending_vertex_shader, shader_type::vertex, false)
+				&& compile_errors(pending_fragment_shader, shader_type::fragment, false)
+				&& compile_errors(id, shader_type::program, false);
+
+			if (!success)
+			{
+				birb::log_error("Could not reload shader [", vertex_shader_name, ", ", fragment_shader_name, "]. Keeping the old version");
+
+				glDeleteProgram(id);
+				id = old_id;
+				compiling = false;
+				pending_vertex_shader = 0;
+				pending_fragment_shader = 0;
+
+				// Don't let other shaders pick up the broken stages from the cache
+				forget_cached_source(vertex_shader_name + "_vert");
+				forget_cached_source(fragment_shader_name + "_frag");
+				return false;
+			}
 		}
+
+		finish_compile();
+
+		glDeleteProgram(old_id);
+		if (active_program == old_id)
+			active_program = 0;
+
+		birb::log("Reloaded shader [", vertex_shader_name, ", ", fragment_shader_name, "] (", birb::ptr_to_str(this), ")");
+		return true;
+	}
+
+	bool shader::uses_source(const std::string& source_name) const
+	{
+		return vertex_shader_name + "_vert" == source_name
+			|| fragment_shader_name + "_frag" == source_name;
 	}
 
 	bool shader::has_uniform_var(const std::string& name) const
@@ -132,10 +248,21 @@ namespace birb
 		return glGetUniformLocation(id, name.c_str()) != -1;
 	}
 
+	bool shader::has_uniform(const uniform& uniform, i32 index) const
+	{
+		return uniform_locations[uniform.slot(index)] != -1;
+	}
+
 	i32 shader::uniform_location(const std::string& name) const
 	{
+		const auto cached_location = named_uniform_locations.find(name);
+		if (cached_location != named_uniform_locations.end())
+			return cached_location->second;
+
 		const i32 location = glGetUniformLocation(id, name.c_str());
-		ensure(location != -1, "Nonexistent uniform");
+		ensure(location != -1 || is_fallback, "Nonexistent uniform");
+
+		named_uniform_locations[name] = location;
 		return location;
 	}
 
@@ -164,10 +291,14 @@ namespace birb
 
 	void shader::apply_color_material(const material& material)
 	{
-		set_diffuse_color(material.diffuse);
-		set_specular_color(material.specular);
+		// Textured variants take the colors from the material textures instead
+		if (has_uniform(shader_uniforms::material_color::diffuse))
+		{
+			set_diffuse_color(material.diffuse);
+			set_specular_color(material.specular);
+		}
+
 		set_shininess(material.shininess);
-		set(shader_uniforms::material::type, material.type);
 	}
 
 	void shader::draw_editor_ui()
@@ -179,6 +310,7 @@ namespace birb
 
 		ImGui::Text("Vertex: %s", vertex_shader_name.c_str());
 		ImGui::Text("Fragment: %s", fragment_shader_name.c_str());
+		ImGui::Text("Variant: %s", shader_variant::to_str(variant_mask).c_str());
 		ImGui::Text("Address: %s", birb::ptr_to_str(this).c_str());
 	}
 
@@ -236,13 +368,34 @@ namespace birb
 		return shader_cache_hit_count;
 	}
 
+	void shader::forget_cached_source(const std::string& source_name)
+	{
+		ensure(birb::g_opengl_initialized);
+
+		// Variants are cached with a "+<variant mask>" suffix after the source name
+		const std::string variant_prefix = source_name + "+";
+
+		for (auto it = shader_cache.begin(); it != shader_cache.end();)
+		{
+			if (it->first != source_name && !it->first.starts_with(variant_prefix))
+			{
+				++it;
+				continue;
+			}
+
+			// Programs that have the shader attached keep it alive until they are deleted
+			glDeleteShader(it->second);
+			it = shader_cache.erase(it);
+		}
+	}
+
 	std::string shader::load_shader_src(const std::string& shader_name) const
 	{
 		ensure(!shader_name.empty());
 
 		// Try to fetch the shader from builtin shaders
 		if (shader_src.contains(shader_name))
-			return shader_src.at(shader_name);
+			return shader_variant::inject_defines(shader_src.at(shader_name), variant_mask);
 
 		// Resort to loading external shaders
 		ensure(!shader_src_search_paths.empty(), "Tried to find shader source code with an empty search path array");
@@ -253,7 +406,7 @@ namespace birb
 		{
 			const std::string file_path = path + '/' + file_name;
 			if (std::filesystem::exists(file_path))
-				return io::read_file(file_path);
+				return shader_variant::inject_defines(io::read_file(file_path), variant_mask);
 		}
 
 		birb::log_error("External shader file [" + shader_name + "] could not be found");
@@ -262,6 +415,12 @@ namespace birb
 	}
 
 	void shader::compile_shader(const std::string& vertex, const std::string& fragment)
+	{
+		begin_compile(vertex, fragment);
+		finish_compile();
+	}
+
+	void shader::begin_compile(const std::string& vertex, const std::string& fragment)
 	{
 		ensure(!shader_src.empty(), "The shader source code hashmap is empty");
 		ensure(!vertex.empty(), "Empty vertex shader name string");
@@ -300,37 +459,146 @@ namespace birb
 		ensure(!vertex_src.empty());
 		ensure(!fragment_src.empty());
 
+		// Each variant needs its own shader objects in the shader cache
+		if (variant_mask != shader_variant::none && !_is_missing)
+		{
+			vertex_name += "+" + std::to_string(variant_mask);
+			fragment_name += "+" + std::to_string(variant_mask);
+		}
+
 		const char* vertex_src_c_str = vertex_src.c_str();
 		const char* fragment_src_c_str = fragment_src.c_str();
 
-		// Compile shaders
+		compiling = true;
+		pending_vertex_shader = 0;
+		pending_fragment_shader = 0;
+
+		// Skip compiling and linking if the program has been linked with the same sources and driver before
+		pending_binary_key = program_binary_cache::key(vertex_src, fragment_src, program_binary_cache::driver_string());
+		this->id = program_binary_cache::load_program(pending_binary_key);
+
+		if (id != 0)
+		{
+			birb::log("Loaded shader program binary [", vertex, ", ", fragment, "] (", birb::ptr_to_str(this), ")");
+		}
+		else
 		{
 			PROFILER_SCOPE_RENDER("Shader compiling");
 
 			birb::log("Compiling shader [", vertex, ", ", fragment, "] (", birb::ptr_to_str(this), ")");
 
-			u32 vertex_shader = compile_gl_shader_program(vertex_name, vertex_src_c_str, shader_type::vertex);
-			ensure(vertex_shader != 0);
+			pending_vertex_shader = compile_gl_shader_program(vertex_name, vertex_src_c_str, shader_type::vertex);
+			ensure(pending_vertex_shader != 0);
 
-			u32 fragment_shader = compile_gl_shader_program(fragment_name, fragment_src_c_str, shader_type::fragment);
-			ensure(fragment_shader != 0);
+			pending_fragment_shader = compile_gl_shader_program(fragment_name, fragment_src_c_str, shader_type::fragment);
+			ensure(pending_fragment_shader != 0);
 
+			// The compile and link statuses are checked in finish_compile(), since
+			// querying them would make the driver finish the work right away
 			this->id = glCreateProgram();
-			glAttachShader(this->id, vertex_shader);
-			glAttachShader(this->id, fragment_shader);
+			glAttachShader(this->id, pending_vertex_shader);
+			glAttachShader(this->id, pending_fragment_shader);
+			program_binary_cache::prepare_program(id);
 			glLinkProgram(this->id);
+		}
+	}
+
+	void shader::finish_compile()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(compiling, "Tried to finish a shader that isn't being compiled");
+		ensure(id != 0);
+
+		// Programs loaded from a program binary have already been checked
+		if (pending_vertex_shader != 0)
+		{
+			compile_errors(pending_vertex_shader, shader_type::vertex);
+			compile_errors(pending_fragment_shader, shader_type::fragment);
 			compile_errors(id, shader_type::program);
+
+			program_binary_cache::store_program(pending_binary_key, id);
 		}
 
+		compiling = false;
+		pending_vertex_shader = 0;
+		pending_fragment_shader = 0;
+
 		// Bind the shader to different uniform blocks
+		bind_uniform_block(shader_uniforms::block::view_matrices, true);
+		bind_uniform_block(shader_uniforms::block::projection_matrices, true);
+
+		// Only the shaders that do lighting use this
+		bind_uniform_block(shader_uniforms::block::light_info, false);
+
+		resolve_uniform_locations();
+	}
+
+	void shader::bind_uniform_block(const uniform_block& block, const bool required)
+	{
+		const u32 block_index = glGetUniformBlockIndex(this->id, block.block_name);
+
+		if (block_index == GL_INVALID_INDEX)
+		{
+			ensure(!required, "A required uniform block could not be found in a shader");
+			return;
+		}
+
+		glUniformBlockBinding(id, block_index, block.bind_point);
+	}
+
+	void shader::resolve_uniform_locations()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(id != 0);
+
+		for (u16 i = 0; i < uniform_table::uniform_count; ++i)
+		{
+			const uniform builtin_uniform(static_cast<uniform_id>(i));
+
+			if (builtin_uniform.is_array)
+			{
+				for (i32 j = 0; j < builtin_uniform.array_max_size; ++j)
+					uniform_locations[builtin_uniform.slot(j)] = glGetUniformLocation(id, builtin_uniform.str(j).c_str());
+			}
+			else
+			{
+				uniform_locations[builtin_uniform.slot()] = glGetUniformLocation(id, builtin_uniform.str().c_str());
+			}
+		}
 
-		const i32 uniform_block_index_view_matrices = glGetUniformBlockIndex(this->id, shader_uniforms::block::view_matrices.block_name);
-		ensure(uniform_block_index_view_matrices != -1, "The view matrix uniform block could not be found in a shader");
-		glUniformBlockBinding(id, uniform_block_index_view_matrices, shader_uniforms::block::view_matrices.bind_point);
+		uniform_value_cached.fill(false);
+		named_uniform_locations.clear();
 
-		const i32 uniform_block_index_projection_matrices = glGetUniformBlockIndex(this->id, shader_uniforms::block::projection_matrices.block_name);
-		ensure(uniform_block_index_projection_matrices != -1, "The projection matrix uniform block could not be found in a shader");
-		glUniformBlockBinding(id, uniform_block_index_projection_matrices, shader_uniforms::block::projection_matrices.bind_point);
+		// Setting the samplers requires the program to be in use. Programs can finish
+		// compiling in the middle of a frame, so whatever was in use gets restored afterwards
+		const u32 previous_program = active_program;
+		activate();
+
+		// Point the lighting buffer samplers to their reserved texture units
+		const auto set_sampler = [this](const uniform& sampler, const u8 texture_unit, const i32 index = -1)
+		{
+			if (uniform_locations[sampler.slot(index)] != -1)
+				set(sampler, static_cast<i32>(texture_unit), index);
+		};
+
+		set_sampler(shader_uniforms::lights::point_light_data, light_texture_unit::point_light_data);
+		set_sampler(shader_uniforms::lights::cluster_ranges, light_texture_unit::cluster_ranges);
+		set_sampler(shader_uniforms::lights::cluster_indices, light_texture_unit::cluster_indices);
+
+		for (u8 i = 0; i < shadow_cascade_count; ++i)
+			set_sampler(shader_uniforms::lights::shadow_map, light_texture_unit::shadow_maps + i, i);
+
+		if (previous_program != 0 && previous_program != id)
+		{
+			glUseProgram(previous_program);
+			active_program = previous_program;
+
+#ifndef NDEBUG
+			d_currently_active_shader = previous_program;
+#endif
+		}
 	}
 
 	u32 shader::compile_gl_shader_program(const std::string& shader_name, const char* shader_src, const shader_type type)
@@ -345,10 +613,10 @@ namespace birb
 			return shader_id;
 		}
 
+		// The compile status gets checked when the program that uses the shader is finished
 		shader_id = glCreateShader(type);
 		glShaderSource(shader_id, 1, &shader_src, NULL);
 		glCompileShader(shader_id);
-		compile_errors(shader_id, type);
 
 		shader_cache[shader_name] = shader_id;
 		birb::log("Shader program cached: ", shader_name, " (", shader_id, ")");
@@ -376,7 +644,7 @@ namespace birb
 		return "NULL";
 	}
 
-	void shader::compile_errors(u32 shader, const shader_type type)
+	bool shader::compile_errors(u32 shader, const shader_type type, const bool fatal)
 	{
 		constexpr i32 LOG_BUFFER_SIZE = 1024;
 
@@ -391,10 +659,14 @@ namespace birb
 			if (has_compiled == false)
 			{
 				glGetShaderInfoLog(shader, LOG_BUFFER_SIZE, NULL, info_log);
-				birb::log_fatal(3, shader_type_to_str(type) + " shader failed to compile:" + info_log);
+
+				if (fatal)
+					birb::log_fatal(3, shader_type_to_str(type) + " shader failed to compile:" + info_log);
+				else
+					birb::log_error(shader_type_to_str(type), " shader failed to compile:", info_log);
 			}
 
-			return;
+			return has_compiled;
 		}
 
 		// Handle errors for shader program linking
@@ -402,7 +674,13 @@ namespace birb
 		if (has_compiled == false)
 		{
 			glGetProgramInfoLog(shader, LOG_BUFFER_SIZE, NULL, info_log);
-			birb::log_fatal(3, "Shader program failed to link:", info_log);
+
+			if (fatal)
+				birb::log_fatal(3, "Shader program failed to link:", info_log);
+			else
+				birb::log_error("Shader program failed to link:", info_log);
 		}
+
+		return has_compiled;
 	}
 }
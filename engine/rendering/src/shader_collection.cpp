@@ -1,9 +1,11 @@
 #include "Assert.hpp"
 #include "Logger.hpp"
+#include "Profiling.hpp"
 #include "Shader.hpp"
 #include "ShaderCollection.hpp"
 #include "ShaderRef.hpp"
 #include "ShaderSource.hpp"
+#include "ShaderVariant.hpp"
 
 #include <array>
 
@@ -47,6 +49,9 @@ namespace birb
 			}
 		};
 
+		ImGui::Checkbox("Async compiling", &async_compile);
+		ImGui::Text("Shaders compiling: %d", static_cast<i32>(pending_shaders.size()));
+
 		list_shaders("Vertex shaders", vertex_shader_hashes);
 		list_shaders("Fragment shaders", fragment_shader_hashes);
 	}
@@ -58,13 +63,18 @@ namespace birb
 
 		birb::log("Precompiling shaders...");
 
-		const std::array<shader_ref, 6> precompiled_shaders = {
+		const std::array<shader_ref, 11> precompiled_shaders = {
 			shader_ref("color", "color"),
 			shader_ref("text", "text"),
 			shader_ref("texture", "texture"),
+			shader_ref("texture", "texture", shader_variant::instanced),
+			shader_ref("texture", "texture", shader_variant::batched),
 			shader_ref("post_process", "post_process"),
 			shader_ref("default", "default"),
+			shader_ref("default_instanced", "default"),
 			shader_ref("vertex_color", "vertex_color"),
+			shader_ref("shadow_depth", "shadow_depth"),
+			shader_ref("shadow_depth_instanced", "shadow_depth"),
 		};
 
 		for (const shader_ref& ref : precompiled_shaders)
@@ -112,13 +122,139 @@ namespace birb
 		ensure(!vertex_shader_hashes.empty());
 		ensure(!fragment_shader_hashes.empty());
 
-		// Compile the shader and return a reference to it
-		return compile_shader(ref);
+		if (!async_compile)
+		{
+			// Compile the shader and return a reference to it
+			return compile_shader(ref);
+		}
+
+		if (!pending_shaders.contains(ref.hash()))
+		{
+			ensure(vertex_shader_hashes.contains(ref.vertex()), "Tried to compile a non-existent vertex shader. Maybe you forgot to register it?");
+			ensure(fragment_shader_hashes.contains(ref.fragment()), "Tried to compile a non-existent fragment shader. Maybe you forgot to register it?");
+
+			std::shared_ptr<shader> new_shader = std::make_shared<shader>(
+					vertex_shader_hashes.at(ref.vertex()),
+					fragment_shader_hashes.at(ref.fragment()),
+					shader::compile_mode::deferred,
+					ref.variant());
+
+			// Programs loaded from the program binary cache are usually ready right away
+			if (shader::is_parallel_compile_supported() && new_shader->poll_compile())
+			{
+				shader_storage[ref.hash()] = new_shader;
+				return new_shader;
+			}
+
+			pending_shaders[ref.hash()] = new_shader;
+		}
+
+		return fallback_shader();
+	}
+
+	void shader_collection::poll_async_compiles()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		const bool parallel = shader::is_parallel_compile_supported();
+
+		for (auto it = pending_shaders.begin(); it != pending_shaders.end();)
+		{
+			if (!it->second->poll_compile())
+			{
+				++it;
+				continue;
+			}
+
+			shader_storage[it->first] = it->second;
+			it = pending_shaders.erase(it);
+
+			// Finishing a shader blocks without parallel compiling, so
+			// spread the work over multiple frames
+			if (!parallel)
+				break;
+		}
+	}
+
+	size_t shader_collection::pending_compile_count()
+	{
+		return pending_shaders.size();
+	}
+
+	std::shared_ptr<shader> shader_collection::fallback_shader()
+	{
+		if (fallback == nullptr)
+		{
+			fallback = std::make_shared<shader>("default", "fallback");
+			fallback->is_fallback = true;
+		}
+
+		return fallback;
+	}
+
+	std::shared_ptr<shader> shader_collection::get_instanced_shader(const shader_ref& ref)
+	{
+		ensure(ref.hash() != 0);
+
+		if (instanced_shader_storage.contains(ref.hash()))
+			return instanced_shader_storage.at(ref.hash());
+
+		hash_shader_source_names();
+
+		ensure(vertex_shader_hashes.contains(ref.vertex()), "Tried to find an instanced variant for a non-existent vertex shader");
+		ensure(fragment_shader_hashes.contains(ref.fragment()), "Tried to find an instanced variant for a non-existent fragment shader");
+
+		const std::string instanced_vertex_name = vertex_shader_hashes.at(ref.vertex()) + instanced_suffix;
+		const std::string& fragment_name = fragment_shader_hashes.at(ref.fragment());
+
+		std::shared_ptr<shader> instanced_shader = nullptr;
+
+		const shader_ref instanced_ref(instanced_vertex_name, fragment_name, ref.variant());
+		if (vertex_shader_hashes.contains(instanced_ref.vertex()))
+		{
+			instanced_shader = get_shader(instanced_ref);
+
+			// Don't remember the fallback shader in place of the real one
+			if (instanced_shader->is_fallback)
+				return instanced_shader;
+		}
+
+		instanced_shader_storage[ref.hash()] = instanced_shader;
+		return instanced_shader;
+	}
+
+	size_t shader_collection::reload_shader_source(const std::string& source_name)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+		ensure(!source_name.empty());
+
+		// The shaders that share the source would otherwise reuse the old compiled stage
+		shader::forget_cached_source(source_name);
+
+		size_t reloaded_count = 0;
+
+		const auto reload_shaders = [&source_name, &reloaded_count](const std::unordered_map<u64, std::shared_ptr<shader>>& shaders)
+		{
+			for (const auto& [hash, shader] : shaders)
+			{
+				if (shader->uses_source(source_name) && shader->reload())
+					++reloaded_count;
+			}
+		};
+
+		reload_shaders(shader_storage);
+		reload_shaders(pending_shaders);
+
+		birb::log("Reloaded ", reloaded_count, " shaders that use ", source_name);
+		return reloaded_count;
 	}
 
 	void shader_collection::wipe()
 	{
 		shader_storage.clear();
+		instanced_shader_storage.clear();
+		pending_shaders.clear();
+		fallback = nullptr;
 	}
 
 	std::shared_ptr<shader> shader_collection::compile_shader(const shader_ref& ref)
@@ -134,7 +270,7 @@ namespace birb
 		const std::string& fragment_name = fragment_shader_hashes.at(ref.fragment());
 
 		// Compile the shader and store it
-		std::shared_ptr<shader> new_shader = std::make_shared<shader>(vertex_name, fragment_name);
+		std::shared_ptr<shader> new_shader = std::make_shared<shader>(vertex_name, fragment_name, shader::compile_mode::blocking, ref.variant());
 		ensure(new_shader->id != 0, "Something went wrong with shader compiling");
 		shader_storage[ref.hash()] = new_shader;
 
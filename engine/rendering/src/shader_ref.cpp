@@ -3,6 +3,7 @@
 #include "Shader.hpp"
 #include "ShaderCollection.hpp"
 #include "ShaderRef.hpp"
+#include "ShaderVariant.hpp"
 
 namespace birb
 {
@@ -16,11 +17,18 @@ namespace birb
 		update_hashes(vertex, fragment);
 	}
 
+	shader_ref::shader_ref(const std::string& vertex, const std::string& fragment, const u32 variant)
+	:variant_mask(variant)
+	{
+		update_hashes(vertex, fragment);
+	}
+
 	void shader_ref::draw_editor_ui()
 	{
 		const std::shared_ptr<shader> shader = shader_collection::get_shader(*this);
 		shader->draw_editor_ui();
 		ImGui::Spacing();
+		ImGui::Text("Variant: %s", shader_variant::to_str(variant_mask).c_str());
 		ImGui::Text("Hash: %lu", combined_hash);
 		ImGui::SetItemTooltip("The combination of the vertex and fragment hashes");
 
@@ -48,6 +56,19 @@ namespace birb
 		return fragment_hash;
 	}
 
+	u32 shader_ref::variant() const
+	{
+		return variant_mask;
+	}
+
+	shader_ref shader_ref::with_variant(const u32 variant) const
+	{
+		shader_ref ref = *this;
+		ref.variant_mask = variant;
+		ref.combined_hash = combine_hashes(combine_hashes(vertex_hash, fragment_hash), static_cast<u64>(variant));
+		return ref;
+	}
+
 	void shader_ref::update_hashes(const std::string& vertex, const std::string& fragment)
 	{
 		ensure(!vertex.empty());
@@ -58,5 +79,8 @@ namespace birb
 
 		// Some hash combination thing found from cppreference
 		combined_hash = combine_hashes(this->vertex_hash, this->fragment_hash);
+
+		// Each variant is a separate program
+		combined_hash = combine_hashes(combined_hash, static_cast<u64>(variant_mask));
 	}
 }
@@ -24,92 +24,97 @@ namespace birb
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::INT);
 
-		const i32 key = uniform_location(uniform.str(index));
-		if (uniform_cache(key, value, uniform_cache_int))
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, value))
 			return;
 
 		activate();
-		glUniform1i(key, value);
+		glUniform1i(uniform_locations[slot], value);
 	}
 
 	void shader::set(const uniform& uniform, f32 value, i32 index)
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::FLOAT);
 
-		const i32 key = uniform_location(uniform.str(index));
-		if (uniform_cache(key, value, uniform_cache_float))
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, value))
 			return;
 
 		activate();
-		glUniform1f(key, value);
+		glUniform1f(uniform_locations[slot], value);
 	}
 
 	void shader::set(const uniform& uniform, const glm::vec2 value, i32 index)
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::VEC2);
 
-		const i32 key = uniform_location(uniform.str(index));
-		if (uniform_cache(key, value, uniform_cache_vec2))
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, value))
 			return;
 
 		activate();
-		glUniform2f(key, value.x, value.y);
+		glUniform2f(uniform_locations[slot], value.x, value.y);
 	}
 
 	void shader::set(const uniform& uniform, const glm::vec3 value, i32 index)
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::VEC3);
 
-		const i32 key = uniform_location(uniform.str(index));
-		if (uniform_cache(key, value, uniform_cache_vec3))
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, value))
 			return;
 
 		activate();
-		glUniform3f(key, value.x, value.y, value.z);
+		glUniform3f(uniform_locations[slot], value.x, value.y, value.z);
 	}
 
 	void shader::set(const uniform& uniform, const glm::vec4 value, i32 index)
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::VEC4);
 
-		const i32 key = uniform_location(uniform.str(index));
-		if (uniform_cache(key, value, uniform_cache_vec4))
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, value))
 			return;
 
 		activate();
-		glUniform4f(key, value.x, value.y, value.z, value.w);
+		glUniform4f(uniform_locations[slot], value.x, value.y, value.z, value.w);
 	}
 
 	void shader::set(const uniform& uniform, const birb::vec3<f32> value, i32 index)
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::BIRB_VEC3_FLOAT);
 
-		const i32 key = uniform_location(uniform.str(index));
-		if (uniform_cache(key, value, uniform_cache_birb_vec3_float))
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, value))
 			return;
 
 		activate();
-		glUniform3f(key, value.x, value.y, value.z);
+		glUniform3f(uniform_locations[slot], value.x, value.y, value.z);
 	}
 
 	void shader::set(const uniform& uniform, const glm::mat4 value, i32 index)
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::MAT4);
 
-		const i32 key = uniform_location(uniform.str(index));
-		if (uniform_cache(key, value, uniform_cache_mat4))
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, value))
 			return;
 
 		activate();
-		glUniformMatrix4fv(key, 1, GL_FALSE, glm::value_ptr(value));
+		glUniformMatrix4fv(uniform_locations[slot], 1, GL_FALSE, glm::value_ptr(value));
 	}
 
 	void shader::set(const uniform& uniform, const color value, i32 index)
 	{
 		UNIFORM_SET_ASSERTS(uniform_type::BIRB_COLOR);
 
+		// Only the RGB part of the color gets uploaded, so leave the alpha out of the cache
+		const u16 slot = uniform.slot(index);
+		if (uniform_cache(slot, glm::vec3(value.r, value.g, value.b)))
+			return;
+
 		activate();
-		glUniform3f(uniform_location(uniform.str(index)), value.r, value.g, value.b);
+		glUniform3f(uniform_locations[slot], value.r, value.g, value.b);
 	}
 
 	void shader::set(const std::string& uniform, const f32 value)
@@ -3,10 +3,17 @@
 
 namespace birb
 {
-	uniform::uniform(const std::string& name, uniform_type type, const std::string& struct_var, bool is_array, i32 array_max_size)
-	:name(name), type(type), is_array(is_array), array_max_size(array_max_size)
+	uniform::uniform(const uniform_id id)
+	:id(id),
+	name(get_uniform_info(id).name),
+	type(get_uniform_info(id).type),
+	is_array(get_uniform_info(id).array_size != 0),
+	array_max_size(get_uniform_info(id).array_size)
 	{
-		ensure((!is_array && array_max_size == 0) || (is_array && array_max_size != 0));
+		ensure(id != uniform_id::count);
+		ensure(!name.empty(), "The uniform is missing from get_uniform_info()");
+
+		const std::string struct_var = get_uniform_info(id).struct_var;
 
 		if (!struct_var.empty() && !is_array)
 		{
@@ -41,6 +48,14 @@ namespace birb
 		return name;
 	}
 
+	u16 uniform::slot(i32 index) const
+	{
+		ensure((!is_array && index == -1) || (is_array && index >= 0));
+		ensure(index < array_max_size || !is_array, "Tried to index things beyond the size of the uniform array");
+
+		return uniform_table::first_slot(id) + (is_array ? index : 0);
+	}
+
 	uniform_block::uniform_block(const u32 bind_point, const char* block_name, const size_t size, const gl_usage usage)
 	:bind_point(bind_point), block_name(block_name), size(size), usage(usage)
 	{}
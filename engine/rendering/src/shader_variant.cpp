@@ -0,0 +1,83 @@
+#include "Assert.hpp"
+#include "ShaderVariant.hpp"
+
+namespace birb
+{
+	namespace shader_variant
+	{
+		const char* define_name(const feature feature)
+		{
+			switch (feature)
+			{
+				case none:
+					break;
+
+				case instanced:
+					return "BIRB_INSTANCED";
+
+				case batched:
+					return "BIRB_BATCHED";
+
+				case textured:
+					return "BIRB_TEXTURED";
+			}
+
+			ensure(0, "Unhandled shader variant feature");
+			return "";
+		}
+
+		std::string define_lines(const u32 mask)
+		{
+			ensure(mask < (1u << feature_count), "Unknown shader variant feature bits");
+
+			std::string lines;
+
+			for (u8 i = 0; i < feature_count; ++i)
+			{
+				if (mask & (1u << i))
+					lines += std::string("#define ") + define_name(static_cast<feature>(1u << i)) + "\n";
+			}
+
+			return lines;
+		}
+
+		std::string inject_defines(const std::string& src, const u32 mask)
+		{
+			if (mask == none || src.empty())
+				return src;
+
+			const std::string defines = define_lines(mask);
+
+			const size_t version_pos = src.find("#version");
+			if (version_pos == std::string::npos)
+				return defines + src;
+
+			const size_t line_end = src.find('\n', version_pos);
+			if (line_end == std::string::npos)
+				return src + "\n" + defines;
+
+			return src.substr(0, line_end + 1) + defines + src.substr(line_end + 1);
+		}
+
+		std::string to_str(const u32 mask)
+		{
+			if (mask == none)
+				return "none";
+
+			std::string str;
+
+			for (u8 i = 0; i < feature_count; ++i)
+			{
+				if (!(mask & (1u << i)))
+					continue;
+
+				if (!str.empty())
+					str += ", ";
+
+				str += define_name(static_cast<feature>(1u << i));
+			}
+
+			return str;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#include "Assert.hpp"
+#include "Profiling.hpp"
+#include "ShadowCascades.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace birb
+{
+	void shadow_cascades::update(const glm::mat4& view_matrix, const f32 fov, const f32 aspect_ratio, const f32 near_clip, const f32 far_clip, const glm::vec3& light_direction)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(near_clip > 0.0f);
+		ensure(far_clip > near_clip);
+		ensure(aspect_ratio > 0.0f);
+		ensure(glm::length(light_direction) > 0.0f, "The directional light needs a direction for shadows");
+
+		const f32 shadow_far_clip = std::clamp(shadow_distance, near_clip * 2.0f, far_clip);
+		const f32 tan_half_fov = std::tan(glm::radians(fov) * 0.5f);
+		const glm::mat4 inverse_view_matrix = glm::inverse(view_matrix);
+
+		// The light view only rotates the world, so that the texel grid stays in place
+		// when the camera moves and the projection can be snapped to it
+		const glm::vec3 direction = glm::normalize(light_direction);
+		const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		const glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+		f32 near_depth = near_clip;
+
+		for (u8 i = 0; i < cascade_count; ++i)
+		{
+			cascade& current = cascades[i];
+			current.near_depth = near_depth;
+			current.far_depth = split_depth(i, near_clip, shadow_far_clip);
+			near_depth = current.far_depth;
+
+			// World space corners of the part of the camera frustum that the cascade covers
+			std::array<glm::vec3, 8> corners;
+			u8 corner_index = 0;
+			for (const f32 depth : { current.near_depth, current.far_depth })
+				for (const f32 y : { -1.0f, 1.0f })
+					for (const f32 x : { -1.0f, 1.0f })
+						corners[corner_index++] = glm::vec3(inverse_view_matrix * glm::vec4(x * depth * tan_half_fov * aspect_ratio, y * depth * tan_half_fov, -depth, 1.0f));
+
+			glm::vec3 center(0.0f);
+			for (const glm::vec3& corner : corners)
+				center += corner;
+			center /= static_cast<f32>(corners.size());
+
+			f32 radius = 0.0f;
+			for (const glm::vec3& corner : corners)
+				radius = std::max(radius, glm::length(corner - center));
+
+			// Round the radius up a bit so that floating point noise doesn't change the projection size
+			radius = std::ceil(radius * 16.0f) / 16.0f;
+
+			current.texel_size = (radius * 2.0f) / map_resolution;
+
+			// Move the projection in whole texel steps
+			glm::vec3 light_space_center = glm::vec3(light_view * glm::vec4(center, 1.0f));
+			light_space_center.x = std::floor(light_space_center.x / current.texel_size) * current.texel_size;
+			light_space_center.y = std::floor(light_space_center.y / current.texel_size) * current.texel_size;
+
+			// The light looks towards -z. Extend the near plane towards the light
+			// so that objects between the light and the cascade can cast shadows
+			const glm::mat4 light_projection = glm::ortho(
+				light_space_center.x - radius, light_space_center.x + radius,
+				light_space_center.y - radius, light_space_center.y + radius,
+				-light_space_center.z - radius - caster_distance,
+				-light_space_center.z + radius);
+
+			current.light_matrix = light_projection * light_view;
+			current.caster_frustum.update(current.light_matrix);
+		}
+	}
+
+	const shadow_cascades::cascade& shadow_cascades::get_cascade(const u8 index) const
+	{
+		ensure(index < cascade_count);
+		return cascades[index];
+	}
+
+	f32 shadow_cascades::split_depth(const u8 index, const f32 near_clip, const f32 far_clip)
+	{
+		ensure(index < cascade_count);
+
+		// Blend the logarithmic split scheme that keeps the texel density even
+		// with the uniform one that would waste fewer texels close to the camera
+		const f32 fraction = static_cast<f32>(index + 1) / cascade_count;
+		const f32 log_split = near_clip * std::pow(far_clip / near_clip, fraction);
+		const f32 uniform_split = near_clip + (far_clip - near_clip) * fraction;
+
+		return split_lambda * log_split + (1.0f - split_lambda) * uniform_split;
+	}
+}
@@ -0,0 +1,120 @@
+#include "Assert.hpp"
+#include "SkylinePacker.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace birb
+{
+	skyline_packer::skyline_packer(const vec2<i32> size)
+	:_size(size)
+	{
+		ensure(size.x > 0);
+		ensure(size.y > 0);
+
+		skyline.push_back({ 0, 0, size.x });
+	}
+
+	std::optional<vec2<i32>> skyline_packer::insert(const vec2<i32> rect_size)
+	{
+		ensure(rect_size.x >= 0);
+		ensure(rect_size.y >= 0);
+
+		if (rect_size.x == 0 || rect_size.y == 0)
+			return vec2<i32>(0, 0);
+
+		// Find the segment where the top edge of the rectangle ends up the lowest.
+		// Ties are broken by picking the narrowest segment to leave less empty space
+		size_t best_index = skyline.size();
+		i32 best_y = std::numeric_limits<i32>::max();
+		i32 best_width = std::numeric_limits<i32>::max();
+
+		for (size_t i = 0; i < skyline.size(); ++i)
+		{
+			const i32 y = fit(i, rect_size);
+			if (y < 0)
+				continue;
+
+			if (y < best_y || (y == best_y && skyline[i].width < best_width))
+			{
+				best_index = i;
+				best_y = y;
+				best_width = skyline[i].width;
+			}
+		}
+
+		if (best_index == skyline.size())
+			return std::nullopt;
+
+		const segment placed = { skyline[best_index].x, best_y + rect_size.y, rect_size.x };
+		skyline.insert(skyline.begin() + best_index, placed);
+
+		// Cut away the parts of the following segments that are now under the rectangle
+		const i32 placed_end = placed.x + placed.width;
+		for (size_t i = best_index + 1; i < skyline.size();)
+		{
+			if (skyline[i].x >= placed_end)
+				break;
+
+			const i32 overlap = placed_end - skyline[i].x;
+			skyline[i].x += overlap;
+			skyline[i].width -= overlap;
+
+			if (skyline[i].width > 0)
+				break;
+
+			skyline.erase(skyline.begin() + i);
+		}
+
+		// Merge neighbouring segments that are at the same height
+		for (size_t i = 0; i + 1 < skyline.size();)
+		{
+			if (skyline[i].y == skyline[i + 1].y)
+			{
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else
+			{
+				++i;
+			}
+		}
+
+		used_area += static_cast<i64>(rect_size.x) * rect_size.y;
+
+		return vec2<i32>(placed.x, best_y);
+	}
+
+	vec2<i32> skyline_packer::size() const
+	{
+		return _size;
+	}
+
+	f32 skyline_packer::occupancy() const
+	{
+		return static_cast<f64>(used_area) / (static_cast<f64>(_size.x) * _size.y);
+	}
+
+	i32 skyline_packer::fit(const size_t index, const vec2<i32> rect_size) const
+	{
+		if (skyline[index].x + rect_size.x > _size.x)
+			return -1;
+
+		// The rectangle rests on the highest segment that it spans over
+		i32 y = 0;
+		i32 width_left = rect_size.x;
+
+		for (size_t i = index; width_left > 0; ++i)
+		{
+			ensure(i < skyline.size());
+
+			y = std::max(y, skyline[i].y);
+			if (y + rect_size.y > _size.y)
+				return -1;
+
+			width_left -= skyline[i].width;
+		}
+
+		return y;
+	}
+}
@@ -1,6 +1,7 @@
 #include "Profiling.hpp"
 #include "Sprite.hpp"
 #include "Texture.hpp"
+#include "TextureAtlas.hpp"
 
 namespace birb
 {
@@ -12,6 +13,25 @@ namespace birb
 		texture = std::make_shared<birb::texture>(file_path.c_str(), 0, format, texture_type::TEX_2D);
 	}
 
+	sprite::sprite(const texture_atlas& atlas, const std::string& image_path)
+	:color(1.0f, 1.0f, 1.0f, 1.0f)
+	{
+		const atlas_region& region = atlas.region(image_path);
+		texture = atlas.page(region.page);
+		uv_rect = region.uv_rect;
+	}
+
+	f32 sprite::aspect_ratio() const
+	{
+		const vec2<i32> size = texture->size();
+		return ((uv_rect.z - uv_rect.x) * size.x) / ((uv_rect.w - uv_rect.y) * size.y);
+	}
+
+	f32 sprite::aspect_ratio_reverse() const
+	{
+		return 1.0f / aspect_ratio();
+	}
+
 	void sprite::draw_editor_ui()
 	{
 		// draw the ui for the sprite base class
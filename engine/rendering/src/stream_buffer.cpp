@@ -0,0 +1,266 @@
+#include "Assert.hpp"
+#include "GLSupervisor.hpp"
+#include "Globals.hpp"
+#include "Logger.hpp"
+#include "Profiling.hpp"
+#include "StreamBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+#include <string_view>
+
+namespace birb
+{
+	// GL_ARB_buffer_storage isn't a part of OpenGL 3.3, so the
+	// function and its flags need to be fetched manually
+	using buffer_storage_fn = void (GLAD_API_PTR*)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	static buffer_storage_fn gl_buffer_storage = nullptr;
+
+	static constexpr GLbitfield map_persistent_bit = 0x0040;
+	static constexpr GLbitfield map_coherent_bit = 0x0080;
+
+	stream_buffer::stream_buffer(const gl_buffer_type type, const u32 frame_capacity)
+	:type(type)
+	{
+		GL_SUPERVISOR_SCOPE();
+
+		ensure(birb::g_opengl_initialized);
+		ensure(frame_capacity > 0);
+
+		// Binding an element array buffer would modify the currently bound VAO
+		ensure(type != gl_buffer_type::element_array, "Stream index data through an array buffer instead");
+
+		persistent = buffer_storage_supported();
+		allocate(frame_capacity);
+	}
+
+	stream_buffer::~stream_buffer()
+	{
+		GL_SUPERVISOR_SCOPE();
+
+		ensure(birb::g_opengl_initialized);
+		release();
+	}
+
+	u32 stream_buffer::push(const void* data, const u32 size, const u32 alignment)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(data != nullptr);
+		ensure(size > 0);
+		ensure(alignment > 0);
+
+		u32 offset = (frame_offset + alignment - 1) / alignment * alignment;
+
+		if (offset + size > _frame_capacity)
+		{
+			// The old buffer object stays alive until the GPU is done with it
+			allocate(std::max(_frame_capacity * 2, size + alignment));
+			offset = 0;
+		}
+
+		frame_offset = offset + size;
+
+		const u32 buffer_offset = frame * _frame_capacity + offset;
+
+		if (persistent)
+		{
+			std::memcpy(mapped_memory + buffer_offset, data, size);
+		}
+		else
+		{
+			// The region hasn't been written to since the buffer was orphaned,
+			// so there's nothing to synchronize with
+			buffer->bind();
+			void* memory = glMapBufferRange(static_cast<GLenum>(type), buffer_offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			ensure(memory != nullptr, "Couldn't map the stream buffer");
+
+			std::memcpy(memory, data, size);
+			glUnmapBuffer(static_cast<GLenum>(type));
+			buffer->unbind();
+		}
+
+		return buffer_offset;
+	}
+
+	void stream_buffer::copy_to(const u32 destination_buffer, const void* data, const u32 size, const u32 destination_offset)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(destination_buffer != 0);
+
+		const u32 source_offset = push(data, size);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer->id());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, destination_buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source_offset, destination_offset, size);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	void stream_buffer::next_frame()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		// Remember when the GPU is done with the commands that read from this frame
+		if (persistent && frame_offset > 0)
+		{
+			ensure(fences[frame] == nullptr);
+			fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		frame = (frame + 1) % frame_count;
+		frame_offset = 0;
+
+		if (persistent)
+			wait_for_fence(frame);
+		else if (frame == 0)
+			orphan();
+	}
+
+	u32 stream_buffer::id() const
+	{
+		return buffer->id();
+	}
+
+	void stream_buffer::bind() const
+	{
+		buffer->bind();
+	}
+
+	void stream_buffer::unbind() const
+	{
+		buffer->unbind();
+	}
+
+	bool stream_buffer::is_persistent() const
+	{
+		return persistent;
+	}
+
+	u32 stream_buffer::frame_capacity() const
+	{
+		return _frame_capacity;
+	}
+
+	u32 stream_buffer::frame_size() const
+	{
+		return frame_offset;
+	}
+
+	void stream_buffer::allocate(const u32 frame_capacity)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		release();
+
+		_frame_capacity = frame_capacity;
+		frame_offset = 0;
+
+		const GLsizeiptr size = static_cast<GLsizeiptr>(_frame_capacity) * frame_count;
+
+		buffer = std::make_unique<gl_buffer>(type);
+		buffer->bind();
+
+		if (persistent)
+		{
+			const GLbitfield flags = GL_MAP_WRITE_BIT | map_persistent_bit | map_coherent_bit;
+			gl_buffer_storage(static_cast<GLenum>(type), size, nullptr, flags);
+
+			mapped_memory = static_cast<std::byte*>(glMapBufferRange(static_cast<GLenum>(type), 0, size, flags));
+			ensure(mapped_memory != nullptr, "Couldn't map the stream buffer persistently");
+		}
+		else
+		{
+			buffer->set_data(size, nullptr, gl_usage::dynamic_draw);
+		}
+
+		buffer->unbind();
+	}
+
+	void stream_buffer::release()
+	{
+		for (void*& fence : fences)
+		{
+			if (fence != nullptr)
+				glDeleteSync(static_cast<GLsync>(fence));
+
+			fence = nullptr;
+		}
+
+		if (buffer == nullptr)
+			return;
+
+		if (mapped_memory != nullptr)
+		{
+			buffer->bind();
+			glUnmapBuffer(static_cast<GLenum>(type));
+			buffer->unbind();
+			mapped_memory = nullptr;
+		}
+
+		buffer.reset();
+	}
+
+	void stream_buffer::orphan()
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		// The driver gives the buffer fresh storage and frees the old one
+		// once the frames that are still in flight are done with it
+		buffer->bind();
+		buffer->set_data(static_cast<intptr_t>(_frame_capacity) * frame_count, nullptr, gl_usage::dynamic_draw);
+		buffer->unbind();
+	}
+
+	void stream_buffer::wait_for_fence(const u8 region)
+	{
+		if (fences[region] == nullptr)
+			return;
+
+		PROFILER_SCOPE_RENDER("Wait for the stream buffer fence");
+
+		const GLsync fence = static_cast<GLsync>(fences[region]);
+
+		constexpr GLuint64 timeout = 1000000; // 1 ms
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout) == GL_TIMEOUT_EXPIRED)
+			continue;
+
+		glDeleteSync(fence);
+		fences[region] = nullptr;
+	}
+
+	bool stream_buffer::buffer_storage_supported()
+	{
+		static const bool supported = []() -> bool
+		{
+			i32 major_version = 0;
+			i32 minor_version = 0;
+			glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+			glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+
+			bool available = major_version > 4 || (major_version == 4 && minor_version >= 4);
+
+			i32 extension_count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+			for (i32 i = 0; i < extension_count && !available; ++i)
+				available = std::string_view(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) == "GL_ARB_buffer_storage";
+
+			if (available)
+				gl_buffer_storage = reinterpret_cast<buffer_storage_fn>(glfwGetProcAddress("glBufferStorage"));
+
+			if (gl_buffer_storage == nullptr)
+			{
+				birb::log("GL_ARB_buffer_storage is not available. Streaming buffers will be orphaned instead");
+				return false;
+			}
+
+			birb::log("Using persistently mapped streaming buffers");
+			return true;
+		}();
+
+		return supported;
+	}
+}
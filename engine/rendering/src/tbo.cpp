@@ -0,0 +1,84 @@
+#include "Assert.hpp"
+#include "GLSupervisor.hpp"
+#include "Globals.hpp"
+#include "TBO.hpp"
+
+#include <algorithm>
+#include <glad/gl.h>
+
+namespace birb
+{
+	static_assert(static_cast<int>(tbo_format::r16ui) == GL_R16UI);
+	static_assert(static_cast<int>(tbo_format::rg32ui) == GL_RG32UI);
+	static_assert(static_cast<int>(tbo_format::rgba32f) == GL_RGBA32F);
+
+	tbo::tbo(const tbo_format format)
+	:buffer(gl_buffer_type::texture), format(format)
+	{
+		GL_SUPERVISOR_SCOPE();
+
+		ensure(birb::g_opengl_initialized);
+
+		glGenTextures(1, &texture_id);
+		ensure(texture_id != 0);
+
+		allocate(nullptr, min_capacity);
+	}
+
+	tbo::~tbo()
+	{
+		GL_SUPERVISOR_SCOPE();
+
+		ensure(birb::g_opengl_initialized);
+		glDeleteTextures(1, &texture_id);
+	}
+
+	void tbo::set_data(const void* data, const size_t size)
+	{
+		GL_SUPERVISOR_SCOPE();
+
+		if (size == 0)
+			return;
+
+		ensure(data != nullptr);
+
+		if (size > _capacity)
+		{
+			allocate(data, size);
+			return;
+		}
+
+		buffer.bind();
+		buffer.update_data(size, data, 0);
+		buffer.unbind();
+	}
+
+	void tbo::bind(const u32 texture_unit) const
+	{
+		GL_SUPERVISOR_SCOPE();
+
+		glActiveTexture(GL_TEXTURE0 + texture_unit);
+		glBindTexture(GL_TEXTURE_BUFFER, texture_id);
+	}
+
+	size_t tbo::capacity() const
+	{
+		return _capacity;
+	}
+
+	void tbo::allocate(const void* data, const size_t size)
+	{
+		_capacity = std::max(size, min_capacity);
+
+		buffer.bind();
+		buffer.set_data(_capacity, nullptr, gl_usage::dynamic_draw);
+		if (data != nullptr)
+			buffer.update_data(size, data, 0);
+		buffer.unbind();
+
+		// Re-attach the buffer to the texture to make sure that it sees the new data store
+		glBindTexture(GL_TEXTURE_BUFFER, texture_id);
+		glTexBuffer(GL_TEXTURE_BUFFER, static_cast<GLenum>(format), buffer.id());
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+}
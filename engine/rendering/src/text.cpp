@@ -1,11 +1,10 @@
 #include "Assert.hpp"
 #include "Character.hpp"
-#include "GLSupervisor.hpp"
 #include "Logger.hpp"
 #include "Profiling.hpp"
 #include "Text.hpp"
 
-#include <glad/gl.h>
+#include <algorithm>
 #include <imgui.h>
 #include <string>
 
@@ -14,30 +13,9 @@ namespace birb
 	text::text(const std::string& text, const birb::font& font, const vec3<f32> position, const birb::color color, const shader_ref& shader)
 	:font(font), position(position), color(color), shader(shader)
 	{
-		allocate_instance_vbos();
 		set_text(text);
 	}
 
-	text::~text()
-	{
-		for (const std::pair<char, u32> vbo : instance_vbos)
-			glDeleteBuffers(1, &vbo.second);
-	}
-
-	text::text(const text& other)
-	:font(other.font),
-	 position(other.position),
-	 color(other.color),
-	 shader(other.shader),
-	 txt(other.txt),
-	 _chars(other._chars),
-	 _char_positions(other._char_positions),
-	 _char_texture_ids(other._char_texture_ids)
-	{
-		allocate_instance_vbos();
-		update_instance_vbos();
-	}
-
 	void text::draw_editor_ui()
 	{
 		ImGui::Text("Text: '%s'", txt.c_str());
@@ -54,16 +32,32 @@ namespace birb
 	{
 		PROFILER_SCOPE_RENDER_FN();
 
-		// Clear out any previous string data
-		clear();
+		// Text that changes every frame usually only changes at the end,
+		// so the layout of the common prefix can be kept as it is
+		const size_t unchanged_count = std::mismatch(txt.begin(), txt.end(), text.begin(), text.end()).first - txt.begin();
 
 		this->txt = text;
+		layout(unchanged_count);
+	}
+
+	void text::layout(const size_t first_char)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		ensure(first_char <= txt.size());
+		ensure(first_char < char_layouts.size());
 
-		f32 x = 0.0f;
-		f32 y = 0.0f;
+		// Throw away the layout of the changed characters
+		_glyphs.resize(char_layouts[first_char].first_glyph);
+		char_layouts.resize(first_char + 1);
 
-		for (const char c : txt)
+		f32 x = char_layouts[first_char].cursor.x;
+		f32 y = char_layouts[first_char].cursor.y;
+
+		for (size_t i = first_char; i < txt.size(); ++i)
 		{
+			const char c = txt[i];
+
 			// Process newline characters
 			if (c == '\n')
 			{
@@ -74,21 +68,27 @@ namespace birb
 				y -= font.size;
 
 				// We shouldn't draw the newline char
+				char_layouts.push_back({ glm::vec2(x, y), static_cast<u32>(_glyphs.size()) });
 				continue;
 			}
 
 			const character& ch = font.get_char(c);
 
-			// position
-			const glm::vec2 pos(
-				x + ch.bearing.x,
-				y - (ch.size.y - ch.bearing.y)
-			);
+			// Characters without a bitmap only move the cursor
+			if (ch.size.x != 0 && ch.size.y != 0)
+			{
+				glyph_quad quad;
 
-			_chars.insert(c);
-			_char_positions[c].push_back(pos);
-			_char_texture_ids[c] = ch.texture_id;
+				quad.position = glm::vec2(
+					x + ch.bearing.x,
+					y - (static_cast<f32>(ch.size.y) - ch.bearing.y)
+				);
+				quad.size = glm::vec2(ch.size.x, ch.size.y);
+				quad.uv_min = glm::vec2(ch.uv_min.x, ch.uv_min.y);
+				quad.uv_max = glm::vec2(ch.uv_max.x, ch.uv_max.y);
 
+				_glyphs.push_back(quad);
+			}
 
 			// Move to the next char. One advance is 1/64 of a pixel
 			// the bitshifting thing gets the value in pixels (2^6 = 64)
@@ -96,15 +96,12 @@ namespace birb
 			// this page where most of this code portion is
 			// adapted from: https://learnopengl.com/In-Practice/Text-Rendering
 			x += (ch.advance >> 6);
-		}
-
-		ensure(!_chars.empty(), "This code path shouldn't be reached with an empty string");
-		ensure(_char_positions.size() <= txt.size());
 
-		// Update instance vbos
-		update_instance_vbos();
+			char_layouts.push_back({ glm::vec2(x, y), static_cast<u32>(_glyphs.size()) });
+		}
 
-		ensure(_chars.size() == _char_texture_ids.size());
+		ensure(char_layouts.size() == txt.size() + 1);
+		ensure(_glyphs.size() <= txt.size());
 	}
 
 	std::string text::get_text() const
@@ -115,9 +112,8 @@ namespace birb
 	void text::clear()
 	{
 		txt.clear();
-		_chars.clear();
-		_char_positions.clear();
-		_char_texture_ids.clear();
+		_glyphs.clear();
+		char_layouts.resize(1);
 	}
 
 	bool text::empty() const
@@ -125,61 +121,8 @@ namespace birb
 		return txt.empty();
 	}
 
-	std::set<char> text::chars() const
-	{
-		return _chars;
-	}
-
-	std::vector<glm::vec2> text::char_positions(const char c) const
-	{
-		ensure(_char_positions.contains(c));
-		return _char_positions.at(c);
-	}
-
-	u32 text::char_texture_id(const char c) const
-	{
-		ensure(_char_texture_ids.contains(c));
-		return _char_texture_ids.at(c);
-	}
-
-	u32 text::instance_vbo(const char c) const
-	{
-		ensure(instance_vbos.contains(c));
-		return instance_vbos.at(c);
-	}
-
-	void text::allocate_instance_vbos()
-	{
-		PROFILER_SCOPE_RENDER_FN();
-
-		ensure(instance_vbos.empty());
-		ensure(instance_vbo_ids.empty());
-
-		constexpr u8 max_char_count = 128;
-		instance_vbo_ids.resize(max_char_count);
-		glGenBuffers(max_char_count, instance_vbo_ids.data());
-	}
-
-	void text::update_instance_vbos()
+	std::span<const text::glyph_quad> text::glyphs() const
 	{
-		PROFILER_SCOPE_RENDER_FN();
-
-		ensure(!instance_vbo_ids.empty());
-
-		u32 index = 0;
-		for (const char c : _chars)
-		{
-			const u32 vbo = instance_vbo_ids.at(index++);
-
-			instance_vbos[c] = vbo;
-
-			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(GL_ARRAY_BUFFER,
-					sizeof(glm::vec2) * _char_positions.at(c).size(),
-					_char_positions.at(c).data(),
-					GL_STATIC_DRAW);
-		}
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return _glyphs;
 	}
 }
@@ -44,14 +44,19 @@ namespace birb
 		else
 			glTexImage2D(GL_TEXTURE_2D, 0, static_cast<i32>(format), dimensions.x, dimensions.y, 0, static_cast<i32>(format), GL_UNSIGNED_INT, NULL);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// Depth maps get compared against depth values, so interpolating between texels makes no sense
+		const i32 filter = format == color_format::DEPTH ? GL_NEAREST : GL_LINEAR;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
 
-		// Enable texture wrapping for depth maps
+		// Everything outside of a depth map is at the maximum depth, so
+		// lookups outside of a shadow map don't end up in shadow
 		if (format == color_format::DEPTH)
 		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			constexpr f32 border_color[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
 		}
 	}
 
@@ -59,16 +64,20 @@ namespace birb
 	{
 		PROFILER_SCOPE_IO("Texture loading");
 
-		ensure(id == 0, "Memory leak");
+		const birb::asset::image image(image_path, true);
+		load(image, image_path, slot, format, type);
+	}
 
-		this->slot = slot;
+	void texture::load(const asset::image& image, const std::string& image_path, const u32 slot, const color_format format, const texture_type type)
+	{
+		PROFILER_SCOPE_RENDER_FN();
 
-		birb::asset::image texture(image_path, true);
-		this->dimensions = texture.dimensions;
+		ensure(id == 0, "Memory leak");
 
-		// Calculate the aspect ratio from the texture size
-		_aspect_ratio = static_cast<f32>(dimensions.x) / static_cast<f32>(dimensions.y);
-		_aspect_ratio_reverse = static_cast<f32>(dimensions.y) / static_cast<f32>(dimensions.x);
+		this->type = type;
+		this->slot = slot;
+		this->format = format;
+		this->image_path = image_path;
 
 		// Convert the texture type to a GLenum
 		GLenum tex_type = static_cast<GLenum>(type);
@@ -80,14 +89,80 @@ namespace birb
 		glTexParameteri(tex_type, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(tex_type, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-		glTexImage2D(tex_type, 0, static_cast<i32>(format), texture.dimensions.x, texture.dimensions.y, 0, static_cast<i32>(format), GL_UNSIGNED_BYTE, texture.data);
-		glGenerateMipmap(tex_type);
+		upload_image(image);
 
 		glBindTexture(tex_type, 0);
 
 		birb::log("Texture loaded [", image_path, "] (", ptr_to_str(this), ")");
 	}
 
+	void texture::reload()
+	{
+		PROFILER_SCOPE_IO("Texture reloading");
+
+		ensure(id != 0, "Texture needs to be initialized at this point");
+		ensure(!image_path.empty(), "Only textures loaded from image files can be reloaded");
+
+		const birb::asset::image image(image_path.c_str(), true);
+
+		const GLenum tex_type = static_cast<GLenum>(type);
+
+		glActiveTexture(GL_TEXTURE0 + slot);
+		glBindTexture(tex_type, id);
+
+		upload_image(image);
+
+		glBindTexture(tex_type, 0);
+
+		birb::log("Texture reloaded [", image_path, "] (", ptr_to_str(this), ")");
+	}
+
+	void texture::upload_image(const asset::image& image)
+	{
+		this->dimensions = image.dimensions;
+
+		// Calculate the aspect ratio from the texture size
+		_aspect_ratio = static_cast<f32>(dimensions.x) / static_cast<f32>(dimensions.y);
+		_aspect_ratio_reverse = static_cast<f32>(dimensions.y) / static_cast<f32>(dimensions.x);
+
+		const GLenum tex_type = static_cast<GLenum>(type);
+
+		glTexImage2D(tex_type, 0, static_cast<i32>(format), image.dimensions.x, image.dimensions.y, 0, static_cast<i32>(format), GL_UNSIGNED_BYTE, image.data);
+		glGenerateMipmap(tex_type);
+	}
+
+	void texture::load(const u8* pixels, const vec2<i32> dimensions, const color_format format, const i32 max_mipmap_level)
+	{
+		ensure(id == 0, "Memory leak");
+		ensure(pixels != nullptr);
+		ensure(dimensions.x > 0);
+		ensure(dimensions.y > 0);
+		ensure(max_mipmap_level >= 0);
+
+		this->dimensions = dimensions;
+		this->slot = 0;
+		this->type = texture_type::TEX_2D;
+
+		_aspect_ratio = static_cast<f32>(dimensions.x) / static_cast<f32>(dimensions.y);
+		_aspect_ratio_reverse = static_cast<f32>(dimensions.y) / static_cast<f32>(dimensions.x);
+
+		glGenTextures(1, &id);
+		ensure(id != 0);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, id);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_mipmap_level);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, static_cast<i32>(format), dimensions.x, dimensions.y, 0, static_cast<i32>(format), GL_UNSIGNED_BYTE, pixels);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
 	texture::~texture()
 	{
 		ensure(id != 0, "Attempted to destruct a texture that wasn't initialized");
@@ -135,7 +210,12 @@ namespace birb
 		ensure(!path.empty());
 
 		// Load the image data
-		asset::image image(path.c_str(), true);
+		const asset::image image(path.c_str(), true);
+		return texture_from_image(image);
+	}
+
+	u32 texture::texture_from_image(const asset::image& image)
+	{
 		ensure(image.data != nullptr);
 		ensure(image.dimensions.x != 0);
 		ensure(image.dimensions.y != 0);
@@ -173,4 +253,9 @@ namespace birb
 	{
 		return _aspect_ratio_reverse;
 	}
+
+	const std::string& texture::path() const
+	{
+		return image_path;
+	}
 }
@@ -0,0 +1,358 @@
+#include "Assert.hpp"
+#include "Image.hpp"
+#include "Logger.hpp"
+#include "Math.hpp"
+#include "Profiling.hpp"
+#include "SkylinePacker.hpp"
+#include "Texture.hpp"
+#include "TextureAtlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <optional>
+
+namespace birb
+{
+	static constexpr char cache_magic[4] = { 'B', 'A', 'T', 'L' };
+	static constexpr u32 cache_version = 1;
+
+	template<typename T>
+	static void write_value(std::ofstream& file, const T& value)
+	{
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	static bool read_value(std::ifstream& file, T& value)
+	{
+		file.read(reinterpret_cast<char*>(&value), sizeof(T));
+		return file.good();
+	}
+
+	/**
+	 * @brief Copy an image into an RGBA page and extend its edge pixels into the gutter
+	 */
+	static void blit_image(const asset::image& image, const atlas_region& region, const i32 gutter, const i32 page_size, std::vector<u8>& page_pixels)
+	{
+		const i32 width = image.dimensions.x;
+		const i32 height = image.dimensions.y;
+		const i32 channels = image.color_channels;
+
+		for (i32 y = -gutter; y < height + gutter; ++y)
+		{
+			const i32 source_y = std::clamp(y, 0, height - 1);
+
+			for (i32 x = -gutter; x < width + gutter; ++x)
+			{
+				const i32 source_x = std::clamp(x, 0, width - 1);
+
+				const u8* source = image.data + (static_cast<size_t>(source_y) * width + source_x) * channels;
+				u8* destination = page_pixels.data() + (static_cast<size_t>(region.position.y + y) * page_size + region.position.x + x) * 4;
+
+				switch (channels)
+				{
+					// Grayscale
+					case 1:
+						destination[0] = destination[1] = destination[2] = source[0];
+						destination[3] = 255;
+						break;
+
+					// Grayscale with alpha
+					case 2:
+						destination[0] = destination[1] = destination[2] = source[0];
+						destination[3] = source[1];
+						break;
+
+					case 3:
+						std::copy_n(source, 3, destination);
+						destination[3] = 255;
+						break;
+
+					default:
+						std::copy_n(source, 4, destination);
+						break;
+				}
+			}
+		}
+	}
+
+	texture_atlas::texture_atlas(const std::vector<std::string>& image_paths, const std::string& cache_path, const i32 page_size, const i32 gutter)
+	:page_size(page_size), gutter(gutter)
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		ensure(!image_paths.empty(), "Can't create an empty texture atlas");
+		ensure(page_size > 0);
+		ensure(gutter >= 0);
+
+		std::vector<atlas_region> packed_regions;
+		std::vector<std::vector<u8>> page_pixels;
+
+		const u64 key = cache_path.empty() ? 0 : cache_key(image_paths);
+
+		if (!cache_path.empty() && read_cache(cache_path, key, image_paths, packed_regions, page_pixels))
+		{
+			_is_cached = true;
+			birb::log("Texture atlas loaded from cache [", cache_path, "]");
+		}
+		else
+		{
+			// Load all of the images first, since their sizes are needed for packing
+			std::vector<asset::image> images;
+			images.reserve(image_paths.size());
+
+			std::vector<vec2<i32>> sizes;
+			sizes.reserve(image_paths.size());
+
+			for (const std::string& path : image_paths)
+			{
+				images.emplace_back(path.c_str(), true);
+				ensure(images.back().data != nullptr, "Couldn't load an image for the texture atlas");
+				ensure(images.back().color_channels >= 1 && images.back().color_channels <= 4);
+				sizes.push_back(images.back().dimensions);
+			}
+
+			packed_regions = pack(sizes, page_size, gutter);
+
+			const u16 page_count = std::accumulate(packed_regions.begin(), packed_regions.end(), 0,
+					[](const i32 count, const atlas_region& region) { return std::max(count, region.page + 1); });
+
+			page_pixels.resize(page_count, std::vector<u8>(static_cast<size_t>(page_size) * page_size * channel_count, 0));
+
+			for (size_t i = 0; i < images.size(); ++i)
+				blit_image(images[i], packed_regions[i], gutter, page_size, page_pixels[packed_regions[i].page]);
+
+			birb::log("Packed ", image_paths.size(), " images into ", page_count, " texture atlas pages");
+
+			if (!cache_path.empty())
+				write_cache(cache_path, key, image_paths, packed_regions, page_pixels);
+		}
+
+		for (size_t i = 0; i < image_paths.size(); ++i)
+			regions[image_paths[i]] = packed_regions[i];
+
+		upload_pages(page_pixels);
+	}
+
+	bool texture_atlas::contains(const std::string& image_path) const
+	{
+		return regions.contains(image_path);
+	}
+
+	const atlas_region& texture_atlas::region(const std::string& image_path) const
+	{
+		ensure(regions.contains(image_path), "The image is not in the texture atlas");
+		return regions.at(image_path);
+	}
+
+	std::shared_ptr<birb::texture> texture_atlas::page(const u16 index) const
+	{
+		ensure(index < pages.size());
+		return pages[index];
+	}
+
+	u16 texture_atlas::page_count() const
+	{
+		return pages.size();
+	}
+
+	bool texture_atlas::is_cached() const
+	{
+		return _is_cached;
+	}
+
+	std::vector<atlas_region> texture_atlas::pack(const std::vector<vec2<i32>>& sizes, const i32 page_size, const i32 gutter)
+	{
+		PROFILER_SCOPE_MISC_FN();
+
+		ensure(page_size > 0);
+		ensure(gutter >= 0);
+
+		// Taller rectangles first leaves less empty space under the skyline
+		std::vector<size_t> order(sizes.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sizes](const size_t a, const size_t b)
+		{
+			if (sizes[a].y != sizes[b].y)
+				return sizes[a].y > sizes[b].y;
+
+			return sizes[a].x > sizes[b].x;
+		});
+
+		std::vector<skyline_packer> packers;
+		std::vector<atlas_region> packed_regions(sizes.size());
+
+		const f32 page_size_reverse = 1.0f / page_size;
+
+		for (const size_t index : order)
+		{
+			const vec2<i32> size = sizes[index];
+			const vec2<i32> padded_size(size.x + gutter * 2, size.y + gutter * 2);
+
+			ensure(size.x > 0 && size.y > 0, "Empty images can't be packed");
+			ensure(padded_size.x <= page_size && padded_size.y <= page_size, "The image is too large for the texture atlas");
+
+			// Try the existing pages in order and start a new page if none of them have space
+			std::optional<vec2<i32>> position;
+			size_t page = 0;
+			for (; page < packers.size() && !position; ++page)
+				position = packers[page].insert(padded_size);
+
+			if (position)
+			{
+				--page;
+			}
+			else
+			{
+				packers.emplace_back(vec2<i32>(page_size, page_size));
+				position = packers.back().insert(padded_size);
+				ensure(position.has_value());
+			}
+
+			atlas_region& region = packed_regions[index];
+			region.page = page;
+			region.position = vec2<i32>(position->x + gutter, position->y + gutter);
+			region.size = size;
+			region.uv_rect = glm::vec4(
+				region.position.x * page_size_reverse,
+				region.position.y * page_size_reverse,
+				(region.position.x + size.x) * page_size_reverse,
+				(region.position.y + size.y) * page_size_reverse);
+		}
+
+		return packed_regions;
+	}
+
+	u64 texture_atlas::cache_key(const std::vector<std::string>& image_paths) const
+	{
+		u64 key = combine_hashes<u64>(page_size, gutter);
+		key = combine_hashes<u64>(key, cache_version);
+
+		for (const std::string& path : image_paths)
+		{
+			std::error_code error;
+			const u64 file_size = std::filesystem::file_size(path, error);
+			const u64 write_time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+			key = combine_hashes<u64>(key, std::hash<std::string>{}(path));
+			key = combine_hashes<u64>(key, file_size);
+			key = combine_hashes<u64>(key, write_time);
+		}
+
+		return key;
+	}
+
+	bool texture_atlas::read_cache(const std::string& path, const u64 key, const std::vector<std::string>& image_paths, std::vector<atlas_region>& packed_regions, std::vector<std::vector<u8>>& page_pixels) const
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		char magic[sizeof(cache_magic)];
+		u32 version = 0;
+		u64 cached_key = 0;
+		i32 cached_page_size = 0;
+		i32 cached_gutter = 0;
+		u32 region_count = 0;
+		u16 page_count = 0;
+
+		file.read(magic, sizeof(magic));
+		if (!file.good() || !std::equal(magic, magic + sizeof(magic), cache_magic))
+			return false;
+
+		if (!read_value(file, version) || version != cache_version
+				|| !read_value(file, cached_key) || cached_key != key
+				|| !read_value(file, cached_page_size) || cached_page_size != page_size
+				|| !read_value(file, cached_gutter) || cached_gutter != gutter
+				|| !read_value(file, region_count) || region_count != image_paths.size()
+				|| !read_value(file, page_count))
+			return false;
+
+		packed_regions.resize(region_count);
+
+		for (u32 i = 0; i < region_count; ++i)
+		{
+			u32 path_length = 0;
+			if (!read_value(file, path_length) || path_length != image_paths[i].size())
+				return false;
+
+			std::string image_path(path_length, '\0');
+			file.read(image_path.data(), path_length);
+			if (image_path != image_paths[i])
+				return false;
+
+			atlas_region& region = packed_regions[i];
+			if (!read_value(file, region.page) || region.page >= page_count
+					|| !read_value(file, region.position)
+					|| !read_value(file, region.size)
+					|| !read_value(file, region.uv_rect))
+				return false;
+		}
+
+		page_pixels.resize(page_count, std::vector<u8>(static_cast<size_t>(page_size) * page_size * channel_count));
+		for (std::vector<u8>& pixels : page_pixels)
+		{
+			file.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+			if (!file.good())
+				return false;
+		}
+
+		return true;
+	}
+
+	void texture_atlas::write_cache(const std::string& path, const u64 key, const std::vector<std::string>& image_paths, const std::vector<atlas_region>& packed_regions, const std::vector<std::vector<u8>>& page_pixels) const
+	{
+		PROFILER_SCOPE_IO_FN();
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			birb::log_warn("Can't write the texture atlas cache to ", path);
+			return;
+		}
+
+		file.write(cache_magic, sizeof(cache_magic));
+		write_value(file, cache_version);
+		write_value(file, key);
+		write_value(file, page_size);
+		write_value(file, gutter);
+		write_value(file, static_cast<u32>(packed_regions.size()));
+		write_value(file, static_cast<u16>(page_pixels.size()));
+
+		for (size_t i = 0; i < packed_regions.size(); ++i)
+		{
+			write_value(file, static_cast<u32>(image_paths[i].size()));
+			file.write(image_paths[i].data(), image_paths[i].size());
+
+			write_value(file, packed_regions[i].page);
+			write_value(file, packed_regions[i].position);
+			write_value(file, packed_regions[i].size);
+			write_value(file, packed_regions[i].uv_rect);
+		}
+
+		for (const std::vector<u8>& pixels : page_pixels)
+			file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+	}
+
+	void texture_atlas::upload_pages(const std::vector<std::vector<u8>>& page_pixels)
+	{
+		PROFILER_SCOPE_RENDER_FN();
+
+		// Each mipmap level halves the gutter. Stop before it disappears
+		// so that the lower levels don't mix the images together
+		const i32 max_mipmap_level = gutter > 0 ? static_cast<i32>(std::log2(gutter)) : 0;
+
+		for (const std::vector<u8>& pixels : page_pixels)
+		{
+			std::shared_ptr<birb::texture> page = std::make_shared<birb::texture>();
+			page->load(pixels.data(), vec2<i32>(page_size, page_size), color_format::RGBA, max_mipmap_level);
+			pages.push_back(page);
+		}
+	}
+}
@@ -18,7 +18,7 @@ namespace birb
 		f32 shininess;
 
 		// 0 = color
-		// 1 = texture
+		// 1 = texture (drawn with the shader_variant::textured variant of the shader)
 		u8 type;
 
 		template<class Archive>
@@ -9,6 +9,11 @@ namespace birb
 	class raycast_target : public editor_component
 	{
 	public:
+		/**
+		 * @brief Center of the target sphere
+		 *
+		 * Relative to the world transform of the entity if it has a transform component
+		 */
 		vec3<f32> position;
 		f32 radius;
 
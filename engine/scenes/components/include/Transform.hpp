@@ -4,6 +4,7 @@
 #include "Vector.hpp"
 
 #include <glm/glm.hpp>
+#include <span>
 
 namespace birb
 {
@@ -45,6 +46,11 @@ namespace birb
 		 */
 		void lock();
 
+		/**
+		 * @brief Lock the model matrix to a value that was calculated with compose_model_matrices()
+		 */
+		void lock(const glm::mat4& model_matrix);
+
 		/**
 		 * @brief Enable model_matrix updates
 		 */
@@ -52,6 +58,21 @@ namespace birb
 
 		bool is_locked() const;
 
+		/**
+		 * @brief Calculate the model matrices of multiple transforms
+		 *
+		 * The components are read from separate contiguous arrays and processed
+		 * in batches of eight (AVX2) or four (SSE2) transforms on x86_64, with a
+		 * scalar fallback for the rest. Produces the same matrices as model_matrix()
+		 * does for each transform, within floating point accuracy
+		 *
+		 * @param positions Positions of the transforms
+		 * @param rotations Euler angles of the transforms in degrees
+		 * @param scales Local scales of the transforms
+		 * @param model_matrices Output for the model matrices. Needs to be as large as the inputs
+		 */
+		static void compose_model_matrices(std::span<const glm::vec3> positions, std::span<const glm::vec3> rotations, std::span<const glm::vec3> scales, std::span<glm::mat4> model_matrices);
+
 		template<class Archive>
 		void serialize(Archive& ar)
 		{
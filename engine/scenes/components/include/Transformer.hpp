@@ -3,6 +3,7 @@
 #include "Types.hpp"
 
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 
 namespace birb
@@ -12,6 +13,25 @@ namespace birb
 	class transformer
 	{
 	public:
+		/**
+		 * @brief Range of consecutive transforms
+		 */
+		struct index_range
+		{
+			size_t first;
+			size_t count;
+
+			size_t end() const { return first + count; }
+			bool operator==(const index_range& other) const = default;
+		};
+
+		// Ranges that are closer to each other than this many transforms are uploaded
+		// together. Copying a few extra matrices is cheaper than an extra copy command
+		static constexpr size_t dirty_range_merge_gap = 8;
+
+		// Amount of transforms that a single thread locks at a time
+		static constexpr size_t lock_chunk_size = 256;
+
 		transformer() = default;
 		~transformer();
 		transformer(const transformer&) = default;
@@ -25,6 +45,8 @@ namespace birb
 
 		/**
 		 * @brief Lock the transforms and cache the model matrices
+		 *
+		 * The model matrices are calculated in parallel
 		 */
 		void lock();
 
@@ -35,6 +57,8 @@ namespace birb
 
 		/**
 		 * @brief Unlock and lock the transforms to re-calculate the model matrices
+		 *
+		 * The instance VBO is kept if the amount of transforms hasn't changed
 		 */
 		void relock();
 
@@ -43,25 +67,73 @@ namespace birb
 		 */
 		void update_transform(const size_t index);
 
+		/**
+		 * @brief Update the model matrices of multiple transforms in parallel
+		 *
+		 * @param indices Indices of the transforms to update. Duplicates are allowed
+		 */
+		void update_transforms(std::span<const size_t> indices);
+
+		/**
+		 * @brief Update the model matrices of a range of transforms in parallel
+		 */
+		void update_transforms(const index_range range);
+
 		/**
 		 * @brief Update the instance VBO
 		 *
-		 * Call this function if you have modified transforms with update_transform()
+		 * Call this function if you have modified transforms with update_transform().
+		 * Only the model matrices that were updated since the previous call are
+		 * streamed into the VBO by the renderer before the transformer gets drawn,
+		 * so calling this multiple times per frame is cheap
 		 */
 		void update_vbo_data();
 
+		/**
+		 * @brief Check if the instance VBO is waiting for new model matrices
+		 */
+		bool has_pending_vbo_data() const;
+
+		/**
+		 * @brief Sorted and non-overlapping ranges of model matrices that need to be uploaded into the instance VBO
+		 */
+		std::span<const index_range> pending_vbo_ranges() const;
+
+		/**
+		 * @brief Model matrices that were cached when the transformer was locked
+		 */
+		const std::vector<glm::mat4>& locked_model_matrices() const;
+
+		/**
+		 * @brief Mark the pending model matrices as uploaded into the instance VBO
+		 */
+		void mark_vbo_data_uploaded();
+
 		bool is_locked() const;
 
+		/**
+		 * @brief Sort the ranges and merge the ones that overlap or are at most max_gap apart
+		 */
+		static void coalesce_ranges(std::vector<index_range>& ranges, const size_t max_gap);
+
 	private:
 		std::vector<glm::mat4> cached_model_matrices;
 		bool _is_locked = false;
 
-		bool d_singular_transform_updated = false;
+		// Ranges updated after the previous update_vbo_data() call
+		std::vector<index_range> dirty_ranges;
+
+		// Coalesced ranges waiting for the renderer to upload them
+		std::vector<index_range> vbo_ranges;
 
 		u32 model_matrix_vbo = 0;
 
-		std::vector<glm::mat4> model_matrices() const;
+		/**
+		 * @brief Calculate and lock the model matrices of a range of transforms in parallel
+		 */
+		void compute_model_matrices(const index_range range);
 		void update_model_matrix_vbo();
 		void free_the_vbo_buffer();
+		void mark_dirty(const index_range range);
 	};
 }
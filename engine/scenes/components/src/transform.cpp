@@ -1,6 +1,7 @@
 #include "Transform.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
 
@@ -73,6 +74,12 @@ namespace birb
 		_is_locked = true;
 	}
 
+	void transform::lock(const glm::mat4& model_matrix)
+	{
+		cached_model_matrix = model_matrix;
+		_is_locked = true;
+	}
+
 	void transform::unlock()
 	{
 		_is_locked = false;
@@ -0,0 +1,360 @@
+#include "Assert.hpp"
+#include "Transform.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BIRB_TRANSFORM_KERNEL_SIMD
+#include <immintrin.h>
+#endif
+
+// Batched model matrix composition
+//
+// The transforms are processed eight at a time with AVX2 if the CPU supports it,
+// then four at a time with SSE2 (always available on x86_64) and the rest one by
+// one with glm. The SIMD paths transpose the position, rotation and scale streams
+// into per-component lanes, compute the quaternions with a polynomial sincos and
+// transpose the resulting columns back into the matrices
+
+namespace birb
+{
+	static_assert(sizeof(glm::vec3) == 3 * sizeof(f32), "The kernel expects tightly packed vec3 streams");
+	static_assert(sizeof(glm::mat4) == 16 * sizeof(f32), "The kernel expects tightly packed matrices");
+
+	static void compose_scalar(const glm::vec3* positions, const glm::vec3* rotations, const glm::vec3* scales, glm::mat4* model_matrices, const size_t count)
+	{
+		// translate * rotate * scale written out column by column. The translation
+		// and scaling don't need full matrix multiplications
+		for (size_t i = 0; i < count; ++i)
+		{
+			const glm::mat3 rotation_matrix = glm::mat3_cast(glm::quat(glm::radians(rotations[i])));
+
+			model_matrices[i][0] = glm::vec4(rotation_matrix[0] * scales[i].x, 0.0f);
+			model_matrices[i][1] = glm::vec4(rotation_matrix[1] * scales[i].y, 0.0f);
+			model_matrices[i][2] = glm::vec4(rotation_matrix[2] * scales[i].z, 0.0f);
+			model_matrices[i][3] = glm::vec4(positions[i], 1.0f);
+		}
+	}
+
+#ifdef BIRB_TRANSFORM_KERNEL_SIMD
+	// Converts degrees into half angles in radians for the quaternion
+	static constexpr f32 degrees_to_half_radians = 3.14159265358979f / 360.0f;
+
+	// Cephes single precision sine and cosine constants
+	static constexpr f32 four_over_pi = 1.27323954473516f;
+	static constexpr f32 pi_over_four_part_1 = 0.78515625f;
+	static constexpr f32 pi_over_four_part_2 = 2.4187564849853515625e-4f;
+	static constexpr f32 pi_over_four_part_3 = 3.77489497744594108e-8f;
+	static constexpr f32 sin_coefficient_0 = -1.9515295891e-4f;
+	static constexpr f32 sin_coefficient_1 = 8.3321608736e-3f;
+	static constexpr f32 sin_coefficient_2 = -1.6666654611e-1f;
+	static constexpr f32 cos_coefficient_0 = 2.443315711809948e-5f;
+	static constexpr f32 cos_coefficient_1 = -1.388731625493765e-3f;
+	static constexpr f32 cos_coefficient_2 = 4.166664568298827e-2f;
+
+	/**
+	 * @brief Load four vec3s and transpose them into x, y and z lanes
+	 */
+	static inline void load_vec3x4(const f32* data, __m128& x, __m128& y, __m128& z)
+	{
+		const __m128 a = _mm_loadu_ps(data);		// x0 y0 z0 x1
+		const __m128 b = _mm_loadu_ps(data + 4);	// y1 z1 x2 y2
+		const __m128 c = _mm_loadu_ps(data + 8);	// z2 x3 y3 z3
+
+		const __m128 x23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		const __m128 y01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		const __m128 y23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		const __m128 z01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		const __m128 z23 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+
+		x = _mm_shuffle_ps(a, x23, _MM_SHUFFLE(2, 0, 3, 0));
+		y = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+		z = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	/**
+	 * @brief Transpose x, y, z and w lanes into the same column of four matrices
+	 */
+	static inline void store_column_x4(f32* matrices, const u8 column, __m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(matrices + column * 4, x);
+		_mm_storeu_ps(matrices + 16 + column * 4, y);
+		_mm_storeu_ps(matrices + 32 + column * 4, z);
+		_mm_storeu_ps(matrices + 48 + column * 4, w);
+	}
+
+	static inline void sincos_sse(const __m128 angle, __m128& sin, __m128& cos)
+	{
+		const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+		__m128 x = _mm_andnot_ps(sign_mask, angle);
+		__m128 sin_sign = _mm_and_ps(angle, sign_mask);
+
+		// Octant of the angle, rounded up to an even number
+		__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(four_over_pi)));
+		octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+		const __m128 y = _mm_cvtepi32_ps(octant);
+
+		sin_sign = _mm_xor_ps(sin_sign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+		const __m128 cos_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+		const __m128 swap_polynomials = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+		// Reduce the angle into [-pi/4, pi/4] in extended precision
+		x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(pi_over_four_part_1)));
+		x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(pi_over_four_part_2)));
+		x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(pi_over_four_part_3)));
+
+		const __m128 z = _mm_mul_ps(x, x);
+
+		__m128 cos_polynomial = _mm_set1_ps(cos_coefficient_0);
+		cos_polynomial = _mm_add_ps(_mm_mul_ps(cos_polynomial, z), _mm_set1_ps(cos_coefficient_1));
+		cos_polynomial = _mm_add_ps(_mm_mul_ps(cos_polynomial, z), _mm_set1_ps(cos_coefficient_2));
+		cos_polynomial = _mm_mul_ps(_mm_mul_ps(cos_polynomial, z), z);
+		cos_polynomial = _mm_add_ps(_mm_sub_ps(cos_polynomial, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+		__m128 sin_polynomial = _mm_set1_ps(sin_coefficient_0);
+		sin_polynomial = _mm_add_ps(_mm_mul_ps(sin_polynomial, z), _mm_set1_ps(sin_coefficient_1));
+		sin_polynomial = _mm_add_ps(_mm_mul_ps(sin_polynomial, z), _mm_set1_ps(sin_coefficient_2));
+		sin_polynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sin_polynomial, z), x), x);
+
+		sin = _mm_or_ps(_mm_and_ps(swap_polynomials, sin_polynomial), _mm_andnot_ps(swap_polynomials, cos_polynomial));
+		cos = _mm_or_ps(_mm_and_ps(swap_polynomials, cos_polynomial), _mm_andnot_ps(swap_polynomials, sin_polynomial));
+
+		sin = _mm_xor_ps(sin, sin_sign);
+		cos = _mm_xor_ps(cos, cos_sign);
+	}
+
+	static size_t compose_sse(const f32* positions, const f32* rotations, const f32* scales, f32* matrices, const size_t count)
+	{
+		const __m128 half_radians = _mm_set1_ps(degrees_to_half_radians);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 position_x, position_y, position_z;
+			__m128 rotation_x, rotation_y, rotation_z;
+			__m128 scale_x, scale_y, scale_z;
+			load_vec3x4(positions + i * 3, position_x, position_y, position_z);
+			load_vec3x4(rotations + i * 3, rotation_x, rotation_y, rotation_z);
+			load_vec3x4(scales + i * 3, scale_x, scale_y, scale_z);
+
+			__m128 sin_x, cos_x, sin_y, cos_y, sin_z, cos_z;
+			sincos_sse(_mm_mul_ps(rotation_x, half_radians), sin_x, cos_x);
+			sincos_sse(_mm_mul_ps(rotation_y, half_radians), sin_y, cos_y);
+			sincos_sse(_mm_mul_ps(rotation_z, half_radians), sin_z, cos_z);
+
+			// Quaternion from the euler angles like glm::quat(glm::vec3) does it
+			const __m128 cos_y_cos_z = _mm_mul_ps(cos_y, cos_z);
+			const __m128 sin_y_sin_z = _mm_mul_ps(sin_y, sin_z);
+			const __m128 sin_y_cos_z = _mm_mul_ps(sin_y, cos_z);
+			const __m128 cos_y_sin_z = _mm_mul_ps(cos_y, sin_z);
+
+			const __m128 qw = _mm_add_ps(_mm_mul_ps(cos_x, cos_y_cos_z), _mm_mul_ps(sin_x, sin_y_sin_z));
+			const __m128 qx = _mm_sub_ps(_mm_mul_ps(sin_x, cos_y_cos_z), _mm_mul_ps(cos_x, sin_y_sin_z));
+			const __m128 qy = _mm_add_ps(_mm_mul_ps(cos_x, sin_y_cos_z), _mm_mul_ps(sin_x, cos_y_sin_z));
+			const __m128 qz = _mm_sub_ps(_mm_mul_ps(cos_x, cos_y_sin_z), _mm_mul_ps(sin_x, sin_y_cos_z));
+
+			// Rotation matrix like glm::mat3_cast() does it
+			const __m128 xx = _mm_mul_ps(qx, qx);
+			const __m128 yy = _mm_mul_ps(qy, qy);
+			const __m128 zz = _mm_mul_ps(qz, qz);
+			const __m128 xy = _mm_mul_ps(qx, qy);
+			const __m128 xz = _mm_mul_ps(qx, qz);
+			const __m128 yz = _mm_mul_ps(qy, qz);
+			const __m128 wx = _mm_mul_ps(qw, qx);
+			const __m128 wy = _mm_mul_ps(qw, qy);
+			const __m128 wz = _mm_mul_ps(qw, qz);
+
+			f32* const output = matrices + i * 16;
+
+			store_column_x4(output, 0,
+					_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scale_x),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scale_x),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scale_x),
+					zero);
+
+			store_column_x4(output, 1,
+					_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scale_y),
+					_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scale_y),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scale_y),
+					zero);
+
+			store_column_x4(output, 2,
+					_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scale_z),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scale_z),
+					_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scale_z),
+					zero);
+
+			store_column_x4(output, 3, position_x, position_y, position_z, one);
+		}
+
+		return i;
+	}
+
+	__attribute__((target("avx2,fma")))
+	static inline void load_vec3x8(const f32* data, __m256& x, __m256& y, __m256& z)
+	{
+		__m128 low_x, low_y, low_z, high_x, high_y, high_z;
+		load_vec3x4(data, low_x, low_y, low_z);
+		load_vec3x4(data + 12, high_x, high_y, high_z);
+
+		x = _mm256_set_m128(high_x, low_x);
+		y = _mm256_set_m128(high_y, low_y);
+		z = _mm256_set_m128(high_z, low_z);
+	}
+
+	__attribute__((target("avx2,fma")))
+	static inline void store_column_x8(f32* matrices, const u8 column, const __m256 x, const __m256 y, const __m256 z, const __m256 w)
+	{
+		store_column_x4(matrices, column, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+		store_column_x4(matrices + 64, column, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1));
+	}
+
+	__attribute__((target("avx2,fma")))
+	static inline void sincos_avx2(const __m256 angle, __m256& sin, __m256& cos)
+	{
+		const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+		__m256 x = _mm256_andnot_ps(sign_mask, angle);
+		__m256 sin_sign = _mm256_and_ps(angle, sign_mask);
+
+		// Octant of the angle, rounded up to an even number
+		__m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(four_over_pi)));
+		octant = _mm256_and_si256(_mm256_add_epi32(octant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+		const __m256 y = _mm256_cvtepi32_ps(octant);
+
+		sin_sign = _mm256_xor_ps(sin_sign, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29)));
+		const __m256 cos_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+		const __m256 swap_polynomials = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+
+		// Reduce the angle into [-pi/4, pi/4] in extended precision
+		x = _mm256_fnmadd_ps(y, _mm256_set1_ps(pi_over_four_part_1), x);
+		x = _mm256_fnmadd_ps(y, _mm256_set1_ps(pi_over_four_part_2), x);
+		x = _mm256_fnmadd_ps(y, _mm256_set1_ps(pi_over_four_part_3), x);
+
+		const __m256 z = _mm256_mul_ps(x, x);
+
+		__m256 cos_polynomial = _mm256_set1_ps(cos_coefficient_0);
+		cos_polynomial = _mm256_fmadd_ps(cos_polynomial, z, _mm256_set1_ps(cos_coefficient_1));
+		cos_polynomial = _mm256_fmadd_ps(cos_polynomial, z, _mm256_set1_ps(cos_coefficient_2));
+		cos_polynomial = _mm256_mul_ps(_mm256_mul_ps(cos_polynomial, z), z);
+		cos_polynomial = _mm256_add_ps(_mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), cos_polynomial), _mm256_set1_ps(1.0f));
+
+		__m256 sin_polynomial = _mm256_set1_ps(sin_coefficient_0);
+		sin_polynomial = _mm256_fmadd_ps(sin_polynomial, z, _mm256_set1_ps(sin_coefficient_1));
+		sin_polynomial = _mm256_fmadd_ps(sin_polynomial, z, _mm256_set1_ps(sin_coefficient_2));
+		sin_polynomial = _mm256_fmadd_ps(_mm256_mul_ps(sin_polynomial, z), x, x);
+
+		sin = _mm256_blendv_ps(cos_polynomial, sin_polynomial, swap_polynomials);
+		cos = _mm256_blendv_ps(sin_polynomial, cos_polynomial, swap_polynomials);
+
+		sin = _mm256_xor_ps(sin, sin_sign);
+		cos = _mm256_xor_ps(cos, cos_sign);
+	}
+
+	__attribute__((target("avx2,fma")))
+	static size_t compose_avx2(const f32* positions, const f32* rotations, const f32* scales, f32* matrices, const size_t count)
+	{
+		const __m256 half_radians = _mm256_set1_ps(degrees_to_half_radians);
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 position_x, position_y, position_z;
+			__m256 rotation_x, rotation_y, rotation_z;
+			__m256 scale_x, scale_y, scale_z;
+			load_vec3x8(positions + i * 3, position_x, position_y, position_z);
+			load_vec3x8(rotations + i * 3, rotation_x, rotation_y, rotation_z);
+			load_vec3x8(scales + i * 3, scale_x, scale_y, scale_z);
+
+			__m256 sin_x, cos_x, sin_y, cos_y, sin_z, cos_z;
+			sincos_avx2(_mm256_mul_ps(rotation_x, half_radians), sin_x, cos_x);
+			sincos_avx2(_mm256_mul_ps(rotation_y, half_radians), sin_y, cos_y);
+			sincos_avx2(_mm256_mul_ps(rotation_z, half_radians), sin_z, cos_z);
+
+			// Quaternion from the euler angles like glm::quat(glm::vec3) does it
+			const __m256 cos_y_cos_z = _mm256_mul_ps(cos_y, cos_z);
+			const __m256 sin_y_sin_z = _mm256_mul_ps(sin_y, sin_z);
+			const __m256 sin_y_cos_z = _mm256_mul_ps(sin_y, cos_z);
+			const __m256 cos_y_sin_z = _mm256_mul_ps(cos_y, sin_z);
+
+			const __m256 qw = _mm256_fmadd_ps(cos_x, cos_y_cos_z, _mm256_mul_ps(sin_x, sin_y_sin_z));
+			const __m256 qx = _mm256_fmsub_ps(sin_x, cos_y_cos_z, _mm256_mul_ps(cos_x, sin_y_sin_z));
+			const __m256 qy = _mm256_fmadd_ps(cos_x, sin_y_cos_z, _mm256_mul_ps(sin_x, cos_y_sin_z));
+			const __m256 qz = _mm256_fmsub_ps(cos_x, cos_y_sin_z, _mm256_mul_ps(sin_x, sin_y_cos_z));
+
+			// Rotation matrix like glm::mat3_cast() does it
+			const __m256 xx = _mm256_mul_ps(qx, qx);
+			const __m256 yy = _mm256_mul_ps(qy, qy);
+			const __m256 zz = _mm256_mul_ps(qz, qz);
+			const __m256 xy = _mm256_mul_ps(qx, qy);
+			const __m256 xz = _mm256_mul_ps(qx, qz);
+			const __m256 yz = _mm256_mul_ps(qy, qz);
+			const __m256 wx = _mm256_mul_ps(qw, qx);
+			const __m256 wy = _mm256_mul_ps(qw, qy);
+			const __m256 wz = _mm256_mul_ps(qw, qz);
+
+			f32* const output = matrices + i * 16;
+
+			store_column_x8(output, 0,
+					_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), scale_x),
+					_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), scale_x),
+					_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), scale_x),
+					zero);
+
+			store_column_x8(output, 1,
+					_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), scale_y),
+					_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), scale_y),
+					_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), scale_y),
+					zero);
+
+			store_column_x8(output, 2,
+					_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), scale_z),
+					_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), scale_z),
+					_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), scale_z),
+					zero);
+
+			store_column_x8(output, 3, position_x, position_y, position_z, one);
+		}
+
+		return i;
+	}
+
+	static bool avx2_supported()
+	{
+		static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		return supported;
+	}
+#endif
+
+	void transform::compose_model_matrices(std::span<const glm::vec3> positions, std::span<const glm::vec3> rotations, std::span<const glm::vec3> scales, std::span<glm::mat4> model_matrices)
+	{
+		ensure(rotations.size() == positions.size());
+		ensure(scales.size() == positions.size());
+		ensure(model_matrices.size() >= positions.size());
+
+		const size_t count = positions.size();
+		size_t processed = 0;
+
+#ifdef BIRB_TRANSFORM_KERNEL_SIMD
+		const f32* position_data = reinterpret_cast<const f32*>(positions.data());
+		const f32* rotation_data = reinterpret_cast<const f32*>(rotations.data());
+		const f32* scale_data = reinterpret_cast<const f32*>(scales.data());
+		f32* matrix_data = reinterpret_cast<f32*>(model_matrices.data());
+
+		if (avx2_supported())
+			processed = compose_avx2(position_data, rotation_data, scale_data, matrix_data, count);
+
+		processed += compose_sse(position_data + processed * 3, rotation_data + processed * 3, scale_data + processed * 3, matrix_data + processed * 16, count - processed);
+#endif
+
+		compose_scalar(positions.data() + processed, rotations.data() + processed, scales.data() + processed, model_matrices.data() + processed, count - processed);
+	}
+}
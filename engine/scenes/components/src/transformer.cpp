@@ -4,8 +4,12 @@
 #include "Transformer.hpp"
 #include "Types.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cstdlib>
+#include <execution>
 #include <glad/gl.h>
+#include <numeric>
 
 namespace birb
 {
@@ -21,10 +25,7 @@ namespace birb
 
 		ensure(_is_locked, "Transformer needs to be locked before it can be rendered");
 		ensure(model_matrix_vbo != 0);
-
-#ifndef NDEBUG
-		ensure(!d_singular_transform_updated);
-#endif
+		ensure(dirty_ranges.empty(), "Call update_vbo_data() after updating transforms");
 
 		return model_matrix_vbo;
 	}
@@ -40,13 +41,9 @@ namespace birb
 		PROFILER_SCOPE_MISC_FN();
 
 		ensure(cached_model_matrices.empty());
-		cached_model_matrices.reserve(transforms.size());
+		cached_model_matrices.resize(transforms.size());
 
-		for (transform t : transforms)
-		{
-			t.lock();
-			cached_model_matrices.push_back(t.model_matrix());
-		}
+		compute_model_matrices(index_range{ 0, transforms.size() });
 
 		update_model_matrix_vbo();
 		_is_locked = true;
@@ -58,9 +55,11 @@ namespace birb
 		ensure(model_matrix_vbo != 0);
 
 		cached_model_matrices.clear();
+		dirty_ranges.clear();
+		vbo_ranges.clear();
 
 		// Unlock all of the child transforms
-		for (transform t : transforms)
+		for (transform& t : transforms)
 			t.unlock();
 
 		_is_locked = false;
@@ -73,8 +72,17 @@ namespace birb
 
 		ensure(_is_locked, "Can't relock if the transformer hasn't been locked earlier");
 
-		unlock();
-		lock();
+		// Transforms were added or removed, so the VBO needs to be re-created
+		if (transforms.size() != cached_model_matrices.size())
+		{
+			unlock();
+			lock();
+			return;
+		}
+
+		// Otherwise the existing VBO can be updated in place
+		update_transforms(index_range{ 0, transforms.size() });
+		update_vbo_data();
 	}
 
 	void transformer::update_transform(const size_t index)
@@ -86,21 +94,86 @@ namespace birb
 		transforms[index].lock();
 		cached_model_matrices[index] = transforms[index].model_matrix();
 
-#ifndef NDEBUG
-		d_singular_transform_updated = true;
-#endif
+		mark_dirty(index_range{ index, 1 });
+	}
+
+	void transformer::update_transforms(std::span<const size_t> indices)
+	{
+		PROFILER_SCOPE_MISC_FN();
+
+		ensure(cached_model_matrices.size() == transforms.size());
+
+		if (indices.empty())
+			return;
+
+		// Sort the indices so that each transform is only touched by one
+		// thread and the updated transforms can be turned into ranges
+		std::vector<size_t> sorted_indices(indices.begin(), indices.end());
+		std::sort(sorted_indices.begin(), sorted_indices.end());
+		sorted_indices.erase(std::unique(sorted_indices.begin(), sorted_indices.end()), sorted_indices.end());
+
+		ensure(sorted_indices.back() < transforms.size());
+
+		std::for_each(std::execution::par_unseq, sorted_indices.begin(), sorted_indices.end(),
+			[this](const size_t index)
+			{
+				transforms[index].unlock();
+				transforms[index].lock();
+				cached_model_matrices[index] = transforms[index].model_matrix();
+			});
+
+		for (const size_t index : sorted_indices)
+			mark_dirty(index_range{ index, 1 });
+	}
+
+	void transformer::update_transforms(const index_range range)
+	{
+		PROFILER_SCOPE_MISC_FN();
+
+		ensure(cached_model_matrices.size() == transforms.size());
+		ensure(range.end() <= transforms.size());
+
+		if (range.count == 0)
+			return;
+
+		compute_model_matrices(range);
+		mark_dirty(range);
 	}
 
 	void transformer::update_vbo_data()
 	{
 		ensure(model_matrix_vbo != 0);
-		bind_vbo();
-		glBufferData(GL_ARRAY_BUFFER, cached_model_matrices.size() * sizeof(glm::mat4), cached_model_matrices.data(), GL_STATIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-#ifndef NDEBUG
-		d_singular_transform_updated = false;
-#endif
+		if (dirty_ranges.empty())
+			return;
+
+		// Re-specifying the buffer here would stall until the GPU is done
+		// with the previous frame. Let the renderer stream the dirty ranges instead
+		vbo_ranges.insert(vbo_ranges.end(), dirty_ranges.begin(), dirty_ranges.end());
+		dirty_ranges.clear();
+
+		coalesce_ranges(vbo_ranges, dirty_range_merge_gap);
+	}
+
+	bool transformer::has_pending_vbo_data() const
+	{
+		return !vbo_ranges.empty();
+	}
+
+	std::span<const transformer::index_range> transformer::pending_vbo_ranges() const
+	{
+		return vbo_ranges;
+	}
+
+	const std::vector<glm::mat4>& transformer::locked_model_matrices() const
+	{
+		ensure(_is_locked);
+		return cached_model_matrices;
+	}
+
+	void transformer::mark_vbo_data_uploaded()
+	{
+		vbo_ranges.clear();
 	}
 
 	bool transformer::is_locked() const
@@ -108,18 +181,70 @@ namespace birb
 		return _is_locked;
 	}
 
-	std::vector<glm::mat4> transformer::model_matrices() const
+	void transformer::coalesce_ranges(std::vector<index_range>& ranges, const size_t max_gap)
 	{
-		PROFILER_SCOPE_MISC_FN();
+		if (ranges.empty())
+			return;
+
+		std::sort(ranges.begin(), ranges.end(), [](const index_range& a, const index_range& b)
+		{
+			return a.first < b.first;
+		});
+
+		// Merge the ranges in place
+		size_t last = 0;
+		for (size_t i = 1; i < ranges.size(); ++i)
+		{
+			if (ranges[i].first <= ranges[last].end() + max_gap)
+				ranges[last].count = std::max(ranges[last].end(), ranges[i].end()) - ranges[last].first;
+			else
+				ranges[++last] = ranges[i];
+		}
+
+		ranges.resize(last + 1);
+	}
 
-		if (_is_locked)
-			return cached_model_matrices;
+	void transformer::compute_model_matrices(const index_range range)
+	{
+		PROFILER_SCOPE_MISC_FN();
 
-		std::vector<glm::mat4> tmp_model_matrices(transforms.size());
-		for (size_t i = 0; i < transforms.size(); ++i)
-			tmp_model_matrices[i] = transforms[i].model_matrix();
+		ensure(range.end() <= transforms.size());
+		ensure(cached_model_matrices.size() == transforms.size());
 
-		return tmp_model_matrices;
+		const size_t chunk_count = (range.count + lock_chunk_size - 1) / lock_chunk_size;
+		std::vector<size_t> chunks(chunk_count);
+		std::iota(chunks.begin(), chunks.end(), 0);
+
+		std::for_each(std::execution::par_unseq, chunks.begin(), chunks.end(),
+			[this, range](const size_t chunk)
+			{
+				const size_t first = range.first + chunk * lock_chunk_size;
+				const size_t count = std::min(lock_chunk_size, range.end() - first);
+
+				// Gather the transform components into contiguous arrays for the kernel
+				std::array<glm::vec3, lock_chunk_size> positions;
+				std::array<glm::vec3, lock_chunk_size> rotations;
+				std::array<glm::vec3, lock_chunk_size> scales;
+
+				for (size_t i = 0; i < count; ++i)
+				{
+					const transform& t = transforms[first + i];
+					positions[i] = t.position.to_glm_vec();
+					rotations[i] = t.rotation.to_glm_vec();
+					scales[i] = t.local_scale.to_glm_vec();
+				}
+
+				const std::span<glm::mat4> model_matrices(cached_model_matrices.data() + first, count);
+
+				transform::compose_model_matrices(
+						std::span(positions.data(), count),
+						std::span(rotations.data(), count),
+						std::span(scales.data(), count),
+						model_matrices);
+
+				for (size_t i = 0; i < count; ++i)
+					transforms[first + i].lock(model_matrices[i]);
+			});
 	}
 
 	void transformer::update_model_matrix_vbo()
@@ -129,17 +254,16 @@ namespace birb
 		ensure(model_matrix_vbo == 0, "Free the previous VBO before creating a new one");
 		ensure(!transforms.empty(), "Can't create a VBO when there are no transforms");
 
-		std::vector<glm::mat4> matrices = model_matrices();
+		ensure(cached_model_matrices.size() == transforms.size());
 
 		u32 vbo = 0;
 		glGenBuffers(1, &vbo);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, matrices.size() * sizeof(glm::mat4), matrices.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, cached_model_matrices.size() * sizeof(glm::mat4), cached_model_matrices.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		model_matrix_vbo = vbo;
-
-#ifndef NDEBUG
-		d_singular_transform_updated = false;
-#endif
+		dirty_ranges.clear();
+		vbo_ranges.clear();
 	}
 
 	void transformer::free_the_vbo_buffer()
@@ -148,4 +272,17 @@ namespace birb
 		glDeleteBuffers(1, &model_matrix_vbo);
 		model_matrix_vbo = 0;
 	}
+
+	void transformer::mark_dirty(const index_range range)
+	{
+		// Transforms are usually updated in order, so try to extend the previous range
+		if (!dirty_ranges.empty() && range.first >= dirty_ranges.back().first && range.first <= dirty_ranges.back().end())
+		{
+			index_range& previous = dirty_ranges.back();
+			previous.count = std::max(previous.end(), range.end()) - previous.first;
+			return;
+		}
+
+		dirty_ranges.push_back(range);
+	}
 }
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "TransformHierarchy.hpp"
 #include "Types.hpp"
 
 #include <entt.hpp>
+#include <glm/glm.hpp>
 #include <string>
 
 namespace birb
@@ -67,11 +69,51 @@ namespace birb
 			return registry.get<T>(entity);
 		}
 
+		/**
+		 * @brief Attach an entity to a parent entity
+		 *
+		 * The transform of the child becomes relative to the transform of the parent
+		 */
+		void set_parent(const entt::entity& child, const entt::entity& parent);
+
+		/**
+		 * @brief Detach an entity from its parent
+		 */
+		void clear_parent(const entt::entity& child);
+
+		/**
+		 * @brief Get the parent of an entity or entt::null if it doesn't have one
+		 */
+		entt::entity parent(const entt::entity& entity) const;
+
+		/**
+		 * @brief Recalculate the world matrices of the transforms that have changed
+		 *
+		 * Call this once per frame after moving entities around. The renderer
+		 * does this before drawing and the physics world after moving rigidbodies
+		 */
+		void update_world_matrices();
+
+		/**
+		 * @brief World matrix of an entity as of the previous update_world_matrices() call
+		 */
+		const glm::mat4& world_matrix(const entt::entity& entity) const;
+
+		/**
+		 * @brief Check if the entity has been in the transform hierarchy during a world matrix update
+		 */
+		bool has_world_matrix(const entt::entity& entity) const;
+
+		/**
+		 * @brief Amount of world matrices that were recalculated during the previous update
+		 */
+		u32 updated_world_matrix_count() const;
+
 		void reload_models();
 
 		static i16 scene_count();
 
 	private:
-
+		transform_hierarchy transforms;
 	};
 }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <entt.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace birb
+{
+	/**
+	 * @brief Parent link of an entity
+	 *
+	 * Entities with a parent follow the transform of the parent. Use
+	 * scene::set_parent() instead of modifying the parent directly,
+	 * so that the hierarchy knows to rebuild itself
+	 */
+	struct hierarchy
+	{
+		entt::entity parent = entt::null;
+	};
+
+	/**
+	 * @brief Location of the world matrix of an entity in the transform hierarchy
+	 *
+	 * Managed by the transform hierarchy
+	 */
+	struct world_matrix_index
+	{
+		u32 index = 0;
+	};
+
+	/**
+	 * @brief Cached world matrices of all entities with a transform component
+	 *
+	 * The world matrices are stored in a single array in depth-first order,
+	 * so parents always come before their children and every subtree is a
+	 * contiguous range in the array. Subtrees of different root entities are
+	 * independent of each other and get updated in parallel.
+	 *
+	 * Changes are detected by comparing the transforms to the values that they
+	 * had during the previous update. Only the changed transforms and their
+	 * descendants get their world matrices recalculated. The local matrices
+	 * are composed in chunks with transform::compose_model_matrices()
+	 */
+	class transform_hierarchy
+	{
+	public:
+		transform_hierarchy() = default;
+		~transform_hierarchy() = default;
+		transform_hierarchy(const transform_hierarchy&) = delete;
+		transform_hierarchy(transform_hierarchy&) = delete;
+		transform_hierarchy(transform_hierarchy&&) = delete;
+
+		/**
+		 * @brief Rebuild the hierarchy during the next update
+		 *
+		 * Needs to be called when transform or hierarchy components are added,
+		 * removed or modified. The registry arguments make it possible to connect
+		 * this function to the registry signals
+		 */
+		void mark_structure_dirty(entt::registry& registry, entt::entity entity);
+
+		/**
+		 * @brief Recalculate the world matrices that have changed since the previous update
+		 */
+		void update(entt::registry& registry);
+
+		/**
+		 * @brief Get a world matrix by its index
+		 *
+		 * The indices of each entity are stored in their world_matrix_index components
+		 */
+		const glm::mat4& world_matrix(const u32 index) const;
+
+		/**
+		 * @brief Amount of entities in the hierarchy
+		 */
+		size_t size() const;
+
+		/**
+		 * @brief Amount of world matrices that were recalculated during the previous update
+		 */
+		u32 updated_matrix_count() const;
+
+		/**
+		 * @brief Check if an entity is an ancestor of another entity
+		 */
+		static bool is_ancestor(const entt::registry& registry, const entt::entity ancestor, const entt::entity entity);
+
+	private:
+		static constexpr u32 no_parent = 0xFFFFFFFF;
+
+		// Amount of nodes that get their local matrices composed in one batch
+		static constexpr u32 local_matrix_chunk_size = 256;
+
+		struct node
+		{
+			entt::entity entity;
+			u32 parent;
+		};
+
+		// Range of nodes that belong to the subtree of a root entity
+		struct subtree
+		{
+			u32 first;
+			u32 end;
+		};
+
+		void rebuild(entt::registry& registry);
+		void update_local_matrices(const entt::registry& registry, const u32 first, const bool update_all);
+		u32 update_subtree(const subtree& root);
+
+		std::vector<node> nodes;
+		std::vector<subtree> roots;
+		std::vector<glm::mat4> world_matrices;
+		std::vector<glm::mat4> local_matrices;
+
+		// Transform values from the previous update
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> rotations;
+		std::vector<glm::vec3> scales;
+		std::vector<u8> locked;
+
+		// Set for the nodes that were recalculated during the current update, so that
+		// the children know to recalculate too. Not a vector<bool>, since the
+		// chunks and subtrees get updated from multiple threads
+		std::vector<u8> dirty;
+
+		bool structure_dirty = true;
+		u32 _updated_matrix_count = 0;
+	};
+}
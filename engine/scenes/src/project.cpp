@@ -96,7 +96,7 @@ namespace birb
 
 		// Point lights
 		nlohmann::json point_lights;
-		for (u16 i = 0; i < shader::point_light_count; ++i)
+		for (size_t i = 0; i < shader::point_lights.size(); ++i)
 		{
 			nlohmann::json point_light;
 			point_light["name"] = shader::point_lights[i].name;
@@ -222,7 +222,12 @@ namespace birb
 			shader::directional_light.diffuse	= json_to_vec3<f32>(directional_light_json["diffuse"]);
 			shader::directional_light.specular	= json_to_vec3<f32>(directional_light_json["specular"]);
 
-			for (u16 i = 0; i < shader::point_light_count; ++i)
+			// Older projects always have 4 point lights, so the light count
+			// can be taken from the project file as-is
+			ensure(point_light_json.size() <= max_point_lights, "The project has too many point lights");
+			shader::point_lights.resize(point_light_json.size());
+
+			for (size_t i = 0; i < shader::point_lights.size(); ++i)
 			{
 				nlohmann::json& point_light = point_light_json[i];
 
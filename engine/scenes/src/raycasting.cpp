@@ -26,15 +26,17 @@ namespace birb
 
 		for (const auto& entity : view)
 		{
-			const raycast_target target = view.get<raycast_target>(entity);
+			const raycast_target& target = view.get<raycast_target>(entity);
 
-			// calculate the distance from the camera to the target
-			const f32 distance_from_camera_to_sphere = squared_distance(camera_position, target.position.to_glm_vec());
+			// Targets on entities with a transform move along with the entity
+			const glm::vec3 target_position = scene.has_world_matrix(entity)
+				? glm::vec3(scene.world_matrix(entity) * glm::vec4(target.position.to_glm_vec(), 1.0f))
+				: target.position.to_glm_vec();
 
-			const f32 t = glm::dot((target.position.to_glm_vec() - camera_position), ray.to_glm_vec());
+			const f32 t = glm::dot((target_position - camera_position), ray.to_glm_vec());
 			const glm::vec3 p = camera_position + t * ray.to_glm_vec();
 
-			const f32 p2 = squared_distance(p, target.position.to_glm_vec());
+			const f32 p2 = squared_distance(p, target_position);
 
 			if (p2 <= target.radius * target.radius)
 			{
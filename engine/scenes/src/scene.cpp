@@ -11,9 +11,12 @@
 #include "ShaderRef.hpp"
 #include "State.hpp"
 #include "Transform.hpp"
+#include "TransformHierarchy.hpp"
 #include "Transformer.hpp"
 
 #include <entt.hpp>
+#include <unordered_map>
+#include <vector>
 
 namespace birb
 {
@@ -23,10 +26,21 @@ namespace birb
 	{
 		ensure(current_scene_count >= 0);
 		current_scene_count++;
+
+		// Rebuild the transform hierarchy when its structure changes
+		registry.on_construct<transform>().connect<&transform_hierarchy::mark_structure_dirty>(transforms);
+		registry.on_destroy<transform>().connect<&transform_hierarchy::mark_structure_dirty>(transforms);
+		registry.on_construct<hierarchy>().connect<&transform_hierarchy::mark_structure_dirty>(transforms);
+		registry.on_update<hierarchy>().connect<&transform_hierarchy::mark_structure_dirty>(transforms);
+		registry.on_destroy<hierarchy>().connect<&transform_hierarchy::mark_structure_dirty>(transforms);
 	}
 
 	scene::~scene()
 	{
+		// The transform hierarchy gets destroyed before the registry, so
+		// destroy the entities while the signals can still be delivered
+		registry.clear();
+
 		current_scene_count--;
 	}
 
@@ -131,14 +145,73 @@ namespace birb
 		return true;
 	}
 
+	void scene::set_parent(const entt::entity& child, const entt::entity& parent)
+	{
+		ensure(registry.valid(child));
+		ensure(registry.valid(parent));
+		ensure(child != parent, "An entity can't be its own parent");
+		ensure(!transform_hierarchy::is_ancestor(registry, child, parent), "Parenting an entity to its descendant would create a loop");
+
+		registry.emplace_or_replace<hierarchy>(child, parent);
+	}
+
+	void scene::clear_parent(const entt::entity& child)
+	{
+		ensure(registry.valid(child));
+		registry.remove<hierarchy>(child);
+	}
+
+	entt::entity scene::parent(const entt::entity& entity) const
+	{
+		const hierarchy* link = registry.try_get<hierarchy>(entity);
+		if (link == nullptr || !registry.valid(link->parent))
+			return entt::null;
+
+		return link->parent;
+	}
+
+	void scene::update_world_matrices()
+	{
+		transforms.update(registry);
+	}
+
+	const glm::mat4& scene::world_matrix(const entt::entity& entity) const
+	{
+		ensure(has_world_matrix(entity), "Update the world matrices after adding transforms");
+		return transforms.world_matrix(registry.get<world_matrix_index>(entity).index);
+	}
+
+	bool scene::has_world_matrix(const entt::entity& entity) const
+	{
+		return registry.all_of<world_matrix_index>(entity);
+	}
+
+	u32 scene::updated_world_matrix_count() const
+	{
+		return transforms.updated_matrix_count();
+	}
+
 	void scene::reload_models()
 	{
 		const auto view = registry.view<birb::model>();
 
+		// Copies of a model share their meshes, so reload each set of copies only once
+		std::unordered_map<const std::vector<mesh>*, const model*> reloaded_models;
+
 		for (auto& entity : view)
 		{
 			model& model = view.get<birb::model>(entity);
-			model.reload();
+			const std::vector<mesh>* shared_meshes = &model.get_meshes();
+
+			if (reloaded_models.contains(shared_meshes))
+			{
+				if (reloaded_models.at(shared_meshes) != nullptr)
+					model.refresh_shared_state(*reloaded_models.at(shared_meshes));
+
+				continue;
+			}
+
+			reloaded_models[shared_meshes] = model.reload() ? &model : nullptr;
 		}
 	}
 
@@ -0,0 +1,235 @@
+#include "Assert.hpp"
+#include "Logger.hpp"
+#include "Profiling.hpp"
+#include "Transform.hpp"
+#include "TransformHierarchy.hpp"
+
+#include <algorithm>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+#include <utility>
+
+namespace birb
+{
+	void transform_hierarchy::mark_structure_dirty(entt::registry&, entt::entity)
+	{
+		structure_dirty = true;
+	}
+
+	void transform_hierarchy::update(entt::registry& registry)
+	{
+		PROFILER_SCOPE_MISC_FN();
+
+		const bool update_all = structure_dirty;
+
+		if (structure_dirty)
+		{
+			rebuild(registry);
+			structure_dirty = false;
+		}
+
+		const entt::registry& const_registry = registry;
+
+		// The local matrices don't depend on the structure, so they are
+		// composed in chunks that don't care about the subtree boundaries
+		std::vector<u32> chunks;
+		for (u32 first = 0; first < nodes.size(); first += local_matrix_chunk_size)
+			chunks.push_back(first);
+
+		std::for_each(std::execution::par, chunks.begin(), chunks.end(), [this, &const_registry, update_all](const u32 first)
+		{
+			update_local_matrices(const_registry, first, update_all);
+		});
+
+		_updated_matrix_count = std::transform_reduce(std::execution::par, roots.begin(), roots.end(), 0u, std::plus<>(),
+			[this](const subtree& root)
+			{
+				return update_subtree(root);
+			});
+	}
+
+	const glm::mat4& transform_hierarchy::world_matrix(const u32 index) const
+	{
+		ensure(index < world_matrices.size());
+		return world_matrices[index];
+	}
+
+	size_t transform_hierarchy::size() const
+	{
+		return nodes.size();
+	}
+
+	u32 transform_hierarchy::updated_matrix_count() const
+	{
+		return _updated_matrix_count;
+	}
+
+	bool transform_hierarchy::is_ancestor(const entt::registry& registry, const entt::entity ancestor, const entt::entity entity)
+	{
+		const hierarchy* link = registry.try_get<hierarchy>(entity);
+
+		// The chain can't be longer than the amount of parent links unless it loops
+		const size_t max_depth = registry.view<hierarchy>().size();
+
+		for (size_t depth = 0; link != nullptr && link->parent != entt::null && registry.valid(link->parent); ++depth)
+		{
+			if (link->parent == ancestor || depth > max_depth)
+				return true;
+
+			link = registry.try_get<hierarchy>(link->parent);
+		}
+
+		return false;
+	}
+
+	void transform_hierarchy::rebuild(entt::registry& registry)
+	{
+		PROFILER_SCOPE_MISC_FN();
+
+		const auto view = registry.view<transform>();
+
+		// Entities whose parent doesn't exist or doesn't have a transform are treated as roots
+		std::unordered_map<entt::entity, std::vector<entt::entity>> children;
+		std::vector<entt::entity> root_entities;
+		size_t entity_count = 0;
+
+		for (const entt::entity entity : view)
+		{
+			++entity_count;
+
+			const hierarchy* link = registry.try_get<hierarchy>(entity);
+			if (link != nullptr && link->parent != entt::null && registry.valid(link->parent) && registry.all_of<transform>(link->parent))
+				children[link->parent].push_back(entity);
+			else
+				root_entities.push_back(entity);
+		}
+
+		nodes.clear();
+		nodes.reserve(entity_count);
+		roots.clear();
+
+		// Depth-first traversal places each subtree into a contiguous range
+		std::vector<std::pair<entt::entity, u32>> stack;
+
+		for (const entt::entity root : root_entities)
+		{
+			const u32 first = nodes.size();
+			stack.emplace_back(root, no_parent);
+
+			while (!stack.empty())
+			{
+				const auto [entity, parent] = stack.back();
+				stack.pop_back();
+
+				const u32 index = nodes.size();
+				nodes.push_back({ entity, parent });
+
+				const auto entity_children = children.find(entity);
+				if (entity_children == children.end())
+					continue;
+
+				// Push in reverse so that the children keep their order
+				for (auto child = entity_children->second.rbegin(); child != entity_children->second.rend(); ++child)
+					stack.emplace_back(*child, index);
+			}
+
+			roots.push_back({ first, static_cast<u32>(nodes.size()) });
+		}
+
+		// Entities that are a part of a parent loop can't be reached from any root
+		if (nodes.size() != entity_count)
+			birb::log_warn("The transform hierarchy has a loop. ", entity_count - nodes.size(), " entities were left out");
+
+		world_matrices.resize(nodes.size());
+		local_matrices.resize(nodes.size());
+		positions.resize(nodes.size());
+		rotations.resize(nodes.size());
+		scales.resize(nodes.size());
+		locked.resize(nodes.size());
+		dirty.resize(nodes.size());
+
+		// Entities that were left out shouldn't keep their old indices
+		registry.clear<world_matrix_index>();
+		for (u32 i = 0; i < nodes.size(); ++i)
+			registry.emplace<world_matrix_index>(nodes[i].entity, i);
+	}
+
+	void transform_hierarchy::update_local_matrices(const entt::registry& registry, const u32 first, const bool update_all)
+	{
+		const u32 end = std::min<u32>(first + local_matrix_chunk_size, nodes.size());
+		bool chunk_changed = false;
+		bool chunk_has_locked = false;
+
+		for (u32 i = first; i < end; ++i)
+		{
+			const transform& transform = registry.get<birb::transform>(nodes[i].entity);
+
+			const glm::vec3 position = transform.position.to_glm_vec();
+			const glm::vec3 rotation = transform.rotation.to_glm_vec();
+			const glm::vec3 scale = transform.local_scale.to_glm_vec();
+
+			const bool changed = update_all
+				|| position != positions[i]
+				|| rotation != rotations[i]
+				|| scale != scales[i]
+				|| transform.is_locked() != static_cast<bool>(locked[i]);
+
+			dirty[i] = changed;
+			chunk_changed |= changed;
+			chunk_has_locked |= transform.is_locked();
+
+			if (!changed)
+				continue;
+
+			positions[i] = position;
+			rotations[i] = rotation;
+			scales[i] = scale;
+			locked[i] = transform.is_locked();
+		}
+
+		if (!chunk_changed)
+			return;
+
+		// Composing the whole chunk is cheaper than picking out the changed nodes,
+		// since the snapshot arrays are up to date for the unchanged nodes too
+		const size_t count = end - first;
+		transform::compose_model_matrices(
+				std::span<const glm::vec3>(positions.data() + first, count),
+				std::span<const glm::vec3>(rotations.data() + first, count),
+				std::span<const glm::vec3>(scales.data() + first, count),
+				std::span<glm::mat4>(local_matrices.data() + first, count));
+
+		if (!chunk_has_locked)
+			return;
+
+		// Locked transforms keep the matrix that they were locked to, which
+		// might not match their current position, rotation and scale
+		for (u32 i = first; i < end; ++i)
+			if (locked[i])
+				local_matrices[i] = registry.get<birb::transform>(nodes[i].entity).model_matrix();
+	}
+
+	u32 transform_hierarchy::update_subtree(const subtree& root)
+	{
+		u32 updated_count = 0;
+
+		for (u32 i = root.first; i < root.end; ++i)
+		{
+			// Parents are always before their children, so the parent has already been processed
+			const u32 parent = nodes[i].parent;
+			dirty[i] = dirty[i] || (parent != no_parent && dirty[parent]);
+
+			if (!dirty[i])
+				continue;
+
+			world_matrices[i] = parent == no_parent ? local_matrices[i] : world_matrices[parent] * local_matrices[i];
+
+			++updated_count;
+		}
+
+		return updated_count;
+	}
+}
@@ -67,6 +67,14 @@ namespace birb
 					std::pair<std::string, u32>("Total", stats.total_draw_calls()),
 				};
 
+				std::vector<std::pair<std::string, u32>> state_change_stats = {
+					std::pair<std::string, u32>("Shader switches", stats.shader_switches),
+					std::pair<std::string, u32>("Material changes", stats.material_changes),
+					std::pair<std::string, u32>("Texture binds", stats.texture_binds),
+					std::pair<std::string, u32>("VAO binds", stats.vao_binds),
+					std::pair<std::string, u32>("Total", stats.total_state_changes()),
+				};
+
 				static const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
 
 				ImGui::BeginTable("Drawing stats", 4, flags);
@@ -124,6 +132,58 @@ namespace birb
 
 				ImGui::Spacing();
 
+				ImGui::BeginTable("State changes", 2, flags);
+				{
+					// Table headers
+					ImGui::TableSetupColumn("State");
+					ImGui::TableSetupColumn("Changes");
+					ImGui::TableHeadersRow();
+
+					for (const std::pair<std::string, u32>& data_point : state_change_stats)
+					{
+						ImGui::TableNextRow();
+						ImGui::TableNextColumn();
+						ImGui::Text("%s", data_point.first.c_str());
+						ImGui::TableNextColumn();
+						ImGui::Text("%u", data_point.second);
+					}
+				}
+				ImGui::EndTable();
+
+				ImGui::Spacing();
+
+				if (renderer.is_frustum_culling_enabled())
+					ImGui::Text("3D entities culled: %u / %u", stats.entities_3d_culled, stats.entities_3d_culled + stats.entities_3d_visible);
+
+				if (renderer.is_occlusion_culling_enabled())
+					ImGui::Text("3D entities occluded: %u (%u occluders)", stats.entities_3d_occluded, stats.occluders_rasterized);
+
+				if (renderer.is_lod_enabled())
+					ImGui::Text("Triangles per LOD: %u / %u / %u / %u", stats.lod_triangles[0], stats.lod_triangles[1], stats.lod_triangles[2], stats.lod_triangles[3]);
+
+				if (renderer.is_instancing_enabled())
+					ImGui::Text("3D entities instanced: %u / %u", stats.entities_3d_instanced, stats.entities_3d);
+
+				if (renderer.is_sprite_batching_enabled())
+					ImGui::Text("Sprite batches: %u (%u sprites)", stats.sprite_batches, stats.sprites_batched);
+
+				ImGui::Text("Instance matrices uploaded: %u", stats.instance_matrices_uploaded);
+				ImGui::Text("World matrices updated: %u", stats.world_matrices_updated);
+
+				if (renderer.is_clustered_lighting_enabled())
+				{
+					ImGui::Text("Point lights: %u (max %u per cluster)", stats.point_lights, stats.light_cluster_max_lights);
+					ImGui::Text("Light clustering: %s", stopwatch::format_time(stats.light_clustering_duration).c_str());
+				}
+
+				if (renderer.is_shadows_enabled())
+				{
+					ImGui::Text("Shadow casters: %u (all cascades)", stats.shadow_casters);
+					ImGui::Text("Shadow maps: %s", stopwatch::format_time(stats.shadow_duration).c_str());
+				}
+
+				ImGui::Spacing();
+
 				if (renderer::is_wireframe_enabled())
 					ImGui::Text("> Wireframe mode enabled");
 
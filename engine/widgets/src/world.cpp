@@ -41,7 +41,23 @@ namespace birb
 
 			if (ImGui::CollapsingHeader("Point lights"))
 			{
-				for (u16 i = 0; i < birb::shader::point_light_count; ++i)
+				ImGui::Text("Light count: %lu / %u", birb::shader::point_lights.size(), birb::max_point_lights);
+
+				ImGui::BeginDisabled(birb::shader::point_lights.size() >= birb::max_point_lights);
+				if (ImGui::Button("Add"))
+					birb::shader::point_lights.emplace_back();
+				ImGui::EndDisabled();
+
+				ImGui::SameLine();
+
+				ImGui::BeginDisabled(birb::shader::point_lights.empty());
+				if (ImGui::Button("Remove last"))
+					birb::shader::point_lights.pop_back();
+				ImGui::EndDisabled();
+
+				ImGui::Spacing();
+
+				for (size_t i = 0; i < birb::shader::point_lights.size(); ++i)
 				{
 					std::string light_name = std::to_string(static_cast<unsigned int>(i)) + " " + birb::shader::point_lights[i].name;
 
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include "Types.hpp"
+
+#include <vector>
+
+// A flat grid of quads on the xz-plane
+inline void grid(const u32 size, std::vector<birb::vertex>& vertices, std::vector<u32>& indices)
+{
+	for (u32 z = 0; z <= size; ++z)
+	{
+		for (u32 x = 0; x <= size; ++x)
+		{
+			birb::vertex v;
+			v.position = glm::vec3(x, 0, z);
+			v.normal = glm::vec3(0, 1, 0);
+			v.tex_coords = glm::vec2(x, z) / static_cast<f32>(size);
+			vertices.push_back(v);
+		}
+	}
+
+	for (u32 z = 0; z < size; ++z)
+	{
+		for (u32 x = 0; x < size; ++x)
+		{
+			const u32 i = z * (size + 1) + x;
+			indices.insert(indices.end(), { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 });
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#include "AssetLoader.hpp"
+#include "Font.hpp"
+#include "FontManager.hpp"
+
+#include <chrono>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <latch>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The decoding waits for the gate to open if there is one
+static birb::asset_handle<int> load_number(birb::asset_loader& loader, const int number, std::latch* gate = nullptr)
+{
+	return loader.load<int, int>(std::to_string(number),
+		[number, gate]() -> std::shared_ptr<int>
+		{
+			if (gate != nullptr)
+				gate->wait();
+
+			// Negative numbers fail to decode
+			return number >= 0 ? std::make_shared<int>(number) : nullptr;
+		},
+		[](int& decoded) -> std::shared_ptr<int>
+		{
+			// Zero fails to upload
+			return decoded != 0 ? std::make_shared<int>(decoded * 2) : nullptr;
+		});
+}
+
+TEST_CASE("Asset loader")
+{
+	birb::asset_loader loader(2);
+	CHECK(loader.worker_count() == 2);
+	CHECK(loader.pending_count() == 0);
+
+	SUBCASE("Assets get uploaded only when processing uploads")
+	{
+		std::latch gate(1);
+		birb::asset_handle<int> handle = load_number(loader, 21, &gate);
+		CHECK(loader.pending_count() == 1);
+
+		// Nothing has been decoded yet, so there's nothing to upload
+		loader.process_uploads();
+		CHECK(handle.status() == birb::asset_status::loading);
+		CHECK(loader.pending_count() == 1);
+
+		gate.count_down();
+		loader.wait_for_decoding();
+
+		// Decoding alone doesn't make the asset ready
+		CHECK(handle.status() == birb::asset_status::loading);
+		CHECK_FALSE(handle.is_ready());
+
+		loader.process_uploads();
+		REQUIRE(handle.is_ready());
+		CHECK(*handle.get() == 42);
+		CHECK(loader.pending_count() == 0);
+	}
+
+	SUBCASE("Failures")
+	{
+		birb::asset_handle<int> decode_failure = load_number(loader, -1);
+		birb::asset_handle<int> upload_failure = load_number(loader, 0);
+		birb::asset_handle<int> success = load_number(loader, 1);
+
+		loader.finish_all();
+		CHECK(loader.pending_count() == 0);
+
+		CHECK(decode_failure.has_failed());
+		CHECK(upload_failure.has_failed());
+		CHECK_FALSE(success.has_failed());
+		CHECK(*success.get() == 2);
+	}
+
+	SUBCASE("Upload budget")
+	{
+		std::vector<birb::asset_handle<int>> handles;
+		for (int i = 1; i <= 4; ++i)
+			handles.push_back(load_number(loader, i));
+
+		loader.wait_for_decoding();
+
+		// At least one upload happens even without any budget
+		loader.process_uploads(std::chrono::microseconds(0));
+		CHECK(loader.pending_count() == 3);
+
+		loader.finish_all();
+		for (const birb::asset_handle<int>& handle : handles)
+			CHECK(handle.is_ready());
+	}
+
+	SUBCASE("Empty handles")
+	{
+		birb::asset_handle<int> handle;
+		CHECK_FALSE(handle.is_ready());
+		CHECK_FALSE(handle.has_failed());
+	}
+}
+
+TEST_CASE("Asset loader font failure")
+{
+	birb::font_manager fonts;
+	birb::asset_loader loader(1);
+
+	// Decoding happens on a worker thread, so a bad path must not end the process
+	birb::asset_handle<birb::font> handle = loader.load_font(fonts, (std::filesystem::temp_directory_path() / "birb3d_missing_font.ttf").string(), 16);
+	loader.finish_all();
+
+	CHECK(handle.has_failed());
+	CHECK(loader.pending_count() == 0);
+}
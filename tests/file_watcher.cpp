@@ -0,0 +1,103 @@
+#include "FileWatcher.hpp"
+
+#include <chrono>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Wait until the watcher reports something or give up after a while
+static std::vector<std::string> wait_for_changes(birb::file_watcher& watcher)
+{
+	for (int i = 0; i < 100; ++i)
+	{
+		std::vector<std::string> changes = watcher.poll_changes();
+		if (!changes.empty())
+			return changes;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	return {};
+}
+
+TEST_CASE("File watcher")
+{
+	if (!birb::file_watcher::is_supported())
+		return;
+
+	const std::filesystem::path directory = "/tmp/birb3d_file_watcher_test";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	const std::string watched_file = (directory / "watched.txt").string();
+	const std::string other_file = (directory / "other.txt").string();
+
+	std::ofstream(watched_file) << "a";
+	std::ofstream(other_file) << "a";
+
+	birb::file_watcher watcher(std::chrono::milliseconds(20));
+	CHECK(watcher.poll_changes().empty());
+
+	SUBCASE("Single file")
+	{
+		watcher.watch(watched_file);
+
+		// Watching the same file again is fine
+		watcher.watch(watched_file);
+
+		// Bursts of writes get reported once
+		std::ofstream(watched_file) << "b";
+		std::ofstream(watched_file) << "c";
+
+		// Other files in the same directory are not reported
+		std::ofstream(other_file) << "b";
+
+		const std::vector<std::string> changes = wait_for_changes(watcher);
+		REQUIRE(changes.size() == 1);
+		CHECK(changes[0] == std::filesystem::canonical(watched_file).string());
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		CHECK(watcher.poll_changes().empty());
+	}
+
+	SUBCASE("Replaced by renaming")
+	{
+		watcher.watch(watched_file);
+
+		const std::string temp_file = (directory / "watched.txt.tmp").string();
+		std::ofstream(temp_file) << "b";
+		std::filesystem::rename(temp_file, watched_file);
+
+		const std::vector<std::string> changes = wait_for_changes(watcher);
+		REQUIRE(changes.size() == 1);
+		CHECK(changes[0] == std::filesystem::canonical(watched_file).string());
+	}
+
+	SUBCASE("Directory")
+	{
+		watcher.watch(directory.string());
+
+		std::ofstream(watched_file) << "b";
+		std::ofstream(other_file) << "b";
+
+		std::vector<std::string> changes;
+		for (int i = 0; i < 10 && changes.size() < 2; ++i)
+		{
+			const std::vector<std::string> new_changes = wait_for_changes(watcher);
+			changes.insert(changes.end(), new_changes.begin(), new_changes.end());
+		}
+
+		CHECK(changes.size() == 2);
+	}
+
+	SUBCASE("Missing paths are ignored")
+	{
+		watcher.watch((directory / "missing.txt").string());
+		CHECK(watcher.poll_changes().empty());
+	}
+
+	std::filesystem::remove_all(directory);
+}
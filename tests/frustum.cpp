@@ -0,0 +1,102 @@
+#include "BoundingBox.hpp"
+#include "Frustum.hpp"
+
+#include <doctest/doctest.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+TEST_CASE("Bounding box")
+{
+	SUBCASE("Default box is invalid")
+	{
+		birb::bounding_box box;
+		CHECK_FALSE(box.is_valid());
+	}
+
+	SUBCASE("Expanding")
+	{
+		birb::bounding_box box;
+		box.expand(glm::vec3(1, 2, 3));
+		box.expand(glm::vec3(-1, -2, -3));
+
+		CHECK(box.is_valid());
+		CHECK(box.min == glm::vec3(-1, -2, -3));
+		CHECK(box.max == glm::vec3(1, 2, 3));
+		CHECK(box.center() == glm::vec3(0, 0, 0));
+		CHECK(box.extents() == glm::vec3(1, 2, 3));
+
+		birb::bounding_box other;
+		other.expand(glm::vec3(5, 0, 0));
+		box.expand(other);
+		CHECK(box.max == glm::vec3(5, 2, 3));
+	}
+
+	SUBCASE("Transforming")
+	{
+		birb::bounding_box box;
+		box.expand(glm::vec3(-1, -1, -1));
+		box.expand(glm::vec3(1, 1, 1));
+
+		const glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(10, 0, 0));
+		const birb::bounding_box moved = box.transformed(translation);
+		CHECK(moved.min == glm::vec3(9, -1, -1));
+		CHECK(moved.max == glm::vec3(11, 1, 1));
+
+		const glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(2, 3, 4));
+		const birb::bounding_box scaled = box.transformed(scale);
+		CHECK(scaled.min == glm::vec3(-2, -3, -4));
+		CHECK(scaled.max == glm::vec3(2, 3, 4));
+	}
+}
+
+TEST_CASE("Frustum culling")
+{
+	const auto unit_box_at = [](const glm::vec3& position)
+	{
+		birb::bounding_box box;
+		box.expand(position - glm::vec3(0.5f));
+		box.expand(position + glm::vec3(0.5f));
+		return box;
+	};
+
+	SUBCASE("Default frustum rejects nothing")
+	{
+		birb::frustum frustum;
+		CHECK(frustum.contains(glm::vec3(1000, -1000, 1000)));
+		CHECK(frustum.intersects(unit_box_at(glm::vec3(-500, 0, 0))));
+	}
+
+	SUBCASE("Perspective")
+	{
+		const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+		birb::frustum frustum(projection * view);
+
+		CHECK(frustum.contains(glm::vec3(0, 0, -10)));
+		CHECK_FALSE(frustum.contains(glm::vec3(0, 0, 10)));
+		CHECK_FALSE(frustum.contains(glm::vec3(0, 0, -200)));
+
+		CHECK(frustum.intersects(unit_box_at(glm::vec3(0, 0, -10))));
+		CHECK_FALSE(frustum.intersects(unit_box_at(glm::vec3(0, 0, 10))));
+		CHECK_FALSE(frustum.intersects(unit_box_at(glm::vec3(50, 0, -10))));
+		CHECK_FALSE(frustum.intersects(unit_box_at(glm::vec3(0, -50, -10))));
+
+		// Partially visible boxes should not get culled
+		CHECK(frustum.intersects(unit_box_at(glm::vec3(0, 0, -100.2f))));
+
+		CHECK(frustum.intersects_sphere(glm::vec3(0, 0, -10), 1.0f));
+		CHECK_FALSE(frustum.intersects_sphere(glm::vec3(0, 0, 10), 1.0f));
+	}
+
+	SUBCASE("Orthographic")
+	{
+		const glm::mat4 projection = glm::ortho(0.0f, 100.0f, 0.0f, 100.0f, 0.1f, 100.0f);
+		birb::frustum frustum(projection);
+
+		CHECK(frustum.contains(glm::vec3(50, 50, -10)));
+		CHECK_FALSE(frustum.contains(glm::vec3(-10, 50, -10)));
+		CHECK_FALSE(frustum.contains(glm::vec3(50, 150, -10)));
+
+		CHECK(frustum.intersects(unit_box_at(glm::vec3(0, 0, -10))));
+		CHECK_FALSE(frustum.intersects(unit_box_at(glm::vec3(200, 0, -10))));
+	}
+}
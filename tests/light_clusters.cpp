@@ -0,0 +1,146 @@
+#include "LightClusters.hpp"
+#include "Shader.hpp"
+
+#include <doctest/doctest.h>
+#include <glm/glm.hpp>
+#include <limits>
+#include <vector>
+
+TEST_CASE("Light radius")
+{
+	birb::point_light light;
+	light.diffuse = { 1.0f, 1.0f, 1.0f };
+
+	SUBCASE("Attenuated light")
+	{
+		const f32 radius = birb::light_clusters::light_radius(light);
+		CHECK(radius > 0.0f);
+
+		// The light should have attenuated to the cutoff value at the radius
+		const f32 attenuation = 1.0f / (light.attenuation_constant + light.attenuation_linear * radius + light.attenuation_quadratic * radius * radius);
+		CHECK(attenuation == doctest::Approx(birb::light_clusters::light_cutoff));
+	}
+
+	SUBCASE("Linear attenuation")
+	{
+		light.attenuation_quadratic = 0.0f;
+		light.attenuation_linear = 1.0f;
+
+		const f32 radius = birb::light_clusters::light_radius(light);
+		CHECK(1.0f / (light.attenuation_constant + radius) == doctest::Approx(birb::light_clusters::light_cutoff));
+	}
+
+	SUBCASE("No attenuation")
+	{
+		light.attenuation_linear = 0.0f;
+		light.attenuation_quadratic = 0.0f;
+		CHECK(birb::light_clusters::light_radius(light) == std::numeric_limits<f32>::max());
+	}
+
+	SUBCASE("Black light")
+	{
+		light.diffuse = { 0.0f, 0.0f, 0.0f };
+		CHECK(birb::light_clusters::light_radius(light) == 0.0f);
+	}
+}
+
+TEST_CASE("Light clustering")
+{
+	using birb::light_clusters;
+
+	constexpr f32 fov = 90.0f;
+	constexpr f32 aspect_ratio = 16.0f / 9.0f;
+	constexpr f32 near_clip = 0.1f;
+	constexpr f32 far_clip = 100.0f;
+
+	// The camera is at the origin looking towards -z
+	const glm::mat4 view_matrix(1.0f);
+
+	light_clusters clusters;
+
+	// Small light that only reaches roughly half of a unit
+	birb::point_light light;
+	light.diffuse = { 1.0f, 1.0f, 1.0f };
+	light.attenuation_linear = 7.0f;
+	light.attenuation_quadratic = 60.0f;
+
+	SUBCASE("Depth slices")
+	{
+		clusters.update(view_matrix, fov, aspect_ratio, near_clip, far_clip, {});
+
+		CHECK(clusters.depth_slice(near_clip) == 0);
+		CHECK(clusters.depth_slice(far_clip * 0.999f) == light_clusters::grid_size_z - 1);
+		CHECK(clusters.depth_slice(1.0f) <= clusters.depth_slice(2.0f));
+		CHECK(clusters.depth_slice(2.0f) <= clusters.depth_slice(50.0f));
+
+		// Depths outside of the clip range get clamped
+		CHECK(clusters.depth_slice(near_clip * 0.5f) == 0);
+		CHECK(clusters.depth_slice(far_clip * 2.0f) == light_clusters::grid_size_z - 1);
+	}
+
+	SUBCASE("Cluster bounds cover the view frustum")
+	{
+		clusters.update(view_matrix, fov, aspect_ratio, near_clip, far_clip, {});
+
+		const birb::bounding_box& first = clusters.cluster_bounds(light_clusters::cluster_index(0, 0, 0));
+		CHECK(first.max.z == doctest::Approx(-near_clip));
+		CHECK(first.min.x < 0.0f);
+		CHECK(first.min.y < 0.0f);
+
+		const birb::bounding_box& last = clusters.cluster_bounds(light_clusters::cluster_index(light_clusters::grid_size_x - 1, light_clusters::grid_size_y - 1, light_clusters::grid_size_z - 1));
+		CHECK(last.min.z == doctest::Approx(-far_clip));
+		CHECK(last.max.x > 0.0f);
+		CHECK(last.max.y > 0.0f);
+	}
+
+	SUBCASE("Light in front of the camera")
+	{
+		light.position = { 0.0f, 0.0f, -10.0f };
+		clusters.update(view_matrix, fov, aspect_ratio, near_clip, far_clip, { light });
+
+		CHECK(clusters.max_cluster_light_count() == 1);
+
+		// The cluster in the middle of the screen at the depth of the light should have it
+		const u16 slice = clusters.depth_slice(10.0f);
+		const u32 center_cluster = light_clusters::cluster_index(light_clusters::grid_size_x / 2, light_clusters::grid_size_y / 2, slice);
+		REQUIRE(clusters.cluster_lights(center_cluster).size() == 1);
+		CHECK(clusters.cluster_lights(center_cluster)[0] == 0);
+
+		// Clusters in the corners of the screen are too far away from the light
+		CHECK(clusters.cluster_lights(light_clusters::cluster_index(0, 0, slice)).empty());
+
+		// The light should only touch a handful of clusters
+		CHECK_FALSE(clusters.light_indices().empty());
+		CHECK(clusters.light_indices().size() < 32);
+	}
+
+	SUBCASE("Light behind the camera")
+	{
+		light.position = { 0.0f, 0.0f, 10.0f };
+		clusters.update(view_matrix, fov, aspect_ratio, near_clip, far_clip, { light });
+
+		CHECK(clusters.light_indices().empty());
+		CHECK(clusters.max_cluster_light_count() == 0);
+	}
+
+	SUBCASE("Light ranges are packed")
+	{
+		std::vector<birb::point_light> lights(64, light);
+		for (size_t i = 0; i < lights.size(); ++i)
+			lights[i].position = { static_cast<f32>(i % 8) - 4.0f, static_cast<f32>(i / 8) - 4.0f, -5.0f - static_cast<f32>(i) };
+
+		clusters.update(view_matrix, fov, aspect_ratio, near_clip, far_clip, lights);
+
+		u32 expected_offset = 0;
+		for (const glm::uvec2& range : clusters.light_ranges())
+		{
+			CHECK(range.x == expected_offset);
+			expected_offset += range.y;
+		}
+
+		CHECK(expected_offset == clusters.light_indices().size());
+
+		for (const u16 index : clusters.light_indices())
+			CHECK(index < lights.size());
+	}
+}
@@ -0,0 +1,137 @@
+#include "Mesh.hpp"
+#include "MeshOptimizer.hpp"
+#include "TestMeshes.hpp"
+
+#include <algorithm>
+#include <array>
+#include <doctest/doctest.h>
+#include <random>
+#include <vector>
+
+// Triangles as vertex positions, rotated to a common starting corner and sorted,
+// so that meshes with the same triangles compare equal regardless of their order
+static std::vector<std::array<f32, 9>> triangle_set(const std::vector<birb::vertex>& vertices, const std::vector<u32>& indices)
+{
+	std::vector<std::array<f32, 9>> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		std::array<f32, 9> triangle;
+		for (u8 j = 0; j < 3; ++j)
+			for (u8 k = 0; k < 3; ++k)
+				triangle[j * 3 + k] = vertices[indices[i + j]].position[k];
+
+		// Rotating keeps the winding intact
+		std::array<f32, 9> smallest = triangle;
+		for (u8 j = 1; j < 3; ++j)
+		{
+			std::rotate(triangle.begin(), triangle.begin() + 3, triangle.end());
+			smallest = std::min(smallest, triangle);
+		}
+
+		triangles.push_back(smallest);
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+TEST_CASE("Average cache miss ratio")
+{
+	const std::vector<u32> triangle = { 0, 1, 2 };
+	CHECK(birb::mesh_optimizer::acmr(triangle, 3) == 3.0f);
+
+	const std::vector<u32> quad = { 0, 1, 2, 2, 1, 3 };
+	CHECK(birb::mesh_optimizer::acmr(quad, 4) == 2.0f);
+
+	// Nothing stays in a cache of size zero
+	CHECK(birb::mesh_optimizer::acmr(quad, 4, 0) == 3.0f);
+
+	CHECK(birb::mesh_optimizer::acmr({}, 0) == 0.0f);
+}
+
+TEST_CASE("Mesh optimization")
+{
+	std::vector<birb::vertex> vertices;
+	std::vector<u32> indices;
+	grid(32, vertices, indices);
+
+	const std::vector<std::array<f32, 9>> original_triangles = triangle_set(vertices, indices);
+
+	// Scramble the triangle order to get a mesh with a bad cache miss ratio
+	std::vector<std::array<u32, 3>> triangles(indices.size() / 3);
+	for (size_t i = 0; i < triangles.size(); ++i)
+		triangles[i] = { indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2] };
+
+	std::mt19937 rng(1337);
+	std::shuffle(triangles.begin(), triangles.end(), rng);
+
+	for (size_t i = 0; i < triangles.size(); ++i)
+		std::copy(triangles[i].begin(), triangles[i].end(), indices.begin() + i * 3);
+
+	const f32 scrambled_acmr = birb::mesh_optimizer::acmr(indices, vertices.size());
+
+	SUBCASE("Welding merges identical vertices")
+	{
+		// Give every triangle its own vertices like an unindexed mesh would have
+		std::vector<birb::vertex> unwelded_vertices;
+		std::vector<u32> unwelded_indices;
+		for (const u32 index : indices)
+		{
+			unwelded_indices.push_back(unwelded_vertices.size());
+			unwelded_vertices.push_back(vertices[index]);
+		}
+
+		birb::mesh_optimizer::weld_vertices(unwelded_vertices, unwelded_indices);
+
+		CHECK(unwelded_vertices.size() == vertices.size());
+		CHECK(triangle_set(unwelded_vertices, unwelded_indices) == original_triangles);
+	}
+
+	SUBCASE("Vertices with different attributes are not welded")
+	{
+		vertices.push_back(vertices[indices[0]]);
+		vertices.back().tex_coords.x += 0.5f;
+		indices[0] = vertices.size() - 1;
+
+		const size_t vertex_count = vertices.size();
+		birb::mesh_optimizer::weld_vertices(vertices, indices);
+		CHECK(vertices.size() == vertex_count);
+	}
+
+	SUBCASE("Vertex cache optimization")
+	{
+		birb::mesh_optimizer::optimize_vertex_cache(indices, vertices.size());
+		const f32 optimized_acmr = birb::mesh_optimizer::acmr(indices, vertices.size());
+
+		CHECK(optimized_acmr < scrambled_acmr);
+		CHECK(optimized_acmr < 1.0f);
+		CHECK(triangle_set(vertices, indices) == original_triangles);
+
+		SUBCASE("Overdraw optimization keeps most of the cache efficiency")
+		{
+			birb::mesh_optimizer::optimize_overdraw(indices, vertices, 1.05f);
+
+			CHECK(birb::mesh_optimizer::acmr(indices, vertices.size()) <= optimized_acmr * 1.1f);
+			CHECK(triangle_set(vertices, indices) == original_triangles);
+		}
+	}
+
+	SUBCASE("Vertex fetch optimization")
+	{
+		birb::mesh_optimizer::optimize_vertex_fetch(vertices, indices);
+
+		// Vertices are in the order they are first used in
+		u32 next_new_vertex = 0;
+		bool in_order = true;
+		for (const u32 index : indices)
+		{
+			in_order = in_order && index <= next_new_vertex;
+			if (index == next_new_vertex)
+				++next_new_vertex;
+		}
+
+		CHECK(in_order);
+		CHECK(next_new_vertex == vertices.size());
+		CHECK(triangle_set(vertices, indices) == original_triangles);
+	}
+}
@@ -0,0 +1,120 @@
+#include "Mesh.hpp"
+#include "MeshSimplifier.hpp"
+#include "Model.hpp"
+#include "TestMeshes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <doctest/doctest.h>
+#include <vector>
+
+TEST_CASE("Mesh simplification")
+{
+	std::vector<birb::vertex> vertices;
+	std::vector<u32> indices;
+	grid(16, vertices, indices);
+
+	const auto face_normals_point_up = [&vertices](const std::vector<u32>& result)
+	{
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const glm::vec3 normal = glm::cross(vertices[result[i + 1]].position - vertices[result[i]].position, vertices[result[i + 2]].position - vertices[result[i]].position);
+			if (normal.y <= 0.0f)
+				return false;
+		}
+		return true;
+	};
+
+	REQUIRE(face_normals_point_up(indices));
+
+	SUBCASE("Flat meshes get simplified down to the target")
+	{
+		const std::vector<u32> result = birb::mesh_simplifier::simplify(vertices, indices, indices.size() / 4, 0.01f);
+
+		CHECK(result.size() % 3 == 0);
+		CHECK(result.size() <= indices.size() / 4);
+		CHECK_FALSE(result.empty());
+		CHECK(std::all_of(result.begin(), result.end(), [&vertices](const u32 index) { return index < vertices.size(); }));
+		CHECK(face_normals_point_up(result));
+	}
+
+	SUBCASE("Border vertices stay in place")
+	{
+		const std::vector<u32> result = birb::mesh_simplifier::simplify(vertices, indices, 0, 0.01f);
+
+		// The corners of the grid can't be removed
+		for (const glm::vec3 corner : { glm::vec3(0, 0, 0), glm::vec3(16, 0, 0), glm::vec3(0, 0, 16), glm::vec3(16, 0, 16) })
+			CHECK(std::any_of(result.begin(), result.end(), [&](const u32 index) { return vertices[index].position == corner; }));
+	}
+
+	SUBCASE("The error limit stops the simplification")
+	{
+		// Bend the grid into a wave
+		for (birb::vertex& v : vertices)
+			v.position.y = std::sin(v.position.x);
+
+		const std::vector<u32> result = birb::mesh_simplifier::simplify(vertices, indices, 0, 0.0f);
+		CHECK(result.size() > indices.size() / 2);
+	}
+
+	SUBCASE("Simplification doesn't do anything if the target has been reached already")
+	{
+		CHECK(birb::mesh_simplifier::simplify(vertices, indices, indices.size(), 0.01f) == indices);
+	}
+
+	SUBCASE("Levels of detail")
+	{
+		const std::vector<std::vector<u32>> lods = birb::mesh_simplifier::generate_lods(vertices, indices, 4);
+
+		REQUIRE_FALSE(lods.empty());
+		CHECK(lods.size() <= 3);
+
+		size_t previous_size = indices.size();
+		for (const std::vector<u32>& lod : lods)
+		{
+			CHECK(lod.size() < previous_size);
+			CHECK(face_normals_point_up(lod));
+			previous_size = lod.size();
+		}
+
+		// Small meshes are left alone
+		std::vector<birb::vertex> small_vertices;
+		std::vector<u32> small_indices;
+		grid(2, small_vertices, small_indices);
+		CHECK(birb::mesh_simplifier::generate_lods(small_vertices, small_indices, 4).empty());
+	}
+}
+
+TEST_CASE("Level of detail selection")
+{
+	// Large models use the full detail meshes
+	CHECK(birb::model::next_lod(0, 4, 1.0f) == 0);
+	CHECK(birb::model::next_lod(3, 4, 1.0f) == 0);
+
+	// Tiny models use the lowest level of detail
+	CHECK(birb::model::next_lod(0, 4, 0.001f) == 3);
+
+	// Models without levels of detail always use the full detail meshes
+	CHECK(birb::model::next_lod(0, 1, 0.001f) == 0);
+	CHECK(birb::model::next_lod(0, 0, 0.001f) == 0);
+
+	// Levels that the model doesn't have are never picked
+	CHECK(birb::model::next_lod(0, 2, 0.001f) == 1);
+
+	// The level doesn't change when the size is close to a threshold
+	u8 lod = birb::model::next_lod(0, 4, 1.0f);
+	f32 threshold = 0.0f;
+	for (f32 size = 1.0f; size > 0.0f; size -= 0.001f)
+	{
+		lod = birb::model::next_lod(lod, 4, size);
+		if (lod == 1)
+		{
+			threshold = size;
+			break;
+		}
+	}
+	REQUIRE(threshold > 0.0f);
+
+	CHECK(birb::model::next_lod(lod, 4, threshold * 1.05f) == 1);
+	CHECK(birb::model::next_lod(lod, 4, threshold * 1.5f) == 0);
+}
@@ -0,0 +1,112 @@
+#include "BoundingBox.hpp"
+#include "Mesh.hpp"
+#include "OcclusionCuller.hpp"
+
+#include <doctest/doctest.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+TEST_CASE("Occlusion culling")
+{
+	const auto box_at = [](const glm::vec3& position, const f32 extent)
+	{
+		birb::bounding_box box;
+		box.expand(position - glm::vec3(extent));
+		box.expand(position + glm::vec3(extent));
+		return box;
+	};
+
+	const auto quad = [](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
+	{
+		std::vector<birb::vertex> vertices(4);
+		vertices[0].position = a;
+		vertices[1].position = b;
+		vertices[2].position = c;
+		vertices[3].position = d;
+		return vertices;
+	};
+
+	// The camera is at the origin looking towards -z
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 2.0f, 0.1f, 100.0f);
+	const glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+
+	// A 10x10 wall in front of the camera
+	const std::vector<birb::vertex> wall = quad({ -5, -5, -10 }, { 5, -5, -10 }, { 5, 5, -10 }, { -5, 5, -10 });
+	const std::vector<u32> wall_indices = { 0, 1, 2, 0, 2, 3 };
+
+	birb::occlusion_culler culler;
+	culler.begin(projection * view);
+
+	SUBCASE("Nothing is occluded without occluders")
+	{
+		culler.rasterize();
+		CHECK(culler.depth(birb::occlusion_culler::width / 2, birb::occlusion_culler::height / 2) == 1.0f);
+		CHECK(culler.is_visible(box_at({ 0, 0, -20 }, 1.0f)));
+	}
+
+	SUBCASE("Boxes behind the wall are occluded")
+	{
+		culler.add_occluder(wall, wall_indices, glm::mat4(1.0f));
+		culler.rasterize();
+		CHECK(culler.triangle_count() == 2);
+
+		CHECK(culler.depth(birb::occlusion_culler::width / 2, birb::occlusion_culler::height / 2) < 1.0f);
+		CHECK(culler.depth(0, 0) == 1.0f);
+
+		CHECK_FALSE(culler.is_visible(box_at({ 0, 0, -20 }, 1.0f)));
+		CHECK_FALSE(culler.is_visible(box_at({ 3, -3, -50 }, 2.0f)));
+
+		// In front of the wall
+		CHECK(culler.is_visible(box_at({ 0, 0, -5 }, 1.0f)));
+
+		// Behind the wall, but next to it
+		CHECK(culler.is_visible(box_at({ 15, 0, -20 }, 1.0f)));
+
+		// Larger than the wall
+		CHECK(culler.is_visible(box_at({ 0, 0, -20 }, 12.0f)));
+
+		// Crosses the near plane
+		CHECK(culler.is_visible(box_at({ 0, 0, 0 }, 1.0f)));
+	}
+
+	SUBCASE("Both windings occlude")
+	{
+		const std::vector<u32> flipped_indices = { 0, 2, 1, 0, 3, 2 };
+		culler.add_occluder(wall, flipped_indices, glm::mat4(1.0f));
+		culler.rasterize();
+
+		CHECK_FALSE(culler.is_visible(box_at({ 0, 0, -20 }, 1.0f)));
+	}
+
+	SUBCASE("Occluders get the model matrix applied")
+	{
+		culler.add_occluder(wall, wall_indices, glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -30)));
+		culler.rasterize();
+
+		CHECK(culler.is_visible(box_at({ 0, 0, -20 }, 1.0f)));
+		CHECK_FALSE(culler.is_visible(box_at({ 0, 0, -60 }, 1.0f)));
+	}
+
+	SUBCASE("Occluders that cross the near plane get clipped")
+	{
+		// A floor that goes under and behind the camera
+		const std::vector<birb::vertex> floor = quad({ -50, -1, 50 }, { 50, -1, 50 }, { 50, -1, -50 }, { -50, -1, -50 });
+		culler.add_occluder(floor, wall_indices, glm::mat4(1.0f));
+		culler.rasterize();
+
+		CHECK_FALSE(culler.is_visible(box_at({ 0, -3, -20 }, 1.0f)));
+		CHECK(culler.is_visible(box_at({ 0, 1, -20 }, 1.0f)));
+	}
+
+	SUBCASE("Beginning a new frame clears the depth buffer")
+	{
+		culler.add_occluder(wall, wall_indices, glm::mat4(1.0f));
+		culler.rasterize();
+
+		culler.begin(projection * view);
+		culler.rasterize();
+
+		CHECK(culler.triangle_count() == 0);
+		CHECK(culler.is_visible(box_at({ 0, 0, -20 }, 1.0f)));
+	}
+}
@@ -0,0 +1,112 @@
+#include "BoundingBox.hpp"
+#include "Mesh.hpp"
+#include "PackedVertex.hpp"
+
+#include <cmath>
+#include <doctest/doctest.h>
+#include <limits>
+#include <random>
+#include <vector>
+
+TEST_CASE("Half floats")
+{
+	using namespace birb::vertex_packing;
+
+	// Values that fit into a half float exactly
+	for (const f32 value : { 0.0f, 1.0f, -2.0f, 0.5f, 0.25f, 1024.0f, 65504.0f, -0.0009765625f })
+		CHECK(half_to_float(float_to_half(value)) == value);
+
+	CHECK(float_to_half(0.0f) == 0x0000);
+	CHECK(float_to_half(-0.0f) == 0x8000);
+	CHECK(float_to_half(1.0f) == 0x3C00);
+
+	// Too large values become infinity
+	CHECK(std::isinf(half_to_float(float_to_half(100000.0f))));
+	CHECK(std::isinf(half_to_float(float_to_half(std::numeric_limits<f32>::infinity()))));
+	CHECK(std::isnan(half_to_float(float_to_half(std::numeric_limits<f32>::quiet_NaN()))));
+
+	// Denormals
+	CHECK(half_to_float(float_to_half(std::ldexp(1.0f, -24))) == std::ldexp(1.0f, -24));
+	CHECK(half_to_float(float_to_half(std::ldexp(3.0f, -20))) == std::ldexp(3.0f, -20));
+
+	// Rounding error is at most half of the 10-bit mantissa step
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<f32> distribution(-100.0f, 100.0f);
+	bool within_tolerance = true;
+	for (u32 i = 0; i < 1000; ++i)
+	{
+		const f32 value = distribution(rng);
+		within_tolerance = within_tolerance && std::abs(half_to_float(float_to_half(value)) - value) <= std::abs(value) * std::ldexp(1.0f, -11);
+	}
+	CHECK(within_tolerance);
+}
+
+TEST_CASE("Octahedral normals")
+{
+	using namespace birb::vertex_packing;
+
+	std::vector<glm::vec3> normals = {
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+	};
+
+	std::mt19937 rng(1234);
+	std::normal_distribution<f32> distribution;
+	for (u32 i = 0; i < 1000; ++i)
+		normals.push_back(glm::normalize(glm::vec3(distribution(rng), distribution(rng), distribution(rng))));
+
+	bool exact = true;
+	for (const glm::vec3& normal : normals)
+	{
+		const glm::vec2 encoded = encode_octahedral(normal);
+		exact = exact && std::abs(encoded.x) <= 1.0f && std::abs(encoded.y) <= 1.0f;
+		exact = exact && glm::dot(decode_octahedral(encoded), normal) > 0.99999f;
+	}
+	CHECK(exact);
+}
+
+TEST_CASE("Packed vertices")
+{
+	CHECK(sizeof(birb::packed_vertex) * 2 == sizeof(birb::vertex));
+
+	birb::bounding_box bounds;
+	bounds.expand(glm::vec3(-50.0f, 0.0f, -20.0f));
+	bounds.expand(glm::vec3(50.0f, 0.0f, 80.0f));
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<f32> unit(0.0f, 1.0f);
+	std::normal_distribution<f32> normal_distribution;
+
+	const glm::vec3 extent = bounds.max - bounds.min;
+
+	f32 max_position_error = 0.0f;
+	f32 min_normal_dot = 1.0f;
+	f32 max_uv_error = 0.0f;
+
+	for (u32 i = 0; i < 1000; ++i)
+	{
+		birb::vertex v;
+		v.position = bounds.min + glm::vec3(unit(rng), unit(rng), unit(rng)) * extent;
+		v.position.y = 0.0f;
+		v.normal = glm::normalize(glm::vec3(normal_distribution(rng), normal_distribution(rng), normal_distribution(rng)));
+		v.tex_coords = glm::vec2(unit(rng), unit(rng));
+
+		const birb::vertex unpacked = birb::vertex_packing::unpack(birb::vertex_packing::pack(v, bounds), bounds);
+
+		for (u8 j = 0; j < 3; ++j)
+			max_position_error = std::max(max_position_error, std::abs(unpacked.position[j] - v.position[j]) / std::max(extent[j], 1.0f));
+
+		min_normal_dot = std::min(min_normal_dot, glm::dot(unpacked.normal, v.normal));
+
+		const glm::vec2 uv_error = unpacked.tex_coords - v.tex_coords;
+		max_uv_error = std::max({ max_uv_error, std::abs(uv_error.x), std::abs(uv_error.y) });
+	}
+
+	// Half of a 16-bit step relative to the mesh size
+	CHECK(max_position_error <= 1.0f / 65535.0f);
+
+	// Less than 0.1 degrees
+	CHECK(min_normal_dot > 0.99999f);
+
+	// Half of the half float mantissa step below 1.0
+	CHECK(max_uv_error <= std::ldexp(1.0f, -12));
+}
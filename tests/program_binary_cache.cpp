@@ -0,0 +1,76 @@
+#include "ProgramBinaryCache.hpp"
+
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+TEST_CASE("Program binary cache keys")
+{
+	using namespace birb::program_binary_cache;
+
+	const u64 base = key("vertex", "fragment", "driver");
+
+	// Keys need to stay the same between runs
+	CHECK(key("vertex", "fragment", "driver") == base);
+
+	// Any change in the sources or the driver invalidates the binary
+	CHECK(key("vertex ", "fragment", "driver") != base);
+	CHECK(key("vertex", "fragment2", "driver") != base);
+	CHECK(key("vertex", "fragment", "driver 2") != base);
+
+	// Moving text from one part to another changes the key
+	CHECK(key("vertexf", "ragment", "driver") != base);
+	CHECK(key("", "vertexfragment", "driver") != key("vertexfragment", "", "driver"));
+
+	// Different keys get different files
+	CHECK(file_path(base) != file_path(key("vertex", "fragment", "driver 2")));
+	CHECK(file_path(base).ends_with(".bin"));
+}
+
+TEST_CASE("Program binary cache files")
+{
+	using namespace birb::program_binary_cache;
+
+	const std::string path = (std::filesystem::temp_directory_path() / "birb3d_program_binary_test.bin").string();
+	std::filesystem::remove(path);
+
+	const u64 test_key = key("vertex", "fragment", "driver");
+
+	program_binary binary;
+	binary.format = 0x1234;
+	binary.data = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+	// Missing files are cache misses
+	program_binary result;
+	CHECK_FALSE(read_file(path, test_key, result));
+
+	REQUIRE(write_file(path, test_key, binary));
+	CHECK_FALSE(std::filesystem::exists(path + ".tmp"));
+
+	SUBCASE("Round trip")
+	{
+		REQUIRE(read_file(path, test_key, result));
+		CHECK(result.format == binary.format);
+		CHECK(result.data == binary.data);
+	}
+
+	SUBCASE("Key mismatch")
+	{
+		CHECK_FALSE(read_file(path, test_key + 1, result));
+	}
+
+	SUBCASE("Truncated file")
+	{
+		std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+		CHECK_FALSE(read_file(path, test_key, result));
+	}
+
+	SUBCASE("Garbage file")
+	{
+		std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a program binary";
+		CHECK_FALSE(read_file(path, test_key, result));
+	}
+
+	std::filesystem::remove(path);
+}
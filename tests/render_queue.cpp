@@ -0,0 +1,94 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <vector>
+
+TEST_CASE("Render queue sorting")
+{
+	birb::render_queue queue;
+
+	SUBCASE("Empty queue")
+	{
+		queue.sort();
+		CHECK(queue.empty());
+		CHECK(queue.size() == 0);
+	}
+
+	SUBCASE("Keys get sorted in ascending order")
+	{
+		const std::vector<u64> keys = {
+			0xFFFFFFFFFFFFFFFF,
+			0,
+			42,
+			0x0100000000000000,
+			0x00000000FF000000,
+			7,
+			0x8000000000000001,
+		};
+
+		for (u32 i = 0; i < keys.size(); ++i)
+			queue.push(keys[i], i);
+
+		queue.sort();
+		CHECK(queue.size() == keys.size());
+
+		std::vector<u64> sorted_keys = keys;
+		std::sort(sorted_keys.begin(), sorted_keys.end());
+
+		for (size_t i = 0; i < sorted_keys.size(); ++i)
+		{
+			CHECK(queue.commands()[i].key == sorted_keys[i]);
+			CHECK(keys[queue.commands()[i].index] == sorted_keys[i]);
+		}
+	}
+
+	SUBCASE("Sorting is stable")
+	{
+		queue.push(2, 0);
+		queue.push(1, 1);
+		queue.push(2, 2);
+		queue.push(1, 3, 5);
+		queue.push(2, 4);
+
+		queue.sort();
+
+		CHECK(queue.commands()[0].index == 1);
+		CHECK(queue.commands()[1].index == 3);
+		CHECK(queue.commands()[1].sub_index == 5);
+		CHECK(queue.commands()[2].index == 0);
+		CHECK(queue.commands()[3].index == 2);
+		CHECK(queue.commands()[4].index == 4);
+	}
+
+	SUBCASE("Clearing")
+	{
+		queue.push(1, 0);
+		queue.clear();
+		CHECK(queue.empty());
+	}
+}
+
+TEST_CASE("Render queue sort key helpers")
+{
+	SUBCASE("Key fields")
+	{
+		CHECK(birb::render_queue::key_field(0xFF, 4, 0) == 0xF);
+		CHECK(birb::render_queue::key_field(0x3, 2, 62) == 0xC000000000000000);
+		CHECK(birb::render_queue::key_field(0x1234, 64, 0) == 0x1234);
+	}
+
+	SUBCASE("Sortable floats")
+	{
+		const std::vector<f32> values = { -1000.0f, -2.5f, -0.001f, 0.0f, 0.001f, 1.0f, 2.5f, 1000.0f };
+		for (size_t i = 1; i < values.size(); ++i)
+			CHECK(birb::render_queue::sortable_float(values[i - 1]) < birb::render_queue::sortable_float(values[i]));
+	}
+
+	SUBCASE("Depth bits keep the order")
+	{
+		CHECK(birb::render_queue::depth_bits(1.0f, 14) < birb::render_queue::depth_bits(10.0f, 14));
+		CHECK(birb::render_queue::depth_bits(10.0f, 14) < birb::render_queue::depth_bits(100.0f, 14));
+		CHECK(birb::render_queue::depth_bits(100.0f, 14) < (1u << 14));
+	}
+}
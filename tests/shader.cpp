@@ -0,0 +1,81 @@
+#include "Globals.hpp"
+#include "Shader.hpp"
+#include "ShaderUniforms.hpp"
+
+#include <doctest/doctest.h>
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+static i32 sampler_value(const birb::shader& shader, const birb::uniform& sampler, const i32 index = -1)
+{
+	const i32 location = glGetUniformLocation(shader.id, sampler.str(index).c_str());
+	REQUIRE(location != -1);
+
+	i32 value = -1;
+	glGetUniformiv(shader.id, location, &value);
+	return value;
+}
+
+static i32 current_program()
+{
+	i32 program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	return program;
+}
+
+#ifdef BIRB_GL_TESTS
+static constexpr bool gl_tests_enabled = true;
+#else
+static constexpr bool gl_tests_enabled = false;
+#endif
+
+// Compiling shaders needs an OpenGL context, which isn't available on headless
+// machines. The test shows up as skipped unless BIRB_GL_TESTS is enabled
+TEST_CASE("Shader sampler uniforms" * doctest::skip(!gl_tests_enabled))
+{
+	REQUIRE_MESSAGE(glfwInit(), "Could not initialize GLFW");
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "shader test", nullptr, nullptr);
+	if (!window)
+	{
+		glfwTerminate();
+		FAIL("Could not create an OpenGL context");
+	}
+
+	glfwMakeContextCurrent(window);
+	gladLoadGL((GLADloadfunc)glfwGetProcAddress);
+	birb::g_opengl_initialized = true;
+
+	{
+		using namespace birb::shader_uniforms;
+
+		// The sampler uniforms get set while the program is being linked,
+		// which used to trip the shader activation assert in debug builds
+		birb::shader shader("default");
+
+		CHECK(sampler_value(shader, lights::point_light_data) == birb::light_texture_unit::point_light_data);
+		CHECK(sampler_value(shader, lights::cluster_ranges) == birb::light_texture_unit::cluster_ranges);
+		CHECK(sampler_value(shader, lights::cluster_indices) == birb::light_texture_unit::cluster_indices);
+
+		for (u8 i = 0; i < birb::shadow_cascade_count; ++i)
+			CHECK(sampler_value(shader, lights::shadow_map, i) == birb::light_texture_unit::shadow_maps + i);
+
+		// Compiling another shader doesn't change the program that is in use
+		shader.activate();
+		birb::shader instanced("default_instanced", "default");
+		CHECK(current_program() == static_cast<i32>(shader.id));
+
+		CHECK(sampler_value(instanced, lights::point_light_data) == birb::light_texture_unit::point_light_data);
+		for (u8 i = 0; i < birb::shadow_cascade_count; ++i)
+			CHECK(sampler_value(instanced, lights::shadow_map, i) == birb::light_texture_unit::shadow_maps + i);
+	}
+
+	birb::g_opengl_initialized = false;
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
@@ -0,0 +1,91 @@
+#include "ShaderUniforms.hpp"
+
+#include <cstddef>
+#include <doctest/doctest.h>
+#include <set>
+
+TEST_CASE("Uniform table layout")
+{
+	using namespace birb;
+
+	SUBCASE("Every built-in uniform has a name")
+	{
+		for (u16 i = 0; i < uniform_table::uniform_count; ++i)
+			CHECK_FALSE(std::string(get_uniform_info(static_cast<uniform_id>(i)).name).empty());
+	}
+
+	SUBCASE("Array uniforms get a slot per element")
+	{
+		for (u16 i = 0; i < uniform_table::uniform_count; ++i)
+		{
+			const uniform_id id = static_cast<uniform_id>(i);
+			CHECK(uniform_table::first_slots[i + 1] - uniform_table::first_slots[i] == uniform_table::element_count(id));
+		}
+	}
+
+	SUBCASE("Value cache offsets match the uniform types")
+	{
+		const u16 model_slot = uniform_table::first_slot(uniform_id::model);
+		CHECK(uniform_table::value_offsets[model_slot + 1] - uniform_table::value_offsets[model_slot] == sizeof(glm::mat4));
+
+		const u16 color_slot = uniform_table::first_slot(uniform_id::color);
+		CHECK(uniform_table::value_offsets[color_slot + 1] - uniform_table::value_offsets[color_slot] == sizeof(glm::vec3));
+
+		CHECK(uniform_table::value_cache_size == uniform_table::value_offsets[uniform_table::slot_count]);
+	}
+
+	SUBCASE("Uniform slots are unique")
+	{
+		std::set<u16> slots;
+
+		for (u16 i = 0; i < uniform_table::uniform_count; ++i)
+		{
+			const uniform builtin_uniform(static_cast<uniform_id>(i));
+
+			if (builtin_uniform.is_array)
+			{
+				for (i32 j = 0; j < builtin_uniform.array_max_size; ++j)
+					slots.insert(builtin_uniform.slot(j));
+			}
+			else
+			{
+				slots.insert(builtin_uniform.slot());
+			}
+		}
+
+		CHECK(slots.size() == uniform_table::slot_count);
+		CHECK(*slots.rbegin() < uniform_table::slot_count);
+	}
+
+	SUBCASE("Uniforms that share a name share a slot")
+	{
+		CHECK(shader_uniforms::material_color::shininess.slot() == shader_uniforms::material_texture::shininess.slot());
+		CHECK(shader_uniforms::material_color::shininess.str() == "material.shininess");
+	}
+}
+
+TEST_CASE("Lighting uniform block layout")
+{
+	using namespace birb;
+
+	// Member offsets in the std140 layout
+	CHECK(offsetof(std140::light_info, point_light_count) == 64);
+	CHECK(offsetof(std140::light_info, clustered) == 68);
+	CHECK(offsetof(std140::light_info, shadows) == 72);
+	CHECK(offsetof(std140::light_info, cluster_grid) == 80);
+	CHECK(offsetof(std140::light_info, cluster_slicing) == 96);
+	CHECK(offsetof(std140::light_info, shadow_matrices) == 112);
+	CHECK(offsetof(std140::light_info, cascade_splits) == 112 + sizeof(glm::mat4) * shadow_cascade_count);
+	CHECK(offsetof(std140::light_info, cascade_texel_sizes) == 128 + sizeof(glm::mat4) * shadow_cascade_count);
+	CHECK(offsetof(std140::point_light, constant) == 12);
+	CHECK(offsetof(std140::point_light, ambient) == 16);
+	CHECK(offsetof(std140::point_light, linear) == 28);
+	CHECK(offsetof(std140::point_light, diffuse) == 32);
+	CHECK(offsetof(std140::point_light, quadratic) == 44);
+	CHECK(offsetof(std140::point_light, specular) == 48);
+
+	// Each point light is four RGBA32F texels and OpenGL 3.3 guarantees
+	// texture buffers with at least 65536 texels
+	CHECK(sizeof(std140::point_light) == sizeof(glm::vec4) * 4);
+	CHECK(max_point_lights * 4 <= 65536);
+}
@@ -0,0 +1,49 @@
+#include "ShaderVariant.hpp"
+
+#include <doctest/doctest.h>
+#include <string>
+
+TEST_CASE("Shader variant defines")
+{
+	using namespace birb;
+
+	CHECK(shader_variant::define_lines(shader_variant::none).empty());
+	CHECK(shader_variant::define_lines(shader_variant::instanced) == "#define BIRB_INSTANCED\n");
+	CHECK(shader_variant::define_lines(shader_variant::instanced | shader_variant::textured) == "#define BIRB_INSTANCED\n#define BIRB_TEXTURED\n");
+
+	CHECK(shader_variant::to_str(shader_variant::none) == "none");
+	CHECK(shader_variant::to_str(shader_variant::batched | shader_variant::textured) == "BIRB_BATCHED, BIRB_TEXTURED");
+}
+
+TEST_CASE("Shader variant define injection")
+{
+	using namespace birb;
+
+	const std::string src = "#version 330 core\nout vec4 FragColor;\nvoid main(){}\n";
+
+	SUBCASE("No features leave the source untouched")
+	{
+		CHECK(shader_variant::inject_defines(src, shader_variant::none) == src);
+	}
+
+	SUBCASE("Defines go after the version directive")
+	{
+		const std::string result = shader_variant::inject_defines(src, shader_variant::batched);
+		CHECK(result == "#version 330 core\n#define BIRB_BATCHED\nout vec4 FragColor;\nvoid main(){}\n");
+	}
+
+	SUBCASE("Sources without a version directive")
+	{
+		CHECK(shader_variant::inject_defines("void main(){}", shader_variant::textured) == "#define BIRB_TEXTURED\nvoid main(){}");
+	}
+
+	SUBCASE("Version directive without a trailing newline")
+	{
+		CHECK(shader_variant::inject_defines("#version 330 core", shader_variant::instanced) == "#version 330 core\n#define BIRB_INSTANCED\n");
+	}
+
+	SUBCASE("Missing sources stay empty")
+	{
+		CHECK(shader_variant::inject_defines("", shader_variant::instanced).empty());
+	}
+}
@@ -0,0 +1,98 @@
+#include "ShadowCascades.hpp"
+
+#include <doctest/doctest.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+TEST_CASE("Shadow cascade splits")
+{
+	using birb::shadow_cascades;
+
+	constexpr f32 near_clip = 0.1f;
+	constexpr f32 far_clip = 100.0f;
+
+	f32 previous_split = near_clip;
+	for (u8 i = 0; i < shadow_cascades::cascade_count; ++i)
+	{
+		const f32 split = shadow_cascades::split_depth(i, near_clip, far_clip);
+		CHECK(split > previous_split);
+		previous_split = split;
+	}
+
+	// The last cascade reaches the far clip
+	CHECK(previous_split == doctest::Approx(far_clip));
+
+	// Closer cascades should be smaller than they would be with uniform splits
+	CHECK(shadow_cascades::split_depth(0, near_clip, far_clip) < far_clip / shadow_cascades::cascade_count);
+}
+
+TEST_CASE("Shadow cascade fitting")
+{
+	using birb::shadow_cascades;
+
+	constexpr f32 fov = 60.0f;
+	constexpr f32 aspect_ratio = 16.0f / 9.0f;
+	constexpr f32 near_clip = 0.1f;
+	constexpr f32 far_clip = 200.0f;
+
+	// The camera is at the origin looking towards -z and the light shines straight down
+	const glm::mat4 view_matrix(1.0f);
+	const glm::vec3 light_direction(0.0f, -1.0f, 0.0f);
+
+	shadow_cascades cascades;
+	cascades.shadow_distance = 50.0f;
+	cascades.update(view_matrix, fov, aspect_ratio, near_clip, far_clip, light_direction);
+
+	SUBCASE("Cascades cover the shadow distance without gaps")
+	{
+		CHECK(cascades.get_cascade(0).near_depth == doctest::Approx(near_clip));
+
+		for (u8 i = 1; i < shadow_cascades::cascade_count; ++i)
+			CHECK(cascades.get_cascade(i).near_depth == cascades.get_cascade(i - 1).far_depth);
+
+		CHECK(cascades.get_cascade(shadow_cascades::cascade_count - 1).far_depth == doctest::Approx(cascades.shadow_distance));
+	}
+
+	SUBCASE("Further cascades have larger texels")
+	{
+		for (u8 i = 1; i < shadow_cascades::cascade_count; ++i)
+			CHECK(cascades.get_cascade(i).texel_size > cascades.get_cascade(i - 1).texel_size);
+	}
+
+	SUBCASE("Points in the cascade land inside of the shadow map")
+	{
+		for (u8 i = 0; i < shadow_cascades::cascade_count; ++i)
+		{
+			const shadow_cascades::cascade& cascade = cascades.get_cascade(i);
+			const f32 depth = (cascade.near_depth + cascade.far_depth) * 0.5f;
+
+			const glm::vec4 clip_pos = cascade.light_matrix * glm::vec4(0.0f, 0.0f, -depth, 1.0f);
+			CHECK(clip_pos.x > -1.0f);
+			CHECK(clip_pos.x < 1.0f);
+			CHECK(clip_pos.y > -1.0f);
+			CHECK(clip_pos.y < 1.0f);
+			CHECK(clip_pos.z > -1.0f);
+			CHECK(clip_pos.z < 1.0f);
+		}
+	}
+
+	SUBCASE("Casters between the light and the cascade are not culled")
+	{
+		const shadow_cascades::cascade& cascade = cascades.get_cascade(0);
+		const f32 depth = (cascade.near_depth + cascade.far_depth) * 0.5f;
+
+		// Above the cascade towards the light
+		CHECK(cascade.caster_frustum.contains(glm::vec3(0.0f, 20.0f, -depth)));
+
+		// Far to the side of the cascade
+		CHECK_FALSE(cascade.caster_frustum.contains(glm::vec3(500.0f, 0.0f, -depth)));
+	}
+
+	SUBCASE("Small camera movements don't change the projection size")
+	{
+		const f32 texel_size = cascades.get_cascade(0).texel_size;
+
+		cascades.update(glm::translate(glm::mat4(1.0f), glm::vec3(0.013f, 0.0f, 0.0f)), fov, aspect_ratio, near_clip, far_clip, light_direction);
+		CHECK(cascades.get_cascade(0).texel_size == texel_size);
+	}
+}
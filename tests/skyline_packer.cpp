@@ -0,0 +1,83 @@
+#include "SkylinePacker.hpp"
+
+#include <doctest/doctest.h>
+#include <optional>
+#include <vector>
+
+struct packed_rect
+{
+	birb::vec2<i32> position;
+	birb::vec2<i32> size;
+};
+
+static bool overlaps(const packed_rect& a, const packed_rect& b)
+{
+	return a.position.x < b.position.x + b.size.x
+		&& b.position.x < a.position.x + a.size.x
+		&& a.position.y < b.position.y + b.size.y
+		&& b.position.y < a.position.y + a.size.y;
+}
+
+TEST_CASE("Skyline packing")
+{
+	using birb::vec2;
+
+	constexpr i32 area_size = 256;
+	birb::skyline_packer packer(vec2<i32>(area_size, area_size));
+
+	SUBCASE("Rectangles don't overlap and stay inside of the area")
+	{
+		std::vector<packed_rect> rects;
+
+		for (i32 i = 0; i < 200; ++i)
+		{
+			const vec2<i32> size(4 + (i * 7) % 29, 3 + (i * 13) % 23);
+			const std::optional<vec2<i32>> position = packer.insert(size);
+
+			if (!position)
+				continue;
+
+			CHECK(position->x >= 0);
+			CHECK(position->y >= 0);
+			CHECK(position->x + size.x <= area_size);
+			CHECK(position->y + size.y <= area_size);
+
+			rects.push_back({ *position, size });
+		}
+
+		REQUIRE(!rects.empty());
+
+		for (size_t i = 0; i < rects.size(); ++i)
+			for (size_t j = i + 1; j < rects.size(); ++j)
+				CHECK_FALSE(overlaps(rects[i], rects[j]));
+
+		CHECK(packer.occupancy() > 0.5f);
+		CHECK(packer.occupancy() <= 1.0f);
+	}
+
+	SUBCASE("A full area rejects more rectangles")
+	{
+		CHECK(packer.insert(vec2<i32>(area_size, area_size)).has_value());
+		CHECK(packer.occupancy() == doctest::Approx(1.0f));
+		CHECK_FALSE(packer.insert(vec2<i32>(1, 1)).has_value());
+	}
+
+	SUBCASE("Too large rectangles don't fit")
+	{
+		CHECK_FALSE(packer.insert(vec2<i32>(area_size + 1, 1)).has_value());
+		CHECK_FALSE(packer.insert(vec2<i32>(1, area_size + 1)).has_value());
+	}
+
+	SUBCASE("Empty rectangles don't take up space")
+	{
+		CHECK(packer.insert(vec2<i32>(0, 10)) == vec2<i32>(0, 0));
+		CHECK(packer.occupancy() == 0.0f);
+	}
+
+	SUBCASE("Rectangles fill the lowest spots first")
+	{
+		CHECK(packer.insert(vec2<i32>(128, 64)) == vec2<i32>(0, 0));
+		CHECK(packer.insert(vec2<i32>(128, 32)) == vec2<i32>(128, 0));
+		CHECK(packer.insert(vec2<i32>(128, 16)) == vec2<i32>(128, 32));
+	}
+}
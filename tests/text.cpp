@@ -0,0 +1,93 @@
+#include "Character.hpp"
+#include "Font.hpp"
+#include "Text.hpp"
+
+#include <doctest/doctest.h>
+#include <map>
+#include <memory>
+#include <string>
+
+static birb::font test_font()
+{
+	std::shared_ptr<std::map<char, birb::character>> character_map = std::make_shared<std::map<char, birb::character>>();
+
+	// Monospace glyphs that are 8 pixels wide. Spaces don't have a bitmap
+	for (char c = ' '; c <= '~'; ++c)
+	{
+		const u32 width = c == ' ' ? 0 : 6;
+		const u32 height = c == ' ' ? 0 : 10;
+		const f32 u = (c - ' ') / 128.0f;
+
+		character_map->insert({ c, birb::character{ { width, height }, { 1, 8 }, 8 << 6, { u, 0.0f }, { u + 1.0f / 128.0f, 1.0f } } });
+	}
+
+	return birb::font(character_map, 1, 16, 0);
+}
+
+static void check_same_layout(const birb::text& a, const birb::text& b)
+{
+	REQUIRE(a.glyphs().size() == b.glyphs().size());
+
+	for (size_t i = 0; i < a.glyphs().size(); ++i)
+	{
+		CHECK(a.glyphs()[i].position == b.glyphs()[i].position);
+		CHECK(a.glyphs()[i].size == b.glyphs()[i].size);
+		CHECK(a.glyphs()[i].uv_min == b.glyphs()[i].uv_min);
+		CHECK(a.glyphs()[i].uv_max == b.glyphs()[i].uv_max);
+	}
+}
+
+TEST_CASE("Text layout")
+{
+	const birb::font font = test_font();
+
+	birb::text text("ab c\nd", font, { 0.0f, 0.0f, 0.0f });
+
+	SUBCASE("Whitespace doesn't get glyphs")
+	{
+		CHECK(text.glyphs().size() == 4);
+	}
+
+	SUBCASE("Characters advance the cursor and newlines go one line down")
+	{
+		CHECK(text.glyphs()[0].position.x == 1.0f);
+		CHECK(text.glyphs()[1].position.x == 9.0f);
+		CHECK(text.glyphs()[2].position.x == 25.0f);
+		CHECK(text.glyphs()[3].position.x == 1.0f);
+		CHECK(text.glyphs()[3].position.y == text.glyphs()[0].position.y - font.size);
+	}
+
+	SUBCASE("Changing the text matches laying it out from scratch")
+	{
+		const std::string texts[] = {
+			"ab c\nde",
+			"ab",
+			"ab c\nd",
+			"x",
+			"",
+			"Frame: 10\nDelta: 0.016",
+			"Frame: 11\nDelta: 0.017",
+			"Frame: 100\nDelta: 0.1",
+		};
+
+		for (const std::string& str : texts)
+		{
+			text.set_text(str);
+			CHECK(text.get_text() == str);
+
+			const birb::text reference(str, font, { 0.0f, 0.0f, 0.0f });
+			check_same_layout(text, reference);
+		}
+	}
+
+	SUBCASE("Clearing the text removes the glyphs")
+	{
+		text.clear();
+		CHECK(text.empty());
+		CHECK(text.glyphs().empty());
+
+		text.set_text("ab");
+		CHECK(text.glyphs().size() == 2);
+		CHECK(text.glyphs()[0].position.x == 1.0f);
+	}
+}
@@ -0,0 +1,84 @@
+#include "TextureAtlas.hpp"
+
+#include <doctest/doctest.h>
+#include <vector>
+
+TEST_CASE("Texture atlas packing")
+{
+	using birb::atlas_region;
+	using birb::texture_atlas;
+	using birb::vec2;
+
+	constexpr i32 page_size = 128;
+	constexpr i32 gutter = 2;
+
+	const std::vector<vec2<i32>> sizes = {
+		{ 16, 16 },
+		{ 100, 40 },
+		{ 8, 60 },
+		{ 124, 124 },
+		{ 30, 10 },
+		{ 16, 16 },
+	};
+
+	const std::vector<atlas_region> regions = texture_atlas::pack(sizes, page_size, gutter);
+	REQUIRE(regions.size() == sizes.size());
+
+	SUBCASE("Regions keep the image sizes and leave room for the gutter")
+	{
+		for (size_t i = 0; i < regions.size(); ++i)
+		{
+			CHECK(regions[i].size == sizes[i]);
+			CHECK(regions[i].position.x >= gutter);
+			CHECK(regions[i].position.y >= gutter);
+			CHECK(regions[i].position.x + regions[i].size.x + gutter <= page_size);
+			CHECK(regions[i].position.y + regions[i].size.y + gutter <= page_size);
+		}
+	}
+
+	SUBCASE("Gutters of the regions on the same page don't overlap")
+	{
+		for (size_t i = 0; i < regions.size(); ++i)
+		{
+			for (size_t j = i + 1; j < regions.size(); ++j)
+			{
+				if (regions[i].page != regions[j].page)
+					continue;
+
+				const bool separate_x = regions[i].position.x + regions[i].size.x + gutter * 2 <= regions[j].position.x
+					|| regions[j].position.x + regions[j].size.x + gutter * 2 <= regions[i].position.x;
+
+				const bool separate_y = regions[i].position.y + regions[i].size.y + gutter * 2 <= regions[j].position.y
+					|| regions[j].position.y + regions[j].size.y + gutter * 2 <= regions[i].position.y;
+
+				CHECK((separate_x || separate_y));
+			}
+		}
+	}
+
+	SUBCASE("Images that don't fit on one page spill to more pages")
+	{
+		// The 124x124 image fills a page of its own
+		CHECK(regions[3].page != regions[1].page);
+	}
+
+	SUBCASE("UV rects match the pixel positions")
+	{
+		const atlas_region& region = regions[1];
+		CHECK(region.uv_rect.x == doctest::Approx(region.position.x / static_cast<f32>(page_size)));
+		CHECK(region.uv_rect.y == doctest::Approx(region.position.y / static_cast<f32>(page_size)));
+		CHECK(region.uv_rect.z == doctest::Approx((region.position.x + region.size.x) / static_cast<f32>(page_size)));
+		CHECK(region.uv_rect.w == doctest::Approx((region.position.y + region.size.y) / static_cast<f32>(page_size)));
+	}
+
+	SUBCASE("Packing is deterministic")
+	{
+		const std::vector<atlas_region> repacked = texture_atlas::pack(sizes, page_size, gutter);
+
+		for (size_t i = 0; i < regions.size(); ++i)
+		{
+			CHECK(repacked[i].page == regions[i].page);
+			CHECK(repacked[i].position == regions[i].position);
+		}
+	}
+}
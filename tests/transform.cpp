@@ -2,6 +2,8 @@
 #include "Vector.hpp"
 
 #include <doctest/doctest.h>
+#include <glm/glm.hpp>
+#include <vector>
 
 TEST_CASE("birb::transform")
 {
@@ -41,3 +43,77 @@ TEST_CASE("birb::transform")
 		CHECK(transform.local_scale == birb::vec3<f32>(8.0f, 1.0f, 0.0f));
 	}
 }
+
+TEST_CASE("Compose model matrices from component arrays")
+{
+	std::vector<birb::transform> transforms(5);
+	transforms[1].position = birb::vec3<f32>(1.0f, -2.0f, 3.0f);
+	transforms[2].rotation = birb::vec3<f32>(45.0f, 0.0f, 0.0f);
+	transforms[3].rotation = birb::vec3<f32>(10.0f, 20.0f, -30.0f);
+	transforms[3].local_scale = birb::vec3<f32>(2.0f, 0.5f, 1.0f);
+	transforms[4].position = birb::vec3<f32>(-5.0f, 0.0f, 8.0f);
+	transforms[4].rotation = birb::vec3<f32>(90.0f, 180.0f, 270.0f);
+	transforms[4].local_scale = birb::vec3<f32>(3.0f, 3.0f, 3.0f);
+
+	std::vector<glm::vec3> positions, rotations, scales;
+	for (const birb::transform& t : transforms)
+	{
+		positions.push_back(t.position.to_glm_vec());
+		rotations.push_back(t.rotation.to_glm_vec());
+		scales.push_back(t.local_scale.to_glm_vec());
+	}
+
+	std::vector<glm::mat4> model_matrices(transforms.size());
+	birb::transform::compose_model_matrices(positions, rotations, scales, model_matrices);
+
+	for (size_t i = 0; i < transforms.size(); ++i)
+	{
+		const glm::mat4 expected = transforms[i].model_matrix();
+
+		for (i32 column = 0; column < 4; ++column)
+			for (i32 row = 0; row < 4; ++row)
+				CHECK(model_matrices[i][column][row] == doctest::Approx(expected[column][row]).epsilon(0.0001));
+	}
+
+	SUBCASE("Lock to a precomputed matrix")
+	{
+		transforms[0].lock(model_matrices[4]);
+		CHECK(transforms[0].is_locked());
+		CHECK(transforms[0].model_matrix() == model_matrices[4]);
+	}
+}
+
+TEST_CASE("Compose model matrices in batches")
+{
+	// 21 transforms go through two eight wide batches (or four four wide ones),
+	// a four wide batch and a scalar tail, depending on the CPU
+	constexpr size_t count = 21;
+
+	std::vector<glm::vec3> positions, rotations, scales;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const f32 value = static_cast<f32>(i);
+		positions.emplace_back(value, -value * 2.0f, value * 0.5f);
+		rotations.emplace_back(value * 37.0f - 360.0f, value * -53.0f, value * 101.0f);
+		scales.emplace_back(1.0f + value * 0.25f, 2.0f, 0.5f + value);
+	}
+
+	std::vector<glm::mat4> model_matrices(count);
+	birb::transform::compose_model_matrices(positions, rotations, scales, model_matrices);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		birb::transform transform;
+		transform.position = birb::vec3<f32>(positions[i].x, positions[i].y, positions[i].z);
+		transform.rotation = birb::vec3<f32>(rotations[i].x, rotations[i].y, rotations[i].z);
+		transform.local_scale = birb::vec3<f32>(scales[i].x, scales[i].y, scales[i].z);
+
+		const glm::mat4 expected = transform.model_matrix();
+
+		// The SIMD sine and cosine don't round exactly like the standard library
+		// does, which shows with the larger angles and scales
+		for (i32 column = 0; column < 4; ++column)
+			for (i32 row = 0; row < 4; ++row)
+				CHECK(model_matrices[i][column][row] == doctest::Approx(expected[column][row]).epsilon(0.0001));
+	}
+}
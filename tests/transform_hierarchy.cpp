@@ -0,0 +1,115 @@
+#include "Scene.hpp"
+#include "Transform.hpp"
+
+#include <doctest/doctest.h>
+#include <entt.hpp>
+#include <glm/glm.hpp>
+
+static void check_translation(const glm::mat4& matrix, const glm::vec3 translation)
+{
+	CHECK(matrix[3].x == doctest::Approx(translation.x));
+	CHECK(matrix[3].y == doctest::Approx(translation.y));
+	CHECK(matrix[3].z == doctest::Approx(translation.z));
+}
+
+TEST_CASE("Transform hierarchy")
+{
+	birb::scene scene;
+
+	const entt::entity root = scene.registry.create();
+	const entt::entity child = scene.registry.create();
+	const entt::entity grandchild = scene.registry.create();
+	const entt::entity other_root = scene.registry.create();
+
+	for (const entt::entity entity : { root, child, grandchild, other_root })
+	{
+		birb::transform transform;
+		transform.position = birb::vec3<f32>(1.0f, 2.0f, 3.0f);
+		scene.registry.emplace<birb::transform>(entity, transform);
+	}
+
+	scene.set_parent(child, root);
+	scene.set_parent(grandchild, child);
+	scene.update_world_matrices();
+
+	SUBCASE("World matrices combine the parent transforms")
+	{
+		CHECK(scene.parent(grandchild) == child);
+		CHECK(scene.parent(root) == entt::null);
+
+		check_translation(scene.world_matrix(root), { 1.0f, 2.0f, 3.0f });
+		check_translation(scene.world_matrix(child), { 2.0f, 4.0f, 6.0f });
+		check_translation(scene.world_matrix(grandchild), { 3.0f, 6.0f, 9.0f });
+		check_translation(scene.world_matrix(other_root), { 1.0f, 2.0f, 3.0f });
+	}
+
+	SUBCASE("Scaling a parent scales the child offset")
+	{
+		scene.registry.get<birb::transform>(root).local_scale = birb::vec3<f32>(2.0f, 2.0f, 2.0f);
+		scene.update_world_matrices();
+
+		check_translation(scene.world_matrix(child), { 3.0f, 6.0f, 9.0f });
+		check_translation(scene.world_matrix(grandchild), { 5.0f, 10.0f, 15.0f });
+	}
+
+	SUBCASE("Only changed subtrees get updated")
+	{
+		scene.update_world_matrices();
+		CHECK(scene.updated_world_matrix_count() == 0);
+
+		scene.registry.get<birb::transform>(child).position.x = 10.0f;
+		scene.update_world_matrices();
+		CHECK(scene.updated_world_matrix_count() == 2);
+		check_translation(scene.world_matrix(grandchild), { 12.0f, 6.0f, 9.0f });
+
+		scene.registry.get<birb::transform>(other_root).position.x = 0.0f;
+		scene.update_world_matrices();
+		CHECK(scene.updated_world_matrix_count() == 1);
+	}
+
+	SUBCASE("Clearing the parent makes the transform local again")
+	{
+		scene.clear_parent(child);
+		scene.update_world_matrices();
+
+		check_translation(scene.world_matrix(child), { 1.0f, 2.0f, 3.0f });
+		check_translation(scene.world_matrix(grandchild), { 2.0f, 4.0f, 6.0f });
+	}
+
+	SUBCASE("Destroying a parent turns the children into roots")
+	{
+		scene.destroy_entity(root);
+		scene.update_world_matrices();
+
+		CHECK(scene.parent(child) == entt::null);
+		check_translation(scene.world_matrix(child), { 1.0f, 2.0f, 3.0f });
+		check_translation(scene.world_matrix(grandchild), { 2.0f, 4.0f, 6.0f });
+	}
+
+	SUBCASE("New entities get world matrices during the next update")
+	{
+		const entt::entity new_entity = scene.registry.create();
+		scene.registry.emplace<birb::transform>(new_entity, birb::transform());
+		CHECK(!scene.has_world_matrix(new_entity));
+
+		scene.set_parent(new_entity, grandchild);
+		scene.update_world_matrices();
+
+		CHECK(scene.has_world_matrix(new_entity));
+		check_translation(scene.world_matrix(new_entity), { 3.0f, 6.0f, 9.0f });
+	}
+
+	SUBCASE("Locked transforms keep their locked matrix")
+	{
+		birb::transform& child_transform = scene.registry.get<birb::transform>(child);
+		child_transform.lock();
+		child_transform.position.x = 10.0f;
+		scene.update_world_matrices();
+		check_translation(scene.world_matrix(child), { 2.0f, 4.0f, 6.0f });
+
+		// Recomposing the chunk for another change shouldn't override the locked matrix
+		scene.registry.get<birb::transform>(other_root).position.x = 0.0f;
+		scene.update_world_matrices();
+		check_translation(scene.world_matrix(grandchild), { 3.0f, 6.0f, 9.0f });
+	}
+}
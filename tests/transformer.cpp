@@ -0,0 +1,61 @@
+#include "Transformer.hpp"
+
+#include <doctest/doctest.h>
+#include <vector>
+
+using range = birb::transformer::index_range;
+
+static void check_range(const range& r, const size_t first, const size_t count)
+{
+	CHECK(r.first == first);
+	CHECK(r.count == count);
+}
+
+TEST_CASE("Coalesce transformer dirty ranges")
+{
+	SUBCASE("Empty")
+	{
+		std::vector<range> ranges;
+		birb::transformer::coalesce_ranges(ranges, 0);
+		CHECK(ranges.empty());
+	}
+
+	SUBCASE("Ranges get sorted")
+	{
+		std::vector<range> ranges = { { 20, 2 }, { 0, 1 }, { 10, 5 } };
+		birb::transformer::coalesce_ranges(ranges, 0);
+
+		REQUIRE(ranges.size() == 3);
+		check_range(ranges[0], 0, 1);
+		check_range(ranges[1], 10, 5);
+		check_range(ranges[2], 20, 2);
+	}
+
+	SUBCASE("Overlapping and adjacent ranges are merged")
+	{
+		std::vector<range> ranges = { { 4, 4 }, { 0, 4 }, { 6, 10 }, { 8, 2 } };
+		birb::transformer::coalesce_ranges(ranges, 0);
+
+		REQUIRE(ranges.size() == 1);
+		check_range(ranges[0], 0, 16);
+	}
+
+	SUBCASE("Ranges within the gap are merged")
+	{
+		std::vector<range> ranges = { { 0, 1 }, { 8, 1 }, { 16, 1 }, { 40, 1 } };
+		birb::transformer::coalesce_ranges(ranges, 7);
+
+		REQUIRE(ranges.size() == 2);
+		check_range(ranges[0], 0, 17);
+		check_range(ranges[1], 40, 1);
+	}
+
+	SUBCASE("Contained ranges don't shrink the outer range")
+	{
+		std::vector<range> ranges = { { 0, 100 }, { 10, 5 }, { 50, 1 } };
+		birb::transformer::coalesce_ranges(ranges, 0);
+
+		REQUIRE(ranges.size() == 1);
+		check_range(ranges[0], 0, 100);
+	}
+}